@@ -5,14 +5,18 @@
  *      Author: secerdan
  */
 
+#include <stdio.h>
+#include <math.h>
 #include "cs_initiator_config.h"
 #include "em_gpio.h"
 #include "sl_sleeptimer.h"
 #include "app.h"
-#include "config/token.h"
-
-#define OPEN_CMD 1
-#define CLOSE_CMD 0
+#include "alg.h"
+#include "dlog.h"
+#include "gate_arbiter.h"
+#include "dist_filter.h"
+#include "relay.h"
+#include "gate_config.h"
 
 enum gate_state_e
 {
@@ -24,20 +28,20 @@ enum reflector_state_e
 {
     JUST_CONNECTED,
     MOVING,
-    RED_ZONE,
 };
 
-enum gate_command_state_e
-{
-  RELAY_POSITION_0,
-  RELAY_POSITION_1,
-  RELAY_POSITION_2,
-  RELAY_DELAY
-};
+/* 1: Q16 fixed-point filter (dist_filter.c), 0: original integer filter */
+#ifndef ALG_Q16_FILTER
+#define ALG_Q16_FILTER 1
+#endif
 
 volatile enum reflector_state_e reflector_state[CS_INITIATOR_MAX_CONNECTIONS];
 volatile uint32_t baseline[CS_INITIATOR_MAX_CONNECTIONS];
+#if ALG_Q16_FILTER
+static dist_filter_t filters[CS_INITIATOR_MAX_CONNECTIONS];
+#else
 volatile uint32_t previous[CS_INITIATOR_MAX_CONNECTIONS];
+#endif
 volatile enum gate_state_e gate_state = DOOR_CLOSED;
 
 //#define GATE_AUTO_CLOSE_MODE
@@ -48,84 +52,31 @@ uint32_t MOVING_THRESHOLD_MM = 1000;
 uint32_t OPEN_BLOCK_DELAY_MS = 8000;
 uint32_t CLOSE_BLOCK_DELAY_MS = 10000;
 
-#define DISTANCE_WEIGHT 500
-#define DISTANCE_RED_ZONE 2000
-#define DISTANCE_OPENING_ZONE 100000
-#define RELAY_DELAY_TIME_MS 500
+uint32_t DISTANCE_RED_ZONE = 2000;
+uint32_t DISTANCE_OPENING_ZONE = 100000;
+uint32_t RELAY_PULSE_MS = RELAY_DELAY_TIME_MS;
+
+uint32_t GATE_TRAVEL_TIME_MS = 4000;
 
 #define RELAY_OPEN_PORT  gpioPortC
 #define RELAY_OPEN_PIN   2
 #define RELAY_CLOSE_PORT gpioPortC
 #define RELAY_CLOSE_PIN  3
 
+#define LED_PORT         gpioPortD
+#define LED_PIN          4
+
+#ifdef GATE_AUTO_CLOSE_MODE
 sl_status_t status;
 sl_sleeptimer_timer_handle_t my_timer;
-uint8_t led_lock = 0;
-
-volatile enum gate_command_state_e relay_state = RELAY_POSITION_0;
-
-void open_callback(sl_sleeptimer_timer_handle_t *handle, void *data)
-{
-  relay_sequence(OPEN_CMD);
-}
+#endif
 
-void close_callback(sl_sleeptimer_timer_handle_t *handle, void *data)
+/* The gate never moves over a reflector in the red zone, a queued command
+ * waits for it to leave */
+static bool relay_hold(relay_command_t cmd)
 {
-  relay_sequence(CLOSE_CMD);
-}
-
-/* Asynchronous relay command */
-void relay_sequence(uint8_t open)
-{
-  /* relay sequence */
-  printf("rs : %d\n", relay_state);
-  uint32_t relay_delay = (RELAY_DELAY_TIME_MS * 32768)/1000;
-  CORE_irqState_t irqState;
-
-  switch (relay_state)
-  {
-    case RELAY_POSITION_0:
-      irqState = CORE_EnterAtomic();
-      led_lock = 1;
-      CORE_ExitAtomic(irqState);
-      /* Set LED ON */
-      GPIO_PinModeSet(gpioPortD, 4, gpioModePushPull, 1);
-      if (open)
-        GPIO_PinModeSet(RELAY_OPEN_PORT, RELAY_OPEN_PIN, gpioModePushPull, 0);
-      else
-        GPIO_PinModeSet(RELAY_CLOSE_PORT, RELAY_CLOSE_PIN, gpioModePushPull, 0);
-      relay_state = RELAY_POSITION_1;
-      break;
-    case RELAY_POSITION_1:
-      if (open)
-        GPIO_PinModeSet(RELAY_OPEN_PORT, RELAY_OPEN_PIN, gpioModePushPull, 1);
-      else
-        GPIO_PinModeSet(RELAY_CLOSE_PORT, RELAY_CLOSE_PIN, gpioModePushPull, 1);
-      relay_state = RELAY_POSITION_2;
-      break;
-    case RELAY_POSITION_2:
-      if (open)
-        GPIO_PinModeSet(RELAY_OPEN_PORT, RELAY_OPEN_PIN, gpioModePushPull, 0);
-      else
-        GPIO_PinModeSet(RELAY_CLOSE_PORT, RELAY_CLOSE_PIN, gpioModePushPull, 0);
-      relay_state = RELAY_DELAY;
-      /* After Opening/Closing the door we wait before new action */
-      relay_delay = open ? (OPEN_BLOCK_DELAY_MS * 32768)/1000 : (CLOSE_BLOCK_DELAY_MS * 32768)/1000;
-      break;
-    case RELAY_DELAY:
-      /* Set LED OFF */
-      GPIO_PinModeSet(gpioPortD, 4, gpioModePushPull, 0);
-      irqState = CORE_EnterAtomic();
-      led_lock = 0;
-      CORE_ExitAtomic(irqState);
-      relay_state = RELAY_POSITION_0;
-      return;
-  }
-
-  if (open)
-    status = sl_sleeptimer_start_timer(&my_timer, relay_delay, open_callback, (void *)NULL, 0, 0);
-  else
-    status = sl_sleeptimer_start_timer(&my_timer, relay_delay, close_callback, (void *)NULL, 0, 0);
+  (void)cmd;
+  return gate_arbiter_red_zone_occupied();
 }
 
 void try_open_gate(uint32_t distance)
@@ -139,34 +90,28 @@ void try_open_gate(uint32_t distance)
       break;
   }
 
-  if (relay_state != RELAY_POSITION_0)
-  /* An action is already on-going on relays */
+  if (gate_arbiter_red_zone_occupied())
+  /* At least one reflector is in risk area */
     return;
 
-  for (uint8_t i = 0; i < CS_INITIATOR_MAX_CONNECTIONS; i++)
-  {
-    if (reflector_state[i] == RED_ZONE)
-    /* At least one reflector is in risk area */
-      return;
-  }
-
   if (distance > DISTANCE_OPENING_ZONE)
   /* Just a security not to open the door too soon */
     return;
 
 
+  /* Queued behind a running sequence, never dropped */
   gate_state = DOOR_OPENNED;
-  relay_sequence(OPEN_CMD);
+  relay_submit(RELAY_CMD_OPEN, OPEN_BLOCK_DELAY_MS);
 
 #ifdef GATE_AUTO_CLOSE_MODE
   /* Gate will auto close after user timeout*/
   status = sl_sleeptimer_start_timer(&my_timer,timer_timeout, my_timer_callback, (void *)NULL, 0, 0);
 #endif
 
-  printf("OPENNING\n");
+  dlog_write(DLOG_GATE_OPENING, 0, 0);
 }
 
-void try_close_gate()
+void try_close_gate(void)
 {
   switch (gate_state)
   {
@@ -177,41 +122,86 @@ void try_close_gate()
       break;
   }
 
-  if (relay_state != RELAY_POSITION_0)
-  /* An action is already on-going on relays */
+  if (gate_arbiter_red_zone_occupied())
+  /* At least one reflector is in risk area */
     return;
 
-  for (uint8_t i = 0; i < CS_INITIATOR_MAX_CONNECTIONS; i++)
-  {
-    if (reflector_state[i] == RED_ZONE)
-    /* At least one reflector is in risk area */
-      return;
-  }
-
   gate_state = DOOR_CLOSED;
-  relay_sequence(CLOSE_CMD);
+  relay_submit(RELAY_CMD_CLOSE, CLOSE_BLOCK_DELAY_MS);
 
-  printf("CLOSING\n");
+  dlog_write(DLOG_GATE_CLOSING, 0, 0);
 }
 
 void init_measure(uint8_t index)
 {
    reflector_state[index] = JUST_CONNECTED;
+   gate_arbiter_start_track(index);
+}
+
+void release_measure(uint8_t index)
+{
+   gate_arbiter_stop_track(index);
+}
+
+void gate_evaluate(void)
+{
+  uint32_t distance;
+
+  switch (gate_arbiter_evaluate(&distance))
+  {
+    case GATE_OPEN:
+      try_open_gate(distance);
+      break;
+    case GATE_CLOSE:
+      try_close_gate();
+      break;
+    default:
+      break;
+  }
 }
 
-volatile uint32_t cnt = 0;
+bool gate_idle(void)
+{
+  return gate_state == DOOR_CLOSED && !relay_busy();
+}
 
 void process_measure(uint8_t index, cs_initiator_instances_t * instances)
 {
   cs_initiator_instances_t * initiator = instances + index;
-  uint32_t new = (uint32_t)(initiator->measurement_mainmode.distance_filtered * 1000.f);
+  uint32_t measured;
   uint32_t distance;
+  int32_t velocity_mm_s = 0;
+
+  /* A NaN or infinite distance cannot be converted, the sample is dropped */
+  if (!isfinite(initiator->measurement_mainmode.distance_filtered))
+    return;
+
+#if ALG_Q16_FILTER
+  dist_filter_t * filter = &filters[index];
+  q16_t sample = q16_from_float(initiator->measurement_mainmode.distance_filtered);
+
+  if (reflector_state[index] == JUST_CONNECTED)
+    dist_filter_reset(filter);
+
+  measured = q16_to_mm(sample);
+  dist_filter_update(filter,
+                     sample,
+                     (q16_t)((BASELINE_WEIGHT << 16) / 100),
+                     sl_sleeptimer_tick_to_ms(sl_sleeptimer_get_tick_count()));
+  distance = q16_to_mm(filter->distance);
+  baseline[index] = q16_to_mm(dist_filter_baseline(filter));
+  velocity_mm_s = (int32_t)(((int64_t)filter->velocity * 1000) >> 16);
+#else
+  uint32_t new = (uint32_t)(initiator->measurement_mainmode.distance_filtered * 1000.f);
+
+  measured = new;
 
   switch (reflector_state[index])
   {
     case JUST_CONNECTED:
       baseline[index] = new;
       previous[index] = new;
+      distance = new;
       break;
     default:
       /* Update the baseline */
@@ -223,97 +213,55 @@ void process_measure(uint8_t index, cs_initiator_instances_t * instances)
       previous[index] = distance;
       break;
   }
+#endif
 
   // printf("diff: %d\nd: %d\nb: %d\n", distance - baseline[index], new, baseline[index]);
-   printf("d: %d, b: %d\n", distance, baseline[index]);
+   dlog_write(DLOG_DISTANCE, (int32_t)distance, (int32_t)baseline[index]);
   // printf("s: %d \n", reflector_state[index]);
 
-  switch (reflector_state[index])
-  {
-    case JUST_CONNECTED:
-      reflector_state[index] = MOVING;
-      break;
-    case MOVING:
-      /* This state is used to determine direction of mouvement */
-      if (distance <= DISTANCE_RED_ZONE)
-      {
-        reflector_state[index] = RED_ZONE;
-        break;
-      }
-      if (distance >= (baseline[index] + MOVING_THRESHOLD_MM))
-      /* We are moving away */
-      {
-        try_close_gate();
-      }
-      else if ((distance +  MOVING_THRESHOLD_MM) < baseline[index])
-      /* We are moving closer */
-      {
-        try_open_gate(distance);
-      }
-      break;
-    case RED_ZONE:
-      if (distance > DISTANCE_RED_ZONE)
-        reflector_state[index] = MOVING;
-      break;
-    default:
-      break;
-  }
+  reflector_state[index] = MOVING;
+
+  /* Direction and red zone are tracked per reflector, the gate itself is
+   * driven from gate_evaluate() */
+  /* The RTL velocity is only provided in real-time fast PBR mode, the
+   * filter estimate is used otherwise */
+  if (initiator->measurement_mainmode.velocity != 0.f)
+    velocity_mm_s = (int32_t)(initiator->measurement_mainmode.velocity * 1000.f);
 
+  gate_arbiter_update(index, measured, distance, baseline[index], velocity_mm_s,
+                      initiator->measurement_mainmode.likeliness);
 }
 
-void alg_init()
+/* Gate parameters of the record, see gate_config.h */
+static void apply_config(const gate_config_t *config)
 {
-  uint8_t data;
-  sl_status_t st;
-
-  st = nvm3_readData(nvm3_defaultHandle, NVM3KEY_DEVICE_MOVING_THRESHOLD, &data, 1);
-
-  if (st == SL_STATUS_NOT_FOUND)
-  {
-    data = CREATOR_DEVICE_MOVING_THRESHOLD_DEFAULT;
-    nvm3_writeData(nvm3_defaultHandle, NVM3KEY_DEVICE_MOVING_THRESHOLD, &data, 1);
-  }
-
-  /* data is in deci-meter, convert to mm */
-  MOVING_THRESHOLD_MM = data * 10 * 10;
-
-  /*-------------------------------------------------------------------------*/
-
-  st = nvm3_readData(nvm3_defaultHandle, NVM3KEY_DEVICE_BASELINE_WEIGHT, &data, 1);
-
-  if (st == SL_STATUS_NOT_FOUND)
-  {
-    data = CREATOR_DEVICE_BASELINE_WEIGHT_DEFAULT;
-    nvm3_writeData(nvm3_defaultHandle, NVM3KEY_DEVICE_BASELINE_WEIGHT, &data, 1);
-  }
-
+  MOVING_THRESHOLD_MM = config->moving_threshold_mm;
   /* value range is 1 -99 */
-  BASELINE_WEIGHT = data;
-
-  /*-------------------------------------------------------------------------*/
-
-  st = nvm3_readData(nvm3_defaultHandle, NVM3KEY_DEVICE_OPEN_TIME, &data, 1);
-
-  if (st == SL_STATUS_NOT_FOUND)
-  {
-    data = CREATOR_DEVICE_OPEN_TIME_DEFAULT;
-    nvm3_writeData(nvm3_defaultHandle, NVM3KEY_DEVICE_OPEN_TIME, &data, 1);
-  }
-
-  /* value is in s */
-  OPEN_BLOCK_DELAY_MS = data * 1000;
-
-  /*-------------------------------------------------------------------------*/
-
-  st = nvm3_readData(nvm3_defaultHandle, NVM3KEY_DEVICE_CLOSE_TIME, &data, 1);
-
-  if (st == SL_STATUS_NOT_FOUND)
-  {
-    data = CREATOR_DEVICE_CLOSE_TIME_DEFAULT;
-    nvm3_writeData(nvm3_defaultHandle, NVM3KEY_DEVICE_CLOSE_TIME, &data, 1);
-  }
-
-  /* value is in s */
-  CLOSE_BLOCK_DELAY_MS = data * 1000;
+  BASELINE_WEIGHT = config->baseline_weight;
+  OPEN_BLOCK_DELAY_MS = config->open_block_ms;
+  CLOSE_BLOCK_DELAY_MS = config->close_block_ms;
+  DISTANCE_RED_ZONE = config->red_zone_mm;
+  DISTANCE_OPENING_ZONE = config->opening_zone_mm;
+  RELAY_PULSE_MS = config->relay_pulse_ms;
+  relay_set_step(RELAY_PULSE_MS);
+}
 
+void alg_init(void)
+{
+  const relay_config_t relay_config = {
+    .open_port = RELAY_OPEN_PORT,
+    .open_pin = RELAY_OPEN_PIN,
+    .close_port = RELAY_CLOSE_PORT,
+    .close_pin = RELAY_CLOSE_PIN,
+    .led_port = LED_PORT,
+    .led_pin = LED_PIN,
+    .step_ms = RELAY_DELAY_TIME_MS,
+    .hold = relay_hold
+  };
+
+  gate_arbiter_init();
+  relay_init(&relay_config);
+
+  /* Parameters from the NVM3 record, applied again on every change */
+  (void)gate_config_init(apply_config);
 }
@@ -0,0 +1,45 @@
+/*
+ * alg.h
+ *
+ *  Created on: 31 août 2025
+ *      Author: secerdan
+ */
+
+#ifndef ALG_H_
+#define ALG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "app.h"
+
+#ifdef ALG_HOST_BUILD
+/* Host build: GPIO/sleeptimer/NVM3 are provided by the shims in host/ */
+#include "alg_host_port.h"
+#endif
+
+/* Relay lead time and pulse length at boot, see relay.h */
+#define RELAY_DELAY_TIME_MS 500
+
+/* Gate parameters, loaded from NVM3 by alg_init() and updated over GATT */
+extern uint32_t BASELINE_WEIGHT;
+extern uint32_t MOVING_THRESHOLD_MM;
+extern uint32_t OPEN_BLOCK_DELAY_MS;
+extern uint32_t CLOSE_BLOCK_DELAY_MS;
+extern uint32_t DISTANCE_RED_ZONE;
+extern uint32_t DISTANCE_OPENING_ZONE;
+extern uint32_t RELAY_PULSE_MS;
+/* Time the gate needs to open fully, used by the predictive opening */
+extern uint32_t GATE_TRAVEL_TIME_MS;
+
+void alg_init(void);
+void init_measure(uint8_t index);
+void release_measure(uint8_t index);
+void process_measure(uint8_t index, cs_initiator_instances_t * instances);
+/* One gate decision across all reflectors updated since the last call */
+void gate_evaluate(void);
+void try_open_gate(uint32_t distance);
+void try_close_gate(void);
+/* Gate closed and no relay sequence running or queued */
+bool gate_idle(void);
+
+#endif /* ALG_H_ */
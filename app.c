@@ -29,19 +29,30 @@
  ******************************************************************************/
 // -----------------------------------------------------------------------------
 // Includes
+#include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <math.h>
 #include "sl_bluetooth.h"
 #include "sl_component_catalog.h"
 #include "app_assert.h"
+#include "sl_sleeptimer.h"
 
 // app content
 #include "sl_main_init.h"
 #include "app.h"
+#include "alg.h"
+#include "relay.h"
+#include "dlog.h"
+#include "proc_sched.h"
+#include "power_policy.h"
+#include "power_monitor.h"
+#include "reflector_cache.h"
+#include "gate_config.h"
 #include "trace.h"
 #include "app_config.h"
 #include "app_timer.h"
+#include "app_queue.h"
 
 // initiator content
 #include "cs_antenna.h"
@@ -49,6 +60,7 @@
 #include "cs_initiator.h"
 #include "cs_initiator_client.h"
 #include "cs_initiator_config.h"
+#include "cs_initiator_latency.h"
 #include "cs_initiator_display_core.h"
 #include "cs_initiator_display.h"
 
@@ -62,6 +74,7 @@
 #include "ble_peer_manager_common.h"
 #include "ble_peer_manager_connections.h"
 #include "ble_peer_manager_central.h"
+#include "ble_peer_manager_central_config.h"
 #include "ble_peer_manager_filter.h"
 
 #ifdef SL_CATALOG_CS_INITIATOR_CLI_PRESENT
@@ -84,6 +97,9 @@
 #define BT_ADDR_LEN                      sizeof(bd_addr)
 #define DISPLAY_REFRESH_RATE             1000u // ms
 #define ABS(x)                           ((x < 0) ? ((-1) * x) : x)
+#define MEASUREMENT_QUEUE_SIZE           (4u * CS_INITIATOR_MAX_CONNECTIONS)
+#define LATENCY_REPORT                   (CS_INITIATOR_LATENCY_STATS && (LATENCY_REPORT_PERIOD_MS > 0))
+#define POWER_REPORT                     (POWER_REPORT_PERIOD_MS > 0)
 
 
 
@@ -99,6 +115,11 @@ static void cs_on_result(const uint8_t conn_handle,
                          const cs_result_session_data_t *result_data,
                          const cs_ranging_data_t *ranging_data,
                          const void *user_data);
+static void cs_on_result_fields(const uint8_t conn_handle,
+                                const uint16_t ranging_counter,
+                                const cs_result_fields_t *result,
+                                const cs_ranging_data_t *ranging_data,
+                                const void *user_data);
 static void cs_on_intermediate_result(const cs_intermediate_result_t *intermediate_result,
                                       const void *user_data);
 static void cs_on_error(uint8_t conn_handle,
@@ -109,6 +130,22 @@ static void check_cli_values(void);
 static sl_status_t create_new_initiator_instance(uint8_t conn_handle);
 static void delete_initiator_instance(uint8_t conn_handle);
 static void app_timer_callback(app_timer_t *timer, void *data);
+static void queue_measurement(uint8_t instance_num, bool progress);
+static void update_procedure_rates(void);
+static void update_power_level(void);
+static void set_instance_intervals(uint8_t instance_num, proc_rate_t rate);
+static void set_heartbeat_period(uint32_t period_ms);
+#if REFLECTOR_CACHE_ENABLE
+static void use_cached_attributes(uint8_t conn_handle, uint8_t num_antennas);
+static void save_cached_attributes(uint8_t instance_num);
+#endif
+#if POWER_REPORT
+static void get_power_plan(power_plan_t *plan);
+static void report_power(void);
+#endif
+#if LATENCY_REPORT
+static void report_latency(void);
+#endif
 
 // -----------------------------------------------------------------------------
 // Static variables
@@ -120,24 +157,35 @@ static rtl_config_t rtl_config = RTL_CONFIG_DEFAULT;
 static uint8_t num_reflector_connections = 0u;
 static cs_initiator_instances_t cs_initiator_instances[CS_INITIATOR_MAX_CONNECTIONS];
 static app_timer_t display_timer;
+static APP_QUEUE(measurement_queue, cs_measurement_event_t, MEASUREMENT_QUEUE_SIZE);
+static uint32_t measurement_drop_cnt = 0u;
+#if LATENCY_REPORT
+static uint32_t latency_report_tick = 0u;
+#endif
+#if POWER_REPORT
+static uint32_t power_report_tick = 0u;
+#endif
 
-#define BURTC_LONG_PERIOD_MS  10000
-#define BURTC_SHORT_PERIOD_MS 50
+#define BURTC_LONG_PERIOD_MS  POWER_ACTIVE_HEARTBEAT_MS
+#define BURTC_SHORT_PERIOD_MS POWER_MODEL_LED_FLASH_MS
 uint32_t v = BURTC_LONG_PERIOD_MS;
-extern uint8_t led_lock;
+
+/* LED off time, stretched by the power policy */
+static volatile uint32_t heartbeat_period_ms = BURTC_LONG_PERIOD_MS;
 
 void BURTC_IRQHandler(void)
 {
   BURTC_IntClear(BURTC_IF_COMP); // compare match
 
-  if (led_lock)
+  /* The relay sequence drives the LED */
+  if (relay_busy())
     return;
 
   if (v == BURTC_SHORT_PERIOD_MS)
   {
     /* Set LED OFF */
     GPIO_PinOutClear(gpioPortD, 4);
-    v = BURTC_LONG_PERIOD_MS;
+    v = heartbeat_period_ms;
   }
   else
   {
@@ -176,6 +224,8 @@ void app_init(void)
 {
   sl_status_t sc = SL_STATUS_OK;
 
+  power_monitor_init();
+  power_policy_init(sl_sleeptimer_tick_to_ms(sl_sleeptimer_get_tick_count()));
   trace_init();
 
   // initialize initiator instances
@@ -186,11 +236,11 @@ void app_init(void)
     memset(&cs_initiator_instances[i].measurement_mainmode, 0u, sizeof(cs_measurement_data_t));
     memset(&cs_initiator_instances[i].measurement_submode, 0u, sizeof(cs_measurement_data_t));
     memset(&cs_initiator_instances[i].measurement_progress, 0u, sizeof(cs_intermediate_result_t));
-    cs_initiator_instances[i].measurement_arrived = false;
-    cs_initiator_instances[i].measurement_progress_changed = false;
     cs_initiator_instances[i].read_remote_capabilities = false;
     cs_initiator_instances[i].number_of_measurements = 0u;
   }
+  sc = APP_QUEUE_INIT(&measurement_queue, cs_measurement_event_t, MEASUREMENT_QUEUE_SIZE);
+  app_assert_status_f(sc, "measurement queue init failed");
 
   // Set configuration parameters
   rtl_config.algo_mode = get_algo_mode();
@@ -254,6 +304,7 @@ void app_init(void)
   // Put your additional application init code here!                         //
   // This is called once during start-up.                                    //
   /////////////////////////////////////////////////////////////////////////////
+  dlog_init();
   alg_init();
   initBURTC();
 }
@@ -263,14 +314,32 @@ void app_init(void)
  *****************************************************************************/
 void app_process_action(void)
 {
-
-  for (uint8_t i = 0u; i < CS_INITIATOR_MAX_CONNECTIONS; i++) {
-    if (cs_initiator_instances[i].measurement_arrived) {
-      process_measure(i, cs_initiator_instances + i);
-
+  cs_measurement_event_t evt;
+  bool measured = false;
+  uint32_t decided = 0u;
+
+  // Results are queued by the CS callbacks in arrival order, wakeups by
+  // unrelated events find the queue empty and return right away.
+  while (app_queue_remove(&measurement_queue, (uint8_t *)&evt) == SL_STATUS_OK) {
+    uint8_t i = evt.instance;
+    if (cs_initiator_instances[i].conn_handle != evt.conn_handle) {
+      // Instance was deleted or reused since the result was queued
+      continue;
+    }
+    if (!evt.progress) {
+      cs_initiator_instances[i].ranging_counter = evt.ranging_counter;
+      cs_initiator_instances[i].measurement_mainmode = evt.mainmode;
+      cs_initiator_instances[i].measurement_submode = evt.submode;
+      process_measure(i, cs_initiator_instances);
+      decided |= 1u << i;
+      measured = true;
+#if REFLECTOR_CACHE_ENABLE
+      if (reflector_cache_pending(evt.conn_handle)) {
+        save_cached_attributes(i);
+      }
+#endif
 
       // write results to the display & to the iostream
-      cs_initiator_instances[i].measurement_arrived = false;
 
 #ifdef LOG_ENABLED
       log_info(APP_INSTANCE_PREFIX "# %04lu --- Ranging Counter = %04lu" NL,
@@ -352,10 +421,9 @@ void app_process_action(void)
                                        rtl_config.algo_mode,
                                        initiator_config.cs_main_mode);
 #endif
-    } else if (cs_initiator_instances[i].measurement_progress_changed) {
+    } else {
       // write measurement progress to the display without changing the last valid
       // measurement results
-      cs_initiator_instances[i].measurement_progress_changed = false;
       log_info(APP_INSTANCE_PREFIX "# %04lu ---" NL,
                cs_initiator_instances[i].measurement_progress.connection,
                cs_initiator_instances[i].measurement_cnt);
@@ -378,17 +446,326 @@ void app_process_action(void)
                                        initiator_config.cs_main_mode);
     }
   }
+  // One gate decision over all reflectors measured in this pass
+  gate_evaluate();
+  for (uint32_t i = 0u; i < CS_INITIATOR_MAX_CONNECTIONS; i++) {
+    if ((decided & (1u << i)) != 0u) {
+      (void)cs_initiator_mark_gate_decision(cs_initiator_instances[i].conn_handle);
+    }
+  }
+  if (measured) {
+    update_procedure_rates();
+  }
+  update_power_level();
+#if LATENCY_REPORT
+  report_latency();
+#endif
+#if POWER_REPORT
+  report_power();
+#endif
 
   /////////////////////////////////////////////////////////////////////////////
   // Put your additional application code here!                              //
   // This is called infinitely.                                              //
   // Do not call blocking functions from here!                               //
   /////////////////////////////////////////////////////////////////////////////
+  dlog_flush();
+  // Gate parameters changed over GATT, once the writes have stopped
+  gate_config_process();
 }
 
 // -----------------------------------------------------------------------------
 // Static function definitions
 
+/******************************************************************************
+ * Slow down the procedures of reflectors that stand still or are far away
+ *****************************************************************************/
+static void update_procedure_rates(void)
+{
+  uint32_t now_ms = sl_sleeptimer_tick_to_ms(sl_sleeptimer_get_tick_count());
+
+  for (uint8_t i = 0u; i < CS_INITIATOR_MAX_CONNECTIONS; i++) {
+    if (cs_initiator_instances[i].conn_handle == SL_BT_INVALID_CONNECTION_HANDLE
+        || cs_initiator_instances[i].fast_procedure_interval == 0u) {
+      continue;
+    }
+    proc_rate_t rate = proc_sched_update(i, gate_arbiter_get_track(i), now_ms);
+    if (rate == cs_initiator_instances[i].proc_rate) {
+      continue;
+    }
+    set_instance_intervals(i, rate);
+  }
+}
+
+/******************************************************************************
+ * Request the procedure and connection intervals of an instance for its
+ * procedure rate and the power level
+ *****************************************************************************/
+static void set_instance_intervals(uint8_t instance_num, proc_rate_t rate)
+{
+  power_level_t level = power_policy_level();
+  uint8_t conn_handle = cs_initiator_instances[instance_num].conn_handle;
+  uint32_t interval = proc_sched_interval(rate, cs_initiator_instances[instance_num].fast_procedure_interval);
+
+  interval *= power_policy_procedure_factor(level);
+  if (interval > UINT16_MAX) {
+    interval = UINT16_MAX;
+  }
+  sl_status_t sc = cs_initiator_set_procedure_interval(conn_handle, (uint16_t)interval);
+  if (sc != SL_STATUS_OK) {
+    log_error(APP_INSTANCE_PREFIX "Failed to set procedure interval %lu, "
+                                  "error:0x%lx" NL,
+              conn_handle,
+              interval,
+              sc);
+    return;
+  }
+  sc = cs_initiator_set_connection_interval_factor(conn_handle,
+                                                   power_policy_connection_factor(level));
+  if (sc != SL_STATUS_OK) {
+    log_error(APP_INSTANCE_PREFIX "Failed to stretch connection interval, "
+                                  "error:0x%lx" NL,
+              conn_handle,
+              sc);
+  }
+  log_info(APP_INSTANCE_PREFIX "Procedure rate: %s (interval %lu, connection x%u)" NL,
+           conn_handle,
+           (rate == PROC_RATE_SLOW) ? "slow" : "fast",
+           interval,
+           power_policy_connection_factor(level));
+  cs_initiator_instances[instance_num].proc_rate = (uint8_t)rate;
+}
+
+/******************************************************************************
+ * Choose the power level from the reflectors and the gate, and stretch the
+ * intervals and the heartbeat when it changes
+ *****************************************************************************/
+static void update_power_level(void)
+{
+  power_policy_input_t input = {
+    .reflectors = 0u,
+    .fast_reflectors = 0u,
+    .red_zone = gate_arbiter_red_zone_occupied(),
+    .gate_idle = gate_idle()
+  };
+  power_level_t previous = power_policy_level();
+  power_level_t level;
+
+  for (uint8_t i = 0u; i < CS_INITIATOR_MAX_CONNECTIONS; i++) {
+    if (cs_initiator_instances[i].conn_handle == SL_BT_INVALID_CONNECTION_HANDLE) {
+      continue;
+    }
+    input.reflectors++;
+    if (cs_initiator_instances[i].proc_rate == (uint8_t)PROC_RATE_FAST) {
+      input.fast_reflectors++;
+    }
+  }
+  level = power_policy_update(&input, sl_sleeptimer_tick_to_ms(sl_sleeptimer_get_tick_count()));
+  if (level == previous) {
+    return;
+  }
+  log_info(APP_PREFIX "Power level: %s" NL, power_policy_level_name(level));
+  set_heartbeat_period(power_policy_heartbeat_ms(level));
+  for (uint8_t i = 0u; i < CS_INITIATOR_MAX_CONNECTIONS; i++) {
+    if (cs_initiator_instances[i].conn_handle == SL_BT_INVALID_CONNECTION_HANDLE
+        || cs_initiator_instances[i].fast_procedure_interval == 0u) {
+      continue;
+    }
+    set_instance_intervals(i, (proc_rate_t)cs_initiator_instances[i].proc_rate);
+  }
+}
+
+/******************************************************************************
+ * Change the LED off time of the heartbeat, used from the next flash on
+ *****************************************************************************/
+static void set_heartbeat_period(uint32_t period_ms)
+{
+  heartbeat_period_ms = period_ms;
+}
+
+#if REFLECTOR_CACHE_ENABLE
+/******************************************************************************
+ * Hand the cached RAS attributes of a known reflector to its new initiator
+ * instance, the RAS discovery is skipped then
+ *****************************************************************************/
+static void use_cached_attributes(uint8_t conn_handle, uint8_t num_antennas)
+{
+  reflector_cache_entry_t entry;
+  reflector_cache_check_t check;
+  sl_status_t sc;
+
+  check = reflector_cache_lookup(conn_handle, num_antennas, &entry);
+  if (check != REFLECTOR_CACHE_OK) {
+    log_info(APP_INSTANCE_PREFIX "RAS attributes not cached: %s" NL,
+             conn_handle,
+             reflector_cache_check_name(check));
+    return;
+  }
+  sc = cs_initiator_set_ras_attributes(conn_handle, &entry.handles, entry.ras_features);
+  if (sc != SL_STATUS_OK) {
+    log_error(APP_INSTANCE_PREFIX "Failed to use the cached RAS attributes, "
+                                  "error:0x%lx" NL,
+              conn_handle,
+              sc);
+    reflector_cache_reject(conn_handle);
+    return;
+  }
+  log_info(APP_INSTANCE_PREFIX "Using cached RAS attributes, features 0x%lx, MTU %u" NL,
+           conn_handle,
+           (unsigned long)entry.ras_features,
+           entry.mtu);
+}
+
+/******************************************************************************
+ * Save the attributes of a reflector after its first measurement
+ *****************************************************************************/
+static void save_cached_attributes(uint8_t instance_num)
+{
+  uint8_t conn_handle = cs_initiator_instances[instance_num].conn_handle;
+  reflector_cache_entry_t entry = { 0 };
+  sl_status_t sc;
+
+  sc = cs_initiator_get_ras_attributes(conn_handle, &entry.handles, &entry.ras_features);
+  if (sc == SL_STATUS_OK) {
+    sc = sl_bt_gatt_server_get_mtu(conn_handle, &entry.mtu);
+  }
+  if (sc == SL_STATUS_OK) {
+    entry.num_antennas = cs_initiator_instances[instance_num].remote_num_antennas;
+    entry.connection_interval = initiator_config.max_connection_interval;
+    entry.procedure_interval = initiator_config.max_procedure_interval;
+    sc = reflector_cache_confirm(conn_handle, &entry);
+  }
+  if (sc != SL_STATUS_OK && sc != SL_STATUS_NOT_SUPPORTED) {
+    log_error(APP_INSTANCE_PREFIX "Failed to cache the RAS attributes, "
+                                  "error:0x%lx" NL,
+              conn_handle,
+              sc);
+  }
+}
+#endif // REFLECTOR_CACHE_ENABLE
+
+#if POWER_REPORT
+/******************************************************************************
+ * Current operating point for the current model
+ *****************************************************************************/
+static void get_power_plan(power_plan_t *plan)
+{
+  power_level_t level = power_policy_level();
+  uint16_t fast_interval = 0u;
+
+  plan->reflectors = 0u;
+  plan->fast_reflectors = 0u;
+  for (uint8_t i = 0u; i < CS_INITIATOR_MAX_CONNECTIONS; i++) {
+    if (cs_initiator_instances[i].conn_handle == SL_BT_INVALID_CONNECTION_HANDLE) {
+      continue;
+    }
+    plan->reflectors++;
+    if (cs_initiator_instances[i].proc_rate == (uint8_t)PROC_RATE_FAST) {
+      plan->fast_reflectors++;
+    }
+    if (cs_initiator_instances[i].fast_procedure_interval != 0u) {
+      fast_interval = cs_initiator_instances[i].fast_procedure_interval;
+    }
+  }
+  plan->connection_interval = initiator_config.max_connection_interval
+                              * power_policy_connection_factor(level);
+  plan->fast_procedure_interval = fast_interval;
+  plan->slow_procedure_interval = proc_sched_interval(PROC_RATE_SLOW, fast_interval)
+                                  * power_policy_procedure_factor(level);
+  plan->heartbeat_ms = power_policy_heartbeat_ms(level);
+  // The scanner runs until every connection slot is used
+  plan->scan_duty = (num_reflector_connections < CS_INITIATOR_MAX_CONNECTIONS)
+                    ? ((float)BLE_PEER_MANAGER_CENTRAL_CONFIG_DEFAULT_SCAN_WINDOW
+                       / (float)BLE_PEER_MANAGER_CENTRAL_CONFIG_DEFAULT_SCAN_INTERVAL)
+                    : 0.f;
+  plan->cpu_fraction = -1.f;
+}
+
+/******************************************************************************
+ * Print the energy mode residency and the current estimates every
+ * POWER_REPORT_PERIOD_MS
+ *****************************************************************************/
+static void report_power(void)
+{
+  uint32_t now = sl_sleeptimer_get_tick_count();
+  power_residency_t residency;
+  power_plan_t plan;
+  float modeled_ua;
+  char line[160];
+  int len;
+
+  if ((now - power_report_tick) < sl_sleeptimer_ms_to_tick(POWER_REPORT_PERIOD_MS)) {
+    return;
+  }
+  power_report_tick = now;
+
+  power_monitor_collect(&residency);
+  if (residency.window_ms == 0u) {
+    return;
+  }
+  get_power_plan(&plan);
+  modeled_ua = power_policy_estimate_ua(&plan);
+  plan.cpu_fraction = (float)(residency.window_ms - residency.em2_ms) / (float)residency.window_ms;
+  len = snprintf(line, sizeof(line), "EM2 %lu/%lu ms (%lu entries), EM0 us:",
+                 (unsigned long)residency.em2_ms,
+                 (unsigned long)residency.window_ms,
+                 (unsigned long)residency.em2_entries);
+  for (uint8_t i = 0u; i < POWER_SUBSYSTEM_COUNT && len < (int)sizeof(line); i++) {
+    len += snprintf(&line[len], sizeof(line) - (size_t)len, " %s %lu",
+                    power_monitor_subsystem_name((power_subsystem_t)i),
+                    (unsigned long)residency.active_us[i]);
+  }
+  log_info(APP_PREFIX "Power %s: %s" NL, power_policy_level_name(power_policy_level()), line);
+  log_info(APP_PREFIX "Estimated current: %lu uA measured residency, %lu uA model" NL,
+           (unsigned long)power_policy_estimate_ua(&plan),
+           (unsigned long)modeled_ua);
+}
+#endif
+
+#if LATENCY_REPORT
+/******************************************************************************
+ * Print the pipeline latency histograms every LATENCY_REPORT_PERIOD_MS
+ *****************************************************************************/
+static void report_latency(void)
+{
+  uint32_t now = sl_sleeptimer_get_tick_count();
+  cs_initiator_latency_histogram_t histogram;
+  char line[160];
+  int len;
+
+  if ((now - latency_report_tick) < sl_sleeptimer_ms_to_tick(LATENCY_REPORT_PERIOD_MS)) {
+    return;
+  }
+  latency_report_tick = now;
+
+  len = snprintf(line, sizeof(line), "buckets [ms]:");
+  for (uint8_t b = 0u; b < CS_INITIATOR_LATENCY_BUCKET_COUNT - 1u && len < (int)sizeof(line); b++) {
+    len += snprintf(&line[len], sizeof(line) - (size_t)len, " <%lu",
+                    (unsigned long)(cs_initiator_latency_bucket_limit_us(b) / 1000u));
+  }
+  log_info(APP_PREFIX "CS pipeline latency from the procedure start, %lu incomplete, %s more" NL,
+           (unsigned long)cs_initiator_latency_get_incomplete(),
+           line);
+  for (uint8_t s = 0u; s < CS_INITIATOR_LATENCY_STAGE_COUNT; s++) {
+    if (!cs_initiator_latency_get((cs_initiator_latency_stage_t)s, &histogram)
+        || histogram.count == 0u) {
+      continue;
+    }
+    len = snprintf(line, sizeof(line), "%-17s n:%lu mean:%lu min:%lu max:%lu us |",
+                   cs_initiator_latency_stage_name((cs_initiator_latency_stage_t)s),
+                   (unsigned long)histogram.count,
+                   (unsigned long)(histogram.sum_us / histogram.count),
+                   (unsigned long)histogram.min_us,
+                   (unsigned long)histogram.max_us);
+    for (uint8_t b = 0u; b < CS_INITIATOR_LATENCY_BUCKET_COUNT && len < (int)sizeof(line); b++) {
+      len += snprintf(&line[len], sizeof(line) - (size_t)len, " %lu",
+                      (unsigned long)histogram.bucket[b]);
+    }
+    log_info(APP_PREFIX "%s" NL, line);
+  }
+}
+#endif
+
 static void app_timer_callback(app_timer_t *timer, void *data)
 {
   (void)timer;
@@ -609,15 +986,97 @@ static void cs_on_result(const uint8_t conn_handle,
                 conn_handle,
                 sc);
     }
-    cs_initiator_instances[initiator_num].measurement_arrived = true;
     cs_initiator_instances[initiator_num].measurement_cnt++;
     cs_initiator_instances[initiator_num].ranging_counter = ranging_counter;
+    queue_measurement(initiator_num, false);
   } else {
     log_error(APP_INSTANCE_PREFIX "Null result reference!" NL,
               conn_handle);
   }
 }
 
+/******************************************************************************
+ * Take over typed measurement results
+ *****************************************************************************/
+static void cs_on_result_fields(const uint8_t conn_handle,
+                                const uint16_t ranging_counter,
+                                const cs_result_fields_t *result,
+                                const cs_ranging_data_t *ranging_data,
+                                const void *user_data)
+{
+  (void)ranging_data;
+  (void)user_data;
+  uint8_t initiator_num;
+  cs_initiator_instances_t *instance;
+
+  sl_status_t sc = get_instance_number(conn_handle, &initiator_num);
+  if (sc != SL_STATUS_OK) {
+    log_error(APP_INSTANCE_PREFIX "Failed to get instance number for connection! [sc: 0x%lx]" NL,
+              conn_handle,
+              sc);
+    return;
+  }
+  instance = &cs_initiator_instances[initiator_num];
+
+  // Fields not provided by the estimator keep their previous value
+  if (cs_result_field_is_valid(result, CS_RESULT_FIELD_DISTANCE_MAINMODE)) {
+    instance->measurement_mainmode.distance_filtered = result->distance_mainmode;
+  }
+  if (cs_result_field_is_valid(result, CS_RESULT_FIELD_DISTANCE_SUBMODE)) {
+    instance->measurement_submode.distance_filtered = result->distance_submode;
+  }
+  if (cs_result_field_is_valid(result, CS_RESULT_FIELD_DISTANCE_RAW_MAINMODE)) {
+    instance->measurement_mainmode.distance_raw = result->distance_raw_mainmode;
+  }
+  if (cs_result_field_is_valid(result, CS_RESULT_FIELD_DISTANCE_RAW_SUBMODE)) {
+    instance->measurement_submode.distance_raw = result->distance_raw_submode;
+  }
+  if (cs_result_field_is_valid(result, CS_RESULT_FIELD_LIKELINESS_MAINMODE)) {
+    instance->measurement_mainmode.likeliness = result->likeliness_mainmode;
+  }
+  if (cs_result_field_is_valid(result, CS_RESULT_FIELD_LIKELINESS_SUBMODE)) {
+    instance->measurement_submode.likeliness = result->likeliness_submode;
+  }
+  if (cs_result_field_is_valid(result, CS_RESULT_FIELD_VELOCITY_MAINMODE)) {
+    instance->measurement_mainmode.velocity = result->velocity_mainmode;
+  }
+  if (cs_result_field_is_valid(result, CS_RESULT_FIELD_BIT_ERROR_RATE)) {
+    instance->measurement_mainmode.bit_error_rate = result->bit_error_rate;
+  }
+  if (cs_result_field_is_valid(result, CS_RESULT_FIELD_DISTANCE_RSSI)) {
+    instance->measurement_mainmode.distance_estimate_rssi = result->distance_rssi;
+  }
+  instance->measurement_cnt++;
+  instance->ranging_counter = ranging_counter;
+  queue_measurement(initiator_num, false);
+}
+
+/******************************************************************************
+ * Queue the latest measurement of an instance for app_process_action()
+ *****************************************************************************/
+static void queue_measurement(uint8_t instance_num, bool progress)
+{
+  cs_measurement_event_t evt;
+  sl_status_t sc;
+
+  evt.instance = instance_num;
+  evt.conn_handle = cs_initiator_instances[instance_num].conn_handle;
+  evt.progress = progress;
+  evt.ranging_counter = (uint16_t)cs_initiator_instances[instance_num].ranging_counter;
+  evt.mainmode = cs_initiator_instances[instance_num].measurement_mainmode;
+  evt.submode = cs_initiator_instances[instance_num].measurement_submode;
+
+  // Keep the queued results, the newest one is dropped on overflow
+  sc = app_queue_add(&measurement_queue, (uint8_t *)&evt);
+  if (sc != SL_STATUS_OK) {
+    measurement_drop_cnt++;
+    log_error(APP_INSTANCE_PREFIX "Measurement queue full, %lu results dropped [sc: 0x%lx]" NL,
+              evt.conn_handle,
+              measurement_drop_cnt,
+              sc);
+  }
+}
+
 /******************************************************************************
  * Extract intermediate results between measurement results
  * Note: only called when stationary object tracking used
@@ -636,7 +1095,7 @@ static void cs_on_intermediate_result(const cs_intermediate_result_t * intermedi
     memcpy(&cs_initiator_instances[instance_num].measurement_progress,
            intermediate_result,
            sizeof(cs_intermediate_result_t));
-    cs_initiator_instances[instance_num].measurement_progress_changed = true;
+    queue_measurement(instance_num, true);
   }
 }
 
@@ -700,6 +1159,12 @@ static sl_status_t create_new_initiator_instance(uint8_t conn_handle)
       log_info(APP_INSTANCE_PREFIX "Init measure" " %d" NL, i);
       init_measure(i);
 
+      // Free running procedures start at the optimized rate
+      cs_initiator_instances[i].proc_rate = (uint8_t)PROC_RATE_FAST;
+      cs_initiator_instances[i].fast_procedure_interval =
+        (initiator_config.max_procedure_count == 0u) ? initiator_config.max_procedure_interval : 0u;
+      proc_sched_reset((uint8_t)i, sl_sleeptimer_tick_to_ms(sl_sleeptimer_get_tick_count()));
+
       break;
     }
   }
@@ -718,6 +1183,16 @@ static sl_status_t create_new_initiator_instance(uint8_t conn_handle)
               conn_handle,
               sc);
     (void)ble_peer_manager_central_close_connection(conn_handle);
+    return sc;
+  }
+  // Get the results as typed fields instead of the TLV result buffer
+  sc = cs_initiator_set_result_fields_cb(conn_handle, cs_on_result_fields);
+  if (sc != SL_STATUS_OK) {
+    log_error(APP_INSTANCE_PREFIX "Failed to select typed results, "
+                                  "using the result buffer. error:0x%lx" NL,
+              conn_handle,
+              sc);
+    sc = SL_STATUS_OK;
   }
   return sc;
 }
@@ -734,9 +1209,8 @@ static void delete_initiator_instance(uint8_t conn_handle)
       memset(&cs_initiator_instances[i].measurement_mainmode, 0u, sizeof(cs_measurement_data_t));
       memset(&cs_initiator_instances[i].measurement_submode, 0u, sizeof(cs_measurement_data_t));
       memset(&cs_initiator_instances[i].measurement_progress, 0u, sizeof(cs_intermediate_result_t));
-      cs_initiator_instances[i].measurement_arrived = false;
-      cs_initiator_instances[i].measurement_progress_changed = false;
       cs_initiator_instances[i].read_remote_capabilities = false;
+      release_measure((uint8_t)i);
       num_reflector_connections--;
       break;
     }
@@ -825,6 +1299,9 @@ static void cs_on_error(uint8_t conn_handle, cs_error_event_t err_evt, sl_status
       } else if (err_evt == CS_ERROR_EVENT_INITIATOR_FAILED_TO_INCREASE_SECURITY) {
         log_error(APP_INSTANCE_PREFIX "Security level increase failed." NL, conn_handle);
       }
+      // A connection set up from cached RAS attributes that fails before
+      // its first result discovers again next time
+      reflector_cache_reject(conn_handle);
       // Close the connection
       (void)ble_peer_manager_central_close_connection(conn_handle);
       break;
@@ -955,6 +1432,12 @@ void sl_bt_on_event(sl_bt_msg_t * evt)
       ble_peer_manager_central_init();
       ble_peer_manager_filter_init();
       cs_initiator_init();
+      reflector_cache_init();
+#if REFLECTOR_CACHE_ENABLE
+      // Reflector attributes may only be kept across connections when bonded
+      sc = sl_bt_sm_set_bondable_mode(1);
+      app_assert_status(sc);
+#endif
 
       // Print the Bluetooth address
       bd_addr address;
@@ -997,7 +1480,22 @@ void sl_bt_on_event(sl_bt_msg_t * evt)
       break;
     }
 
+    case sl_bt_evt_connection_opened_id:
+      if (evt->data.evt_connection_opened.role == sl_bt_connection_role_central) {
+        reflector_cache_opened(evt->data.evt_connection_opened.connection,
+                               &evt->data.evt_connection_opened.address,
+                               evt->data.evt_connection_opened.address_type,
+                               evt->data.evt_connection_opened.bonding);
+      }
+      break;
+
+    case sl_bt_evt_sm_bonded_id:
+      reflector_cache_bonded(evt->data.evt_sm_bonded.connection,
+                             evt->data.evt_sm_bonded.bonding);
+      break;
+
     case sl_bt_evt_connection_closed_id:
+      reflector_cache_closed(evt->data.evt_connection_closed.connection);
       //Start OTA advertising
       ota_adv(true);
       break;
@@ -1111,6 +1609,11 @@ void sl_bt_on_event(sl_bt_msg_t * evt)
         return;
       }
       cs_initiator_instances[instance_num].read_remote_capabilities = true;
+      cs_initiator_instances[instance_num].remote_num_antennas =
+        evt->data.evt_cs_read_remote_supported_capabilities_complete.num_antennas;
+#if REFLECTOR_CACHE_ENABLE
+      use_cached_attributes(connection, cs_initiator_instances[instance_num].remote_num_antennas);
+#endif
       // Scan for new reflector connections if we have room for more
       if (num_reflector_connections < CS_INITIATOR_MAX_CONNECTIONS) {
         sc = ble_peer_manager_central_create_connection();
@@ -1182,3 +1685,15 @@ void ble_peer_manager_on_event_initiator(ble_peer_manager_evt_type_t * event)
       break;
   }
 }
+
+/******************************************************************************
+ * Free initiator instances, for the scan aggregation window of the peer
+ * manager
+ *****************************************************************************/
+uint8_t ble_peer_manager_central_free_slots(void)
+{
+  if (num_reflector_connections >= CS_INITIATOR_MAX_CONNECTIONS) {
+    return 0u;
+  }
+  return (uint8_t)(CS_INITIATOR_MAX_CONNECTIONS - num_reflector_connections);
+}
@@ -64,12 +64,23 @@ typedef struct {
   cs_measurement_data_t measurement_mainmode;
   cs_measurement_data_t measurement_submode;
   cs_intermediate_result_t measurement_progress;
-  bool measurement_arrived;
-  bool measurement_progress_changed;
   bool read_remote_capabilities;
   uint8_t number_of_measurements;
+  uint8_t proc_rate;                // proc_rate_t currently requested
+  uint16_t fast_procedure_interval; // Interval selected at connection time
+  uint8_t remote_num_antennas;      // From the remote CS capabilities
 } cs_initiator_instances_t;
 
+// Measurement event queued by the CS callbacks for app_process_action()
+typedef struct {
+  uint8_t instance;
+  uint8_t conn_handle;
+  bool progress;                    // Intermediate result, no measurement
+  uint16_t ranging_counter;
+  cs_measurement_data_t mainmode;
+  cs_measurement_data_t submode;
+} cs_measurement_event_t;
+
 #define BOARD_EVB
 
 /**************************************************************************//**
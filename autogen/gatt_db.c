@@ -29,9 +29,11 @@ GATT_DATA(const uint8_t gattdb_uuidtable_128_map[]) =
   0xb2, 0x80, 0x04, 0xd0, 0xa6, 0xd6, 0xe1, 0x90, 0xb4, 0x45, 0x6c, 0x27, 0x68, 0x18, 0x5c, 0x38, 
   0xb0, 0x49, 0xe0, 0x70, 0x44, 0x74, 0x50, 0xb8, 0x6e, 0x41, 0x8d, 0x5c, 0xef, 0xb4, 0xdd, 0x7c, 
   0x01, 0x20, 0xdd, 0x53, 0xf9, 0xf9, 0x5c, 0xb5, 0xe6, 0x47, 0x36, 0x31, 0x06, 0x49, 0x67, 0xb4, 
+  0x94, 0x39, 0x2f, 0x60, 0x6d, 0x0a, 0xaf, 0xa6, 0xad, 0x4a, 0x80, 0x76, 0x9f, 0xb6, 0xbf, 0xca, 
+  0x90, 0x4b, 0xd8, 0x27, 0x1f, 0x3a, 0x6e, 0x9c, 0x2b, 0x4d, 0x41, 0x8f, 0x3a, 0x7c, 0x0b, 0x5e, 
   0x63, 0x60, 0x32, 0xe0, 0x37, 0x5e, 0xa4, 0x88, 0x53, 0x4e, 0x6d, 0xfb, 0x64, 0x35, 0xbf, 0xf7, 
 };
-GATT_DATA(const sli_bt_gattdb_value_t gattdb_attribute_field_29) = {
+GATT_DATA(const sli_bt_gattdb_value_t gattdb_attribute_field_33) = {
   .len = 16,
   .data = { 0xf0, 0x19, 0x21, 0xb4, 0x47, 0x8f, 0xa4, 0xbf, 0xa1, 0x4f, 0x63, 0xfd, 0xee, 0xd6, 0x14, 0x1d, }
 };
@@ -115,21 +117,25 @@ GATT_DATA(const sli_bt_gattdb_attribute_t gattdb_attributes_map[]) = {
   { .handle = 0x1b, .uuid = 0x8003, .permissions = 0x803, .caps = 0xffff, .state = 0x00, .datatype = 0x07, .dynamicdata = NULL },
   { .handle = 0x1c, .uuid = 0x0002, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x05, .characteristic = { .properties = 0x08, .char_uuid = 0x8004 } },
   { .handle = 0x1d, .uuid = 0x8004, .permissions = 0x802, .caps = 0xffff, .state = 0x00, .datatype = 0x07, .dynamicdata = NULL },
-  { .handle = 0x1e, .uuid = 0x0000, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x00, .constdata = &gattdb_attribute_field_29 },
-  { .handle = 0x1f, .uuid = 0x0002, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x05, .characteristic = { .properties = 0x08, .char_uuid = 0x8005 } },
-  { .handle = 0x20, .uuid = 0x8005, .permissions = 0x802, .caps = 0xffff, .state = 0x00, .datatype = 0x07, .dynamicdata = NULL },
+  { .handle = 0x1e, .uuid = 0x0002, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x05, .characteristic = { .properties = 0x0a, .char_uuid = 0x8005 } },
+  { .handle = 0x1f, .uuid = 0x8005, .permissions = 0x803, .caps = 0xffff, .state = 0x00, .datatype = 0x07, .dynamicdata = NULL },
+  { .handle = 0x20, .uuid = 0x0002, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x05, .characteristic = { .properties = 0x02, .char_uuid = 0x8006 } },
+  { .handle = 0x21, .uuid = 0x8006, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x07, .dynamicdata = NULL },
+  { .handle = 0x22, .uuid = 0x0000, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x00, .constdata = &gattdb_attribute_field_33 },
+  { .handle = 0x23, .uuid = 0x0002, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x05, .characteristic = { .properties = 0x08, .char_uuid = 0x8007 } },
+  { .handle = 0x24, .uuid = 0x8007, .permissions = 0x802, .caps = 0xffff, .state = 0x00, .datatype = 0x07, .dynamicdata = NULL },
 };
 
 GATT_HEADER(const sli_bt_gattdb_t gattdb) = {
   .attributes = gattdb_attributes_map,
-  .attribute_table_size = 32,
-  .attribute_num = 32,
+  .attribute_table_size = 36,
+  .attribute_num = 36,
   .uuid16 = gattdb_uuidtable_16_map,
   .uuid16_table_size = 11,
   .uuid16_num = 11,
   .uuid128 = gattdb_uuidtable_128_map,
-  .uuid128_table_size = 6,
-  .uuid128_num = 6,
+  .uuid128_table_size = 8,
+  .uuid128_num = 8,
   .num_ccfg = 1,
   .caps_mask = 0xffff,
   .enabled_caps = 0xffff,
@@ -22,8 +22,10 @@ extern const sli_bt_gattdb_t gattdb;
 #define gattdb_CLOSE_TIME                     25
 #define gattdb_MOVING_THRESHOLD               27
 #define gattdb_RESET                          29
-#define gattdb_ota                            30
-#define gattdb_ota_control                    32
+#define gattdb_GATE_CONFIG                    31
+#define gattdb_LATENCY_HISTOGRAM              33
+#define gattdb_ota                            34
+#define gattdb_ota_control                    36
 
 #define gattdb_generic_attribute_len          2
 #define gattdb_service_changed_char_len       4
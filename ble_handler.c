@@ -1,84 +1,275 @@
+#include <string.h>
 #include "sl_status.h"
+#include "em_assert.h"
 #include "sl_bgapi.h"
 #include "sl_bt_api_compatibility.h"
 #include "sl_bt_api.h"
-#include "config/token.h"
 #include "autogen/gatt_db.h"
 #include "cmsis_nvic_virtual.h"
+#include "gate_config.h"
+#include "cs_initiator_latency.h"
 
 
-extern uint32_t BASELINE_WEIGHT;
-extern uint32_t MOVING_THRESHOLD_MM;
-extern uint32_t OPEN_BLOCK_DELAY_MS;
-extern uint32_t CLOSE_BLOCK_DELAY_MS;
+/* The 1-byte characteristics carry decimetres and seconds, the record
+ * millimetres and milliseconds. Reads saturate at 255. */
+static uint8_t to_byte(uint32_t value, uint32_t unit)
+{
+   value /= unit;
+   return (value > 255u) ? 255u : (uint8_t)value;
+}
 
-void write_characteristic(sl_bt_evt_gatt_server_user_write_request_t * request)
+/* Long write of gattdb_GATE_CONFIG, collected until the execute write */
+static uint8_t staged[GATE_CONFIG_TLV_SIZE];
+static uint16_t staged_len;
+static uint8_t staged_connection = SL_BT_INVALID_CONNECTION_HANDLE;
+
+/* Latency Histograms readout, little-endian:
+ *   header  format version, stage count, bucket count, 0 (1 byte each),
+ *           incomplete procedures (4 bytes), upper limit of every bucket
+ *           but the last in microseconds (4 bytes each)
+ *   stage   count, min, max and mean in microseconds (4 bytes each), then
+ *           the procedures per bucket saturated at 65535 (2 bytes each)
+ * min, max and mean are 0 for a stage without procedures. */
+#define LATENCY_FORMAT_VERSION  1
+#define LATENCY_HEADER_SIZE     (8 + 4 * (CS_INITIATOR_LATENCY_BUCKET_COUNT - 1))
+#define LATENCY_STAGE_SIZE      (16 + 2 * CS_INITIATOR_LATENCY_BUCKET_COUNT)
+#define LATENCY_READOUT_SIZE    (LATENCY_HEADER_SIZE \
+                                 + CS_INITIATOR_LATENCY_STAGE_COUNT * LATENCY_STAGE_SIZE)
+
+/* A long read is served from the copy taken at its first part, so results
+ * delivered between the Read Blobs do not tear it */
+static uint8_t latency_readout[LATENCY_READOUT_SIZE];
+static uint8_t latency_connection = SL_BT_INVALID_CONNECTION_HANDLE;
+
+static uint16_t put_u32(uint8_t *buf, uint16_t pos, uint32_t value)
 {
-   sl_status_t sc = SL_STATUS_OK;
-   nvm3_ObjectKey_t key = NVM3KEY_DEVICE_MOVING_THRESHOLD;
-   EFM_ASSERT(request->value.len == 1);
+   for (uint8_t n = 0; n < 4; n++)
+     buf[pos++] = (uint8_t)(value >> (8u * n));
+   return pos;
+}
+
+static void encode_latency(uint8_t *buf)
+{
+   cs_initiator_latency_histogram_t histogram;
+   uint16_t pos = 0;
+
+   buf[pos++] = LATENCY_FORMAT_VERSION;
+   buf[pos++] = CS_INITIATOR_LATENCY_STAGE_COUNT;
+   buf[pos++] = CS_INITIATOR_LATENCY_BUCKET_COUNT;
+   buf[pos++] = 0;
+   pos = put_u32(buf, pos, cs_initiator_latency_get_incomplete());
+   for (uint8_t b = 0; b < CS_INITIATOR_LATENCY_BUCKET_COUNT - 1; b++)
+     pos = put_u32(buf, pos, cs_initiator_latency_bucket_limit_us(b));
+
+   for (uint8_t s = 0; s < CS_INITIATOR_LATENCY_STAGE_COUNT; s++)
+   {
+     if (!cs_initiator_latency_get((cs_initiator_latency_stage_t)s, &histogram)
+         || histogram.count == 0)
+       memset(&histogram, 0, sizeof(histogram));
+     pos = put_u32(buf, pos, histogram.count);
+     pos = put_u32(buf, pos, histogram.min_us);
+     pos = put_u32(buf, pos, histogram.max_us);
+     pos = put_u32(buf, pos, (histogram.count == 0) ? 0
+                   : (uint32_t)(histogram.sum_us / histogram.count));
+     for (uint8_t b = 0; b < CS_INITIATOR_LATENCY_BUCKET_COUNT; b++)
+     {
+       uint32_t n = (histogram.bucket[b] > 0xffffu) ? 0xffffu : histogram.bucket[b];
+
+       buf[pos++] = (uint8_t)n;
+       buf[pos++] = (uint8_t)(n >> 8);
+     }
+   }
+   EFM_ASSERT(pos == LATENCY_READOUT_SIZE);
+}
+
+/* Apply a TLV payload as a whole, returns the ATT error */
+static uint8_t write_config(const uint8_t *data, uint16_t len)
+{
+   gate_config_t config = *gate_config_get();
+
+   if (gate_config_decode(data, len, &config) != SL_STATUS_OK)
+     return (uint8_t)SL_STATUS_BT_ATT_VALUE_NOT_ALLOWED;
+   if (gate_config_set(&config) != SL_STATUS_OK)
+     return (uint8_t)SL_STATUS_BT_ATT_OUT_OF_RANGE;
+   return (uint8_t)SL_STATUS_OK;
+}
+
+/* Prepare write, the parts must arrive in order */
+static uint8_t stage_config(sl_bt_evt_gatt_server_user_write_request_t * request)
+{
+   if (request->characteristic != gattdb_GATE_CONFIG)
+     return (uint8_t)SL_STATUS_BT_ATT_ATT_NOT_LONG;
+
+   /* First part, a long write that was never executed is dropped */
+   if (request->offset == 0)
+   {
+     staged_len = 0;
+     staged_connection = request->connection;
+   }
+   if (request->connection != staged_connection || request->offset != staged_len)
+     return (uint8_t)SL_STATUS_BT_ATT_INVALID_OFFSET;
+   if (request->value.len > sizeof(staged) - staged_len)
+     return (uint8_t)SL_STATUS_BT_ATT_INVALID_ATT_LENGTH;
+
+   memcpy(&staged[staged_len], request->value.data, request->value.len);
+   staged_len += request->value.len;
+   return (uint8_t)SL_STATUS_OK;
+}
+
+/* 1-byte characteristics of the first layout */
+static uint8_t write_byte(sl_bt_evt_gatt_server_user_write_request_t * request)
+{
+   gate_config_t config = *gate_config_get();
+   uint8_t data;
 
+   if (request->value.len != 1)
+     return (uint8_t)SL_STATUS_BT_ATT_INVALID_ATT_LENGTH;
+
+   data = request->value.data[0];
    switch (request->characteristic)
    {
      case gattdb_BASELINE:
-       key = NVM3KEY_DEVICE_BASELINE_WEIGHT;
-       BASELINE_WEIGHT = (uint32_t)request->value.data;
+       config.baseline_weight = data;
        break;
      case gattdb_OPEN_TIME:
-       key = NVM3KEY_DEVICE_OPEN_TIME;
-       OPEN_BLOCK_DELAY_MS = (uint32_t)request->value.data * 1000;
+       config.open_block_ms = (uint32_t)data * 1000;
        break;
      case gattdb_CLOSE_TIME:
-       key = NVM3KEY_DEVICE_CLOSE_TIME;
-       CLOSE_BLOCK_DELAY_MS = (uint32_t)request->value.data * 1000;
+       config.close_block_ms = (uint32_t)data * 1000;
        break;
      case gattdb_RESET:
+       /* Changes still waiting for the quiet period */
+       (void)gate_config_flush();
        NVIC_SystemReset();
        break;
      case gattdb_MOVING_THRESHOLD:
      default:
-       key = NVM3KEY_DEVICE_MOVING_THRESHOLD;
-       MOVING_THRESHOLD_MM = (uint32_t)request->value.data * 10 * 10;
+       config.moving_threshold_mm = (uint32_t)data * 10 * 10;
        break;
    }
 
-   nvm3_writeData(nvm3_defaultHandle, key, (const*)request->value.data, 1);
+   /* Applied now, written to NVM3 from the main loop once the writes stop */
+   if (gate_config_set(&config) != SL_STATUS_OK)
+     return (uint8_t)SL_STATUS_BT_ATT_OUT_OF_RANGE;
+   return (uint8_t)SL_STATUS_OK;
+}
+
+void write_characteristic(sl_bt_evt_gatt_server_user_write_request_t * request)
+{
+   sl_status_t sc = SL_STATUS_OK;
+   uint8_t att_error;
+
+   switch (request->att_opcode)
+   {
+     case sl_bt_gatt_prepare_write_request:
+       att_error = stage_config(request);
+       sc = sl_bt_gatt_server_send_user_prepare_write_response(
+          request->connection,
+          request->characteristic,
+          att_error,
+          request->offset,
+          request->value.len,
+          request->value.data);
+       EFM_ASSERT(sc == SL_STATUS_OK);
+       return;
+
+     case sl_bt_gatt_execute_write_request:
+       att_error = (uint8_t)SL_STATUS_OK;
+       if (request->connection == staged_connection)
+       {
+         att_error = write_config(staged, staged_len);
+         staged_len = 0;
+         staged_connection = SL_BT_INVALID_CONNECTION_HANDLE;
+       }
+       break;
+
+     default:
+       if (request->characteristic == gattdb_GATE_CONFIG)
+         att_error = write_config(request->value.data, request->value.len);
+       else
+         att_error = write_byte(request);
+       break;
+   }
 
     // Send response to user write request.
     sc = sl_bt_gatt_server_send_user_write_response(
       request->connection,
       request->characteristic,
-      (uint8_t)SL_STATUS_OK);
+      att_error);
 
     EFM_ASSERT(sc == SL_STATUS_OK);
 }
 
+/* Long reads come back with the offset of the next part */
+static void send_long_read(sl_bt_evt_gatt_server_user_read_request_t * request,
+                           const uint8_t *value, uint16_t len)
+{
+   sl_status_t sc;
+   uint16_t sent_len;
+
+   if (request->offset > len)
+     sc = sl_bt_gatt_server_send_user_read_response(
+        request->connection,
+        request->characteristic,
+        (uint8_t)SL_STATUS_BT_ATT_INVALID_OFFSET,
+        0,
+        NULL,
+        &sent_len);
+   else
+     sc = sl_bt_gatt_server_send_user_read_response(
+        request->connection,
+        request->characteristic,
+        (uint8_t)SL_STATUS_OK,
+        len - request->offset,
+        &value[request->offset],
+        &sent_len);
+   EFM_ASSERT(sc == SL_STATUS_OK);
+}
+
 void read_characteristic(sl_bt_evt_gatt_server_user_read_request_t * request)
 {
    sl_status_t sc = SL_STATUS_OK;
-   nvm3_ObjectKey_t key = NVM3KEY_DEVICE_MOVING_THRESHOLD;
+   const gate_config_t *config = gate_config_get();
    uint8_t data;
+   uint8_t tlv[GATE_CONFIG_TLV_SIZE];
+   uint16_t len;
    uint16_t sent_len;
 
+   if (request->characteristic == gattdb_GATE_CONFIG)
+   {
+     len = gate_config_encode(config, tlv, sizeof(tlv));
+     send_long_read(request, tlv, len);
+     return;
+   }
+
+   if (request->characteristic == gattdb_LATENCY_HISTOGRAM)
+   {
+     if (request->offset == 0 || request->connection != latency_connection)
+     {
+       encode_latency(latency_readout);
+       latency_connection = request->connection;
+     }
+     send_long_read(request, latency_readout, sizeof(latency_readout));
+     return;
+   }
+
    switch (request->characteristic)
    {
      case gattdb_BASELINE:
-       key = NVM3KEY_DEVICE_BASELINE_WEIGHT;
+       data = config->baseline_weight;
        break;
      case gattdb_OPEN_TIME:
-       key = NVM3KEY_DEVICE_OPEN_TIME;
+       data = to_byte(config->open_block_ms, 1000);
        break;
      case gattdb_CLOSE_TIME:
-       key = NVM3KEY_DEVICE_CLOSE_TIME;
+       data = to_byte(config->close_block_ms, 1000);
        break;
      case gattdb_MOVING_THRESHOLD:
      default:
-       key = NVM3KEY_DEVICE_MOVING_THRESHOLD;
+       data = to_byte(config->moving_threshold_mm, 10 * 10);
        break;
    }
 
-   nvm3_readData(nvm3_defaultHandle, key, &data, 1);
-
    sc = sl_bt_gatt_server_send_user_read_response(
       request->connection,
       request->characteristic,
@@ -55,6 +55,22 @@
 #define CS_INITIATOR_UART_LOG                 1
 #endif
 
+// <o LATENCY_REPORT_PERIOD_MS> Pipeline latency report period [msec] <0..3600000>
+// <i> Print the CS pipeline latency histograms to the console periodically.
+// <i> 0 disables the report. Needs CS_INITIATOR_LATENCY_STATS.
+// <i> Default: 60000
+#ifndef LATENCY_REPORT_PERIOD_MS
+#define LATENCY_REPORT_PERIOD_MS              60000
+#endif
+
+// <o POWER_REPORT_PERIOD_MS> Power report period [msec] <0..3600000>
+// <i> Print the energy mode residency per subsystem and the estimated
+// <i> average current to the console periodically. 0 disables the report.
+// <i> Default: 60000
+#ifndef POWER_REPORT_PERIOD_MS
+#define POWER_REPORT_PERIOD_MS                60000
+#endif
+
 // <<< end of configuration section >>>
 
 #endif // APP_CONFIG_H
@@ -82,6 +82,39 @@
 #define BLE_PEER_MANAGER_CENTRAL_CONFIG_DEFAULT_SCAN_WINDOW             16
 #endif
 
+// <o BLE_PEER_MANAGER_CENTRAL_CONFIG_SCAN_AGGREGATION_MS> Scan aggregation window <0..10000>
+// <i> Matching scan reports are collected for this time before the
+// <i> best ranked peer is connected. 0 connects to the first match.
+// <i> Also the time constant of the RSSI smoothing. Below about 2 s the
+// <i> RSSI trend is mostly noise and peers rank by proximity only.
+// <i> Default value: 2000 ms
+#ifndef BLE_PEER_MANAGER_CENTRAL_CONFIG_SCAN_AGGREGATION_MS
+#define BLE_PEER_MANAGER_CENTRAL_CONFIG_SCAN_AGGREGATION_MS             2000
+#endif
+
+// <o BLE_PEER_MANAGER_CENTRAL_CONFIG_MAX_CANDIDATES> Scan candidates <1..32>
+// <i> Peers ranked in one aggregation window
+// <i> Default value: 8
+#ifndef BLE_PEER_MANAGER_CENTRAL_CONFIG_MAX_CANDIDATES
+#define BLE_PEER_MANAGER_CENTRAL_CONFIG_MAX_CANDIDATES                  8
+#endif
+
+// <o BLE_PEER_MANAGER_CENTRAL_CONFIG_APPROACH_HORIZON_MS> Approach horizon <0..10000>
+// <i> Peers are ranked by the RSSI their trend predicts this far ahead,
+// <i> so an approaching peer goes before one standing still nearby.
+// <i> 0 ranks by the smoothed RSSI only.
+// <i> Default value: 2000 ms
+#ifndef BLE_PEER_MANAGER_CENTRAL_CONFIG_APPROACH_HORIZON_MS
+#define BLE_PEER_MANAGER_CENTRAL_CONFIG_APPROACH_HORIZON_MS             2000
+#endif
+
+// <o BLE_PEER_MANAGER_CENTRAL_CONFIG_MAX_RSSI_SLOPE> Max RSSI slope <1..100>
+// <i> Limit of the RSSI trend used for ranking, in dB/s
+// <i> Default value: 15 dB/s
+#ifndef BLE_PEER_MANAGER_CENTRAL_CONFIG_MAX_RSSI_SLOPE
+#define BLE_PEER_MANAGER_CENTRAL_CONFIG_MAX_RSSI_SLOPE                  15
+#endif
+
 // <<< end of configuration section >>>
 
 /** @} (end addtogroup ble_peer_manager_central) */
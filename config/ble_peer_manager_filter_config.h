@@ -42,6 +42,14 @@
 // <i> Default: 0
 #define BLE_PEER_MANAGER_FILTER_LOG                          1
 
+// <q BLE_PEER_MANAGER_FILTER_COMPILED> Compiled matcher
+// <i> Match the scan reports with a program compiled from the filter
+// <i> instead of checking every filter on every AD element.
+// <i> Default: 1
+#ifndef BLE_PEER_MANAGER_FILTER_COMPILED
+#define BLE_PEER_MANAGER_FILTER_COMPILED                     1
+#endif
+
 // <<< end of configuration section >>>
 
 /** @} (end addtogroup ble_peer_manager_filter) */
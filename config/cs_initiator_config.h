@@ -117,6 +117,19 @@
 #define CS_INITIATOR_MAX_RANGING_DATA_SIZE            (1866)
 #endif
 
+// <o CS_INITIATOR_RANGING_BUFFER_POOL_SIZE> Ranging buffer pool size <1..16>
+// <i> Number of "Maximum ranging data size" buffers shared by all initiator instances.
+// <i> An instance borrows an initiator buffer from its first CS result until the distance
+// <i> is calculated. The reflector buffer is borrowed for the whole connection in real-time
+// <i> RAS mode, and from the GET request until the calculation in on-demand mode.
+// <i> Procedures that find the pool empty are dropped. Twice the maximum initiator
+// <i> connections never runs out, real-time mode needs more than the maximum initiator
+// <i> connections.
+// <i> Default: CS_INITIATOR_MAX_CONNECTIONS + 2
+#ifndef CS_INITIATOR_RANGING_BUFFER_POOL_SIZE
+#define CS_INITIATOR_RANGING_BUFFER_POOL_SIZE         (CS_INITIATOR_MAX_CONNECTIONS + 2)
+#endif
+
 // <o CS_INITIATOR_MAX_DROP> Maximum dropped procedures <2..10>
 // <i> Maximum number of dropped procedures if current ranging data is not received.
 // <i> Default: 10
@@ -124,6 +137,42 @@
 #define CS_INITIATOR_MAX_DROP                         10
 #endif
 
+// <q CS_INITIATOR_LATENCY_STATS> Pipeline latency statistics
+// <i> Default: 1
+// <i> Timestamp the stages of every procedure, from the procedure start to the
+// <i> gate decision, with the DWT cycle counter and collect the time of each
+// <i> stage in a fixed bucket histogram. Read with cs_initiator_latency_get().
+#ifndef CS_INITIATOR_LATENCY_STATS
+#define CS_INITIATOR_LATENCY_STATS                    1
+#endif
+
+// <e CS_INITIATOR_CAPTURE> Binary procedure capture
+// <i> Default: 0
+// <i> Write the input of every RTL estimation (CS parameters, procedure
+// <i> configuration, step channels, initiator and reflector ranging data) and
+// <i> its result into an RTT up buffer as timestamped, length-prefixed records.
+// <i> Records that do not fit are dropped and counted, the capture never waits
+// <i> for the debugger. Turn off "Data logging" while capturing.
+#ifndef CS_INITIATOR_CAPTURE
+#define CS_INITIATOR_CAPTURE                          0
+#endif
+
+// <o CS_INITIATOR_CAPTURE_RTT_BUFFER_INDEX> RTT up buffer index <1..8>
+// <i> Default: 5
+// <i> Must not be used by another component, see sl_rtt_buffer_index.h.
+#ifndef CS_INITIATOR_CAPTURE_RTT_BUFFER_INDEX
+#define CS_INITIATOR_CAPTURE_RTT_BUFFER_INDEX         5
+#endif
+
+// <o CS_INITIATOR_CAPTURE_BUFFER_SIZE> RTT buffer size [bytes] <1024..32768>
+// <i> Default: 8192
+// <i> A procedure record takes up to twice "Maximum ranging data size" and
+// <i> the step channels.
+#ifndef CS_INITIATOR_CAPTURE_BUFFER_SIZE
+#define CS_INITIATOR_CAPTURE_BUFFER_SIZE              8192
+#endif
+// </e>
+
 // <o CS_INITIATOR_ERROR_TIMEOUT_MS> Error timeout [msec] <100..5000>
 // <i> Timeout value in order to avoid stuck in error state indefinitely.
 // <i> Once the time elapses the initiator instance's error callback executes to
@@ -170,6 +219,16 @@
 // <i> Default: SL_RTL_CS_ALGO_MODE_REAL_TIME_FAST
 #define CS_INITIATOR_DEFAULT_ALGO_MODE           SL_RTL_CS_ALGO_MODE_REAL_TIME_FAST
 
+// <q CS_INITIATOR_CONFIG_PIPELINED_EXTRACT> Per-subevent step validation
+// <i> Default: 1
+// <i> Check step mode, channel and antenna path layout of every subevent as
+// <i> it arrives. A procedure with invalid steps is dropped as soon as the
+// <i> initiator side completes instead of after the reflector data transfer
+// <i> and a failing RTL run.
+#ifndef CS_INITIATOR_CONFIG_PIPELINED_EXTRACT
+#define CS_INITIATOR_CONFIG_PIPELINED_EXTRACT    1
+#endif
+
 // </h>
 
 // <h> Channel Sounding
@@ -398,6 +457,51 @@
 #define CS_INITIATOR_RAS_DATA_OVERWRITTEN_NOTIFICATION     (1)
 #endif
 
+// <o CS_INITIATOR_RAS_LOST_SEGMENT_MERGE_GAP> Lost segment merge gap <0..63>
+// <i> Lost segments with at most this many received segments between them
+// <i> are retrieved with one request. 63 retrieves all in one range.
+// <i> This is only applicable for On-Demand Ranging Data mode
+// <i> Default: 4
+#ifndef CS_INITIATOR_RAS_LOST_SEGMENT_MERGE_GAP
+#define CS_INITIATOR_RAS_LOST_SEGMENT_MERGE_GAP      (4)
+#endif
+
+// <e CS_INITIATOR_RAS_MODE_AUTO> Select RAS mode automatically
+// <i> Start in the mode above, then switch between Real-Time and On-Demand
+// <i> mode per connection based on segment loss, dropped procedures and
+// <i> ranging data latency.
+// <i> Default: 0
+#ifndef CS_INITIATOR_RAS_MODE_AUTO
+#define CS_INITIATOR_RAS_MODE_AUTO                   (0)
+#endif
+
+// <o CS_INITIATOR_RAS_AUTO_ON_DEMAND_THRESHOLD> Bad procedures to leave Real-Time mode [%] <1..100>
+// <i> Default: 20
+#ifndef CS_INITIATOR_RAS_AUTO_ON_DEMAND_THRESHOLD
+#define CS_INITIATOR_RAS_AUTO_ON_DEMAND_THRESHOLD    (20)
+#endif
+
+// <o CS_INITIATOR_RAS_AUTO_REAL_TIME_THRESHOLD> Bad procedures to return to Real-Time mode [%] <0..99>
+// <i> Must be below the threshold to leave Real-Time mode.
+// <i> Default: 5
+#ifndef CS_INITIATOR_RAS_AUTO_REAL_TIME_THRESHOLD
+#define CS_INITIATOR_RAS_AUTO_REAL_TIME_THRESHOLD    (5)
+#endif
+
+// <o CS_INITIATOR_RAS_AUTO_MIN_PROCEDURES> Minimum procedures between mode changes <1..1000>
+// <i> Default: 16
+#ifndef CS_INITIATOR_RAS_AUTO_MIN_PROCEDURES
+#define CS_INITIATOR_RAS_AUTO_MIN_PROCEDURES         (16)
+#endif
+
+// <o CS_INITIATOR_RAS_AUTO_MAX_LATENCY_MS> Ranging data latency counted as bad [ms] <1..10000>
+// <i> Time from the first segment to the complete ranging data.
+// <i> Default: 250
+#ifndef CS_INITIATOR_RAS_AUTO_MAX_LATENCY_MS
+#define CS_INITIATOR_RAS_AUTO_MAX_LATENCY_MS         (250)
+#endif
+// </e>
+
 // </h>
 
 // <<< end of configuration section >>>
@@ -50,5 +50,13 @@ DEFINE_BASIC_TOKEN(OPEN_TIME, uint8_t, CREATOR_DEVICE_OPEN_TIME_DEFAULT)
 DEFINE_BASIC_TOKEN(CLOSE_TIME, uint8_t, CREATOR_DEVICE_CLOSE_TIME_DEFAULT)
 #endif
 
+/* Gate parameter record, see gate_config.h. Replaces the four objects
+ * above, which are only read once to migrate them. */
+#define CREATOR_GATE_CONFIG 0x0010
+#define NVM3KEY_GATE_CONFIG (NVM3_USER_REGION | CREATOR_GATE_CONFIG)
+
+/* Reflector attribute cache, one object per slot, see reflector_cache.h */
+#define CREATOR_REFLECTOR_CACHE 0x0100
+#define NVM3KEY_REFLECTOR_CACHE(slot) (NVM3_USER_REGION | (CREATOR_REFLECTOR_CACHE + (slot)))
 
 #endif /* CONFIG_TOKEN_H_ */
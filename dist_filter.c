@@ -0,0 +1,110 @@
+/*
+ * dist_filter.c
+ *
+ * Fixed-point distance filter, see dist_filter.h.
+ */
+
+#include "dist_filter.h"
+
+#if (DIST_FILTER_MEDIAN_N != 1) && (DIST_FILTER_MEDIAN_N != 3) && (DIST_FILTER_MEDIAN_N != 5)
+#error "DIST_FILTER_MEDIAN_N must be 1, 3 or 5"
+#endif
+
+#if DIST_FILTER_EWMA_ORDER < 1
+#error "DIST_FILTER_EWMA_ORDER must be at least 1"
+#endif
+
+static q16_t q16_sat(int64_t value)
+{
+  if (value > Q16_MAX)
+    return Q16_MAX;
+  if (value < Q16_MIN)
+    return Q16_MIN;
+  return (q16_t)value;
+}
+
+#define SORT2(a, b) do { if ((a) > (b)) { q16_t t = (a); (a) = (b); (b) = t; } } while (0)
+
+/* Fixed comparison networks, no data dependent loop */
+static q16_t median(const q16_t *window)
+{
+#if DIST_FILTER_MEDIAN_N == 1
+  return window[0];
+#elif DIST_FILTER_MEDIAN_N == 3
+  q16_t a = window[0], b = window[1], c = window[2];
+  SORT2(a, b);
+  SORT2(b, c);
+  SORT2(a, b);
+  return b;
+#else
+  q16_t a = window[0], b = window[1], c = window[2], d = window[3], e = window[4];
+  SORT2(a, b);
+  SORT2(d, e);
+  SORT2(a, d);
+  SORT2(b, e);
+  SORT2(b, c);
+  SORT2(c, d);
+  SORT2(b, c);
+  return c;
+#endif
+}
+
+void dist_filter_reset(dist_filter_t *filter)
+{
+  filter->started = false;
+  filter->window_pos = 0;
+  filter->distance = 0;
+  filter->velocity = 0;
+  filter->last_ms = 0;
+}
+
+void dist_filter_update(dist_filter_t *filter, q16_t sample, q16_t alpha, uint32_t now_ms)
+{
+  q16_t filtered;
+  q16_t value;
+  q16_t previous;
+  q16_t speed;
+  uint32_t dt_ms;
+
+  if (!filter->started)
+  {
+    /* The first sample seeds every stage */
+    for (uint8_t i = 0; i < DIST_FILTER_MEDIAN_N; i++)
+      filter->window[i] = sample;
+    for (uint8_t i = 0; i < DIST_FILTER_EWMA_ORDER; i++)
+      filter->ewma[i] = sample;
+    filter->distance = sample;
+    filter->velocity = 0;
+    filter->last_ms = now_ms;
+    filter->window_pos = 0;
+    filter->started = true;
+    return;
+  }
+
+  filter->window[filter->window_pos] = sample;
+  filter->window_pos = (filter->window_pos + 1) % DIST_FILTER_MEDIAN_N;
+  filtered = median(filter->window);
+  value = filtered;
+
+  /* ewma += alpha * (x - ewma), the input of a stage is the previous one */
+  for (uint8_t i = 0; i < DIST_FILTER_EWMA_ORDER; i++)
+  {
+    int64_t diff = (int64_t)value - filter->ewma[i];
+    filter->ewma[i] = q16_sat(filter->ewma[i] + ((diff * alpha) >> 16));
+    value = filter->ewma[i];
+  }
+
+  /* Smoothed distance: mean of the new median and the previous output */
+  previous = filter->distance;
+  filter->distance = q16_sat(((int64_t)filtered + previous + 1) >> 1);
+
+  dt_ms = now_ms - filter->last_ms;
+  if (dt_ms != 0)
+  {
+    /* A single difference is dominated by the measurement noise */
+    speed = q16_sat((((int64_t)filter->distance - previous) * 1000) / dt_ms);
+    filter->velocity = q16_sat(filter->velocity
+                               + ((((int64_t)speed - filter->velocity) * DIST_FILTER_VELOCITY_WEIGHT) / 100));
+    filter->last_ms = now_ms;
+  }
+}
@@ -0,0 +1,84 @@
+/*
+ * dist_filter.h
+ *
+ * Fixed-point (Q16.16, meters) distance filter used by process_measure():
+ * median-of-N prefilter, EWMA baseline of configurable order, smoothed
+ * distance and velocity. Every step is saturating and constant time.
+ */
+
+#ifndef DIST_FILTER_H_
+#define DIST_FILTER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Prefilter window, 1 disables it. Only 1, 3 and 5 are supported */
+#ifndef DIST_FILTER_MEDIAN_N
+#define DIST_FILTER_MEDIAN_N    3
+#endif
+
+/* Number of cascaded first order EWMA stages of the baseline */
+#ifndef DIST_FILTER_EWMA_ORDER
+#define DIST_FILTER_EWMA_ORDER  1
+#endif
+
+/* Weight of a new difference in the velocity EWMA, in percent */
+#ifndef DIST_FILTER_VELOCITY_WEIGHT
+#define DIST_FILTER_VELOCITY_WEIGHT  20
+#endif
+
+typedef int32_t q16_t;
+
+#define Q16_ONE                 ((q16_t)1 << 16)
+#define Q16_MAX                 INT32_MAX
+#define Q16_MIN                 INT32_MIN
+
+typedef struct
+{
+  bool started;
+  uint8_t window_pos;
+  q16_t window[DIST_FILTER_MEDIAN_N];
+  q16_t ewma[DIST_FILTER_EWMA_ORDER];
+  q16_t distance;         /* Smoothed distance */
+  q16_t velocity;         /* Smoothed, m/s, positive when moving away */
+  uint32_t last_ms;
+} dist_filter_t;
+
+void dist_filter_reset(dist_filter_t *filter);
+
+/*
+ * Feed one sample. alpha is the weight of the new sample in the baseline
+ * EWMA, in Q16 (Q16_ONE keeps only the new sample).
+ */
+void dist_filter_update(dist_filter_t *filter, q16_t sample, q16_t alpha, uint32_t now_ms);
+
+/* Output of the last EWMA stage */
+static inline q16_t dist_filter_baseline(const dist_filter_t *filter)
+{
+  return filter->ewma[DIST_FILTER_EWMA_ORDER - 1];
+}
+
+/* The only float operation of the path, done once per sample */
+static inline q16_t q16_from_float(float value)
+{
+  float scaled = value * (float)Q16_ONE;
+
+  /* NaN fails every comparison, converting it is undefined */
+  if (scaled != scaled)
+    return 0;
+  if (scaled >= (float)Q16_MAX)
+    return Q16_MAX;
+  if (scaled <= (float)Q16_MIN)
+    return Q16_MIN;
+  return (q16_t)scaled;
+}
+
+/* Meters in Q16 to millimeters, negative values clamp to 0 */
+static inline uint32_t q16_to_mm(q16_t value)
+{
+  if (value <= 0)
+    return 0;
+  return (uint32_t)(((int64_t)value * 1000 + (Q16_ONE / 2)) >> 16);
+}
+
+#endif /* DIST_FILTER_H_ */
@@ -0,0 +1,209 @@
+/*
+ * dlog.c
+ *
+ * Deferred log. dlog_write() only copies a timestamp, a site id and two
+ * arguments into a ring, so it can be called from sleeptimer callbacks
+ * without formatting or waiting on the console. dlog_flush() prints the
+ * records from the main loop, as text or as binary frames.
+ */
+
+#include <stdio.h>
+#include "em_core.h"
+#include "sl_sleeptimer.h"
+#include "dlog.h"
+
+#define DLOG_RING_MASK (DLOG_RING_SIZE - 1)
+#define DLOG_LINE_MAX  80
+
+#if (DLOG_RING_SIZE & DLOG_RING_MASK) != 0
+#error "DLOG_RING_SIZE must be a power of 2"
+#endif
+
+typedef struct
+{
+  const char *format;
+  uint16_t min_interval_ms;   /* 0: every call is kept */
+} dlog_site_t;
+
+/* Indexed by dlog_id_t */
+static const dlog_site_t dlog_sites[DLOG_ID_COUNT] =
+{
+  [DLOG_RELAY_STATE]  = { "rs : %ld",         0 },
+  [DLOG_GATE_OPENING] = { "OPENNING",         0 },
+  [DLOG_GATE_CLOSING] = { "CLOSING",          0 },
+  [DLOG_DISTANCE]     = { "d: %ld, b: %ld", 100 },
+};
+
+static dlog_record_t ring[DLOG_RING_SIZE];
+static volatile uint32_t head;
+static volatile uint32_t tail;
+static volatile uint32_t dropped;
+
+static uint32_t min_interval_tick[DLOG_ID_COUNT];
+static uint32_t last_tick[DLOG_ID_COUNT];
+static uint8_t suppressed[DLOG_ID_COUNT];
+static uint8_t seen[DLOG_ID_COUNT];
+
+void dlog_init(void)
+{
+  CORE_irqState_t irqState = CORE_EnterAtomic();
+
+  for (uint8_t i = 0; i < DLOG_ID_COUNT; i++)
+  {
+    min_interval_tick[i] = sl_sleeptimer_ms_to_tick(dlog_sites[i].min_interval_ms);
+    suppressed[i] = 0;
+    seen[i] = 0;
+  }
+  head = 0;
+  tail = 0;
+  dropped = 0;
+  CORE_ExitAtomic(irqState);
+}
+
+void dlog_write(dlog_id_t id, int32_t arg0, int32_t arg1)
+{
+  uint32_t tick = sl_sleeptimer_get_tick_count();
+  dlog_record_t *record;
+  CORE_irqState_t irqState;
+
+  if (id >= DLOG_ID_COUNT)
+    return;
+
+  irqState = CORE_EnterAtomic();
+
+  if (seen[id] && (tick - last_tick[id]) < min_interval_tick[id])
+  {
+    if (suppressed[id] < UINT8_MAX)
+      suppressed[id]++;
+    CORE_ExitAtomic(irqState);
+    return;
+  }
+
+  if ((head - tail) >= DLOG_RING_SIZE)
+  {
+    /* Keep the oldest records, the flush will report the loss */
+    dropped++;
+    CORE_ExitAtomic(irqState);
+    return;
+  }
+
+  record = &ring[head & DLOG_RING_MASK];
+  record->tick = tick;
+  record->id = (uint8_t)id;
+  record->suppressed = suppressed[id];
+  record->arg[0] = arg0;
+  record->arg[1] = arg1;
+  head++;
+
+  seen[id] = 1;
+  last_tick[id] = tick;
+  suppressed[id] = 0;
+
+  CORE_ExitAtomic(irqState);
+}
+
+void dlog_flush(void)
+{
+  dlog_record_t record;
+#if DLOG_BINARY
+  uint8_t frame[DLOG_FRAME_SIZE];
+#else
+  char line[DLOG_LINE_MAX];
+#endif
+  uint32_t lost;
+  CORE_irqState_t irqState;
+
+  while (tail != head)
+  {
+    /* The slot is only reused by dlog_write() once tail moved past it */
+    record = ring[tail & DLOG_RING_MASK];
+    tail++;
+
+#if DLOG_BINARY
+    dlog_encode(&record, frame);
+    DLOG_WRITE(frame, sizeof(frame));
+#else
+    /* One print per record, the console may add its own prefix */
+    dlog_format(&record, line, sizeof(line));
+    DLOG_PRINT("%s\n", line);
+#endif
+  }
+
+  if (dropped)
+  {
+    irqState = CORE_EnterAtomic();
+    lost = dropped;
+    dropped = 0;
+    CORE_ExitAtomic(irqState);
+    DLOG_PRINT("dlog: %lu records lost\n", (unsigned long)lost);
+  }
+}
+
+int dlog_format(const dlog_record_t *record, char *line, int size)
+{
+  int len;
+
+  len = snprintf(line, size, "[%lu] ",
+                 (unsigned long)sl_sleeptimer_tick_to_ms(record->tick));
+  if (len >= size)
+    return size - 1;
+  if (record->id >= DLOG_ID_COUNT)
+    len += snprintf(line + len, size - len, "dlog: unknown id %u", record->id);
+  else
+    len += snprintf(line + len, size - len, dlog_sites[record->id].format,
+                    (long)record->arg[0], (long)record->arg[1]);
+  if (record->suppressed && len < size)
+    len += snprintf(line + len, size - len, " (+%u)", record->suppressed);
+  return (len < size) ? len : size - 1;
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t value)
+{
+  p[0] = (uint8_t)value;
+  p[1] = (uint8_t)(value >> 8);
+  p[2] = (uint8_t)(value >> 16);
+  p[3] = (uint8_t)(value >> 24);
+  return p + 4;
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16)
+         | ((uint32_t)p[3] << 24);
+}
+
+/* Two's complement of the byte sum between the mark and the checksum */
+static uint8_t checksum(const uint8_t *frame)
+{
+  uint8_t sum = 0;
+
+  for (uint8_t i = 1; i < DLOG_FRAME_SIZE - 1; i++)
+    sum += frame[i];
+  return (uint8_t)-sum;
+}
+
+void dlog_encode(const dlog_record_t *record, uint8_t *frame)
+{
+  uint8_t *p = frame;
+
+  *p++ = DLOG_FRAME_MARK;
+  p = put_u32(p, record->tick);
+  *p++ = record->id;
+  *p++ = record->suppressed;
+  p = put_u32(p, (uint32_t)record->arg[0]);
+  p = put_u32(p, (uint32_t)record->arg[1]);
+  *p = checksum(frame);
+}
+
+bool dlog_decode(const uint8_t *frame, dlog_record_t *record)
+{
+  if (frame[0] != DLOG_FRAME_MARK || frame[DLOG_FRAME_SIZE - 1] != checksum(frame))
+    return false;
+  record->tick = get_u32(&frame[1]);
+  record->id = frame[5];
+  record->suppressed = frame[6];
+  record->reserved = 0;
+  record->arg[0] = (int32_t)get_u32(&frame[7]);
+  record->arg[1] = (int32_t)get_u32(&frame[11]);
+  return true;
+}
@@ -0,0 +1,77 @@
+/*
+ * dlog.h
+ *
+ * Deferred log: binary records are stored from any context in O(1) and
+ * formatted from the main loop by dlog_flush(). With DLOG_BINARY the flush
+ * sends the records as binary frames instead, host/dlog_decode.c formats
+ * them from a console capture.
+ */
+
+#ifndef DLOG_H_
+#define DLOG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef ALG_HOST_BUILD
+#include "alg_host_port.h"
+#endif
+
+#ifndef DLOG_PRINT
+#define DLOG_PRINT(...) printf(__VA_ARGS__)
+#endif
+
+#ifndef DLOG_WRITE
+#define DLOG_WRITE(data, size) fwrite((data), 1, (size), stdout)
+#endif
+
+/* 1: dlog_flush() sends binary frames instead of text lines */
+#ifndef DLOG_BINARY
+#define DLOG_BINARY 0
+#endif
+
+/* Binary frame: mark, tick, id, suppressed, arg[0], arg[1], checksum, the
+ * multi-byte fields little endian. The mark never shows up in text lines. */
+#define DLOG_FRAME_MARK 0x1E
+#define DLOG_FRAME_SIZE 16
+
+/* Number of records buffered between two flushes, must be a power of 2 */
+#define DLOG_RING_SIZE 32
+
+/* Log sites, each one has a format and a rate limit in dlog.c */
+typedef enum
+{
+  DLOG_RELAY_STATE,
+  DLOG_GATE_OPENING,
+  DLOG_GATE_CLOSING,
+  DLOG_DISTANCE,
+  DLOG_ID_COUNT
+} dlog_id_t;
+
+typedef struct
+{
+  uint32_t tick;        /* Sleeptimer tick of the call */
+  uint8_t id;           /* dlog_id_t */
+  uint8_t suppressed;   /* Calls of the same site dropped by the rate limit */
+  uint16_t reserved;
+  int32_t arg[2];
+} dlog_record_t;
+
+void dlog_init(void);
+
+/* Store a record, safe from interrupt context */
+void dlog_write(dlog_id_t id, int32_t arg0, int32_t arg1);
+
+/* Format and print the stored records, main loop only */
+void dlog_flush(void);
+
+/* Format a record as dlog_flush() prints it, returns the length */
+int dlog_format(const dlog_record_t *record, char *line, int size);
+
+/* Binary frame of a record */
+void dlog_encode(const dlog_record_t *record, uint8_t *frame);
+
+/* Record of a binary frame, false if the frame is damaged */
+bool dlog_decode(const uint8_t *frame, dlog_record_t *record);
+
+#endif /* DLOG_H_ */
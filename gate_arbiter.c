@@ -0,0 +1,301 @@
+/*
+ * gate_arbiter.c
+ *
+ * Per-reflector tracks and the gate decision made across them.
+ */
+
+#include <stddef.h>
+#include "sl_sleeptimer.h"
+#include "alg.h"
+#include "gate_arbiter.h"
+
+#if CS_INITIATOR_MAX_CONNECTIONS > 32
+#error "red_mask holds one bit per connection"
+#endif
+
+static gate_track_t tracks[CS_INITIATOR_MAX_CONNECTIONS];
+
+/* One bit per track in the red zone, kept until the track leaves it, stops
+ * or has no update for GATE_RED_ZONE_TIMEOUT_MS */
+static uint32_t red_mask;
+
+/* Set by an update, cleared by the evaluation */
+static bool updated;
+
+static uint8_t decision_index;
+
+void gate_arbiter_init(void)
+{
+  for (uint8_t i = 0; i < CS_INITIATOR_MAX_CONNECTIONS; i++)
+  {
+    gate_arbiter_stop_track(i);
+  }
+  updated = false;
+}
+
+void gate_arbiter_start_track(uint8_t index)
+{
+  gate_arbiter_stop_track(index);
+  tracks[index].active = true;
+}
+
+void gate_arbiter_stop_track(uint8_t index)
+{
+  if (index >= CS_INITIATOR_MAX_CONNECTIONS)
+    return;
+
+  tracks[index].active = false;
+  tracks[index].started = false;
+  tracks[index].red_zone = false;
+  tracks[index].trend = TRACK_STILL;
+  tracks[index].confidence = 0.f;
+  tracks[index].history_count = 0;
+  tracks[index].history_head = 0;
+  red_mask &= ~(1ul << index);
+}
+
+void gate_arbiter_update(uint8_t index,
+                         uint32_t measured_mm,
+                         uint32_t distance_mm,
+                         uint32_t baseline_mm,
+                         int32_t velocity_mm_s,
+                         float confidence)
+{
+  gate_track_t *track;
+  uint32_t now;
+
+  if (index >= CS_INITIATOR_MAX_CONNECTIONS || !tracks[index].active)
+    return;
+
+  track = &tracks[index];
+  track->trend = TRACK_STILL;
+
+  if (!track->started)
+  {
+    /* The first measurement only sets the baseline */
+    track->started = true;
+  }
+  else if (track->red_zone)
+  {
+    if (distance_mm > DISTANCE_RED_ZONE)
+      track->red_zone = false;
+  }
+  else if (distance_mm <= DISTANCE_RED_ZONE)
+  {
+    track->red_zone = true;
+  }
+  else if (distance_mm >= (baseline_mm + MOVING_THRESHOLD_MM))
+  {
+    track->trend = TRACK_LEAVING;
+  }
+  else if ((distance_mm + MOVING_THRESHOLD_MM) < baseline_mm)
+  {
+    track->trend = TRACK_APPROACHING;
+  }
+
+  if (track->red_zone)
+    red_mask |= (1ul << index);
+  else
+    red_mask &= ~(1ul << index);
+
+  track->distance_mm = distance_mm;
+  track->baseline_mm = baseline_mm;
+  track->velocity_mm_s = velocity_mm_s;
+  track->confidence = confidence;
+
+  now = sl_sleeptimer_get_tick_count();
+  track->history_mm[track->history_head] = measured_mm;
+  track->history_tick[track->history_head] = now;
+  track->history_head = (track->history_head + 1) % GATE_PREDICT_SAMPLES;
+  if (track->history_count < GATE_PREDICT_SAMPLES)
+    track->history_count++;
+
+  track->last_update_tick = now;
+  updated = true;
+}
+
+/* Release the red zone tracks without update for GATE_RED_ZONE_TIMEOUT_MS */
+static void expire_red_zone(void)
+{
+  uint32_t now = sl_sleeptimer_get_tick_count();
+  uint32_t timeout = sl_sleeptimer_ms_to_tick(GATE_RED_ZONE_TIMEOUT_MS);
+
+  for (uint8_t i = 0; red_mask != 0 && i < CS_INITIATOR_MAX_CONNECTIONS; i++)
+  {
+    if ((red_mask & (1ul << i)) && (now - tracks[i].last_update_tick) > timeout)
+    {
+      tracks[i].red_zone = false;
+      red_mask &= ~(1ul << i);
+    }
+  }
+}
+
+/*
+ * Least squares line through the measured distances of the last
+ * GATE_PREDICT_WINDOW_MS. Unlike the filter velocity, which averages the
+ * past differences, the line follows a change of pace within the window.
+ * Returns false with fewer than GATE_PREDICT_MIN_SAMPLES, or when the slope
+ * does not stand GATE_PREDICT_MIN_T standard errors out of the noise around
+ * the line, as for a parked reflector. distance_mm is the line at the
+ * newest sample, the smoothed distance lags it.
+ */
+static bool fit_approach(const gate_track_t *track, int32_t *velocity_mm_s, uint32_t *distance_mm)
+{
+  uint8_t newest = (track->history_head + GATE_PREDICT_SAMPLES - 1) % GATE_PREDICT_SAMPLES;
+  uint32_t newest_tick = track->history_tick[newest];
+  float n = 0.f;
+  float st = 0.f, sd = 0.f, stt = 0.f, std = 0.f, sdd = 0.f;
+  float sxx, sxy, syy, slope, residual, offset;
+
+  for (uint8_t k = 0; k < track->history_count; k++)
+  {
+    uint8_t i = (newest + GATE_PREDICT_SAMPLES - k) % GATE_PREDICT_SAMPLES;
+    uint32_t age_ms = sl_sleeptimer_tick_to_ms(newest_tick - track->history_tick[i]);
+    float t, d;
+
+    if (age_ms > GATE_PREDICT_WINDOW_MS)
+      break;
+
+    /* Relative to the newest sample, so the sums stay small */
+    t = -(float)age_ms;
+    d = (float)(int32_t)(track->history_mm[i] - track->history_mm[newest]);
+    n += 1.f;
+    st += t;
+    sd += d;
+    stt += t * t;
+    std += t * d;
+    sdd += d * d;
+  }
+
+  if (n < GATE_PREDICT_MIN_SAMPLES)
+    return false;
+
+  sxx = stt - (st * st) / n;
+  sxy = std - (st * sd) / n;
+  syy = sdd - (sd * sd) / n;
+  if (sxx <= 0.f)
+    return false;
+
+  slope = sxy / sxx;
+  residual = syy - sxy * slope;
+  if (residual < 0.f)
+    residual = 0.f;
+
+  /* slope / sqrt(residual / ((n - 2) * sxx)) >= GATE_PREDICT_MIN_T */
+  if ((slope * slope * (n - 2.f) * sxx) < (GATE_PREDICT_MIN_T * GATE_PREDICT_MIN_T * residual))
+    return false;
+
+  offset = (sd - slope * st) / n;
+  if (offset < -(float)track->history_mm[newest])
+    offset = -(float)track->history_mm[newest];
+  *distance_mm = track->history_mm[newest] + (int32_t)offset;
+  *velocity_mm_s = (int32_t)(slope * 1000.f);
+  return true;
+}
+
+uint32_t gate_arbiter_time_to_arrival(const gate_track_t *track)
+{
+  int32_t velocity_mm_s;
+  uint32_t distance_mm;
+
+  if (!fit_approach(track, &velocity_mm_s, &distance_mm)
+      || velocity_mm_s > -GATE_PREDICT_MIN_SPEED_MM_S)
+    return UINT32_MAX;
+  if (track->red_zone || distance_mm <= DISTANCE_RED_ZONE)
+    return 0;
+  return (uint32_t)(((uint64_t)(distance_mm - DISTANCE_RED_ZONE) * 1000)
+                    / (uint32_t)(-velocity_mm_s));
+}
+
+#if GATE_PREDICTIVE_OPEN
+static bool arrives_before_open(const gate_track_t *track)
+{
+  /* The relay pulse follows a lead step, the gate moves after the pulse */
+  return gate_arbiter_time_to_arrival(track) <= (2 * RELAY_PULSE_MS + GATE_TRAVEL_TIME_MS);
+}
+#endif
+
+gate_decision_t gate_arbiter_evaluate(uint32_t *distance_mm)
+{
+  uint32_t now = sl_sleeptimer_get_tick_count();
+  uint32_t timeout = sl_sleeptimer_ms_to_tick(GATE_TRACK_TIMEOUT_MS);
+  uint32_t closest = UINT32_MAX;
+  uint8_t closest_index = 0;
+  uint8_t leaving_index = 0;
+  bool approaching = false;
+  bool leaving = false;
+
+  if (!updated)
+    return GATE_HOLD;
+  updated = false;
+
+  /* Nobody may stand in the gate while it moves, stale tracks included
+   * until GATE_RED_ZONE_TIMEOUT_MS */
+  expire_red_zone();
+  if (red_mask)
+    return GATE_HOLD;
+
+  for (uint8_t i = 0; i < CS_INITIATOR_MAX_CONNECTIONS; i++)
+  {
+    const gate_track_t *track = &tracks[i];
+
+    if (!track->active
+        || (now - track->last_update_tick) > timeout
+        || track->confidence < GATE_MIN_CONFIDENCE)
+      continue;
+
+#if GATE_PREDICTIVE_OPEN
+    if (track->trend == TRACK_APPROACHING
+        || (track->started && track->trend != TRACK_LEAVING && arrives_before_open(track)))
+#else
+    if (track->trend == TRACK_APPROACHING)
+#endif
+    {
+      approaching = true;
+      if (track->distance_mm <= DISTANCE_OPENING_ZONE && track->distance_mm < closest)
+      {
+        closest = track->distance_mm;
+        closest_index = i;
+      }
+    }
+    else if (track->trend == TRACK_LEAVING && !leaving)
+    {
+      leaving = true;
+      leaving_index = i;
+    }
+  }
+
+  if (closest != UINT32_MAX)
+  {
+    *distance_mm = closest;
+    decision_index = closest_index;
+    return GATE_OPEN;
+  }
+
+  /* Close only when nobody is on the way in */
+  if (leaving && !approaching)
+  {
+    decision_index = leaving_index;
+    return GATE_CLOSE;
+  }
+
+  return GATE_HOLD;
+}
+
+uint8_t gate_arbiter_decision_index(void)
+{
+  return decision_index;
+}
+
+bool gate_arbiter_red_zone_occupied(void)
+{
+  expire_red_zone();
+  return red_mask != 0;
+}
+
+const gate_track_t *gate_arbiter_get_track(uint8_t index)
+{
+  if (index >= CS_INITIATOR_MAX_CONNECTIONS)
+    return NULL;
+  return &tracks[index];
+}
@@ -0,0 +1,116 @@
+/*
+ * gate_arbiter.h
+ *
+ * Keeps one track per reflector and turns all of them into a single gate
+ * decision per evaluation, so one reflector moving away cannot close the
+ * gate on another one that is approaching.
+ */
+
+#ifndef GATE_ARBITER_H_
+#define GATE_ARBITER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cs_initiator_config.h"
+
+/* A track without update for this long is ignored */
+#define GATE_TRACK_TIMEOUT_MS   3000
+
+/* A track that stops reporting in the red zone still holds the gate, it
+ * may stand in it. After this long without update it is released, so a
+ * lost reflector cannot block the gate until it disconnects */
+#define GATE_RED_ZONE_TIMEOUT_MS  30000
+
+/* Below this likeliness a measurement does not move the gate */
+#define GATE_MIN_CONFIDENCE     0.3f
+
+/* Open early when the time to reach the red zone is shorter than the relay
+ * lead step and pulse plus GATE_TRAVEL_TIME_MS, so the gate is open on
+ * arrival */
+#ifndef GATE_PREDICTIVE_OPEN
+#define GATE_PREDICTIVE_OPEN    1
+#endif
+
+/*
+ * The arrival is predicted from a line fitted to the measured distances of
+ * the last GATE_PREDICT_WINDOW_MS, at least GATE_PREDICT_MIN_SAMPLES of
+ * them. Its slope must stand GATE_PREDICT_MIN_T standard errors out of the
+ * noise around the line. Slower approaches are left to the baseline trend,
+ * a line through the noise of a parked reflector stays below
+ * GATE_PREDICT_MIN_SPEED_MM_S over the window.
+ */
+#define GATE_PREDICT_WINDOW_MS       1500
+#define GATE_PREDICT_MIN_SAMPLES     5
+#define GATE_PREDICT_MIN_T           6.0f
+#define GATE_PREDICT_MIN_SPEED_MM_S  700
+
+/* The window at 10 Hz, faster rates fit the newest samples only */
+#define GATE_PREDICT_SAMPLES         16
+
+typedef enum
+{
+  GATE_HOLD,
+  GATE_OPEN,
+  GATE_CLOSE
+} gate_decision_t;
+
+typedef enum
+{
+  TRACK_STILL,
+  TRACK_APPROACHING,
+  TRACK_LEAVING
+} gate_track_trend_t;
+
+typedef struct
+{
+  bool active;              /* Reflector connected */
+  bool started;             /* At least one measurement since connection */
+  bool red_zone;
+  gate_track_trend_t trend;
+  uint32_t distance_mm;     /* Smoothed distance */
+  uint32_t baseline_mm;
+  int32_t velocity_mm_s;    /* Filter or RTL velocity, positive when moving away */
+  uint32_t history_mm[GATE_PREDICT_SAMPLES];    /* Measured distances, a ring */
+  uint32_t history_tick[GATE_PREDICT_SAMPLES];
+  uint8_t history_count;
+  uint8_t history_head;     /* Next entry to write */
+  uint32_t last_update_tick;
+  float confidence;         /* Likeliness of the last measurement */
+} gate_track_t;
+
+void gate_arbiter_init(void);
+
+/* Start a new track on (re)connection, stop it on disconnection */
+void gate_arbiter_start_track(uint8_t index);
+void gate_arbiter_stop_track(uint8_t index);
+
+/* Feed one measurement of a reflector, measured_mm as reported and
+ * distance_mm after the distance filter */
+void gate_arbiter_update(uint8_t index,
+                         uint32_t measured_mm,
+                         uint32_t distance_mm,
+                         uint32_t baseline_mm,
+                         int32_t velocity_mm_s,
+                         float confidence);
+
+/*
+ * One decision across all tracks. Returns GATE_HOLD when no track was
+ * updated since the previous evaluation. For GATE_OPEN, distance_mm is set
+ * to the closest approaching reflector.
+ */
+gate_decision_t gate_arbiter_evaluate(uint32_t *distance_mm);
+
+/* Expected time until the reflector reaches the red zone from the line
+ * fitted to its last measured distances, UINT32_MAX when they show no
+ * approach faster than GATE_PREDICT_MIN_SPEED_MM_S */
+uint32_t gate_arbiter_time_to_arrival(const gate_track_t *track);
+
+/* Track behind the last GATE_OPEN or GATE_CLOSE */
+uint8_t gate_arbiter_decision_index(void);
+
+/* True while any active reflector is in the red zone */
+bool gate_arbiter_red_zone_occupied(void);
+
+const gate_track_t *gate_arbiter_get_track(uint8_t index);
+
+#endif /* GATE_ARBITER_H_ */
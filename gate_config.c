@@ -0,0 +1,423 @@
+/*
+ * gate_config.c
+ *
+ * Gate parameter record, see gate_config.h.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "sl_sleeptimer.h"
+#include "gate_config.h"
+#include "config/token.h"
+
+/* Ranges accepted for the parameters */
+#define MOVING_THRESHOLD_MIN_MM   100u
+#define MOVING_THRESHOLD_MAX_MM   50000u
+#define BLOCK_MAX_MS              600000u
+#define BASELINE_WEIGHT_MIN       1u
+#define BASELINE_WEIGHT_MAX       99u
+#define ZONE_MAX_MM               200000u   /* Beyond the CS range */
+#define RELAY_PULSE_MIN_MS        50u
+#define RELAY_PULSE_MAX_MS        5000u
+
+/* Defaults of the version 2 fields, the initial values in alg.c */
+#define RED_ZONE_DEFAULT_MM       2000u
+#define OPENING_ZONE_DEFAULT_MM   100000u
+#define RELAY_PULSE_DEFAULT_MS    500u
+
+/* Largest record read back, a newer firmware may have added fields */
+#define RECORD_MAX_SIZE           64u
+
+typedef struct
+{
+  uint8_t version;
+  uint8_t size;                     /* Bytes of the whole record */
+  uint16_t crc;                     /* Of the whole record with crc 0 */
+  gate_config_t values;
+} record_t;
+
+static gate_config_t shadow;
+static gate_config_t saved;         /* Values of the record in NVM3 */
+static gate_config_apply_t apply_cb;
+static sl_sleeptimer_timer_handle_t timer;
+
+static bool dirty;
+static volatile bool due;
+static uint32_t first_change;       /* Ticks of the first unsaved change */
+static uint32_t deadline;
+
+static const nvm3_ObjectKey_t legacy_keys[] = {
+  NVM3KEY_DEVICE_MOVING_THRESHOLD,
+  NVM3KEY_DEVICE_BASELINE_WEIGHT,
+  NVM3KEY_DEVICE_OPEN_TIME,
+  NVM3KEY_DEVICE_CLOSE_TIME
+};
+
+/* TLV elements, in the order they are encoded */
+static const struct
+{
+  uint8_t tag;
+  uint8_t size;
+  uint8_t offset;
+} fields[] = {
+  { GATE_CONFIG_TAG_MOVING_THRESHOLD_MM, 4, offsetof(gate_config_t, moving_threshold_mm) },
+  { GATE_CONFIG_TAG_OPEN_BLOCK_MS, 4, offsetof(gate_config_t, open_block_ms) },
+  { GATE_CONFIG_TAG_CLOSE_BLOCK_MS, 4, offsetof(gate_config_t, close_block_ms) },
+  { GATE_CONFIG_TAG_BASELINE_WEIGHT, 1, offsetof(gate_config_t, baseline_weight) },
+  { GATE_CONFIG_TAG_RED_ZONE_MM, 4, offsetof(gate_config_t, red_zone_mm) },
+  { GATE_CONFIG_TAG_OPENING_ZONE_MM, 4, offsetof(gate_config_t, opening_zone_mm) },
+  { GATE_CONFIG_TAG_RELAY_PULSE_MS, 4, offsetof(gate_config_t, relay_pulse_ms) }
+};
+
+#define FIELD_COUNT  (sizeof(fields) / sizeof(fields[0]))
+
+/* CRC-16/CCITT-FALSE */
+static uint16_t crc16(const uint8_t *data, size_t len)
+{
+  uint16_t crc = 0xffff;
+
+  while (len--)
+  {
+    crc ^= (uint16_t)(*data++ << 8);
+    for (int i = 0; i < 8; i++)
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+  }
+  return crc;
+}
+
+static uint16_t record_crc(const uint8_t *record, size_t len)
+{
+  uint8_t copy[RECORD_MAX_SIZE];
+
+  memcpy(copy, record, len);
+  copy[offsetof(record_t, crc)] = 0;
+  copy[offsetof(record_t, crc) + 1] = 0;
+  return crc16(copy, len);
+}
+
+/* Index in fields, FIELD_COUNT if the tag is unknown */
+static size_t find_field(uint8_t tag)
+{
+  size_t i = 0;
+
+  while (i < FIELD_COUNT && fields[i].tag != tag)
+    i++;
+  return i;
+}
+
+static uint32_t ms_to_tick(uint32_t ms)
+{
+  return (uint32_t)(((uint64_t)ms * sl_sleeptimer_get_timer_frequency()) / 1000u);
+}
+
+static void on_timer(sl_sleeptimer_timer_handle_t *handle, void *data)
+{
+  (void)handle;
+  (void)data;
+  /* Only wakes the main loop, the flash is written from there */
+  due = true;
+}
+
+static void arm(uint32_t now)
+{
+  int32_t remaining = (int32_t)(deadline - now);
+
+  if (remaining < 1)
+    remaining = 1;
+  /* A running timer cannot be started again */
+  (void)sl_sleeptimer_stop_timer(&timer);
+  (void)sl_sleeptimer_start_timer(&timer, (uint32_t)remaining, on_timer, NULL, 0, 0);
+}
+
+static sl_status_t write_record(const gate_config_t *values)
+{
+  record_t record;
+  sl_status_t sc;
+
+  memset(&record, 0, sizeof(record));
+  record.version = GATE_CONFIG_VERSION;
+  record.size = sizeof(record);
+  record.values = *values;
+  record.crc = record_crc((const uint8_t *)&record, sizeof(record));
+
+  sc = nvm3_writeData(nvm3_defaultHandle, NVM3KEY_GATE_CONFIG, &record, sizeof(record));
+  if (sc == SL_STATUS_OK)
+    saved = *values;
+  return sc;
+}
+
+/* Record of this or another version, false if missing or damaged */
+static bool read_record(gate_config_t *values, gate_config_origin_t *origin)
+{
+  union
+  {
+    record_t record;
+    uint8_t bytes[RECORD_MAX_SIZE];
+  } buf;
+  uint32_t type;
+  size_t len;
+
+  if (nvm3_getObjectInfo(nvm3_defaultHandle, NVM3KEY_GATE_CONFIG, &type, &len) != SL_STATUS_OK)
+  {
+    *origin = GATE_CONFIG_DEFAULTS;
+    return false;
+  }
+  *origin = GATE_CONFIG_DAMAGED;
+  if (len < offsetof(record_t, values) || len > RECORD_MAX_SIZE)
+    return false;
+  memset(&buf, 0, sizeof(buf));
+  if (nvm3_readData(nvm3_defaultHandle, NVM3KEY_GATE_CONFIG, buf.bytes, len) != SL_STATUS_OK)
+    return false;
+  if (buf.record.version == 0 || buf.record.size != len
+      || buf.record.crc != record_crc(buf.bytes, len))
+    return false;
+
+  /* Fields are only ever appended: the ones an older record lacks keep
+   * their defaults, the ones of a newer record are not known here */
+  if (len < sizeof(record_t))
+    memcpy(values, &buf.record.values, len - offsetof(record_t, values));
+  else
+    *values = buf.record.values;
+  *origin = (buf.record.version < GATE_CONFIG_VERSION) ? GATE_CONFIG_MIGRATED : GATE_CONFIG_LOADED;
+  return true;
+}
+
+/* The 1-byte objects of the first layout, in decimetres and seconds */
+static bool read_legacy(gate_config_t *values)
+{
+  bool found = false;
+  uint8_t data;
+
+  if (nvm3_readData(nvm3_defaultHandle, NVM3KEY_DEVICE_MOVING_THRESHOLD, &data, 1) == SL_STATUS_OK)
+  {
+    values->moving_threshold_mm = (uint32_t)data * 100u;
+    found = true;
+  }
+  if (nvm3_readData(nvm3_defaultHandle, NVM3KEY_DEVICE_BASELINE_WEIGHT, &data, 1) == SL_STATUS_OK)
+  {
+    values->baseline_weight = data;
+    found = true;
+  }
+  if (nvm3_readData(nvm3_defaultHandle, NVM3KEY_DEVICE_OPEN_TIME, &data, 1) == SL_STATUS_OK)
+  {
+    values->open_block_ms = (uint32_t)data * 1000u;
+    found = true;
+  }
+  if (nvm3_readData(nvm3_defaultHandle, NVM3KEY_DEVICE_CLOSE_TIME, &data, 1) == SL_STATUS_OK)
+  {
+    values->close_block_ms = (uint32_t)data * 1000u;
+    found = true;
+  }
+  return found;
+}
+
+/* Out of range fields take their default, one by one */
+static void sanitize(gate_config_t *values)
+{
+  gate_config_t defaults;
+
+  gate_config_defaults(&defaults);
+  if (values->moving_threshold_mm < MOVING_THRESHOLD_MIN_MM
+      || values->moving_threshold_mm > MOVING_THRESHOLD_MAX_MM)
+    values->moving_threshold_mm = defaults.moving_threshold_mm;
+  if (values->open_block_ms > BLOCK_MAX_MS)
+    values->open_block_ms = defaults.open_block_ms;
+  if (values->close_block_ms > BLOCK_MAX_MS)
+    values->close_block_ms = defaults.close_block_ms;
+  if (values->baseline_weight < BASELINE_WEIGHT_MIN || values->baseline_weight > BASELINE_WEIGHT_MAX)
+    values->baseline_weight = defaults.baseline_weight;
+  if (values->red_zone_mm >= values->opening_zone_mm || values->opening_zone_mm > ZONE_MAX_MM)
+  {
+    values->red_zone_mm = defaults.red_zone_mm;
+    values->opening_zone_mm = defaults.opening_zone_mm;
+  }
+  if (values->relay_pulse_ms < RELAY_PULSE_MIN_MS || values->relay_pulse_ms > RELAY_PULSE_MAX_MS)
+    values->relay_pulse_ms = defaults.relay_pulse_ms;
+  memset(values->reserved, 0, sizeof(values->reserved));
+}
+
+void gate_config_defaults(gate_config_t *config)
+{
+  memset(config, 0, sizeof(*config));
+  config->moving_threshold_mm = CREATOR_DEVICE_MOVING_THRESHOLD_DEFAULT * 100u;
+  config->open_block_ms = CREATOR_DEVICE_OPEN_TIME_DEFAULT * 1000u;
+  config->close_block_ms = CREATOR_DEVICE_CLOSE_TIME_DEFAULT * 1000u;
+  config->baseline_weight = CREATOR_DEVICE_BASELINE_WEIGHT_DEFAULT;
+  config->red_zone_mm = RED_ZONE_DEFAULT_MM;
+  config->opening_zone_mm = OPENING_ZONE_DEFAULT_MM;
+  config->relay_pulse_ms = RELAY_PULSE_DEFAULT_MS;
+}
+
+bool gate_config_valid(const gate_config_t *config)
+{
+  return config->moving_threshold_mm >= MOVING_THRESHOLD_MIN_MM
+         && config->moving_threshold_mm <= MOVING_THRESHOLD_MAX_MM
+         && config->open_block_ms <= BLOCK_MAX_MS
+         && config->close_block_ms <= BLOCK_MAX_MS
+         && config->baseline_weight >= BASELINE_WEIGHT_MIN
+         && config->baseline_weight <= BASELINE_WEIGHT_MAX
+         && config->red_zone_mm < config->opening_zone_mm
+         && config->opening_zone_mm <= ZONE_MAX_MM
+         && config->relay_pulse_ms >= RELAY_PULSE_MIN_MS
+         && config->relay_pulse_ms <= RELAY_PULSE_MAX_MS;
+}
+
+gate_config_origin_t gate_config_init(gate_config_apply_t apply)
+{
+  gate_config_origin_t origin;
+  gate_config_t values;
+  bool loaded;
+
+  (void)sl_sleeptimer_stop_timer(&timer);
+  apply_cb = apply;
+  dirty = false;
+  due = false;
+
+  gate_config_defaults(&values);
+  loaded = read_record(&values, &origin);
+  if (!loaded && origin == GATE_CONFIG_DEFAULTS && read_legacy(&values))
+    origin = GATE_CONFIG_LEGACY;
+  sanitize(&values);
+
+  shadow = values;
+  memset(&saved, 0, sizeof(saved));
+  if (origin == GATE_CONFIG_LOADED)
+  {
+    saved = values;
+  }
+  else if (write_record(&values) == SL_STATUS_OK && origin == GATE_CONFIG_LEGACY)
+  {
+    /* Written once at the first boot of this layout */
+    for (size_t i = 0; i < sizeof(legacy_keys) / sizeof(legacy_keys[0]); i++)
+      (void)nvm3_deleteObject(nvm3_defaultHandle, legacy_keys[i]);
+  }
+
+  if (apply_cb != NULL)
+    apply_cb(&shadow);
+  return origin;
+}
+
+const gate_config_t *gate_config_get(void)
+{
+  return &shadow;
+}
+
+sl_status_t gate_config_set(const gate_config_t *config)
+{
+  uint32_t now = sl_sleeptimer_get_tick_count();
+  uint32_t quiet_end;
+  gate_config_t values = *config;
+
+  if (!gate_config_valid(&values))
+    return SL_STATUS_INVALID_PARAMETER;
+  memset(values.reserved, 0, sizeof(values.reserved));
+
+  shadow = values;
+  if (apply_cb != NULL)
+    apply_cb(&shadow);
+
+  /* Back to the saved values, nothing to write */
+  if (memcmp(&shadow, &saved, sizeof(shadow)) == 0)
+  {
+    dirty = false;
+    (void)sl_sleeptimer_stop_timer(&timer);
+    return SL_STATUS_OK;
+  }
+
+  if (!dirty)
+    first_change = now;
+  dirty = true;
+  due = false;
+  quiet_end = now + ms_to_tick(GATE_CONFIG_QUIET_MS);
+  deadline = first_change + ms_to_tick(GATE_CONFIG_MAX_DELAY_MS);
+  if ((int32_t)(quiet_end - deadline) < 0)
+    deadline = quiet_end;
+  arm(now);
+  return SL_STATUS_OK;
+}
+
+bool gate_config_pending(void)
+{
+  return dirty;
+}
+
+void gate_config_process(void)
+{
+  uint32_t now;
+
+  if (!dirty)
+    return;
+  now = sl_sleeptimer_get_tick_count();
+  if (!due && (int32_t)(now - deadline) < 0)
+    return;
+
+  due = false;
+  if (gate_config_flush() != SL_STATUS_OK)
+  {
+    /* Try again after another quiet period */
+    deadline = now + ms_to_tick(GATE_CONFIG_QUIET_MS);
+    arm(now);
+  }
+}
+
+sl_status_t gate_config_flush(void)
+{
+  sl_status_t sc;
+
+  if (!dirty)
+    return SL_STATUS_OK;
+  (void)sl_sleeptimer_stop_timer(&timer);
+  sc = write_record(&shadow);
+  if (sc == SL_STATUS_OK)
+    dirty = false;
+  return sc;
+}
+
+uint16_t gate_config_encode(const gate_config_t *config, uint8_t *buf, uint16_t size)
+{
+  const uint8_t *values = (const uint8_t *)config;
+  uint16_t len = 0;
+
+  if (size < GATE_CONFIG_TLV_SIZE)
+    return 0;
+  for (size_t i = 0; i < FIELD_COUNT; i++)
+  {
+    uint32_t value = 0;
+
+    memcpy(&value, &values[fields[i].offset], fields[i].size);
+    buf[len++] = fields[i].tag;
+    buf[len++] = fields[i].size;
+    for (uint8_t n = 0; n < fields[i].size; n++)
+      buf[len++] = (uint8_t)(value >> (8u * n));
+  }
+  return len;
+}
+
+sl_status_t gate_config_decode(const uint8_t *data, uint16_t len, gate_config_t *config)
+{
+  gate_config_t values = *config;
+  uint8_t *dest = (uint8_t *)&values;
+  uint32_t seen = 0;
+  uint16_t pos = 0;
+
+  while (pos < len)
+  {
+    size_t i;
+    uint32_t value = 0;
+
+    if (len - pos < 2)
+      return SL_STATUS_INVALID_PARAMETER;
+    i = find_field(data[pos]);
+    if (i == FIELD_COUNT || fields[i].size != data[pos + 1]
+        || len - pos - 2 < fields[i].size || (seen & (1u << i)) != 0)
+      return SL_STATUS_INVALID_PARAMETER;
+    seen |= 1u << i;
+    pos += 2;
+
+    for (uint8_t n = 0; n < fields[i].size; n++)
+      value |= (uint32_t)data[pos++] << (8u * n);
+    memcpy(&dest[fields[i].offset], &value, fields[i].size);
+  }
+  *config = values;
+  return SL_STATUS_OK;
+}
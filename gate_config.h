@@ -0,0 +1,107 @@
+/*
+ * gate_config.h
+ *
+ * Gate parameters kept in one versioned, CRC-checked NVM3 record with a RAM
+ * shadow. Changes go to the shadow and are applied at once; the record is
+ * written from the main loop once the changes have stopped for
+ * GATE_CONFIG_QUIET_MS, so a burst of GATT writes costs one flash write and
+ * no page write stalls a BLE event. A missing, damaged or older record is
+ * rebuilt from the defaults and, on the first boot after the update, from
+ * the 1-byte objects the parameters were kept in before.
+ *
+ * Over GATT the values are also carried as one TLV payload, a sequence of
+ * { tag, length, value } with little-endian values of a fixed width per
+ * tag. A write holds any subset of the tags, the others keep their value.
+ */
+
+#ifndef GATE_CONFIG_H_
+#define GATE_CONFIG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sl_status.h"
+
+/* Bumped when fields are added to gate_config_t, at its end */
+#define GATE_CONFIG_VERSION       2
+
+/* Time without changes before the record is written */
+#define GATE_CONFIG_QUIET_MS      2000u
+
+/* Latest write after the first unsaved change, for continuous changes */
+#define GATE_CONFIG_MAX_DELAY_MS  30000u
+
+typedef struct
+{
+  uint32_t moving_threshold_mm;
+  uint32_t open_block_ms;
+  uint32_t close_block_ms;
+  uint8_t baseline_weight;          /* Percent, 1..99 */
+  uint8_t reserved[3];
+  /* Version 2 */
+  uint32_t red_zone_mm;             /* Gate kept open below */
+  uint32_t opening_zone_mm;         /* Reflectors ignored beyond */
+  uint32_t relay_pulse_ms;          /* Relay lead time and pulse length */
+} gate_config_t;
+
+/* TLV tags, never renumbered */
+typedef enum
+{
+  GATE_CONFIG_TAG_MOVING_THRESHOLD_MM = 1,  /* uint32 */
+  GATE_CONFIG_TAG_OPEN_BLOCK_MS       = 2,  /* uint32 */
+  GATE_CONFIG_TAG_CLOSE_BLOCK_MS      = 3,  /* uint32 */
+  GATE_CONFIG_TAG_BASELINE_WEIGHT     = 4,  /* uint8 */
+  GATE_CONFIG_TAG_RED_ZONE_MM         = 5,  /* uint32 */
+  GATE_CONFIG_TAG_OPENING_ZONE_MM     = 6,  /* uint32 */
+  GATE_CONFIG_TAG_RELAY_PULSE_MS      = 7   /* uint32 */
+} gate_config_tag_t;
+
+/* Size of the TLV payload with every tag */
+#define GATE_CONFIG_TLV_SIZE      (6 * (2 + 4) + (2 + 1))
+
+/* Where the values came from at boot */
+typedef enum
+{
+  GATE_CONFIG_LOADED,               /* Record of this version */
+  GATE_CONFIG_MIGRATED,             /* Older record, new fields defaulted */
+  GATE_CONFIG_LEGACY,               /* 1-byte objects of the first layout */
+  GATE_CONFIG_DEFAULTS,             /* Nothing stored */
+  GATE_CONFIG_DAMAGED               /* Bad CRC or size, defaults used */
+} gate_config_origin_t;
+
+/* Called with the new values on init and on every accepted change */
+typedef void (*gate_config_apply_t)(const gate_config_t *config);
+
+/* Load the record, or build it, and apply it */
+gate_config_origin_t gate_config_init(gate_config_apply_t apply);
+
+/* Current values, saved or not */
+const gate_config_t *gate_config_get(void);
+
+void gate_config_defaults(gate_config_t *config);
+
+/* All fields in range */
+bool gate_config_valid(const gate_config_t *config);
+
+/* Apply all values, or none of them if one is out of range. The record is
+ * written later by gate_config_process(). */
+sl_status_t gate_config_set(const gate_config_t *config);
+
+/* True while a change is not written yet */
+bool gate_config_pending(void);
+
+/* Main loop: write the record when it is due */
+void gate_config_process(void);
+
+/* Write a pending change now, e.g. before a reset */
+sl_status_t gate_config_flush(void);
+
+/* All values of config as TLV, returns the length, 0 if size is too small */
+uint16_t gate_config_encode(const gate_config_t *config, uint8_t *buf, uint16_t size);
+
+/* Overwrite the fields of config present in the TLV payload. Returns
+ * SL_STATUS_INVALID_PARAMETER for an unknown or repeated tag, a wrong value
+ * length or a truncated element; config is only changed on SL_STATUS_OK.
+ * The ranges are left to gate_config_set(). */
+sl_status_t gate_config_decode(const uint8_t *data, uint16_t len, gate_config_t *config);
+
+#endif /* GATE_CONFIG_H_ */
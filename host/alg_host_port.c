@@ -0,0 +1,281 @@
+/*
+ * alg_host_port.c
+ *
+ * Host implementation of the GPIO, sleeptimer and NVM3 shims used to build
+ * alg.c off-target. Time only advances through alg_host_advance_to(), so a
+ * replay runs as fast as the host can process it.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "em_gpio.h"
+#include "sl_sleeptimer.h"
+#include "nvm3_generic.h"
+#include "alg_host_port.h"
+
+#define HOST_TIMER_MAX   8
+#define HOST_GPIO_PORTS  4
+#define HOST_GPIO_PINS   16
+#define HOST_NVM3_OBJECTS 16
+#define HOST_NVM3_OBJECT_SIZE 64
+
+bool alg_host_verbose = false;
+
+static uint32_t now_ms;
+static sl_sleeptimer_timer_handle_t *timers[HOST_TIMER_MAX];
+static uint8_t pin_level[HOST_GPIO_PORTS][HOST_GPIO_PINS];
+static alg_host_pin_callback_t pin_callback;
+
+static struct {
+  bool used;
+  nvm3_ObjectKey_t key;
+  size_t len;
+  uint8_t data[HOST_NVM3_OBJECT_SIZE];
+} nvm3_objects[HOST_NVM3_OBJECTS];
+
+static nvm3_Handle_t nvm3_default;
+nvm3_Handle_t *nvm3_defaultHandle = &nvm3_default;
+
+int alg_host_trace(const char *format, ...)
+{
+  va_list args;
+  int ret;
+
+  if (!alg_host_verbose) {
+    return 0;
+  }
+  printf("# ");
+  va_start(args, format);
+  ret = vprintf(format, args);
+  va_end(args);
+  return ret;
+}
+
+void alg_host_write(const void *data, unsigned int size)
+{
+  if (alg_host_verbose) {
+    fwrite(data, 1, size, stdout);
+  }
+}
+
+uint32_t alg_host_now_ms(void)
+{
+  return now_ms;
+}
+
+void alg_host_set_pin_callback(alg_host_pin_callback_t callback)
+{
+  pin_callback = callback;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Sleeptimer */
+
+sl_status_t sl_sleeptimer_start_timer(sl_sleeptimer_timer_handle_t *handle,
+                                      uint32_t timeout,
+                                      sl_sleeptimer_timer_callback_t callback,
+                                      void *callback_data,
+                                      uint8_t priority,
+                                      uint16_t option_flags)
+{
+  (void)priority;
+  (void)option_flags;
+  uint8_t free_slot = HOST_TIMER_MAX;
+
+  for (uint8_t i = 0; i < HOST_TIMER_MAX; i++) {
+    if (timers[i] == handle) {
+      /* Same as on target: a running timer cannot be started again */
+      return SL_STATUS_NOT_READY;
+    }
+    if (timers[i] == NULL && free_slot == HOST_TIMER_MAX) {
+      free_slot = i;
+    }
+  }
+  if (free_slot == HOST_TIMER_MAX) {
+    return SL_STATUS_NO_MORE_RESOURCE;
+  }
+
+  handle->callback = callback;
+  handle->callback_data = callback_data;
+  /* Round up, a tick timer never fires early */
+  handle->expire_ms = now_ms + (uint32_t)(((uint64_t)timeout * 1000u + 32767u) / 32768u);
+  handle->running = true;
+  timers[free_slot] = handle;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_sleeptimer_stop_timer(sl_sleeptimer_timer_handle_t *handle)
+{
+  for (uint8_t i = 0; i < HOST_TIMER_MAX; i++) {
+    if (timers[i] == handle) {
+      timers[i] = NULL;
+      handle->running = false;
+      return SL_STATUS_OK;
+    }
+  }
+  return SL_STATUS_INVALID_STATE;
+}
+
+uint32_t sl_sleeptimer_get_tick_count(void)
+{
+  return (uint32_t)(((uint64_t)now_ms * 32768u) / 1000u);
+}
+
+uint32_t sl_sleeptimer_ms_to_tick(uint16_t time_ms)
+{
+  return ((uint32_t)time_ms * 32768u) / 1000u;
+}
+
+uint32_t sl_sleeptimer_tick_to_ms(uint32_t tick)
+{
+  return (uint32_t)(((uint64_t)tick * 1000u) / 32768u);
+}
+
+uint32_t sl_sleeptimer_get_timer_frequency(void)
+{
+  return 32768u;
+}
+
+bool alg_host_next_timer(uint32_t *time_ms)
+{
+  bool found = false;
+
+  for (uint8_t i = 0; i < HOST_TIMER_MAX; i++) {
+    if (timers[i] != NULL && (!found || timers[i]->expire_ms < *time_ms)) {
+      *time_ms = timers[i]->expire_ms;
+      found = true;
+    }
+  }
+  return found;
+}
+
+void alg_host_advance_to(uint32_t time_ms)
+{
+  uint32_t next = 0;
+
+  while (alg_host_next_timer(&next) && next <= time_ms) {
+    for (uint8_t i = 0; i < HOST_TIMER_MAX; i++) {
+      sl_sleeptimer_timer_handle_t *handle = timers[i];
+      if (handle != NULL && handle->expire_ms == next) {
+        timers[i] = NULL;
+        handle->running = false;
+        now_ms = next;
+        handle->callback(handle, handle->callback_data);
+        break;
+      }
+    }
+  }
+  if (time_ms > now_ms) {
+    now_ms = time_ms;
+  }
+}
+
+/* ------------------------------------------------------------------------- */
+/* GPIO */
+
+static void pin_write(GPIO_Port_TypeDef port, unsigned int pin, unsigned int value)
+{
+  if ((unsigned int)port >= HOST_GPIO_PORTS || pin >= HOST_GPIO_PINS) {
+    return;
+  }
+  value = value ? 1 : 0;
+  if (pin_level[port][pin] != value) {
+    pin_level[port][pin] = (uint8_t)value;
+    if (pin_callback != NULL) {
+      pin_callback(now_ms, port, pin, value);
+    }
+  }
+}
+
+void GPIO_PinModeSet(GPIO_Port_TypeDef port,
+                     unsigned int pin,
+                     GPIO_Mode_TypeDef mode,
+                     unsigned int out)
+{
+  (void)mode;
+  pin_write(port, pin, out);
+}
+
+void GPIO_PinOutSet(GPIO_Port_TypeDef port, unsigned int pin)
+{
+  pin_write(port, pin, 1);
+}
+
+void GPIO_PinOutClear(GPIO_Port_TypeDef port, unsigned int pin)
+{
+  pin_write(port, pin, 0);
+}
+
+/* ------------------------------------------------------------------------- */
+/* NVM3 */
+
+sl_status_t nvm3_writeData(nvm3_Handle_t *h, nvm3_ObjectKey_t key, const void *value, size_t len)
+{
+  uint8_t slot = HOST_NVM3_OBJECTS;
+
+  if (len > HOST_NVM3_OBJECT_SIZE) {
+    return SL_STATUS_INVALID_PARAMETER;
+  }
+  for (uint8_t i = 0; i < HOST_NVM3_OBJECTS; i++) {
+    if (nvm3_objects[i].used && nvm3_objects[i].key == key) {
+      slot = i;
+      break;
+    }
+    if (!nvm3_objects[i].used && slot == HOST_NVM3_OBJECTS) {
+      slot = i;
+    }
+  }
+  if (slot == HOST_NVM3_OBJECTS) {
+    return SL_STATUS_FULL;
+  }
+  nvm3_objects[slot].used = true;
+  nvm3_objects[slot].key = key;
+  nvm3_objects[slot].len = len;
+  memcpy(nvm3_objects[slot].data, value, len);
+  h->write_count++;
+  return SL_STATUS_OK;
+}
+
+sl_status_t nvm3_readData(nvm3_Handle_t *h, nvm3_ObjectKey_t key, void *value, size_t len)
+{
+  (void)h;
+
+  for (uint8_t i = 0; i < HOST_NVM3_OBJECTS; i++) {
+    if (nvm3_objects[i].used && nvm3_objects[i].key == key) {
+      if (len > nvm3_objects[i].len) {
+        return SL_STATUS_INVALID_PARAMETER;
+      }
+      memcpy(value, nvm3_objects[i].data, len);
+      return SL_STATUS_OK;
+    }
+  }
+  return SL_STATUS_NOT_FOUND;
+}
+
+sl_status_t nvm3_getObjectInfo(nvm3_Handle_t *h, nvm3_ObjectKey_t key,
+                               uint32_t *type, size_t *len)
+{
+  (void)h;
+
+  for (uint8_t i = 0; i < HOST_NVM3_OBJECTS; i++) {
+    if (nvm3_objects[i].used && nvm3_objects[i].key == key) {
+      *type = NVM3_OBJECTTYPE_DATA;
+      *len = nvm3_objects[i].len;
+      return SL_STATUS_OK;
+    }
+  }
+  return SL_STATUS_NOT_FOUND;
+}
+
+sl_status_t nvm3_deleteObject(nvm3_Handle_t *h, nvm3_ObjectKey_t key)
+{
+  for (uint8_t i = 0; i < HOST_NVM3_OBJECTS; i++) {
+    if (nvm3_objects[i].used && nvm3_objects[i].key == key) {
+      nvm3_objects[i].used = false;
+      h->write_count++;
+      return SL_STATUS_OK;
+    }
+  }
+  return SL_STATUS_NOT_FOUND;
+}
@@ -0,0 +1,42 @@
+/*
+ * alg_host_port.h
+ *
+ * Host port of alg.c: virtual clock, timer and GPIO hooks used by the replay
+ * driver. Only included when ALG_HOST_BUILD is defined.
+ */
+
+#ifndef ALG_HOST_PORT_H_
+#define ALG_HOST_PORT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define DLOG_PRINT(...) alg_host_trace(__VA_ARGS__)
+#define DLOG_WRITE(data, size) alg_host_write((data), (size))
+
+typedef void (*alg_host_pin_callback_t)(uint32_t time_ms,
+                                        unsigned int port,
+                                        unsigned int pin,
+                                        unsigned int value);
+
+/* Print dlog records only when set */
+extern bool alg_host_verbose;
+
+int alg_host_trace(const char *format, ...);
+
+/* Binary dlog frames, written to stdout under the same condition */
+void alg_host_write(const void *data, unsigned int size);
+
+/* Current virtual time in ms */
+uint32_t alg_host_now_ms(void);
+
+/* Run every timer that expires up to time_ms, then set the clock to it */
+void alg_host_advance_to(uint32_t time_ms);
+
+/* Time of the next pending timer, false if none is running */
+bool alg_host_next_timer(uint32_t *time_ms);
+
+/* Called on every GPIO output level change */
+void alg_host_set_pin_callback(alg_host_pin_callback_t callback);
+
+#endif /* ALG_HOST_PORT_H_ */
@@ -0,0 +1,639 @@
+/*
+ * alg_replay.c
+ *
+ * Replays recorded distance traces through alg.c on the host and prints the
+ * resulting gate decision timeline. Time is virtual: a trace of several hours
+ * replays in milliseconds, so parameter sweeps can be scripted around it.
+ *
+ * Build (from the project root):
+ *   SDK=simplicity_sdk_2025.6.2
+ *   gcc -O2 -DALG_HOST_BUILD -Ihost/shim -Ihost -I. -Iconfig -Iautogen \
+ *     -I$SDK/platform/common/inc -I$SDK/protocol/bluetooth/inc \
+ *     -I$SDK/util/silicon_labs/rtl/inc \
+ *     -I$SDK/app/bluetooth/common/ble_peer_manager/common \
+ *     -I$SDK/app/bluetooth/common/cs_antenna \
+ *     -I$SDK/app/bluetooth/common/cs_result/inc \
+ *     -I$SDK/app/bluetooth/common/cs_initiator/inc \
+ *     -I$SDK/app/bluetooth/common/cs_ras/common/inc \
+ *     -I$SDK/app/bluetooth/common/cs_initiator_display/inc \
+ *     alg.c dlog.c gate_arbiter.c dist_filter.c proc_sched.c relay.c \
+ *     gate_config.c host/alg_host_port.c host/alg_replay.c -o alg_replay
+ * Add -DCS_INITIATOR_MAX_CONNECTIONS=<n> to replay more reflectors, and
+ * -DALG_Q16_FILTER=0 to replay the original integer filter and
+ * -DGATE_PREDICTIVE_OPEN=0 to compare against the opening on trend only.
+ *
+ * Trace format, one sample per line, '#' starts a comment:
+ *   <time_ms>,<instance>,<distance_filtered_m>[,<likeliness>[,<velocity_m_s>]]
+ * A negative distance marks a (re)connection of the instance, a distance
+ * of exactly -2 its disconnection. The first sample of an instance is
+ * always treated as a new connection. Likeliness defaults to 1, velocity
+ * to 0 (no RTL velocity, the filter estimate is used). The velocity only
+ * drives the procedure rate, the predictive opening fits its own line
+ * through the distances.
+ * Samples with the same time_ms form one gate evaluation, like results
+ * drained in one main loop pass on the target.
+ *
+ * With -a, the trace is taken as recorded at the fast procedure rate and
+ * proc_sched.c decides the rate of every instance: at the slow rate only
+ * one sample out of PROC_SCHED_SLOW_FACTOR is measured. Comparing the
+ * decision times and the procedure count with a run without -a gives the
+ * cost of the adaptive scheduling in latency and its saving in procedures.
+ *
+ * Output, one line per gate command:
+ *   <decision_ms>,<OPEN|CLOSE>,<instance>,<distance_mm>,<relay_pulse_ms>
+ * distance_mm is the smoothed distance of the reflector that caused it.
+ *
+ * For every instance that reached the red zone after an OPEN, a line
+ *   # arrival <instance>: <arrival_ms>,<gate_open_ms>,<wait_ms>
+ * follows, where gate_open_ms is the relay pulse plus the gate travel time
+ * and wait_ms how long the user stood in front of the still moving gate
+ * (negative: the gate was open that much earlier).
+ *
+ * With -f, the trace only goes through the two distance filters of
+ * process_measure(): the Q16 filter of dist_filter.c and the original
+ * integer filter (ALG_Q16_FILTER=0), both per instance in one binary. Each
+ * is compared with the same filter computed in double, and then timed over
+ * the trace samples. Output:
+ *   # filter,samples,distance_err_mean_mm,distance_err_max_mm,
+ *     baseline_err_mean_mm,baseline_err_max_mm,ns_per_sample,tsc_per_sample
+ *   legacy,...
+ *   q16,...
+ * The q16 reference includes the median prefilter, the legacy one has none.
+ * tsc_per_sample counts time stamp counter ticks on x86 hosts, 0
+ * elsewhere. The traces in host/traces are synthetic walks.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "em_gpio.h"
+#include "alg.h"
+#include "dlog.h"
+#include "gate_arbiter.h"
+#include "proc_sched.h"
+#include "dist_filter.h"
+
+#define RELAY_OPEN_PORT  gpioPortC
+#define RELAY_OPEN_PIN   2
+#define RELAY_CLOSE_PORT gpioPortC
+#define RELAY_CLOSE_PIN  3
+#define LED_PORT         gpioPortD
+#define LED_PIN          4
+
+#define LINE_MAX_LEN     128
+#define COMPARE_SAMPLES  (1u << 16)
+#define COMPARE_TIMED    2000000u
+
+static cs_initiator_instances_t instances[CS_INITIATOR_MAX_CONNECTIONS];
+static bool connected[CS_INITIATOR_MAX_CONNECTIONS];
+
+/* First time an instance reached the red zone, and when the gate opened
+ * for it, 0 when unknown */
+static uint32_t arrival_ms[CS_INITIATOR_MAX_CONNECTIONS];
+static uint32_t gate_open_ms[CS_INITIATOR_MAX_CONNECTIONS];
+
+static struct {
+  bool pending;
+  uint32_t time_ms;
+  uint8_t index;
+} decision;
+static bool summary_only;
+static bool adaptive;
+static proc_rate_t rate[CS_INITIATOR_MAX_CONNECTIONS];
+static uint8_t skipped[CS_INITIATOR_MAX_CONNECTIONS];
+static uint32_t open_count;
+static uint32_t close_count;
+static uint32_t first_open_ms = UINT32_MAX;
+static int32_t total_wait_ms;
+
+/* The reflector behind the decision taken by gate_evaluate() */
+static void capture_decision(uint32_t time_ms)
+{
+  decision.pending = true;
+  decision.time_ms = time_ms;
+  decision.index = gate_arbiter_decision_index();
+}
+
+static void on_pin(uint32_t time_ms, unsigned int port, unsigned int pin, unsigned int value)
+{
+  bool open;
+  uint8_t index;
+
+  if (port == LED_PORT && pin == LED_PIN && value) {
+    /* The LED is switched on synchronously with the gate decision */
+    capture_decision(time_ms);
+    return;
+  }
+
+  if (port == RELAY_OPEN_PORT && pin == RELAY_OPEN_PIN && value) {
+    open = true;
+  } else if (port == RELAY_CLOSE_PORT && pin == RELAY_CLOSE_PIN && value) {
+    open = false;
+  } else {
+    return;
+  }
+
+  if (open) {
+    open_count++;
+    if (gate_open_ms[decision.index] == 0) {
+      gate_open_ms[decision.index] = time_ms + GATE_TRAVEL_TIME_MS;
+    }
+    if (first_open_ms == UINT32_MAX) {
+      first_open_ms = decision.time_ms;
+    }
+  } else {
+    close_count++;
+  }
+
+  if (!summary_only) {
+    index = decision.index;
+    printf("%lu,%s,%u,%lu,%lu\n",
+           (unsigned long)decision.time_ms,
+           open ? "OPEN" : "CLOSE",
+           index,
+           (unsigned long)gate_arbiter_get_track(index)->distance_mm,
+           (unsigned long)time_ms);
+  }
+  decision.pending = false;
+}
+
+/* ---- Filter comparison (-f) ---- */
+
+typedef struct {
+  uint8_t index;
+  bool reset;
+  float distance_m;
+  uint32_t time_ms;
+} compare_sample_t;
+
+/* process_measure() with ALG_Q16_FILTER=0 */
+typedef struct {
+  uint32_t baseline;
+  uint32_t previous;
+} legacy_filter_t;
+
+/* Either filter computed in double, in mm */
+typedef struct {
+  bool started;
+  unsigned int window_pos;
+  double window[DIST_FILTER_MEDIAN_N];
+  double ewma[DIST_FILTER_EWMA_ORDER];
+  double distance;
+} reference_filter_t;
+
+typedef struct {
+  double distance_sum;
+  double distance_max;
+  double baseline_sum;
+  double baseline_max;
+} compare_error_t;
+
+static compare_sample_t compare_samples[COMPARE_SAMPLES];
+static volatile uint32_t compare_sink;
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t now_tsc(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+static void legacy_update(legacy_filter_t *filter, bool reset, float distance_m,
+                          uint32_t *distance, uint32_t *baseline_mm)
+{
+  uint32_t new = (uint32_t)(distance_m * 1000.f);
+
+  if (reset) {
+    filter->baseline = new;
+    filter->previous = new;
+    *distance = new;
+  } else {
+    filter->baseline = (new * BASELINE_WEIGHT) + (filter->baseline * (100 - BASELINE_WEIGHT));
+    filter->baseline /= 100;
+    *distance = (new + filter->previous) / 2;
+    filter->previous = *distance;
+  }
+  *baseline_mm = filter->baseline;
+}
+
+static void q16_update(dist_filter_t *filter, bool reset, float distance_m, uint32_t time_ms,
+                       uint32_t *distance, uint32_t *baseline_mm)
+{
+  if (reset) {
+    dist_filter_reset(filter);
+  }
+  dist_filter_update(filter,
+                     q16_from_float(distance_m),
+                     (q16_t)((BASELINE_WEIGHT << 16) / 100),
+                     time_ms);
+  *distance = q16_to_mm(filter->distance);
+  *baseline_mm = q16_to_mm(dist_filter_baseline(filter));
+}
+
+static void reference_update(reference_filter_t *filter, unsigned int median_n,
+                             unsigned int order, double sample)
+{
+  double sorted[DIST_FILTER_MEDIAN_N];
+  double value;
+
+  if (!filter->started) {
+    for (unsigned int i = 0; i < median_n; i++) {
+      filter->window[i] = sample;
+    }
+    for (unsigned int i = 0; i < order; i++) {
+      filter->ewma[i] = sample;
+    }
+    filter->distance = sample;
+    filter->window_pos = 0;
+    filter->started = true;
+    return;
+  }
+
+  filter->window[filter->window_pos] = sample;
+  filter->window_pos = (filter->window_pos + 1) % median_n;
+  for (unsigned int i = 0; i < median_n; i++) {
+    unsigned int j = i;
+
+    while (j > 0 && sorted[j - 1] > filter->window[i]) {
+      sorted[j] = sorted[j - 1];
+      j--;
+    }
+    sorted[j] = filter->window[i];
+  }
+  value = sorted[median_n / 2];
+  filter->distance = (value + filter->distance) / 2.;
+  for (unsigned int i = 0; i < order; i++) {
+    filter->ewma[i] += (value - filter->ewma[i]) * (double)BASELINE_WEIGHT / 100.;
+    value = filter->ewma[i];
+  }
+}
+
+static void add_error(compare_error_t *error, uint32_t distance, uint32_t baseline_mm,
+                      const reference_filter_t *reference, unsigned int order)
+{
+  double distance_error = (double)distance - reference->distance;
+  double baseline_error = (double)baseline_mm - reference->ewma[order - 1];
+
+  distance_error = distance_error < 0. ? -distance_error : distance_error;
+  baseline_error = baseline_error < 0. ? -baseline_error : baseline_error;
+  error->distance_sum += distance_error;
+  error->baseline_sum += baseline_error;
+  if (distance_error > error->distance_max) {
+    error->distance_max = distance_error;
+  }
+  if (baseline_error > error->baseline_max) {
+    error->baseline_max = baseline_error;
+  }
+}
+
+static int compare_filters(FILE *trace)
+{
+  static legacy_filter_t legacy[CS_INITIATOR_MAX_CONNECTIONS];
+  static dist_filter_t q16[CS_INITIATOR_MAX_CONNECTIONS];
+  static reference_filter_t legacy_reference[CS_INITIATOR_MAX_CONNECTIONS];
+  static reference_filter_t q16_reference[CS_INITIATOR_MAX_CONNECTIONS];
+  bool started[CS_INITIATOR_MAX_CONNECTIONS] = { false };
+  compare_error_t legacy_error = { 0 };
+  compare_error_t q16_error = { 0 };
+  char line[LINE_MAX_LEN];
+  uint32_t count = 0;
+  uint32_t distance;
+  uint32_t baseline_mm;
+  uint32_t repeat;
+  uint64_t ns[2];
+  uint64_t tsc[2];
+
+  while (fgets(line, sizeof(line), trace) != NULL) {
+    unsigned long time_ms;
+    unsigned int index;
+    float distance_m;
+
+    if (line[0] == '#' || line[0] == '\n') {
+      continue;
+    }
+    if (sscanf(line, "%lu,%u,%f", &time_ms, &index, &distance_m) < 3
+        || index >= CS_INITIATOR_MAX_CONNECTIONS) {
+      fprintf(stderr, "skipping malformed line: %s", line);
+      continue;
+    }
+    if (distance_m < 0.f) {
+      started[index] = false;
+      continue;
+    }
+    if (count == COMPARE_SAMPLES) {
+      fprintf(stderr, "trace longer than %u samples\n", COMPARE_SAMPLES);
+      return 1;
+    }
+    compare_samples[count].index = (uint8_t)index;
+    compare_samples[count].reset = !started[index];
+    compare_samples[count].distance_m = distance_m;
+    compare_samples[count].time_ms = (uint32_t)time_ms;
+    started[index] = true;
+    count++;
+  }
+  if (count == 0) {
+    fprintf(stderr, "no samples\n");
+    return 1;
+  }
+
+  for (uint32_t i = 0; i < count; i++) {
+    const compare_sample_t *sample = &compare_samples[i];
+    double sample_mm = (double)sample->distance_m * 1000.;
+
+    if (sample->reset) {
+      legacy_reference[sample->index].started = false;
+      q16_reference[sample->index].started = false;
+    }
+    reference_update(&legacy_reference[sample->index], 1, 1, sample_mm);
+    reference_update(&q16_reference[sample->index],
+                     DIST_FILTER_MEDIAN_N, DIST_FILTER_EWMA_ORDER, sample_mm);
+    legacy_update(&legacy[sample->index], sample->reset, sample->distance_m,
+                  &distance, &baseline_mm);
+    add_error(&legacy_error, distance, baseline_mm, &legacy_reference[sample->index], 1);
+    q16_update(&q16[sample->index], sample->reset, sample->distance_m, sample->time_ms,
+               &distance, &baseline_mm);
+    add_error(&q16_error, distance, baseline_mm, &q16_reference[sample->index],
+              DIST_FILTER_EWMA_ORDER);
+  }
+
+  /* The same passes over the trace for both, warmed up by the checks */
+  repeat = COMPARE_TIMED / count + 1;
+  for (unsigned int f = 0; f < 2; f++) {
+    uint64_t start_ns = now_ns();
+    uint64_t start_tsc = now_tsc();
+
+    for (uint32_t r = 0; r < repeat; r++) {
+      for (uint32_t i = 0; i < count; i++) {
+        const compare_sample_t *sample = &compare_samples[i];
+
+        if (f == 0) {
+          legacy_update(&legacy[sample->index], sample->reset, sample->distance_m,
+                        &distance, &baseline_mm);
+        } else {
+          q16_update(&q16[sample->index], sample->reset, sample->distance_m, sample->time_ms,
+                     &distance, &baseline_mm);
+        }
+        compare_sink += distance + baseline_mm;
+      }
+    }
+    tsc[f] = now_tsc() - start_tsc;
+    ns[f] = now_ns() - start_ns;
+  }
+
+  printf("# filter,samples,distance_err_mean_mm,distance_err_max_mm,"
+         "baseline_err_mean_mm,baseline_err_max_mm,ns_per_sample,tsc_per_sample\n");
+  for (unsigned int f = 0; f < 2; f++) {
+    const compare_error_t *error = f == 0 ? &legacy_error : &q16_error;
+    double timed = (double)repeat * (double)count;
+
+    printf("%s,%lu,%.3f,%.3f,%.3f,%.3f,%.2f,%.2f\n",
+           f == 0 ? "legacy" : "q16",
+           (unsigned long)count,
+           error->distance_sum / count,
+           error->distance_max,
+           error->baseline_sum / count,
+           error->baseline_max,
+           (double)ns[f] / timed,
+           (double)tsc[f] / timed);
+  }
+  return 0;
+}
+
+static void usage(const char *name)
+{
+  fprintf(stderr,
+          "usage: %s [options] [trace.csv]\n"
+          "  -w <1..99>  baseline weight          (default %lu)\n"
+          "  -m <mm>     moving threshold         (default %lu)\n"
+          "  -r <mm>     red zone distance        (default %lu)\n"
+          "  -z <mm>     opening zone distance    (default %lu)\n"
+          "  -o <ms>     block delay after open   (default %lu)\n"
+          "  -c <ms>     block delay after close  (default %lu)\n"
+          "  -t <ms>     gate travel time         (default %lu)\n"
+          "  -a          model the adaptive procedure rate\n"
+          "  -f          compare the Q16 and the original distance filter\n"
+          "  -s          print a single summary line (for sweeps)\n"
+          "  -v          print alg.c log records\n",
+          name,
+          (unsigned long)BASELINE_WEIGHT,
+          (unsigned long)MOVING_THRESHOLD_MM,
+          (unsigned long)DISTANCE_RED_ZONE,
+          (unsigned long)DISTANCE_OPENING_ZONE,
+          (unsigned long)OPEN_BLOCK_DELAY_MS,
+          (unsigned long)CLOSE_BLOCK_DELAY_MS,
+          (unsigned long)GATE_TRAVEL_TIME_MS);
+}
+
+int main(int argc, char *argv[])
+{
+  FILE *trace = stdin;
+  char line[LINE_MAX_LEN];
+  uint32_t samples = 0;
+  uint32_t last_time_ms = 0;
+  bool pending_evaluation = false;
+  bool compare = false;
+  int opt;
+
+  /* Defaults are the NVM3 defaults written by alg_init() */
+  dlog_init();
+  alg_init();
+
+  while ((opt = getopt(argc, argv, "w:m:r:z:o:c:t:afsvh")) != -1) {
+    switch (opt) {
+      case 'w':
+        BASELINE_WEIGHT = strtoul(optarg, NULL, 0);
+        break;
+      case 'm':
+        MOVING_THRESHOLD_MM = strtoul(optarg, NULL, 0);
+        break;
+      case 'r':
+        DISTANCE_RED_ZONE = strtoul(optarg, NULL, 0);
+        break;
+      case 'z':
+        DISTANCE_OPENING_ZONE = strtoul(optarg, NULL, 0);
+        break;
+      case 'o':
+        OPEN_BLOCK_DELAY_MS = strtoul(optarg, NULL, 0);
+        break;
+      case 'c':
+        CLOSE_BLOCK_DELAY_MS = strtoul(optarg, NULL, 0);
+        break;
+      case 't':
+        GATE_TRAVEL_TIME_MS = strtoul(optarg, NULL, 0);
+        break;
+      case 'a':
+        adaptive = true;
+        break;
+      case 'f':
+        compare = true;
+        break;
+      case 's':
+        summary_only = true;
+        break;
+      case 'v':
+        alg_host_verbose = true;
+        break;
+      default:
+        usage(argv[0]);
+        return 2;
+    }
+  }
+
+  if (BASELINE_WEIGHT < 1 || BASELINE_WEIGHT > 99) {
+    fprintf(stderr, "baseline weight must be in 1..99\n");
+    return 2;
+  }
+
+  if (optind < argc) {
+    trace = fopen(argv[optind], "r");
+    if (trace == NULL) {
+      perror(argv[optind]);
+      return 1;
+    }
+  }
+
+  if (compare) {
+    int result = compare_filters(trace);
+
+    if (trace != stdin) {
+      fclose(trace);
+    }
+    return result;
+  }
+
+  alg_host_set_pin_callback(on_pin);
+
+  while (fgets(line, sizeof(line), trace) != NULL) {
+    unsigned long time_ms;
+    unsigned int index;
+    float distance_m;
+    float likeliness = 1.f;
+    float velocity = 0.f;
+
+    if (line[0] == '#' || line[0] == '\n') {
+      continue;
+    }
+    if (sscanf(line, "%lu,%u,%f,%f,%f", &time_ms, &index, &distance_m, &likeliness, &velocity) < 3
+        || index >= CS_INITIATOR_MAX_CONNECTIONS) {
+      fprintf(stderr, "skipping malformed line: %s", line);
+      continue;
+    }
+    if (time_ms < last_time_ms) {
+      fprintf(stderr, "trace is not sorted by time at %lu\n", time_ms);
+      return 1;
+    }
+
+    /* Samples of the previous time stamp are complete */
+    if (pending_evaluation && time_ms != last_time_ms) {
+      gate_evaluate();
+      dlog_flush();
+      pending_evaluation = false;
+    }
+    last_time_ms = (uint32_t)time_ms;
+
+    /* Relay timers due before this sample fire first */
+    alg_host_advance_to((uint32_t)time_ms);
+
+    if (distance_m == -2.f) {
+      connected[index] = false;
+      release_measure((uint8_t)index);
+      continue;
+    }
+    if (distance_m < 0.f || !connected[index]) {
+      connected[index] = true;
+      arrival_ms[index] = 0;
+      gate_open_ms[index] = 0;
+      rate[index] = PROC_RATE_FAST;
+      skipped[index] = 0;
+      proc_sched_reset((uint8_t)index, (uint32_t)time_ms);
+      init_measure((uint8_t)index);
+      if (distance_m < 0.f) {
+        continue;
+      }
+    }
+
+    /* Procedures not run at the slow rate */
+    if (adaptive && rate[index] == PROC_RATE_SLOW
+        && ++skipped[index] < PROC_SCHED_SLOW_FACTOR) {
+      continue;
+    }
+    skipped[index] = 0;
+
+    instances[index].measurement_mainmode.distance_filtered = distance_m;
+    instances[index].measurement_mainmode.likeliness = likeliness;
+    instances[index].measurement_mainmode.velocity = velocity;
+    instances[index].measurement_cnt++;
+    process_measure((uint8_t)index, instances);
+    if (adaptive) {
+      rate[index] = proc_sched_update((uint8_t)index,
+                                      gate_arbiter_get_track((uint8_t)index),
+                                      (uint32_t)time_ms);
+    }
+    pending_evaluation = true;
+    samples++;
+
+    if (arrival_ms[index] == 0 && gate_open_ms[index] != 0
+        && distance_m * 1000.f <= (float)DISTANCE_RED_ZONE) {
+      arrival_ms[index] = (uint32_t)time_ms;
+      total_wait_ms += (int32_t)(gate_open_ms[index] - arrival_ms[index]);
+      if (!summary_only) {
+        printf("# arrival %u: %lu,%lu,%ld\n",
+               index,
+               (unsigned long)arrival_ms[index],
+               (unsigned long)gate_open_ms[index],
+               (long)(int32_t)(gate_open_ms[index] - arrival_ms[index]));
+      }
+    }
+  }
+  if (pending_evaluation) {
+    gate_evaluate();
+  }
+
+  /* Let the last relay sequence complete */
+  uint32_t next;
+  while (alg_host_next_timer(&next)) {
+    alg_host_advance_to(next);
+  }
+  dlog_flush();
+
+  if (summary_only) {
+    printf("%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%ld,%ld,%lu\n",
+           (unsigned long)BASELINE_WEIGHT,
+           (unsigned long)MOVING_THRESHOLD_MM,
+           (unsigned long)DISTANCE_RED_ZONE,
+           (unsigned long)DISTANCE_OPENING_ZONE,
+           (unsigned long)OPEN_BLOCK_DELAY_MS,
+           (unsigned long)CLOSE_BLOCK_DELAY_MS,
+           (unsigned long)open_count,
+           (unsigned long)close_count,
+           first_open_ms == UINT32_MAX ? -1L : (long)first_open_ms,
+           (long)total_wait_ms,
+           (unsigned long)samples);
+  } else {
+    printf("# samples=%lu opens=%lu closes=%lu procedures/gate event=%lu\n",
+           (unsigned long)samples,
+           (unsigned long)open_count,
+           (unsigned long)close_count,
+           (unsigned long)(samples / ((open_count + close_count) ? (open_count + close_count) : 1)));
+  }
+
+  if (trace != stdin) {
+    fclose(trace);
+  }
+  return 0;
+}
@@ -0,0 +1,1304 @@
+/*
+ * buffer_pool_stress.c
+ *
+ * Runs cs_initiator.c, its state machine and cs_initiator_extract.c on the
+ * host over interleaved connections and checks the lifetimes of the ranging
+ * buffers lent by cs_initiator_buffer_pool.c. The Bluetooth stack, the RAS
+ * client and the RTL library are stubbed, the stubs hand the events of the
+ * stack and the RAS client callbacks to the initiator in a random order over
+ * the connections: procedures with their initiator and reflector halves,
+ * aborted procedures, lost reflector data, Real-Time re-enables and deletes
+ * with and without the wait for the procedure disable. The lend and return
+ * sites covered are those of
+ *   cs_initiator.c                 reset_ras_config(), the Real-Time
+ *                                  re-enable, the On-Demand data ready
+ *   cs_initiator_extract.c         reset_subevent_data(), the first CS result
+ *   cs_initiator_state_machine.c   the Real-Time init, the On-Demand data
+ *                                  processed, the cleanup after delete
+ * After every action the buffers held by the instances must match the pool
+ * count, no buffer may be held twice, and the buffers must be held in the
+ * phases the action leaves: both halves at the estimation, the Real-Time
+ * reflector buffer for the whole connection, nothing after a delete. Exits
+ * with 1 on the first failed check.
+ *
+ * Then one connection stretches its connection interval twice at a
+ * procedure boundary: the peer ignores the first update, the procedure
+ * timer has to restart the procedures on the old interval without an
+ * error, the peer takes the second one, the timer has to be stopped on the
+ * connection parameters event. Not run while recording.
+ *
+ * The second binary runs the On-Demand mode. The pool size can be lowered
+ * with -DCS_INITIATOR_RANGING_BUFFER_POOL_SIZE=<n> to have lends refused,
+ * down to CS_INITIATOR_MAX_CONNECTIONS + 1 in Real-Time mode.
+ *
+ * Build (from the project root):
+ *   SDK=simplicity_sdk_2025.6.2
+ *   C=$SDK/app/bluetooth/common
+ *   F="$C/cs_initiator/src/cs_initiator.c \
+ *     $C/cs_initiator/src/cs_initiator_state_machine.c \
+ *     $C/cs_initiator/src/cs_initiator_extract.c \
+ *     $C/cs_initiator/src/cs_initiator_buffer_pool.c \
+ *     $C/cs_initiator/src/cs_initiator_latency.c \
+ *     $C/cs_initiator/src/cs_initiator_error.c \
+ *     $C/cs_initiator/src/cs_initiator_client.c \
+ *     $C/cs_initiator/src/cs_initiator_ras_policy.c \
+ *     $C/cs_initiator/src/cs_initiator_recovery.c \
+ *     $C/cs_initiator/src/cs_initiator_capture.c \
+ *     $C/cs_ras/common/src/cs_ras_format_converter.c"
+ *   gcc -O2 -Ihost/shim -I. -Iconfig -Iautogen \
+ *     -I$SDK/platform/common/inc -I$SDK/protocol/bluetooth/inc \
+ *     -I$SDK/util/silicon_labs/rtl/inc \
+ *     -I$SDK/app/common/util/app_timer -I$SDK/app/common/util/app_timer/bm \
+ *     -I$C/cs_initiator/inc -I$C/cs_ras/common/inc -I$C/cs_ras/client/inc \
+ *     -I$C/cs_result/inc \
+ *     $F host/buffer_pool_stress.c -o buffer_pool_stress
+ *   gcc -O2 -DCS_INITIATOR_RAS_MODE_USE_REAL_TIME_MODE=0 \
+ *     -Ihost/shim -I. -Iconfig -Iautogen \
+ *     -I$SDK/platform/common/inc -I$SDK/protocol/bluetooth/inc \
+ *     -I$SDK/util/silicon_labs/rtl/inc \
+ *     -I$SDK/app/common/util/app_timer -I$SDK/app/common/util/app_timer/bm \
+ *     -I$C/cs_initiator/inc -I$C/cs_ras/common/inc -I$C/cs_ras/client/inc \
+ *     -I$C/cs_result/inc \
+ *     $F host/buffer_pool_stress.c -o buffer_pool_stress_on_demand
+ * The component logs are compiled out, add -DHOST_APP_LOG to print them.
+ *
+ * Options:
+ *   -p <procedures>  procedures started over all connections (100000)
+ *   -c <connections> connections, 1..CS_INITIATOR_MAX_CONNECTIONS (all)
+ *   -s <seed>        random seed (1)
+ *   -a <percent>     procedures aborted by the controller (2)
+ *   -l <percent>     procedures whose reflector data is lost (2)
+ *   -r <percent>     actions that re-enable Real-Time data (1)
+ *   -d <percent>     actions that delete the connection (1)
+ *   -w <file>        records the run for state_machine_bench
+ *
+ * Output:
+ *   PASS lifetimes
+ *   mode <real-time|on-demand>, <connections> connections
+ *   procedures <estimated> estimated, <aborted> aborted, <dropped> dropped
+ *   connections <opened> opened, <waited> deleted after the disable,
+ *     <immediate> deleted at once, <reenabled> re-enables
+ *   ranging buffers <peak>/<size> (<bytes> bytes), <failed> refused
+ *   PASS interval stretch
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <getopt.h>
+#include "sl_bt_api.h"
+#include "sl_sleeptimer.h"
+#include "app_timer.h"
+#include "cs_initiator.h"
+#include "cs_initiator_client.h"
+#include "cs_initiator_common.h"
+#include "cs_initiator_buffer_pool.h"
+#include "cs_initiator_estimate.h"
+#include "cs_ras_client.h"
+#include "cs_ras_client_timeout.h"
+
+/* Step data sizes, see cs_initiator_extract.c */
+#define MODE_0_INITIATOR  5
+#define MODE_0_REFLECTOR  3
+#define MODE_2_SIZE(a)    (1 + ((a) + 1) * 4)
+#define CALIBRATION_STEPS 3
+#define PBR_STEPS         36
+#define PATHS             1
+
+#define RAS_HANDLE        0x30
+
+#if defined(CS_INITIATOR_RAS_MODE_USE_REAL_TIME_MODE) && (CS_INITIATOR_RAS_MODE_USE_REAL_TIME_MODE == 0)
+#define REAL_TIME         false
+#define MODE_NAME         "on-demand"
+#else
+#define REAL_TIME         true
+#define MODE_NAME         "real-time"
+#endif
+
+typedef enum {
+  CONN_CLOSED,
+  CONN_RUNNING,
+  CONN_DELETING                      /* Waits for the procedure disable */
+} conn_state_t;
+
+typedef enum {
+  STAGE_IDLE,                        /* Next is the first CS result */
+  STAGE_INITIATOR,                   /* Next is the last CS result */
+  STAGE_REFLECTOR                    /* Next is the reflector data */
+} stage_t;
+
+typedef struct {
+  conn_state_t state;
+  stage_t stage;
+  uint8_t handle;
+  uint16_t counter;
+  bool accepted;                     /* First CS result started a procedure */
+  cs_initiator_t *instance;          /* From the procedure timer */
+  app_timer_callback_t timer_callback;
+  uint8_t *rx_buffer;                /* Real-Time receive or On-Demand GET */
+  bool rx_armed;
+  uint16_t get_counter;
+  bool get_requested;
+  uint16_t estimated_counter;
+  bool estimated;
+} stress_conn_t;
+
+static stress_conn_t connections[CS_INITIATOR_MAX_CONNECTIONS];
+static uint8_t connection_count = CS_INITIATOR_MAX_CONNECTIONS;
+static uint8_t next_handle = 1;
+static const char *action = "init";
+
+/* Stub behavior set by the driver */
+static sl_status_t disable_status = SL_STATUS_OK;
+static uint16_t requested_interval;
+static bool refusal_expected;
+static unsigned long refusal_errors;
+static unsigned long timer_stops;
+
+static unsigned int abort_percent = 2;
+static unsigned int lost_percent = 2;
+static unsigned int reenable_percent = 1;
+static unsigned int delete_percent = 1;
+
+static unsigned long started;
+static unsigned long estimated;
+static unsigned long aborted;
+static unsigned long dropped;
+static unsigned long opened;
+static unsigned long deleted_waited;
+static unsigned long deleted_immediate;
+static unsigned long reenabled;
+
+static void fail(const char *test, const char *what)
+{
+  printf("FAIL %s: %s after %s\n", test, what, action);
+  exit(1);
+}
+
+static stress_conn_t *get_connection(uint8_t conn_handle)
+{
+  for (uint8_t i = 0; i < connection_count; i++) {
+    if (connections[i].state != CONN_CLOSED && connections[i].handle == conn_handle) {
+      return &connections[i];
+    }
+  }
+  return NULL;
+}
+
+static unsigned int percent(void)
+{
+  return (unsigned int)rand() % 100u;
+}
+
+/* ---- Recording ---- */
+
+static FILE *recording;
+
+/* One line of the recording, the format is in state_machine_bench.c */
+static void record(const char *format, ...)
+{
+  va_list args;
+
+  if (recording == NULL) {
+    return;
+  }
+  va_start(args, format);
+  vfprintf(recording, format, args);
+  va_end(args);
+}
+
+/* ---- Stubs of the Bluetooth stack ---- */
+
+sl_status_t sl_bt_connection_get_security_status(uint8_t connection,
+                                                 uint8_t *security_mode,
+                                                 uint8_t *key_size,
+                                                 uint8_t *bonding_handle)
+{
+  (void)connection;
+  (void)key_size;
+  (void)bonding_handle;
+  *security_mode = sl_bt_connection_mode1_level2;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_connection_set_parameters(uint8_t connection,
+                                            uint16_t min_interval,
+                                            uint16_t max_interval,
+                                            uint16_t latency,
+                                            uint16_t timeout,
+                                            uint16_t min_ce_length,
+                                            uint16_t max_ce_length)
+{
+  (void)connection;
+  (void)min_interval;
+  (void)latency;
+  (void)timeout;
+  (void)min_ce_length;
+  (void)max_ce_length;
+  requested_interval = max_interval;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_connection_set_preferred_phy(uint8_t connection,
+                                               uint8_t preferred_phy,
+                                               uint8_t accepted_phy)
+{
+  (void)connection;
+  (void)preferred_phy;
+  (void)accepted_phy;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_sm_increase_security(uint8_t connection)
+{
+  (void)connection;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_gatt_discover_primary_services(uint8_t connection)
+{
+  (void)connection;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_gatt_discover_characteristics(uint8_t connection, uint32_t service)
+{
+  (void)connection;
+  (void)service;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_cs_set_default_settings(uint8_t connection,
+                                          uint8_t initiator_status,
+                                          uint8_t reflector_status,
+                                          uint8_t antenna_identifier,
+                                          int8_t max_tx_power)
+{
+  (void)connection;
+  (void)initiator_status;
+  (void)reflector_status;
+  (void)antenna_identifier;
+  (void)max_tx_power;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_cs_security_enable(uint8_t connection)
+{
+  (void)connection;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_cs_create_config(uint8_t connection,
+                                   uint8_t config_id,
+                                   uint8_t create_context,
+                                   uint8_t main_mode_type,
+                                   uint8_t sub_mode_type,
+                                   uint8_t min_main_mode_steps,
+                                   uint8_t max_main_mode_steps,
+                                   uint8_t main_mode_repetition,
+                                   uint8_t mode_calibration_steps,
+                                   uint8_t role,
+                                   uint8_t rtt_type,
+                                   uint8_t cs_sync_phy,
+                                   const sl_bt_cs_channel_map_t *channel_map,
+                                   uint8_t channel_map_repetition,
+                                   uint8_t channel_selection_type,
+                                   uint8_t ch3c_shape,
+                                   uint8_t ch3c_jump,
+                                   uint8_t reserved)
+{
+  (void)connection;
+  (void)config_id;
+  (void)create_context;
+  (void)main_mode_type;
+  (void)sub_mode_type;
+  (void)min_main_mode_steps;
+  (void)max_main_mode_steps;
+  (void)main_mode_repetition;
+  (void)mode_calibration_steps;
+  (void)role;
+  (void)rtt_type;
+  (void)cs_sync_phy;
+  (void)channel_map;
+  (void)channel_map_repetition;
+  (void)channel_selection_type;
+  (void)ch3c_shape;
+  (void)ch3c_jump;
+  (void)reserved;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_cs_remove_config(uint8_t connection, uint8_t config_id)
+{
+  (void)connection;
+  (void)config_id;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_cs_set_procedure_parameters(uint8_t connection,
+                                              uint8_t config_id,
+                                              uint16_t max_procedure_len,
+                                              uint16_t min_procedure_interval,
+                                              uint16_t max_procedure_interval,
+                                              uint16_t max_procedure_count,
+                                              uint32_t min_subevent_len,
+                                              uint32_t max_subevent_len,
+                                              uint8_t tone_antenna_config_selection,
+                                              uint8_t phy,
+                                              int8_t tx_pwr_delta,
+                                              uint8_t preferred_peer_antenna,
+                                              uint8_t snr_control_initiator,
+                                              uint8_t snr_control_reflector)
+{
+  (void)connection;
+  (void)config_id;
+  (void)max_procedure_len;
+  (void)min_procedure_interval;
+  (void)max_procedure_interval;
+  (void)max_procedure_count;
+  (void)min_subevent_len;
+  (void)max_subevent_len;
+  (void)tone_antenna_config_selection;
+  (void)phy;
+  (void)tx_pwr_delta;
+  (void)preferred_peer_antenna;
+  (void)snr_control_initiator;
+  (void)snr_control_reflector;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_cs_procedure_enable(uint8_t connection, uint8_t enable, uint8_t config_id)
+{
+  (void)connection;
+  (void)config_id;
+  return (enable == sl_bt_cs_procedure_state_disabled) ? disable_status : SL_STATUS_OK;
+}
+
+/* ---- Stubs of the timers ---- */
+
+uint32_t sl_sleeptimer_get_tick_count(void)
+{
+  return 0;
+}
+
+uint32_t sl_sleeptimer_tick_to_ms(uint32_t tick)
+{
+  return tick;
+}
+
+sl_status_t app_timer_start(app_timer_t *timer,
+                            uint32_t timeout_ms,
+                            app_timer_callback_t callback,
+                            void *callback_data,
+                            bool is_periodic)
+{
+  cs_initiator_t *initiator = (cs_initiator_t *)callback_data;
+  stress_conn_t *conn = get_connection(initiator->conn_handle);
+
+  // The procedure timer is the one place that shows the instance
+  if (conn != NULL && timer == &initiator->timer_handle) {
+    conn->instance = initiator;
+    conn->timer_callback = callback;
+  }
+  (void)timeout_ms;
+  (void)is_periodic;
+  return SL_STATUS_OK;
+}
+
+sl_status_t app_timer_stop(app_timer_t *timer)
+{
+  (void)timer;
+  timer_stops++;
+  return SL_STATUS_OK;
+}
+
+/* ---- Stubs of the RTL library and the estimation ---- */
+
+enum sl_rtl_error_code rtl_library_init(const uint8_t conn_handle,
+                                        sl_rtl_cs_libitem *handle,
+                                        rtl_config_t      *config,
+                                        uint8_t           *instance_id)
+{
+  (void)conn_handle;
+  (void)handle;
+  (void)config;
+  (void)instance_id;
+  return SL_RTL_ERROR_SUCCESS;
+}
+
+enum sl_rtl_error_code rtl_library_create_estimator(const uint8_t conn_handle,
+                                                    sl_rtl_cs_libitem *handle,
+                                                    rtl_config_t      *config,
+                                                    sl_rtl_cs_params  *cs_parameters,
+                                                    const uint8_t     cs_mode,
+                                                    const uint8_t     cs_sub_mode)
+{
+  (void)conn_handle;
+  (void)handle;
+  (void)config;
+  (void)cs_parameters;
+  (void)cs_mode;
+  (void)cs_sub_mode;
+  return SL_RTL_ERROR_SUCCESS;
+}
+
+uint32_t get_num_tones_from_channel_map(const uint8_t *ch_map, const uint32_t ch_map_len)
+{
+  (void)ch_map;
+  (void)ch_map_len;
+  return 72;
+}
+
+void calculate_distance(cs_initiator_t *initiator)
+{
+  stress_conn_t *conn = get_connection(initiator->conn_handle);
+  cs_ras_ranging_header_t *header;
+
+  if (conn == NULL) {
+    fail("lifetimes", "estimation of an unknown connection");
+  }
+  if (initiator->data.initiator.ranging_data == NULL
+      || initiator->data.reflector.ranging_data == NULL) {
+    fail("lifetimes", "estimation without both buffers");
+  }
+  if (initiator->data.reflector.ranging_data != conn->rx_buffer) {
+    fail("lifetimes", "estimation of a reflector buffer the RAS client did not fill");
+  }
+  header = (cs_ras_ranging_header_t *)initiator->data.reflector.ranging_data;
+  if (header->ranging_counter != initiator->ranging_counter) {
+    fail("lifetimes", "estimation of mismatched halves");
+  }
+  conn->estimated = true;
+  conn->estimated_counter = initiator->ranging_counter;
+}
+
+enum sl_rtl_error_code sl_rtl_cs_deinit(sl_rtl_cs_libitem *item)
+{
+  (void)item;
+  return SL_RTL_ERROR_SUCCESS;
+}
+
+enum sl_rtl_error_code sl_rtl_cs_set_cs_params(sl_rtl_cs_libitem *item,
+                                               const sl_rtl_cs_params *params)
+{
+  (void)item;
+  (void)params;
+  return SL_RTL_ERROR_SUCCESS;
+}
+
+enum sl_rtl_error_code sl_rtl_util_validate_bluetooth_cs_channel_map(const sl_rtl_cs_mode cs_mode,
+                                                                     const sl_rtl_cs_algo_mode algo_mode,
+                                                                     const uint8_t channel_map[10])
+{
+  (void)cs_mode;
+  (void)algo_mode;
+  (void)channel_map;
+  return SL_RTL_ERROR_SUCCESS;
+}
+
+/* ---- Stubs of the RAS client ---- */
+
+sl_status_t cs_ras_client_create(uint8_t connection,
+                                 cs_ras_gattdb_handles_t *handles,
+                                 uint16_t att_mtu)
+{
+  (void)connection;
+  (void)handles;
+  (void)att_mtu;
+  return SL_STATUS_OK;
+}
+
+sl_status_t cs_ras_client_create_initialized(uint8_t connection,
+                                             cs_ras_gattdb_handles_t *handles,
+                                             uint16_t att_mtu,
+                                             cs_ras_features_t features)
+{
+  (void)connection;
+  (void)handles;
+  (void)att_mtu;
+  (void)features;
+  return SL_STATUS_OK;
+}
+
+sl_status_t cs_ras_client_get_features(uint8_t connection, cs_ras_features_t *features)
+{
+  (void)connection;
+  *features = CS_RAS_FEATURE_RT_RANGING_DATA_MASK;
+  return SL_STATUS_OK;
+}
+
+sl_status_t cs_ras_client_configure(uint8_t connection, cs_ras_client_config_t config)
+{
+  (void)connection;
+  (void)config;
+  return SL_STATUS_OK;
+}
+
+sl_status_t cs_ras_client_select_mode(uint8_t connection, cs_ras_mode_t mode)
+{
+  (void)connection;
+  (void)mode;
+  return SL_STATUS_OK;
+}
+
+sl_status_t cs_ras_client_procedure_enabled(uint8_t connection, bool enabled)
+{
+  (void)connection;
+  (void)enabled;
+  return SL_STATUS_OK;
+}
+
+sl_status_t cs_ras_client_real_time_receive(uint8_t connection, uint32_t data_size, uint8_t *data)
+{
+  stress_conn_t *conn = get_connection(connection);
+
+  if (conn == NULL || data == NULL || data_size < CS_INITIATOR_MAX_RANGING_DATA_SIZE) {
+    fail("lifetimes", "Real-Time receive without a buffer");
+  }
+  conn->rx_buffer = data;
+  conn->rx_armed = true;
+  return SL_STATUS_OK;
+}
+
+sl_status_t cs_ras_client_get_ranging_data(uint8_t connection,
+                                           uint16_t ranging_counter,
+                                           uint32_t data_size,
+                                           uint8_t *data)
+{
+  stress_conn_t *conn = get_connection(connection);
+
+  if (conn == NULL || data == NULL || data_size < CS_INITIATOR_MAX_RANGING_DATA_SIZE) {
+    fail("lifetimes", "GET ranging data without a buffer");
+  }
+  conn->rx_buffer = data;
+  conn->get_counter = ranging_counter;
+  conn->get_requested = true;
+  return SL_STATUS_OK;
+}
+
+sl_status_t cs_ras_client_ack(uint8_t connection, cs_ras_ranging_counter_t ranging_counter)
+{
+  (void)connection;
+  (void)ranging_counter;
+  return SL_STATUS_OK;
+}
+
+sl_status_t cs_ras_client_retreive_lost_segments(uint8_t connection,
+                                                 uint16_t ranging_counter,
+                                                 uint8_t start_segment,
+                                                 uint8_t end_segment,
+                                                 uint32_t data_size,
+                                                 uint8_t *data)
+{
+  (void)connection;
+  (void)ranging_counter;
+  (void)start_segment;
+  (void)end_segment;
+  (void)data_size;
+  (void)data;
+  return SL_STATUS_OK;
+}
+
+sl_status_t cs_ras_client_abort(uint8_t connection)
+{
+  (void)connection;
+  return SL_STATUS_OK;
+}
+
+/* ---- Initiator callbacks ---- */
+
+static void on_result(const uint8_t conn_handle,
+                      const uint16_t ranging_counter,
+                      const uint8_t *result,
+                      const cs_result_session_data_t *result_data,
+                      const cs_ranging_data_t *ranging_data,
+                      const void *user_data)
+{
+  (void)conn_handle;
+  (void)ranging_counter;
+  (void)result;
+  (void)result_data;
+  (void)ranging_data;
+  (void)user_data;
+}
+
+static void on_intermediate_result(const cs_intermediate_result_t *result, const void *user_data)
+{
+  (void)result;
+  (void)user_data;
+}
+
+static void on_error_event(uint8_t conn_handle, cs_error_event_t evt, sl_status_t sc)
+{
+  char what[64];
+
+  // The only error allowed is a Real-Time buffer refused by a full pool
+  if (refusal_expected
+      && evt == CS_ERROR_EVENT_RAS_CLIENT_REALTIME_RECEIVE_FAILED
+      && sc == SL_STATUS_NO_MORE_RESOURCE) {
+    refusal_errors++;
+    return;
+  }
+  snprintf(what, sizeof(what), "connection %u error %u, sc 0x%lx",
+           conn_handle, (unsigned int)evt, (unsigned long)sc);
+  fail("lifetimes", what);
+}
+
+/* ---- Events ---- */
+
+static union {
+  sl_bt_msg_t msg;
+  uint8_t raw[sizeof(sl_bt_msg_t) + 256];
+} event;
+
+static sl_bt_msg_t *new_event(uint32_t id)
+{
+  memset(&event, 0, sizeof(event));
+  event.msg.header = id;
+  return &event.msg;
+}
+
+static void send_event(sl_bt_msg_t *evt)
+{
+  if (recording != NULL) {
+    size_t size = sizeof(event);
+
+    // Trailing zero bytes are left out
+    while (size > offsetof(sl_bt_msg_t, data) && event.raw[size - 1] == 0) {
+      size--;
+    }
+    fprintf(recording, "E,%08lx,", (unsigned long)evt->header);
+    for (size_t i = offsetof(sl_bt_msg_t, data); i < size; i++) {
+      fprintf(recording, "%02x", event.raw[i]);
+    }
+    fputc('\n', recording);
+  }
+  (void)cs_initiator_on_event(evt);
+}
+
+static uint8_t put_steps(uint8_t *data, unsigned int first, unsigned int count)
+{
+  uint8_t len = 0;
+
+  for (unsigned int step = first; step < first + count; step++) {
+    uint8_t size = (step < CALIBRATION_STEPS) ? MODE_0_INITIATOR : MODE_2_SIZE(PATHS);
+
+    data[len++] = (step < CALIBRATION_STEPS) ? 0 : 2;
+    data[len++] = (uint8_t)(2 + step % 20);
+    data[len++] = size;
+    memset(&data[len], (int)step, size);
+    len += size;
+  }
+  return len;
+}
+
+/* First half of the initiator steps, the procedure continues */
+static void send_first_result(stress_conn_t *conn)
+{
+  sl_bt_msg_t *evt = new_event(sl_bt_evt_cs_result_id);
+  sl_bt_evt_cs_result_t *result = &evt->data.evt_cs_result;
+  unsigned int steps = (CALIBRATION_STEPS + PBR_STEPS) / 2;
+
+  result->connection = conn->handle;
+  result->procedure_counter = conn->counter;
+  result->procedure_done_status = sl_bt_cs_done_status_partial_results_continue;
+  result->subevent_done_status = sl_bt_cs_done_status_partial_results_continue;
+  result->num_antenna_paths = PATHS;
+  result->num_steps = (uint8_t)steps;
+  result->data.len = put_steps(result->data.data, 0, steps);
+  send_event(evt);
+}
+
+/* Second half, complete or aborted by the controller */
+static void send_last_result(stress_conn_t *conn, bool abort)
+{
+  sl_bt_msg_t *evt = new_event(sl_bt_evt_cs_result_continue_id);
+  sl_bt_evt_cs_result_continue_t *result = &evt->data.evt_cs_result_continue;
+  unsigned int first = (CALIBRATION_STEPS + PBR_STEPS) / 2;
+  uint8_t done = abort ? sl_bt_cs_done_status_aborted : sl_bt_cs_done_status_complete;
+
+  result->connection = conn->handle;
+  result->procedure_done_status = done;
+  result->subevent_done_status = done;
+  result->num_antenna_paths = PATHS;
+  result->num_steps = (uint8_t)(CALIBRATION_STEPS + PBR_STEPS - first);
+  result->data.len = put_steps(result->data.data, first, CALIBRATION_STEPS + PBR_STEPS - first);
+  send_event(evt);
+}
+
+static uint32_t build_reflector(uint8_t *body, uint16_t counter)
+{
+  cs_ras_ranging_header_t *header = (cs_ras_ranging_header_t *)body;
+  cs_ras_subevent_header_t *subevent = (cs_ras_subevent_header_t *)&body[sizeof(*header)];
+  uint32_t size = sizeof(*header) + sizeof(*subevent);
+
+  memset(body, 0, size);
+  header->ranging_counter = counter & CS_RAS_RANGING_COUNTER_MASK;
+  header->antenna_paths_mask = (uint8_t)((1u << PATHS) - 1u);
+  subevent->ranging_done_status = sl_bt_cs_done_status_complete;
+  subevent->subevent_done_status = sl_bt_cs_done_status_complete;
+  subevent->number_of_steps_reported = CALIBRATION_STEPS + PBR_STEPS;
+  for (unsigned int step = 0; step < CALIBRATION_STEPS + PBR_STEPS; step++) {
+    uint8_t step_size = (step < CALIBRATION_STEPS) ? MODE_0_REFLECTOR : MODE_2_SIZE(PATHS);
+
+    body[size++] = (step < CALIBRATION_STEPS) ? 0 : 2;
+    memset(&body[size], (int)step, step_size);
+    size += step_size;
+  }
+  return size;
+}
+
+static void send_enable_complete(stress_conn_t *conn, uint8_t state)
+{
+  sl_bt_msg_t *evt = new_event(sl_bt_evt_cs_procedure_enable_complete_id);
+
+  evt->data.evt_cs_procedure_enable_complete.connection = conn->handle;
+  evt->data.evt_cs_procedure_enable_complete.state = state;
+  evt->data.evt_cs_procedure_enable_complete.status = SL_STATUS_OK;
+  send_event(evt);
+}
+
+/* ---- Checks ---- */
+
+static void check_pool(void)
+{
+  cs_initiator_buffer_pool_stats_t stats;
+  const uint8_t *held[2 * CS_INITIATOR_MAX_CONNECTIONS];
+  unsigned int count = 0;
+
+  for (uint8_t i = 0; i < connection_count; i++) {
+    cs_initiator_t *instance = connections[i].instance;
+
+    if (instance == NULL || connections[i].state == CONN_CLOSED) {
+      continue;
+    }
+    if (instance->data.initiator.ranging_data != NULL) {
+      held[count++] = instance->data.initiator.ranging_data;
+    }
+    if (instance->data.reflector.ranging_data != NULL) {
+      held[count++] = instance->data.reflector.ranging_data;
+    }
+  }
+  for (unsigned int i = 0; i < count; i++) {
+    for (unsigned int j = i + 1; j < count; j++) {
+      if (held[i] == held[j]) {
+        fail("lifetimes", "buffer held twice");
+      }
+    }
+  }
+  cs_initiator_buffer_pool_get_stats(&stats);
+  if (stats.in_use != count) {
+    fail("lifetimes", (stats.in_use > count) ? "buffer leaked" : "buffer held but not lent");
+  }
+}
+
+static void check_reflector_held(stress_conn_t *conn)
+{
+  if (!REAL_TIME || conn->instance == NULL) {
+    return;
+  }
+  if (conn->instance->data.reflector.ranging_data == NULL
+      || conn->instance->data.reflector.ranging_data != conn->rx_buffer) {
+    fail("lifetimes", "Real-Time reflector buffer not held");
+  }
+}
+
+static void check_procedure_released(stress_conn_t *conn)
+{
+  if (conn->instance->data.initiator.ranging_data != NULL) {
+    fail("lifetimes", "initiator buffer held after the procedure");
+  }
+  if (!REAL_TIME && conn->instance->data.reflector.ranging_data != NULL) {
+    fail("lifetimes", "On-Demand reflector buffer held after the procedure");
+  }
+}
+
+static void check_instance_released(cs_initiator_t *instance)
+{
+  if (instance != NULL
+      && (instance->data.initiator.ranging_data != NULL
+          || instance->data.reflector.ranging_data != NULL)) {
+    fail("lifetimes", "buffer held after delete");
+  }
+}
+
+/* True if the pool has no buffer left, a refused lend is then expected */
+static bool pool_full(void)
+{
+  cs_initiator_buffer_pool_stats_t stats;
+
+  cs_initiator_buffer_pool_get_stats(&stats);
+  return stats.in_use == stats.size;
+}
+
+/* ---- Actions ---- */
+
+static void close_connection(stress_conn_t *conn)
+{
+  cs_initiator_t *instance = conn->instance;
+
+  conn->state = CONN_CLOSED;
+  conn->instance = NULL;
+  check_instance_released(instance);
+}
+
+static void delete_connection(stress_conn_t *conn)
+{
+  action = "delete";
+  disable_status = (rand() & 1) ? SL_STATUS_OK : SL_STATUS_INVALID_HANDLE;
+  record("D,%u,%lu\n", conn->handle, (unsigned long)disable_status);
+  if (cs_initiator_delete(conn->handle) != SL_STATUS_OK) {
+    fail("lifetimes", "delete refused");
+  }
+  if (disable_status == SL_STATUS_OK) {
+    conn->state = CONN_DELETING;
+  } else {
+    deleted_immediate++;
+    close_connection(conn);
+  }
+  disable_status = SL_STATUS_OK;
+}
+
+static void open_connection(stress_conn_t *conn)
+{
+  cs_initiator_config_t config = INITIATOR_CONFIG_DEFAULT;
+  rtl_config_t rtl_config = RTL_CONFIG_DEFAULT;
+  cs_ras_gattdb_handles_t handles;
+  sl_bt_msg_t *evt;
+  uint8_t instance_id;
+  unsigned long refusals = refusal_errors;
+
+  action = "connect";
+  while (get_connection(next_handle) != NULL || next_handle == SL_BT_INVALID_CONNECTION_HANDLE) {
+    next_handle++;
+  }
+  memset(conn, 0, sizeof(*conn));
+  conn->handle = next_handle++;
+  conn->state = CONN_RUNNING;
+  conn->counter = (uint16_t)rand();
+  opened++;
+
+  // One antenna path, as the step data below
+  config.num_antennas = 1;
+  config.cs_tone_antenna_config_idx_req = CS_ANTENNA_CONFIG_INDEX_SINGLE_ONLY;
+  cs_initiator_apply_channel_map_preset(config.channel_map_preset, config.channel_map.data);
+  config.max_procedure_count = 0;
+  record("C,%u\n", conn->handle);
+  if (cs_initiator_create(conn->handle, &config, &rtl_config, on_result,
+                          on_intermediate_result, on_error_event, &instance_id) != SL_STATUS_OK) {
+    fail("lifetimes", "create failed");
+  }
+  memset(&handles, 0, sizeof(handles));
+  for (unsigned int i = 0; i < CS_RAS_CHARACTERISTIC_INDEX_COUNT; i++) {
+    handles.array[i] = (uint16_t)(RAS_HANDLE + 3 * i);
+  }
+  (void)cs_initiator_set_ras_attributes(conn->handle, &handles, CS_RAS_FEATURE_RT_RANGING_DATA_MASK);
+
+  evt = new_event(sl_bt_evt_connection_parameters_id);
+  evt->data.evt_connection_parameters.connection = conn->handle;
+  evt->data.evt_connection_parameters.interval = requested_interval;
+  evt->data.evt_connection_parameters.latency = config.latency;
+  evt->data.evt_connection_parameters.timeout = config.timeout;
+  evt->data.evt_connection_parameters.security_mode = sl_bt_connection_mode1_level2;
+  send_event(evt);
+
+  evt = new_event(sl_bt_evt_cs_security_enable_complete_id);
+  evt->data.evt_cs_security_enable_complete.connection = conn->handle;
+  send_event(evt);
+
+  evt = new_event(sl_bt_evt_cs_config_complete_id);
+  evt->data.evt_cs_config_complete.connection = conn->handle;
+  evt->data.evt_cs_config_complete.config_id = config.config_id;
+  send_event(evt);
+
+  // The Real-Time reflector buffer is lent here
+  refusal_expected = REAL_TIME && pool_full();
+  record("M,%u,%u\n", conn->handle,
+         (unsigned int)(REAL_TIME ? CS_RAS_MODE_REAL_TIME_RANGING_DATA
+                        : CS_RAS_MODE_ON_DEMAND_RANGING_DATA));
+  cs_ras_client_on_mode_changed(conn->handle,
+                                REAL_TIME ? CS_RAS_MODE_REAL_TIME_RANGING_DATA
+                                : CS_RAS_MODE_ON_DEMAND_RANGING_DATA,
+                                SL_STATUS_OK);
+  refusal_expected = false;
+  if (refusal_errors != refusals) {
+    // The application gives up on the connection
+    action = "connect without a buffer";
+    if (conn->instance != NULL) {
+      fail("lifetimes", "procedure started without a reflector buffer");
+    }
+    delete_connection(conn);
+    if (conn->state == CONN_DELETING) {
+      send_enable_complete(conn, sl_bt_cs_procedure_state_disabled);
+      deleted_waited++;
+      close_connection(conn);
+    }
+    return;
+  }
+  if (conn->instance == NULL) {
+    fail("lifetimes", "procedure not enabled");
+  }
+  send_enable_complete(conn, sl_bt_cs_procedure_state_enabled);
+  check_reflector_held(conn);
+  if (conn->instance->data.initiator.ranging_data != NULL) {
+    fail("lifetimes", "initiator buffer held before the first procedure");
+  }
+}
+
+static void reenable_real_time(stress_conn_t *conn)
+{
+  unsigned long refusals = refusal_errors;
+
+  action = "Real-Time re-enable";
+  conn->rx_armed = false;
+  record("M,%u,%u\n", conn->handle, (unsigned int)CS_RAS_MODE_NONE);
+  cs_ras_client_on_mode_changed(conn->handle, CS_RAS_MODE_NONE, SL_STATUS_OK);
+  // The buffer is kept, lending it again has to be a no-op
+  record("M,%u,%u\n", conn->handle, (unsigned int)CS_RAS_MODE_REAL_TIME_RANGING_DATA);
+  cs_ras_client_on_mode_changed(conn->handle, CS_RAS_MODE_REAL_TIME_RANGING_DATA, SL_STATUS_OK);
+  if (refusal_errors != refusals || !conn->rx_armed) {
+    fail("lifetimes", "Real-Time reception not re-enabled");
+  }
+  reenabled++;
+}
+
+static void deliver_reflector(stress_conn_t *conn)
+{
+  uint32_t size;
+
+  action = "reflector data";
+  record("R,%u,%u\n", conn->handle, (unsigned int)conn->counter);
+  if (REAL_TIME) {
+    if (!conn->rx_armed) {
+      fail("lifetimes", "reflector data without Real-Time reception");
+    }
+    conn->rx_armed = false;
+  } else {
+    conn->get_requested = false;
+    cs_ras_client_on_ranging_data_ready(conn->handle, conn->counter & CS_RAS_RANGING_COUNTER_MASK);
+    if (!conn->get_requested) {
+      // No GET without an initiator half or without a buffer
+      return;
+    }
+    if (conn->get_counter != (conn->counter & CS_RAS_RANGING_COUNTER_MASK)) {
+      fail("lifetimes", "GET of another counter");
+    }
+  }
+  size = build_reflector(conn->rx_buffer, conn->counter);
+  cs_ras_client_on_ranging_data_segment(conn->handle, 0, size);
+  cs_ras_client_on_ranging_data_reception_finished(conn->handle,
+                                                   REAL_TIME,
+                                                   false,
+                                                   SL_STATUS_OK,
+                                                   CS_RAS_CP_RESPONSE_CODE_SUCCESS,
+                                                   conn->counter & CS_RAS_RANGING_COUNTER_MASK,
+                                                   0,
+                                                   0,
+                                                   true,
+                                                   size,
+                                                   true,
+                                                   0,
+                                                   0);
+}
+
+static void procedure_step(stress_conn_t *conn)
+{
+  unsigned long refused;
+  cs_initiator_buffer_pool_stats_t stats;
+
+  switch (conn->stage) {
+    case STAGE_IDLE:
+      action = "first CS result";
+      conn->counter++;
+      started++;
+      cs_initiator_buffer_pool_get_stats(&stats);
+      refused = stats.failed;
+      send_first_result(conn);
+      conn->accepted = (conn->instance->ranging_counter
+                        == (conn->counter & CS_RAS_RANGING_COUNTER_MASK));
+      cs_initiator_buffer_pool_get_stats(&stats);
+      if (conn->accepted && conn->instance->data.initiator.ranging_data == NULL
+          && stats.failed == refused) {
+        fail("lifetimes", "initiator buffer not lent");
+      }
+      conn->stage = STAGE_INITIATOR;
+      break;
+    case STAGE_INITIATOR:
+      if (percent() < abort_percent) {
+        action = "aborted CS result";
+        send_last_result(conn, true);
+        if (conn->accepted) {
+          aborted++;
+          check_procedure_released(conn);
+        } else {
+          dropped++;
+        }
+        conn->stage = STAGE_IDLE;
+        break;
+      }
+      action = "last CS result";
+      send_last_result(conn, false);
+      if (!conn->accepted) {
+        dropped++;
+      }
+      conn->stage = STAGE_REFLECTOR;
+      break;
+    default:
+      conn->stage = STAGE_IDLE;
+      if (percent() < lost_percent) {
+        // The initiator half waits for the drop counter
+        if (conn->accepted) {
+          dropped++;
+        }
+        break;
+      }
+      conn->estimated = false;
+      deliver_reflector(conn);
+      if (conn->estimated) {
+        if (conn->estimated_counter != (conn->counter & CS_RAS_RANGING_COUNTER_MASK)) {
+          fail("lifetimes", "estimation of another procedure");
+        }
+        estimated++;
+        check_procedure_released(conn);
+      } else if (conn->accepted) {
+        dropped++;
+      }
+      break;
+  }
+  check_reflector_held(conn);
+}
+
+static void run(unsigned long procedures)
+{
+  cs_initiator_buffer_pool_stats_t stats;
+
+  while (started < procedures) {
+    stress_conn_t *conn = &connections[(unsigned int)rand() % connection_count];
+
+    switch (conn->state) {
+      case CONN_CLOSED:
+        open_connection(conn);
+        break;
+      case CONN_DELETING:
+        action = "procedure disabled";
+        send_enable_complete(conn, sl_bt_cs_procedure_state_disabled);
+        deleted_waited++;
+        close_connection(conn);
+        break;
+      default:
+        if (percent() < delete_percent) {
+          delete_connection(conn);
+        } else if (REAL_TIME && percent() < reenable_percent) {
+          reenable_real_time(conn);
+        } else {
+          procedure_step(conn);
+        }
+        break;
+    }
+    check_pool();
+  }
+
+  // Close everything, nothing may stay lent
+  for (uint8_t i = 0; i < connection_count; i++) {
+    if (connections[i].state == CONN_RUNNING) {
+      delete_connection(&connections[i]);
+    }
+    if (connections[i].state == CONN_DELETING) {
+      action = "procedure disabled";
+      send_enable_complete(&connections[i], sl_bt_cs_procedure_state_disabled);
+      deleted_waited++;
+      close_connection(&connections[i]);
+    }
+  }
+  action = "closing all connections";
+  cs_initiator_buffer_pool_get_stats(&stats);
+  if (stats.in_use != 0) {
+    fail("lifetimes", "buffer leaked");
+  }
+  printf("PASS lifetimes\n");
+}
+
+/* One procedure to its estimation */
+static void run_procedure(stress_conn_t *conn)
+{
+  unsigned long before = estimated;
+
+  while (conn->stage != STAGE_REFLECTOR) {
+    procedure_step(conn);
+  }
+  procedure_step(conn);
+  if (estimated == before) {
+    fail("interval stretch", "procedure not estimated");
+  }
+}
+
+/* The disable at the procedure boundary, the pending interval follows */
+static void stretch_boundary(stress_conn_t *conn)
+{
+  run_procedure(conn);
+  if (conn->instance->initiator_state != (uint8_t)INITIATOR_STATE_WAIT_PROCEDURE_DISABLE_COMPLETE) {
+    fail("interval stretch", "procedures not disabled at the boundary");
+  }
+  action = "procedure disabled at the boundary";
+  send_enable_complete(conn, sl_bt_cs_procedure_state_disabled);
+}
+
+static void check_restarted(stress_conn_t *conn, uint16_t interval)
+{
+  cs_initiator_t *instance = conn->instance;
+
+  if (instance->wait_connection_parameters) {
+    fail("interval stretch", "still waiting for the connection parameters");
+  }
+  if (instance->config.max_connection_interval != interval
+      || instance->config.min_connection_interval != interval) {
+    fail("interval stretch", "configured interval not the one in use");
+  }
+  if (instance->initiator_state != (uint8_t)INITIATOR_STATE_WAIT_PROCEDURE_ENABLE_COMPLETE) {
+    fail("interval stretch", "procedures not enabled again");
+  }
+  send_enable_complete(conn, sl_bt_cs_procedure_state_enabled);
+}
+
+static void run_interval_stretch(void)
+{
+  stress_conn_t *conn = &connections[0];
+  cs_initiator_t *instance;
+  uint16_t base;
+  unsigned long stops;
+  sl_bt_msg_t *evt;
+
+  abort_percent = 0;
+  lost_percent = 0;
+  open_connection(conn);
+  instance = conn->instance;
+  base = instance->conn_interval;
+
+  // The peer ignores the update, the procedure timer elapses
+  action = "interval stretch";
+  if (cs_initiator_set_connection_interval_factor(conn->handle, 2) != SL_STATUS_OK) {
+    fail("interval stretch", "stretch refused");
+  }
+  stretch_boundary(conn);
+  if (!instance->wait_connection_parameters || requested_interval != 2 * base
+      || instance->initiator_state != (uint8_t)INITIATOR_STATE_START_PROCEDURE) {
+    fail("interval stretch", "update not requested at the boundary");
+  }
+  action = "ignored interval update";
+  conn->timer_callback(&instance->timer_handle, instance);
+  check_restarted(conn, base);
+
+  // The peer takes the update
+  action = "interval stretch";
+  if (cs_initiator_set_connection_interval_factor(conn->handle, 2) != SL_STATUS_OK) {
+    fail("interval stretch", "stretch refused");
+  }
+  stretch_boundary(conn);
+  if (!instance->wait_connection_parameters) {
+    fail("interval stretch", "update not requested again");
+  }
+  action = "interval update";
+  stops = timer_stops;
+  evt = new_event(sl_bt_evt_connection_parameters_id);
+  evt->data.evt_connection_parameters.connection = conn->handle;
+  evt->data.evt_connection_parameters.interval = requested_interval;
+  evt->data.evt_connection_parameters.latency = instance->config.latency;
+  evt->data.evt_connection_parameters.timeout = instance->config.timeout;
+  evt->data.evt_connection_parameters.security_mode = sl_bt_connection_mode1_level2;
+  send_event(evt);
+  if (timer_stops == stops) {
+    fail("interval stretch", "procedure timer left running");
+  }
+  if (instance->cs_parameters.connection_interval != 2 * base) {
+    fail("interval stretch", "estimator not on the new interval");
+  }
+  check_restarted(conn, (uint16_t)(2 * base));
+  run_procedure(conn);
+
+  delete_connection(conn);
+  if (conn->state == CONN_DELETING) {
+    send_enable_complete(conn, sl_bt_cs_procedure_state_disabled);
+    close_connection(conn);
+  }
+  check_pool();
+  printf("PASS interval stretch\n");
+}
+
+int main(int argc, char **argv)
+{
+  cs_initiator_buffer_pool_stats_t stats;
+  unsigned long procedures = 100000;
+  unsigned long value;
+  unsigned int seed = 1;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "p:c:s:a:l:r:d:w:")) != -1) {
+    switch (opt) {
+      case 'p':
+        procedures = strtoul(optarg, NULL, 0);
+        break;
+      case 'c':
+        value = strtoul(optarg, NULL, 0);
+        connection_count = (value >= 1 && value <= CS_INITIATOR_MAX_CONNECTIONS) ? (uint8_t)value : 0;
+        break;
+      case 's':
+        seed = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      case 'a':
+        abort_percent = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      case 'l':
+        lost_percent = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      case 'r':
+        reenable_percent = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      case 'd':
+        delete_percent = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      case 'w':
+        recording = fopen(optarg, "w");
+        if (recording == NULL) {
+          fprintf(stderr, "cannot write %s\n", optarg);
+          return 1;
+        }
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-p procedures] [-c connections] [-s seed] "
+                        "[-a percent] [-l percent] [-r percent] [-d percent] [-w file]\n",
+                argv[0]);
+        return 1;
+    }
+  }
+  if (procedures == 0 || connection_count == 0 || abort_percent > 100
+      || lost_percent > 100 || reenable_percent > 100 || delete_percent > 100) {
+    fprintf(stderr, "invalid parameters\n");
+    return 1;
+  }
+  srand(seed);
+  cs_initiator_init();
+  record("# buffer_pool_stress %s, %lu procedures, %u connections, seed %u\n",
+         MODE_NAME, procedures, connection_count, seed);
+
+  run(procedures);
+
+  cs_initiator_buffer_pool_get_stats(&stats);
+  printf("mode %s, %u connections\n", MODE_NAME, connection_count);
+  printf("procedures %lu estimated, %lu aborted, %lu dropped\n", estimated, aborted, dropped);
+  printf("connections %lu opened, %lu deleted after the disable, %lu deleted at once, "
+         "%lu re-enables\n",
+         opened, deleted_waited, deleted_immediate, reenabled);
+  printf("ranging buffers %u/%u (%u bytes), %lu refused\n",
+         stats.peak, stats.size,
+         (unsigned int)(stats.size * CS_INITIATOR_MAX_RANGING_DATA_SIZE),
+         (unsigned long)stats.failed);
+  if (recording != NULL) {
+    record("S,%lu\n", estimated);
+    fclose(recording);
+  } else {
+    run_interval_stretch();
+  }
+  return 0;
+}
@@ -0,0 +1,142 @@
+/*
+ * cs_capture_dump.c
+ *
+ * Prints a capture stream recorded by cs_initiator_capture.c, read from the
+ * RTT channel "cs_capture", e.g. with JLinkRTTLogger -RTTChannel 5.
+ *
+ * Build (from the project root):
+ *   SDK=simplicity_sdk_2025.6.2
+ *   C=$SDK/app/bluetooth/common
+ *   gcc -O2 -DCS_INITIATOR_CAPTURE=1 -Ihost/shim -I. -Iconfig -Iautogen \
+ *     -I$SDK/platform/common/inc -I$SDK/protocol/bluetooth/inc \
+ *     -I$SDK/util/silicon_labs/rtl/inc -I$C/cs_initiator/inc \
+ *     host/cs_capture_reader.c host/cs_capture_dump.c -Ihost -o cs_capture_dump
+ *
+ * Usage: cs_capture_dump [-v] <capture file or ->
+ *   -v   hex dump the step channels and ranging data bodies
+ *
+ * Output, one line per record:
+ *   <time_ms>,<conn>,procedure,<counter>,<antenna_paths>,<steps>,<initiator_len>,<reflector_len>
+ *   <time_ms>,<conn>,result,<counter>,<rtl_error>[,<field_type>=<value>...]
+ *   <time_ms>,<conn>,lost,<records>
+ *
+ * Start records are printed as comments.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <getopt.h>
+#include "cs_capture_reader.h"
+
+static void hex(const char *name, const uint8_t *data, size_t length)
+{
+  printf("#   %s:", name);
+  for (size_t i = 0; i < length; i++) {
+    printf(" %02x", data[i]);
+  }
+  printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+  cs_capture_reader_t reader;
+  cs_capture_record_t record;
+  bool verbose = false;
+  int opt;
+  int status;
+
+  while ((opt = getopt(argc, argv, "v")) != -1) {
+    switch (opt) {
+      case 'v':
+        verbose = true;
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-v] <capture>\n", argv[0]);
+        return 1;
+    }
+  }
+  if (optind >= argc) {
+    fprintf(stderr, "usage: %s [-v] <capture>\n", argv[0]);
+    return 1;
+  }
+  if (!cs_capture_reader_open(&reader, argv[optind])) {
+    fprintf(stderr, "cannot read capture %s\n", argv[optind]);
+    return 1;
+  }
+
+  while ((status = cs_capture_reader_next(&reader, &record)) > 0) {
+    double time_ms = cs_capture_reader_time_ms(&reader, &record);
+    cs_capture_procedure_t procedure;
+    cs_capture_result_t result;
+    cs_initiator_capture_lost_t lost;
+
+    switch (record.header.type) {
+      case CS_INITIATOR_CAPTURE_RECORD_START:
+        printf("# start, version %u, %u Hz\n",
+               CS_INITIATOR_CAPTURE_VERSION, (unsigned int)reader.timer_frequency);
+        break;
+      case CS_INITIATOR_CAPTURE_RECORD_PROCEDURE:
+        if (!cs_capture_get_procedure(&record, &procedure)) {
+          fprintf(stderr, "malformed procedure record\n");
+          break;
+        }
+        printf("%.3f,%u,procedure,%u,%u,%u,%u,%u\n",
+               time_ms,
+               record.header.conn_handle,
+               procedure.ranging_counter,
+               procedure.procedure.ras_info.num_antenna_paths,
+               procedure.procedure.ras_info.num_steps_reported,
+               procedure.initiator.ranging_data_body_len,
+               procedure.reflector.ranging_data_body_len);
+        if (verbose) {
+          hex("channels",
+              procedure.procedure.ras_info.step_channels,
+              procedure.procedure.ras_info.num_steps_reported);
+          hex("initiator",
+              (const uint8_t *)procedure.initiator.ranging_data_body,
+              procedure.initiator.ranging_data_body_len);
+          hex("reflector",
+              (const uint8_t *)procedure.reflector.ranging_data_body,
+              procedure.reflector.ranging_data_body_len);
+        }
+        break;
+      case CS_INITIATOR_CAPTURE_RECORD_RESULT:
+        if (!cs_capture_get_result(&record, &result)) {
+          fprintf(stderr, "malformed result record\n");
+          break;
+        }
+        printf("%.3f,%u,result,%u,%d",
+               time_ms,
+               record.header.conn_handle,
+               result.ranging_counter,
+               (int)result.rtl_error);
+        for (uint8_t i = 0; i < result.num_fields; i++) {
+          printf(",%u=%g", result.type[i], (double)result.value[i]);
+        }
+        printf("\n");
+        break;
+      case CS_INITIATOR_CAPTURE_RECORD_LOST:
+        if (record.header.length < sizeof(lost)) {
+          fprintf(stderr, "malformed lost record\n");
+          break;
+        }
+        memcpy(&lost, record.payload, sizeof(lost));
+        printf("%.3f,%u,lost,%u\n",
+               time_ms,
+               record.header.conn_handle,
+               (unsigned int)lost.records);
+        break;
+      default:
+        printf("# unknown record type %u\n", record.header.type);
+        break;
+    }
+  }
+  if (status < 0) {
+    fprintf(stderr, "%s\n", reader.error);
+  }
+  fprintf(stderr, "records lost on the target: %u\n", (unsigned int)reader.lost);
+  cs_capture_reader_close(&reader);
+  return status < 0 ? 1 : 0;
+}
@@ -0,0 +1,175 @@
+/*
+ * cs_capture_reader.c
+ *
+ * Reader of the binary capture stream written by cs_initiator_capture.c.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "cs_capture_reader.h"
+
+bool cs_capture_reader_open(cs_capture_reader_t *reader, const char *path)
+{
+  memset(reader, 0, sizeof(*reader));
+  if (strcmp(path, "-") == 0) {
+    reader->file = stdin;
+  } else {
+    reader->file = fopen(path, "rb");
+  }
+  return reader->file != NULL;
+}
+
+void cs_capture_reader_close(cs_capture_reader_t *reader)
+{
+  if (reader->file != NULL && reader->file != stdin) {
+    fclose(reader->file);
+  }
+  free(reader->payload);
+  memset(reader, 0, sizeof(*reader));
+}
+
+static int fail(cs_capture_reader_t *reader, const char *error)
+{
+  reader->error = error;
+  return -1;
+}
+
+static int check_start(cs_capture_reader_t *reader, const cs_capture_record_t *record)
+{
+  cs_initiator_capture_start_t start;
+
+  if (record->header.length < sizeof(start)) {
+    return fail(reader, "truncated start record");
+  }
+  memcpy(&start, record->payload, sizeof(start));
+  if (start.magic != CS_INITIATOR_CAPTURE_MAGIC) {
+    return fail(reader, "bad magic");
+  }
+  if (start.version != CS_INITIATOR_CAPTURE_VERSION) {
+    return fail(reader, "unsupported version");
+  }
+  if (start.cs_params_size != sizeof(sl_rtl_cs_params)
+      || start.procedure_config_size != sizeof(sl_rtl_cs_procedure_config)) {
+    return fail(reader, "RTL structure sizes differ from this build");
+  }
+  if (start.timer_frequency == 0) {
+    return fail(reader, "zero timer frequency");
+  }
+  reader->timer_frequency = start.timer_frequency;
+  return 1;
+}
+
+int cs_capture_reader_next(cs_capture_reader_t *reader, cs_capture_record_t *record)
+{
+  size_t n = fread(&record->header, 1, sizeof(record->header), reader->file);
+
+  if (n == 0) {
+    return 0;
+  }
+  if (n != sizeof(record->header)) {
+    return fail(reader, "truncated header");
+  }
+  if (record->header.length > reader->capacity) {
+    uint8_t *payload = realloc(reader->payload, record->header.length);
+
+    if (payload == NULL) {
+      return fail(reader, "out of memory");
+    }
+    reader->payload = payload;
+    reader->capacity = record->header.length;
+  }
+  record->payload = reader->payload;
+  if (fread(record->payload, 1, record->header.length, reader->file)
+      != record->header.length) {
+    return fail(reader, "truncated payload");
+  }
+
+  /* A new start record restarts the stream, e.g. after a target reset */
+  if (record->header.type == CS_INITIATOR_CAPTURE_RECORD_START) {
+    return check_start(reader, record);
+  }
+  if (reader->timer_frequency == 0) {
+    return fail(reader, "no start record");
+  }
+  if (record->header.type == CS_INITIATOR_CAPTURE_RECORD_LOST
+      && record->header.length >= sizeof(cs_initiator_capture_lost_t)) {
+    cs_initiator_capture_lost_t lost;
+
+    memcpy(&lost, record->payload, sizeof(lost));
+    reader->lost += lost.records;
+  }
+  return 1;
+}
+
+double cs_capture_reader_time_ms(const cs_capture_reader_t *reader,
+                                 const cs_capture_record_t *record)
+{
+  if (reader->timer_frequency == 0) {
+    return 0.0;
+  }
+  return 1000.0 * (double)record->header.timestamp / (double)reader->timer_frequency;
+}
+
+bool cs_capture_get_procedure(const cs_capture_record_t *record,
+                              cs_capture_procedure_t *procedure)
+{
+  cs_initiator_capture_procedure_t fixed;
+  uint8_t *data;
+
+  if (record->header.type != CS_INITIATOR_CAPTURE_RECORD_PROCEDURE
+      || record->header.length < sizeof(fixed)) {
+    return false;
+  }
+  memcpy(&fixed, record->payload, sizeof(fixed));
+  if (record->header.length != sizeof(fixed) + fixed.num_steps
+      + fixed.initiator_len + fixed.reflector_len) {
+    return false;
+  }
+  data = record->payload + sizeof(fixed);
+
+  /* Filled as calculate_distance() does before sl_rtl_ras_process() */
+  memset(procedure, 0, sizeof(*procedure));
+  procedure->ranging_counter = fixed.ranging_counter;
+  procedure->cs_params = fixed.cs_params;
+  procedure->procedure.ras_info.step_channels = data;
+  procedure->procedure.ras_info.num_steps_reported = fixed.num_steps;
+  procedure->procedure.ras_info.num_antenna_paths = fixed.num_antenna_paths;
+  data += fixed.num_steps;
+  procedure->initiator.ranging_data_body = (sl_rtl_ras_ranging_data_body *)data;
+  procedure->initiator.ranging_data_body_len = fixed.initiator_len;
+  data += fixed.initiator_len;
+  procedure->reflector.ranging_data_body = (sl_rtl_ras_ranging_data_body *)data;
+  procedure->reflector.ranging_data_body_len = fixed.reflector_len;
+  procedure->procedure.initiator_ras_measurement = &procedure->initiator;
+  procedure->procedure.reflector_ras_measurement = &procedure->reflector;
+  procedure->procedure.initiator_measurement_type = SL_RTL_RAS;
+  procedure->procedure.reflector_measurement_type = SL_RTL_RAS;
+  procedure->procedure.cs_procedure_config = fixed.procedure_config;
+  return true;
+}
+
+bool cs_capture_get_result(const cs_capture_record_t *record,
+                           cs_capture_result_t *result)
+{
+  cs_initiator_capture_result_t fixed;
+  const uint8_t *data;
+
+  if (record->header.type != CS_INITIATOR_CAPTURE_RECORD_RESULT
+      || record->header.length < sizeof(fixed)) {
+    return false;
+  }
+  memcpy(&fixed, record->payload, sizeof(fixed));
+  if (record->header.length != sizeof(fixed) + fixed.num_fields * (1u + sizeof(float))) {
+    return false;
+  }
+  data = record->payload + sizeof(fixed);
+  result->ranging_counter = fixed.ranging_counter;
+  result->rtl_error = (enum sl_rtl_error_code)fixed.rtl_error;
+  result->num_fields = fixed.num_fields;
+  for (uint8_t i = 0; i < fixed.num_fields; i++) {
+    result->type[i] = data[0];
+    memcpy(&result->value[i], &data[1], sizeof(float));
+    data += 1 + sizeof(float);
+  }
+  return true;
+}
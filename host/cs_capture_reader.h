@@ -0,0 +1,70 @@
+/*
+ * cs_capture_reader.h
+ *
+ * Reader of the binary capture stream written by cs_initiator_capture.c.
+ * Procedure records are turned back into the structures passed to
+ * sl_rtl_ras_process() on the target.
+ */
+
+#ifndef CS_CAPTURE_READER_H_
+#define CS_CAPTURE_READER_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "cs_initiator_capture.h"
+
+typedef struct {
+  FILE *file;
+  uint8_t *payload;
+  size_t capacity;
+  uint32_t timer_frequency;   /* From the start record, 0 before it */
+  uint32_t lost;              /* Sum of the lost records read so far */
+  const char *error;          /* Set when cs_capture_reader_next() fails */
+} cs_capture_reader_t;
+
+typedef struct {
+  cs_initiator_capture_header_t header;
+  uint8_t *payload;           /* Valid until the next record is read */
+} cs_capture_record_t;
+
+/* Input of sl_rtl_ras_process(), pointing into the record payload */
+typedef struct {
+  uint16_t ranging_counter;
+  sl_rtl_cs_params cs_params;
+  sl_rtl_ras_measurement initiator;
+  sl_rtl_ras_measurement reflector;
+  sl_rtl_ras_procedure procedure;
+} cs_capture_procedure_t;
+
+typedef struct {
+  uint16_t ranging_counter;
+  enum sl_rtl_error_code rtl_error;
+  uint8_t num_fields;
+  uint8_t type[UINT8_MAX];
+  float value[UINT8_MAX];
+} cs_capture_result_t;
+
+/* Open a capture file, "-" reads stdin */
+bool cs_capture_reader_open(cs_capture_reader_t *reader, const char *path);
+
+void cs_capture_reader_close(cs_capture_reader_t *reader);
+
+/* Read the next record. Returns 1 for a record, 0 at the end of the stream
+ * and -1 for a malformed stream, with reader->error set. The stream must
+ * begin with a start record of a matching version and layout. */
+int cs_capture_reader_next(cs_capture_reader_t *reader, cs_capture_record_t *record);
+
+/* Record timestamp in ms */
+double cs_capture_reader_time_ms(const cs_capture_reader_t *reader,
+                                 const cs_capture_record_t *record);
+
+/* Decode a procedure record, false if it is not one or is truncated */
+bool cs_capture_get_procedure(const cs_capture_record_t *record,
+                              cs_capture_procedure_t *procedure);
+
+/* Decode a result record, false if it is not one or is truncated */
+bool cs_capture_get_result(const cs_capture_record_t *record,
+                           cs_capture_result_t *result);
+
+#endif /* CS_CAPTURE_READER_H_ */
@@ -0,0 +1,895 @@
+/*
+ * cs_pipeline_bench.c
+ *
+ * Times the initiator side processing of CS procedures on the host:
+ * cs_initiator_extract.c on the CS result events, cs_ras_client_messaging.c
+ * and the step index of cs_ras_format_converter.c on the RAS notifications
+ * of the reflector, and cs_result.c for the result delivery. The RTL
+ * estimation is a prebuilt target library and is not part of it.
+ *
+ * The second binary is built with CS_INITIATOR_CONFIG_PIPELINED_EXTRACT off.
+ * Its steps are then only checked once the procedure is done, where
+ * sl_rtl_ras_process() does it on the target. The bench stands in for that
+ * check with a step index over the initiator data and a channel check, and
+ * reports it as the validate stage. The done stage is the time from the
+ * event that completes a procedure to its result, the latency that
+ * pipelining shortens. Invalid procedures, see -e, are dropped by the
+ * pipelined build when their initiator half is done, by the serial build
+ * after the reflector data.
+ *
+ * Build (from the project root):
+ *   SDK=simplicity_sdk_2025.6.2
+ *   C=$SDK/app/bluetooth/common
+ *   gcc -O2 -Ihost/shim -I. -Iconfig -Iautogen \
+ *     -I$SDK/platform/common/inc -I$SDK/protocol/bluetooth/inc \
+ *     -I$SDK/util/silicon_labs/rtl/inc \
+ *     -I$SDK/app/common/util/app_timer -I$SDK/app/common/util/app_timer/bm \
+ *     -I$C/cs_initiator/inc -I$C/cs_ras/common/inc -I$C/cs_ras/client/inc \
+ *     -I$C/cs_result/inc \
+ *     $C/cs_initiator/src/cs_initiator_extract.c \
+ *     $C/cs_initiator/src/cs_initiator_buffer_pool.c \
+ *     $C/cs_initiator/src/cs_initiator_latency.c \
+ *     $C/cs_ras/common/src/cs_ras_format_converter.c \
+ *     $C/cs_ras/client/src/cs_ras_client_messaging.c \
+ *     $C/cs_result/src/cs_result.c \
+ *     $SDK/platform/common/src/sl_slist.c \
+ *     host/cs_pipeline_bench.c -o cs_pipeline_bench
+ *   gcc -O2 -DCS_INITIATOR_CONFIG_PIPELINED_EXTRACT=0 \
+ *     -Ihost/shim -I. -Iconfig -Iautogen \
+ *     -I$SDK/platform/common/inc -I$SDK/protocol/bluetooth/inc \
+ *     -I$SDK/util/silicon_labs/rtl/inc \
+ *     -I$SDK/app/common/util/app_timer -I$SDK/app/common/util/app_timer/bm \
+ *     -I$C/cs_initiator/inc -I$C/cs_ras/common/inc -I$C/cs_ras/client/inc \
+ *     -I$C/cs_result/inc \
+ *     $C/cs_initiator/src/cs_initiator_extract.c \
+ *     $C/cs_initiator/src/cs_initiator_buffer_pool.c \
+ *     $C/cs_initiator/src/cs_initiator_latency.c \
+ *     $C/cs_ras/common/src/cs_ras_format_converter.c \
+ *     $C/cs_ras/client/src/cs_ras_client_messaging.c \
+ *     $C/cs_result/src/cs_result.c \
+ *     $SDK/platform/common/src/sl_slist.c \
+ *     host/cs_pipeline_bench.c -o cs_pipeline_bench_serial
+ * The component logs are compiled out, add -DHOST_APP_LOG to print them.
+ *
+ * Options:
+ *   -t <file>        replay a capture instead of generated procedures
+ *   -w <file>        write the generated procedures as a capture and exit
+ *   -p <procedures>  generated procedures per connection (1000)
+ *   -c <connections> generated connections, 1..CS_INITIATOR_MAX_CONNECTIONS (1)
+ *   -n <steps>       generated mode 2 steps per procedure (72)
+ *   -a <paths>       generated antenna paths, 1..4 (1)
+ *   -m <mtu>         ATT MTU of the RAS notifications (247)
+ *   -H <handle>      Real-Time Ranging Data characteristic handle (0x30)
+ *   -r <repeat>      replays of the event stream (10)
+ *   -s <seed>        random seed of the generated step data (1)
+ *   -e <percent>     generated procedures with an invalid step channel (0)
+ *
+ * Capture format: BGAPI event frames back to back, each the 4 byte header
+ * and the payload of one event as popped from the stack. cs_result and
+ * cs_result_continue events carry the initiator data, notifications of the
+ * Real-Time Ranging Data characteristic the reflector data, other events are
+ * skipped. As in real-time mode on the target, the reflector buffer of a
+ * connection is lent for good at its first event, and a cs_result event
+ * starts a procedure and drops the previous one if it is still incomplete.
+ *
+ * Output:
+ *   mode <pipelined|serial>
+ *   procedures <delivered> delivered, <dropped> dropped, <n> per second
+ *   # stage,mean_us,p99_us,max_us
+ *   <stage>,<mean_us>,<p99_us>,<max_us>     per delivered procedure
+ *   dropped <us> us, <n> notifications      mean processing and reflector
+ *                                           notifications per dropped one
+ *   stack <bytes>                           high-water mark of the processing
+ *   ranging buffers <peak>/<size> (<bytes> bytes), <failed> refused
+ * The components do not allocate from the heap, the ranging buffers lent by
+ * cs_initiator_buffer_pool.c are their dynamic memory. Times and stack use
+ * are those of the host build and only comparable between runs on the same
+ * host.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <limits.h>
+#include <getopt.h>
+#include <time.h>
+#include <ucontext.h>
+#include "sl_bt_api.h"
+#include "cs_initiator_common.h"
+#include "cs_initiator_buffer_pool.h"
+#include "cs_initiator_extract.h"
+#include "cs_ras_client_messaging.h"
+#include "cs_ras_format_converter.h"
+#include "cs_result.h"
+
+#define STACK_SIZE        (256 * 1024)
+#define STACK_PAINT       0xA5
+
+/* Initiator step data sizes, see cs_initiator_extract.c */
+#define MODE_0_INITIATOR  5
+#define MODE_0_REFLECTOR  3
+#define MODE_2_SIZE(a)    (1 + ((a) + 1) * 4)
+#define CALIBRATION_STEPS 3
+
+typedef enum {
+  STAGE_EXTRACT,      /* extract_cs_result_data() on every CS result event */
+  STAGE_RAS_RX,       /* RAS notifications, segment reassembly and step index */
+  STAGE_RAS_CHECK,    /* ranging_data_is_complete() */
+  STAGE_VALIDATE,     /* Step checks left for the procedure end */
+  STAGE_RESULT,       /* Result encoding and decoding */
+  STAGE_TOTAL,
+  STAGE_DONE,         /* Completing event to result, not part of the total */
+  STAGE_COUNT
+} stage_t;
+
+static const char *stage_names[STAGE_COUNT] = {
+  "extract", "ras_rx", "ras_check", "validate", "result", "total", "done"
+};
+
+#if defined(CS_INITIATOR_CONFIG_PIPELINED_EXTRACT) && (CS_INITIATOR_CONFIG_PIPELINED_EXTRACT == 1)
+#define MODE_NAME         "pipelined"
+#else
+#define MODE_NAME         "serial"
+#endif
+
+typedef struct {
+  bool used;
+  bool active;                       /* Procedure in progress */
+  bool initiator_done;
+  bool reflector_done;
+  bool reception_stopped;            /* Set by the messaging callback */
+  cs_ras_messaging_status_t reception_status;
+  uint32_t reception_size;
+  uint64_t reception_lost;
+  uint32_t notifications;            /* Reflector notifications processed */
+  cs_initiator_t initiator;
+  cs_ras_client_messaging_reception_t rx;
+  uint64_t time_ns[STAGE_COUNT];
+} bench_conn_t;
+
+static bench_conn_t connections[CS_INITIATOR_MAX_CONNECTIONS];
+static cs_ras_gattdb_handles_t handles;
+static uint16_t att_mtu = 247;
+
+static uint8_t *stream;
+static size_t stream_size;
+static size_t stream_capacity;
+static unsigned long repeat = 10;
+
+static uint32_t *samples[STAGE_COUNT];
+static unsigned long sample_capacity;
+static unsigned long delivered;
+static unsigned long dropped;
+static uint64_t dropped_ns;
+static unsigned long dropped_notifications;
+static uint64_t event_start_ns;      /* Start of the event in process */
+static unsigned int invalid_percent;
+static double elapsed_s;
+
+static ucontext_t main_context;
+static ucontext_t bench_context;
+static uint8_t bench_stack[STACK_SIZE];
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* ---- Stubs of the Bluetooth stack ---- */
+
+sl_status_t sl_bt_gatt_send_characteristic_confirmation(uint8_t connection)
+{
+  (void)connection;
+  return SL_STATUS_OK;
+}
+
+/* ---- Procedure bookkeeping ---- */
+
+static bench_conn_t *rx_connection(cs_ras_client_messaging_reception_t *rx)
+{
+  return (bench_conn_t *)((uint8_t *)rx - offsetof(bench_conn_t, rx));
+}
+
+static bench_conn_t *get_connection(uint8_t conn_handle)
+{
+  bench_conn_t *free_conn = NULL;
+
+  for (uint8_t i = 0; i < CS_INITIATOR_MAX_CONNECTIONS; i++) {
+    if (connections[i].used && connections[i].initiator.conn_handle == conn_handle) {
+      return &connections[i];
+    }
+    if (!connections[i].used && free_conn == NULL) {
+      free_conn = &connections[i];
+    }
+  }
+  if (free_conn != NULL) {
+    memset(free_conn, 0, sizeof(*free_conn));
+    free_conn->used = true;
+    free_conn->initiator.conn_handle = conn_handle;
+    reset_subevent_data(&free_conn->initiator, true);
+  }
+  return free_conn;
+}
+
+static void end_procedure(bench_conn_t *conn, bool success)
+{
+  if (conn->rx.segment_status.started) {
+    (void)cs_ras_client_messaging_stop(&conn->rx);
+  }
+  conn->reception_stopped = false;
+  reset_subevent_data(&conn->initiator, true);
+  conn->active = false;
+  if (!success) {
+    dropped++;
+    for (stage_t s = STAGE_EXTRACT; s < STAGE_TOTAL; s++) {
+      dropped_ns += conn->time_ns[s];
+    }
+    dropped_notifications += conn->notifications;
+  }
+}
+
+static void start_procedure(bench_conn_t *conn)
+{
+  cs_ras_messaging_config_t config;
+
+  if (conn->active) {
+    end_procedure(conn, false);
+  }
+  memset(conn->time_ns, 0, sizeof(conn->time_ns));
+  conn->notifications = 0;
+  conn->initiator_done = false;
+  conn->reflector_done = false;
+  conn->active = true;
+
+  // Real-time mode holds the reflector buffer for the whole connection
+  if (!cs_initiator_buffer_pool_lend(&conn->initiator.data.reflector)) {
+    end_procedure(conn, false);
+    return;
+  }
+  memset(&config, 0, sizeof(config));
+  config.data = conn->initiator.data.reflector.ranging_data;
+  config.data_size = CS_INITIATOR_MAX_RANGING_DATA_SIZE;
+  config.att_mtu = att_mtu;
+  config.conn_handle = conn->initiator.conn_handle;
+  config.indication = false;
+  config.real_time = true;
+  if (cs_ras_client_messaging_receive(&conn->rx, &config, &handles) != SL_STATUS_OK) {
+    end_procedure(conn, false);
+  }
+}
+
+static void deliver(bench_conn_t *conn)
+{
+  cs_result_session_data_t session;
+  uint8_t buffer[CS_RESULT_MAX_BUFFER_SIZE];
+  float value;
+  uint64_t start;
+  uint64_t total = 0;
+
+  start = now_ns();
+  cs_result_initialize_results_data(&session);
+  for (uint8_t field = CS_RESULT_FIELD_DISTANCE_MAINMODE;
+       field <= CS_RESULT_FIELD_LIKELINESS_SUBMODE;
+       field++) {
+    value = (float)conn->initiator.data.num_steps / (float)(field + 1);
+    (void)cs_result_append_field(&session, field, (uint8_t *)&value, buffer);
+  }
+  cs_result_initialize_results_data(&session);
+  (void)cs_result_create_session_data(buffer, session.write_pos, &session);
+  for (uint8_t field = CS_RESULT_FIELD_DISTANCE_MAINMODE;
+       field <= CS_RESULT_FIELD_LIKELINESS_SUBMODE;
+       field++) {
+    (void)cs_result_extract_field(&session, field, buffer, (uint8_t *)&value);
+  }
+  conn->time_ns[STAGE_RESULT] = now_ns() - start;
+  conn->time_ns[STAGE_DONE] = now_ns() - event_start_ns;
+
+  if (delivered < sample_capacity) {
+    for (stage_t s = STAGE_EXTRACT; s < STAGE_TOTAL; s++) {
+      samples[s][delivered] = (uint32_t)conn->time_ns[s];
+      total += conn->time_ns[s];
+    }
+    samples[STAGE_TOTAL][delivered] = (uint32_t)total;
+    samples[STAGE_DONE][delivered] = (uint32_t)conn->time_ns[STAGE_DONE];
+    delivered++;
+  }
+  end_procedure(conn, true);
+}
+
+#if !defined(CS_INITIATOR_CONFIG_PIPELINED_EXTRACT) || (CS_INITIATOR_CONFIG_PIPELINED_EXTRACT == 0)
+/* Channels 2..76 without 23..25, see cs_initiator_extract.c */
+static bool channel_is_valid(uint8_t ch)
+{
+  return ch >= 2 && ch <= 76 && (ch < 23 || ch > 25);
+}
+
+/* What the RTL checks of the whole procedure when the extractor did not */
+static bool validate_steps(cs_initiator_t *initiator)
+{
+  static cs_ras_step_index_t index;
+  uint8_t *data = initiator->data.initiator.ranging_data;
+
+  if (cs_ras_format_build_step_index(data,
+                                     data + initiator->data.initiator.ranging_data_size,
+                                     true,
+                                     initiator->num_antenna_path,
+                                     &index) != SL_STATUS_OK
+      || index.num_steps != initiator->data.num_steps) {
+    return false;
+  }
+  for (uint8_t i = 0; i < initiator->data.num_steps; i++) {
+    if (!channel_is_valid(initiator->data.step_channels[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+#endif
+
+static void finish_procedure(bench_conn_t *conn)
+{
+  cs_procedure_state_t state;
+  uint64_t start;
+
+  if (!conn->initiator_done || !conn->reflector_done) {
+    return;
+  }
+  #if !defined(CS_INITIATOR_CONFIG_PIPELINED_EXTRACT) || (CS_INITIATOR_CONFIG_PIPELINED_EXTRACT == 0)
+  bool valid;
+
+  start = now_ns();
+  valid = validate_steps(&conn->initiator);
+  conn->time_ns[STAGE_VALIDATE] = now_ns() - start;
+  if (!valid) {
+    end_procedure(conn, false);
+    return;
+  }
+  #endif
+  start = now_ns();
+  state = ranging_data_is_complete(conn->initiator.data.reflector.ranging_data,
+                                   conn->initiator.data.reflector.ranging_data_size,
+                                   &conn->initiator.data.reflector_index);
+  conn->time_ns[STAGE_RAS_CHECK] = now_ns() - start;
+  if (state != CS_PROCEDURE_STATE_COMPLETED) {
+    end_procedure(conn, false);
+    return;
+  }
+  deliver(conn);
+}
+
+static void initiator_result(bench_conn_t *conn, sl_bt_msg_t *evt, bool first)
+{
+  cs_result_data_t content;
+  cs_procedure_state_t state;
+  uint64_t start;
+
+  memset(&content, 0, sizeof(content));
+  content.cs_event = evt;
+  content.first_cs_result = first;
+  start = now_ns();
+  state = extract_cs_result_data(&conn->initiator, &content);
+  conn->time_ns[STAGE_EXTRACT] += now_ns() - start;
+  if (state == CS_PROCEDURE_STATE_ABORTED) {
+    end_procedure(conn, false);
+  } else if (state == CS_PROCEDURE_STATE_COMPLETED) {
+    conn->initiator_done = true;
+    finish_procedure(conn);
+  }
+}
+
+static void reflector_data(bench_conn_t *conn, sl_bt_msg_t *evt)
+{
+  uint64_t start;
+
+  start = now_ns();
+  (void)cs_ras_client_messaging_on_bt_event(evt);
+  conn->time_ns[STAGE_RAS_RX] += now_ns() - start;
+  conn->notifications++;
+  if (!conn->reception_stopped) {
+    return;
+  }
+  conn->reception_stopped = false;
+  // Real-time data with a lost segment is dropped
+  if (conn->reception_status != CS_RAS_MESSAGING_STATUS_SUCCESS
+      || conn->reception_lost != 0) {
+    end_procedure(conn, false);
+    return;
+  }
+  conn->initiator.data.reflector.ranging_data_size = conn->reception_size;
+  conn->reflector_done = true;
+  finish_procedure(conn);
+}
+
+static void process_event(sl_bt_msg_t *evt)
+{
+  bench_conn_t *conn;
+
+  event_start_ns = now_ns();
+  switch (SL_BT_MSG_ID(evt->header)) {
+    case sl_bt_evt_cs_result_id:
+      conn = get_connection(evt->data.evt_cs_result.connection);
+      if (conn == NULL) {
+        break;
+      }
+      start_procedure(conn);
+      if (conn->active) {
+        initiator_result(conn, evt, true);
+      }
+      break;
+    case sl_bt_evt_cs_result_continue_id:
+      conn = get_connection(evt->data.evt_cs_result_continue.connection);
+      if (conn != NULL && conn->active && !conn->initiator_done) {
+        initiator_result(conn, evt, false);
+      }
+      break;
+    case sl_bt_evt_gatt_characteristic_value_id:
+      conn = get_connection(evt->data.evt_gatt_characteristic_value.connection);
+      if (conn != NULL && conn->active) {
+        reflector_data(conn, evt);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+/* ---- Callbacks of cs_ras_client_messaging.c ---- */
+
+void cs_ras_client_messaging_reception_stopped(cs_ras_client_messaging_reception_t *rx,
+                                               cs_ras_messaging_status_t           status,
+                                               sl_status_t                         sc,
+                                               bool                                recoverable,
+                                               uint32_t                            size,
+                                               bool                                last_arrived,
+                                               uint8_t                             last_known_segment,
+                                               uint64_t                            lost_segments)
+{
+  bench_conn_t *conn = rx_connection(rx);
+
+  (void)sc;
+  (void)recoverable;
+  (void)last_arrived;
+  (void)last_known_segment;
+  conn->reception_stopped = true;
+  conn->reception_status = status;
+  conn->reception_size = size;
+  conn->reception_lost = lost_segments;
+}
+
+void cs_ras_client_messaging_segment_received(cs_ras_client_messaging_reception_t *rx,
+                                              cs_ras_ranging_counter_t            counter)
+{
+  bench_conn_t *conn = rx_connection(rx);
+  uint32_t offset = (uint32_t)counter * CS_RAS_SEGMENT_DATA_SIZE(rx->config.att_mtu);
+
+  // Same as cs_ras_client.c on the target
+  if (rx->size > offset) {
+    ranging_data_segment_arrived(&conn->initiator, offset, rx->size - offset);
+  }
+}
+
+/* ---- Event stream ---- */
+
+static void append(const void *data, size_t size)
+{
+  if (stream_size + size > stream_capacity) {
+    stream_capacity = stream_capacity ? 2 * stream_capacity : 65536;
+    while (stream_capacity < stream_size + size) {
+      stream_capacity *= 2;
+    }
+    stream = realloc(stream, stream_capacity);
+    if (stream == NULL) {
+      fprintf(stderr, "out of memory\n");
+      exit(1);
+    }
+  }
+  memcpy(&stream[stream_size], data, size);
+  stream_size += size;
+}
+
+static void put_event(uint32_t id, const void *payload, size_t size)
+{
+  uint32_t header = id | (uint32_t)((size & 0xff) << 8) | (uint32_t)((size >> 8) & 0x7);
+  uint8_t bytes[SL_BT_MSG_HEADER_LEN];
+
+  for (uint8_t i = 0; i < SL_BT_MSG_HEADER_LEN; i++) {
+    bytes[i] = (uint8_t)(header >> (8 * i));
+  }
+  append(bytes, sizeof(bytes));
+  append(payload, size);
+}
+
+/* Channels 2..76 without 23..25 */
+static uint8_t channel(void)
+{
+  uint8_t ch = (uint8_t)(2 + rand() % 72);
+
+  return (ch >= 23) ? (uint8_t)(ch + 3) : ch;
+}
+
+static void random_bytes(uint8_t *data, uint8_t size)
+{
+  for (uint8_t i = 0; i < size; i++) {
+    data[i] = (uint8_t)rand();
+  }
+}
+
+static void put_initiator(uint8_t conn_handle, uint16_t counter, unsigned int steps, uint8_t paths)
+{
+  uint8_t payload[sizeof(sl_bt_evt_cs_result_t) + 255];
+  uint8_t data[255];
+  unsigned int total = CALIBRATION_STEPS + steps;
+  unsigned int step = 0;
+  // Step on an excluded channel, past the first event when there is one
+  unsigned int invalid_step = (invalid_percent > 0 && (unsigned int)rand() % 100u < invalid_percent)
+                              ? total - 1 : UINT_MAX;
+  bool first = true;
+
+  while (step < total) {
+    uint8_t len = 0;
+    uint8_t num_steps = 0;
+    uint8_t done;
+
+    for (; step < total; step++) {
+      uint8_t size = (step < CALIBRATION_STEPS) ? MODE_0_INITIATOR : MODE_2_SIZE(paths);
+
+      if (len + 3 + size > (int)sizeof(data)) {
+        break;
+      }
+      data[len++] = (step < CALIBRATION_STEPS) ? 0 : 2;
+      data[len++] = (step == invalid_step) ? 24 : channel();
+      data[len++] = size;
+      random_bytes(&data[len], size);
+      len += size;
+      num_steps++;
+    }
+    done = (step == total) ? sl_bt_cs_done_status_complete
+           : sl_bt_cs_done_status_partial_results_continue;
+    memset(payload, 0, sizeof(payload));
+    if (first) {
+      sl_bt_evt_cs_result_t *evt = (sl_bt_evt_cs_result_t *)payload;
+
+      evt->connection = conn_handle;
+      evt->procedure_counter = counter;
+      evt->procedure_done_status = done;
+      evt->subevent_done_status = done;
+      evt->num_antenna_paths = paths;
+      evt->num_steps = num_steps;
+      evt->data.len = len;
+      memcpy(evt->data.data, data, len);
+      put_event(sl_bt_evt_cs_result_id, payload, sizeof(*evt) + len);
+      first = false;
+    } else {
+      sl_bt_evt_cs_result_continue_t *evt = (sl_bt_evt_cs_result_continue_t *)payload;
+
+      evt->connection = conn_handle;
+      evt->procedure_done_status = done;
+      evt->subevent_done_status = done;
+      evt->num_antenna_paths = paths;
+      evt->num_steps = num_steps;
+      evt->data.len = len;
+      memcpy(evt->data.data, data, len);
+      put_event(sl_bt_evt_cs_result_continue_id, payload, sizeof(*evt) + len);
+    }
+  }
+}
+
+static size_t build_reflector(uint8_t *body, uint16_t counter, unsigned int steps, uint8_t paths)
+{
+  cs_ras_ranging_header_t *header = (cs_ras_ranging_header_t *)body;
+  cs_ras_subevent_header_t *subevent = (cs_ras_subevent_header_t *)&body[sizeof(*header)];
+  size_t size = sizeof(*header) + sizeof(*subevent);
+
+  memset(body, 0, size);
+  header->ranging_counter = counter & CS_RAS_RANGING_COUNTER_MASK;
+  header->antenna_paths_mask = (uint8_t)((1u << paths) - 1u);
+  subevent->ranging_done_status = sl_bt_cs_done_status_complete;
+  subevent->subevent_done_status = sl_bt_cs_done_status_complete;
+  subevent->number_of_steps_reported = (uint8_t)(CALIBRATION_STEPS + steps);
+  for (unsigned int step = 0; step < CALIBRATION_STEPS + steps; step++) {
+    uint8_t step_size = (step < CALIBRATION_STEPS) ? MODE_0_REFLECTOR : MODE_2_SIZE(paths);
+
+    body[size++] = (step < CALIBRATION_STEPS) ? 0 : 2;
+    random_bytes(&body[size], step_size);
+    size += step_size;
+  }
+  return size;
+}
+
+static void put_segment(uint8_t conn_handle, uint16_t handle, const uint8_t *body,
+                        size_t body_size, unsigned int segment)
+{
+  uint8_t payload[sizeof(sl_bt_evt_gatt_characteristic_value_t) + 255];
+  sl_bt_evt_gatt_characteristic_value_t *evt = (sl_bt_evt_gatt_characteristic_value_t *)payload;
+  size_t segment_size = CS_RAS_SEGMENT_DATA_SIZE(att_mtu);
+  size_t offset = segment * segment_size;
+  size_t len = body_size - offset;
+  cs_ras_segment_header_t segment_header = CS_RAS_SEGMENT_HEADER_EMPTY;
+
+  if (len > segment_size) {
+    len = segment_size;
+  }
+  if (segment == 0) {
+    CS_RAS_SET_FIRST_SEGMENT(segment_header);
+  }
+  if (offset + len == body_size) {
+    CS_RAS_SET_LAST_SEGMENT(segment_header);
+  }
+  CS_RAS_SET_SEGMENT_COUNTER(segment_header, segment % CS_RAS_SEGMENT_COUNTER_MOD);
+  memset(payload, 0, sizeof(payload));
+  evt->connection = conn_handle;
+  evt->characteristic = handle;
+  evt->att_opcode = sl_bt_gatt_handle_value_notification;
+  evt->value.len = (uint8_t)(len + CS_RAS_SEGMENT_HEADER_SIZE);
+  evt->value.data[0] = segment_header;
+  memcpy(&evt->value.data[CS_RAS_SEGMENT_HEADER_SIZE], &body[offset], len);
+  put_event(sl_bt_evt_gatt_characteristic_value_id,
+            payload,
+            sizeof(*evt) + CS_RAS_SEGMENT_HEADER_SIZE + len);
+}
+
+/* Initiator events of all connections first, then their segments interleaved */
+static bool generate(unsigned long procedures, uint8_t count, unsigned int steps, uint8_t paths)
+{
+  static uint8_t body[CS_INITIATOR_MAX_CONNECTIONS][CS_INITIATOR_MAX_RANGING_DATA_SIZE];
+  size_t body_size[CS_INITIATOR_MAX_CONNECTIONS];
+  size_t initiator_size = sizeof(cs_ras_ranging_header_t) + sizeof(cs_ras_subevent_header_t)
+                          + CALIBRATION_STEPS * (1 + MODE_0_INITIATOR)
+                          + steps * (1 + MODE_2_SIZE(paths));
+  size_t segment_size = CS_RAS_SEGMENT_DATA_SIZE(att_mtu);
+  unsigned int segments;
+
+  if (initiator_size > CS_INITIATOR_MAX_RANGING_DATA_SIZE) {
+    fprintf(stderr, "%zu bytes of initiator data exceed CS_INITIATOR_MAX_RANGING_DATA_SIZE\n",
+            initiator_size);
+    return false;
+  }
+  for (unsigned long p = 0; p < procedures; p++) {
+    uint16_t counter = (uint16_t)p;
+
+    segments = 0;
+    for (uint8_t c = 0; c < count; c++) {
+      put_initiator((uint8_t)(c + 1), counter, steps, paths);
+      body_size[c] = build_reflector(body[c], counter, steps, paths);
+      if ((body_size[c] + segment_size - 1) / segment_size > segments) {
+        segments = (unsigned int)((body_size[c] + segment_size - 1) / segment_size);
+      }
+    }
+    for (unsigned int s = 0; s < segments; s++) {
+      for (uint8_t c = 0; c < count; c++) {
+        if (s * segment_size < body_size[c]) {
+          put_segment((uint8_t)(c + 1),
+                      handles.array[CS_RAS_CHARACTERISTIC_INDEX_REAL_TIME_RANGING_DATA],
+                      body[c], body_size[c], s);
+        }
+      }
+    }
+  }
+  return true;
+}
+
+static bool load_capture(const char *path)
+{
+  FILE *file = fopen(path, "rb");
+  uint8_t buffer[4096];
+  size_t size;
+
+  if (file == NULL) {
+    return false;
+  }
+  while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    append(buffer, size);
+  }
+  fclose(file);
+  return stream_size != 0;
+}
+
+static unsigned long count_procedures(void)
+{
+  unsigned long count = 0;
+  size_t pos = 0;
+
+  while (pos + SL_BT_MSG_HEADER_LEN <= stream_size) {
+    uint32_t header = (uint32_t)stream[pos] | ((uint32_t)stream[pos + 1] << 8)
+                      | ((uint32_t)stream[pos + 2] << 16) | ((uint32_t)stream[pos + 3] << 24);
+
+    if (SL_BT_MSG_ID(header) == sl_bt_evt_cs_result_id) {
+      count++;
+    }
+    pos += SL_BT_MSG_HEADER_LEN + SL_BT_MSG_LEN(header);
+  }
+  return count;
+}
+
+/* ---- Processing, run on its own painted stack ---- */
+
+static void run(void)
+{
+  static union {
+    sl_bt_msg_t msg;
+    uint8_t bytes[SL_BT_MSG_HEADER_LEN + 2048];
+  } evt;
+  uint64_t start = now_ns();
+
+  for (unsigned long r = 0; r < repeat; r++) {
+    size_t pos = 0;
+
+    while (pos + SL_BT_MSG_HEADER_LEN <= stream_size) {
+      uint32_t header = (uint32_t)stream[pos] | ((uint32_t)stream[pos + 1] << 8)
+                        | ((uint32_t)stream[pos + 2] << 16) | ((uint32_t)stream[pos + 3] << 24);
+      size_t size = SL_BT_MSG_HEADER_LEN + SL_BT_MSG_LEN(header);
+
+      if (pos + size > stream_size) {
+        break;
+      }
+      memcpy(evt.bytes, &stream[pos], size);
+      process_event(&evt.msg);
+      pos += size;
+    }
+  }
+  elapsed_s = (double)(now_ns() - start) / 1e9;
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+  uint32_t x = *(const uint32_t *)a;
+  uint32_t y = *(const uint32_t *)b;
+
+  return (x > y) - (x < y);
+}
+
+int main(int argc, char **argv)
+{
+  const char *capture = NULL;
+  const char *output = NULL;
+  unsigned long procedures = 1000;
+  unsigned long count = 1;
+  unsigned long steps = 72;
+  unsigned long paths = 1;
+  unsigned long mtu = 247;
+  unsigned long handle = 0x30;
+  unsigned int seed = 1;
+  cs_initiator_buffer_pool_stats_t pool;
+  size_t stack_used;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "t:w:p:c:n:a:m:H:r:s:e:")) != -1) {
+    switch (opt) {
+      case 't':
+        capture = optarg;
+        break;
+      case 'w':
+        output = optarg;
+        break;
+      case 'p':
+        procedures = strtoul(optarg, NULL, 0);
+        break;
+      case 'c':
+        count = strtoul(optarg, NULL, 0);
+        break;
+      case 'n':
+        steps = strtoul(optarg, NULL, 0);
+        break;
+      case 'a':
+        paths = strtoul(optarg, NULL, 0);
+        break;
+      case 'm':
+        mtu = strtoul(optarg, NULL, 0);
+        break;
+      case 'H':
+        handle = strtoul(optarg, NULL, 0);
+        break;
+      case 'r':
+        repeat = strtoul(optarg, NULL, 0);
+        break;
+      case 's':
+        seed = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      case 'e':
+        invalid_percent = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-t capture] [-w capture] [-p procs] [-c conns] [-n steps] "
+                        "[-a paths] [-m mtu] [-H handle] [-r repeat] [-s seed] "
+                        "[-e percent]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (count == 0 || count > CS_INITIATOR_MAX_CONNECTIONS
+      || steps + CALIBRATION_STEPS > UINT8_MAX || paths == 0 || paths > 4
+      || mtu < ATT_MTU_MIN || mtu > ATT_MTU_MAX || handle == 0 || handle > UINT16_MAX
+      || repeat == 0 || invalid_percent > 100) {
+    fprintf(stderr, "invalid parameters\n");
+    return 1;
+  }
+  att_mtu = (uint16_t)mtu;
+  for (uint8_t i = 0; i < CS_RAS_CHARACTERISTIC_INDEX_COUNT; i++) {
+    handles.array[i] = CS_RAS_INVALID_CHARACTERISTIC_HANDLE;
+  }
+  handles.array[CS_RAS_CHARACTERISTIC_INDEX_REAL_TIME_RANGING_DATA] = (uint16_t)handle;
+
+  if (capture != NULL) {
+    if (!load_capture(capture)) {
+      fprintf(stderr, "cannot read capture %s\n", capture);
+      return 1;
+    }
+  } else {
+    srand(seed);
+    if (!generate(procedures, (uint8_t)count, (unsigned int)steps, (uint8_t)paths)) {
+      return 1;
+    }
+  }
+  if (output != NULL) {
+    FILE *file = fopen(output, "wb");
+
+    if (file == NULL || fwrite(stream, 1, stream_size, file) != stream_size) {
+      fprintf(stderr, "cannot write capture %s\n", output);
+      return 1;
+    }
+    fclose(file);
+    return 0;
+  }
+
+  sample_capacity = count_procedures() * repeat;
+  for (stage_t s = STAGE_EXTRACT; s < STAGE_COUNT; s++) {
+    samples[s] = malloc((sample_capacity + 1) * sizeof(uint32_t));
+    if (samples[s] == NULL) {
+      fprintf(stderr, "out of memory\n");
+      return 1;
+    }
+  }
+  cs_initiator_buffer_pool_init();
+  cs_initiator_latency_init();
+  cs_ras_client_messaging_init();
+
+  memset(bench_stack, STACK_PAINT, sizeof(bench_stack));
+  getcontext(&bench_context);
+  bench_context.uc_stack.ss_sp = bench_stack;
+  bench_context.uc_stack.ss_size = sizeof(bench_stack);
+  bench_context.uc_link = &main_context;
+  makecontext(&bench_context, run, 0);
+  swapcontext(&main_context, &bench_context);
+
+  // The stack grows downwards from the end of the array
+  stack_used = sizeof(bench_stack);
+  for (size_t i = 0; i < sizeof(bench_stack) && bench_stack[i] == STACK_PAINT; i++) {
+    stack_used--;
+  }
+  cs_initiator_buffer_pool_get_stats(&pool);
+
+  printf("mode %s\n", MODE_NAME);
+  printf("procedures %lu delivered, %lu dropped, %.0f per second\n",
+         delivered,
+         dropped,
+         elapsed_s > 0.0 ? (double)(delivered + dropped) / elapsed_s : 0.0);
+  printf("# stage,mean_us,p99_us,max_us\n");
+  for (stage_t s = STAGE_EXTRACT; s < STAGE_COUNT && delivered > 0; s++) {
+    double sum = 0.0;
+
+    for (unsigned long i = 0; i < delivered; i++) {
+      sum += samples[s][i];
+    }
+    qsort(samples[s], delivered, sizeof(uint32_t), compare_u32);
+    printf("%s,%.2f,%.2f,%.2f\n",
+           stage_names[s],
+           sum / (double)delivered / 1000.0,
+           samples[s][(delivered * 99) / 100] / 1000.0,
+           samples[s][delivered - 1] / 1000.0);
+  }
+  if (dropped > 0) {
+    printf("dropped %.2f us, %.1f notifications\n",
+           (double)dropped_ns / (double)dropped / 1000.0,
+           (double)dropped_notifications / (double)dropped);
+  }
+  printf("stack %zu\n", stack_used);
+  printf("ranging buffers %u/%u (%lu bytes), %lu refused\n",
+         pool.peak,
+         pool.size,
+         (unsigned long)pool.peak * CS_INITIATOR_MAX_RANGING_DATA_SIZE,
+         (unsigned long)pool.failed);
+  return 0;
+}
@@ -0,0 +1,342 @@
+/*
+ * cs_result_bench.c
+ *
+ * Compares the two result delivery paths of the CS initiator on the host,
+ * both built on cs_result.c:
+ *   tlv    report_result() appends every RTL output to the TLV buffer with
+ *          cs_result_append_field(), cs_on_result() in app.c takes each one
+ *          back out with cs_result_extract_field()
+ *   typed  report_result() stores every output once with
+ *          cs_result_set_field(), cs_on_result_fields() in app.c copies the
+ *          valid members
+ * The field sets and the order follow report_result() and app.c. Checks
+ * that both paths deliver the same values and that an unknown field type
+ * is refused, then prints the time per procedure of each path. Exits with 1
+ * on the first failed check.
+ *
+ * Build (from the project root):
+ *   SDK=simplicity_sdk_2025.6.2
+ *   C=$SDK/app/bluetooth/common
+ *   gcc -O2 -Ihost/shim -I. -Iconfig -Iautogen \
+ *     -I$SDK/platform/common/inc -I$SDK/protocol/bluetooth/inc \
+ *     -I$C/cs_result/inc \
+ *     $C/cs_result/src/cs_result.c host/cs_result_bench.c -o cs_result_bench
+ * The result logs follow CS_RESULT_LOG of config/cs_result_config.h, off as
+ * in this project. Add -DCS_RESULT_LOG=1 -DHOST_APP_LOG to print them.
+ *
+ * Options:
+ *   -p <procedures>  procedures per path (1000000)
+ *   -m <set>         fields: pbr (5, the default of this project),
+ *                    sub (PBR with RTT submode, 8), rtt (RTT main mode, 5)
+ *
+ * Output:
+ *   # path,ns_per_procedure
+ *   tlv,<ns>
+ *   typed,<ns>
+ * Times are those of the host build and only comparable between runs on
+ * the same host.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+#include "cs_result.h"
+#include "cs_result_config.h"
+
+/* Part of cs_measurement_t filled by app.c */
+typedef struct {
+  float distance_filtered;
+  float distance_raw;
+  float likeliness;
+  float distance_estimate_rssi;
+  float velocity;
+  float bit_error_rate;
+} measurement_t;
+
+typedef struct {
+  measurement_t mainmode;
+  measurement_t submode;
+} instance_t;
+
+/* Fields of each configuration, in the order report_result() gets them */
+static const cs_result_field_type_t pbr_fields[] = {
+  CS_RESULT_FIELD_DISTANCE_MAINMODE,
+  CS_RESULT_FIELD_DISTANCE_RAW_MAINMODE,
+  CS_RESULT_FIELD_LIKELINESS_MAINMODE,
+  CS_RESULT_FIELD_DISTANCE_RSSI,
+  CS_RESULT_FIELD_VELOCITY_MAINMODE
+};
+
+static const cs_result_field_type_t sub_fields[] = {
+  CS_RESULT_FIELD_DISTANCE_MAINMODE,
+  CS_RESULT_FIELD_DISTANCE_SUBMODE,
+  CS_RESULT_FIELD_DISTANCE_RAW_MAINMODE,
+  CS_RESULT_FIELD_DISTANCE_RAW_SUBMODE,
+  CS_RESULT_FIELD_LIKELINESS_MAINMODE,
+  CS_RESULT_FIELD_LIKELINESS_SUBMODE,
+  CS_RESULT_FIELD_DISTANCE_RSSI,
+  CS_RESULT_FIELD_VELOCITY_MAINMODE
+};
+
+static const cs_result_field_type_t rtt_fields[] = {
+  CS_RESULT_FIELD_DISTANCE_MAINMODE,
+  CS_RESULT_FIELD_DISTANCE_RAW_MAINMODE,
+  CS_RESULT_FIELD_LIKELINESS_MAINMODE,
+  CS_RESULT_FIELD_DISTANCE_RSSI,
+  CS_RESULT_FIELD_BIT_ERROR_RATE
+};
+
+static const cs_result_field_type_t *fields = pbr_fields;
+static size_t field_count = sizeof(pbr_fields) / sizeof(pbr_fields[0]);
+
+/* Defeats the optimizer across the timed loops */
+static volatile float sink;
+
+static void fail(const char *test, const char *what)
+{
+  printf("FAIL %s: %s\n", test, what);
+  exit(1);
+}
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static bool has_field(cs_result_field_type_t type)
+{
+  for (size_t i = 0; i < field_count; i++) {
+    if (fields[i] == type) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/* RTL outputs of procedure n */
+static float rtl_value(unsigned long n, cs_result_field_type_t type)
+{
+  return (float)(n % 1000u) * 0.01f + (float)type;
+}
+
+/* ---- tlv path ---- */
+
+static void produce_tlv(unsigned long n, cs_result_session_data_t *session, uint8_t *buffer)
+{
+  cs_result_initialize_results_data(session);
+  for (size_t i = 0; i < field_count; i++) {
+    float value = rtl_value(n, fields[i]);
+
+    (void)cs_result_append_field(session, fields[i], (uint8_t *)&value, buffer);
+  }
+}
+
+/* One extract per field as in cs_on_result(), skipped fields as there */
+static void consume_tlv(cs_result_session_data_t *session, uint8_t *buffer, instance_t *instance)
+{
+  (void)cs_result_extract_field(session, CS_RESULT_FIELD_DISTANCE_MAINMODE, buffer,
+                                (uint8_t *)&instance->mainmode.distance_filtered);
+  if (has_field(CS_RESULT_FIELD_DISTANCE_SUBMODE)) {
+    (void)cs_result_extract_field(session, CS_RESULT_FIELD_DISTANCE_SUBMODE, buffer,
+                                  (uint8_t *)&instance->submode.distance_filtered);
+  }
+  (void)cs_result_extract_field(session, CS_RESULT_FIELD_DISTANCE_RAW_MAINMODE, buffer,
+                                (uint8_t *)&instance->mainmode.distance_raw);
+  if (has_field(CS_RESULT_FIELD_DISTANCE_RAW_SUBMODE)) {
+    (void)cs_result_extract_field(session, CS_RESULT_FIELD_DISTANCE_RAW_SUBMODE, buffer,
+                                  (uint8_t *)&instance->submode.distance_raw);
+  }
+  (void)cs_result_extract_field(session, CS_RESULT_FIELD_LIKELINESS_MAINMODE, buffer,
+                                (uint8_t *)&instance->mainmode.likeliness);
+  if (has_field(CS_RESULT_FIELD_LIKELINESS_SUBMODE)) {
+    (void)cs_result_extract_field(session, CS_RESULT_FIELD_LIKELINESS_SUBMODE, buffer,
+                                  (uint8_t *)&instance->submode.likeliness);
+  }
+  if (has_field(CS_RESULT_FIELD_VELOCITY_MAINMODE)) {
+    (void)cs_result_extract_field(session, CS_RESULT_FIELD_VELOCITY_MAINMODE, buffer,
+                                  (uint8_t *)&instance->mainmode.velocity);
+  }
+  if (has_field(CS_RESULT_FIELD_BIT_ERROR_RATE)) {
+    (void)cs_result_extract_field(session, CS_RESULT_FIELD_BIT_ERROR_RATE, buffer,
+                                  (uint8_t *)&instance->mainmode.bit_error_rate);
+  }
+  (void)cs_result_extract_field(session, CS_RESULT_FIELD_DISTANCE_RSSI, buffer,
+                                (uint8_t *)&instance->mainmode.distance_estimate_rssi);
+}
+
+/* ---- typed path ---- */
+
+static void produce_typed(unsigned long n, cs_result_fields_t *result)
+{
+  cs_result_clear_fields(result);
+  for (size_t i = 0; i < field_count; i++) {
+    (void)cs_result_set_field(result, fields[i], rtl_value(n, fields[i]));
+  }
+}
+
+/* Same as cs_on_result_fields() */
+static void consume_typed(const cs_result_fields_t *result, instance_t *instance)
+{
+  if (cs_result_field_is_valid(result, CS_RESULT_FIELD_DISTANCE_MAINMODE)) {
+    instance->mainmode.distance_filtered = result->distance_mainmode;
+  }
+  if (cs_result_field_is_valid(result, CS_RESULT_FIELD_DISTANCE_SUBMODE)) {
+    instance->submode.distance_filtered = result->distance_submode;
+  }
+  if (cs_result_field_is_valid(result, CS_RESULT_FIELD_DISTANCE_RAW_MAINMODE)) {
+    instance->mainmode.distance_raw = result->distance_raw_mainmode;
+  }
+  if (cs_result_field_is_valid(result, CS_RESULT_FIELD_DISTANCE_RAW_SUBMODE)) {
+    instance->submode.distance_raw = result->distance_raw_submode;
+  }
+  if (cs_result_field_is_valid(result, CS_RESULT_FIELD_LIKELINESS_MAINMODE)) {
+    instance->mainmode.likeliness = result->likeliness_mainmode;
+  }
+  if (cs_result_field_is_valid(result, CS_RESULT_FIELD_LIKELINESS_SUBMODE)) {
+    instance->submode.likeliness = result->likeliness_submode;
+  }
+  if (cs_result_field_is_valid(result, CS_RESULT_FIELD_VELOCITY_MAINMODE)) {
+    instance->mainmode.velocity = result->velocity_mainmode;
+  }
+  if (cs_result_field_is_valid(result, CS_RESULT_FIELD_BIT_ERROR_RATE)) {
+    instance->mainmode.bit_error_rate = result->bit_error_rate;
+  }
+  if (cs_result_field_is_valid(result, CS_RESULT_FIELD_DISTANCE_RSSI)) {
+    instance->mainmode.distance_estimate_rssi = result->distance_rssi;
+  }
+}
+
+/* ---- Checks ---- */
+
+static void test_same_values(void)
+{
+  cs_result_session_data_t session;
+  uint8_t buffer[CS_RESULT_MAX_BUFFER_SIZE];
+  cs_result_fields_t result;
+  instance_t tlv;
+  instance_t typed;
+
+  for (unsigned long n = 0; n < 100; n++) {
+    memset(&tlv, 0, sizeof(tlv));
+    memset(&typed, 0, sizeof(typed));
+    produce_tlv(n, &session, buffer);
+    consume_tlv(&session, buffer, &tlv);
+    produce_typed(n, &result);
+    consume_typed(&result, &typed);
+    if (memcmp(&tlv, &typed, sizeof(tlv)) != 0) {
+      fail("same values", "paths differ");
+    }
+  }
+
+  /* Every field type lands in its own member */
+  for (int type = 0; type < CS_RESULT_FIELD_COUNT; type++) {
+    cs_result_clear_fields(&result);
+    if (cs_result_set_field(&result, (cs_result_field_type_t)type, 1.0f) != SL_STATUS_OK
+        || result.valid_mask != CS_RESULT_FIELD_BIT(type)) {
+      fail("set field", "type refused");
+    }
+  }
+  cs_result_clear_fields(&result);
+  cs_result_set_field(&result, CS_RESULT_FIELD_DISTANCE_MAINMODE, 1.0f);
+  cs_result_set_field(&result, CS_RESULT_FIELD_BIT_ERROR_RATE, 2.0f);
+  if (result.distance_mainmode != 1.0f || result.bit_error_rate != 2.0f
+      || result.distance_submode != 0.0f || result.velocity_submode != 0.0f) {
+    fail("set field", "wrong member");
+  }
+  if (cs_result_set_field(&result, (cs_result_field_type_t)CS_RESULT_FIELD_COUNT, 3.0f)
+      != SL_STATUS_INVALID_TYPE) {
+    fail("set field", "unknown type accepted");
+  }
+  printf("PASS same values, %zu fields\n", field_count);
+}
+
+/* ---- Timing ---- */
+
+static double time_tlv(unsigned long procedures)
+{
+  cs_result_session_data_t session;
+  uint8_t buffer[CS_RESULT_MAX_BUFFER_SIZE];
+  instance_t instance;
+  uint64_t start;
+
+  memset(&instance, 0, sizeof(instance));
+  start = now_ns();
+  for (unsigned long n = 0; n < procedures; n++) {
+    produce_tlv(n, &session, buffer);
+    consume_tlv(&session, buffer, &instance);
+    sink = instance.mainmode.distance_filtered;
+  }
+  return (double)(now_ns() - start) / (double)procedures;
+}
+
+static double time_typed(unsigned long procedures)
+{
+  cs_result_fields_t result;
+  instance_t instance;
+  uint64_t start;
+
+  memset(&instance, 0, sizeof(instance));
+  start = now_ns();
+  for (unsigned long n = 0; n < procedures; n++) {
+    produce_typed(n, &result);
+    consume_typed(&result, &instance);
+    sink = instance.mainmode.distance_filtered;
+  }
+  return (double)(now_ns() - start) / (double)procedures;
+}
+
+int main(int argc, char **argv)
+{
+  unsigned long procedures = 1000000;
+  double tlv_ns;
+  double typed_ns;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "p:m:")) != -1) {
+    switch (opt) {
+      case 'p':
+        procedures = strtoul(optarg, NULL, 0);
+        break;
+      case 'm':
+        if (strcmp(optarg, "pbr") == 0) {
+          fields = pbr_fields;
+          field_count = sizeof(pbr_fields) / sizeof(pbr_fields[0]);
+        } else if (strcmp(optarg, "sub") == 0) {
+          fields = sub_fields;
+          field_count = sizeof(sub_fields) / sizeof(sub_fields[0]);
+        } else if (strcmp(optarg, "rtt") == 0) {
+          fields = rtt_fields;
+          field_count = sizeof(rtt_fields) / sizeof(rtt_fields[0]);
+        } else {
+          fprintf(stderr, "unknown field set %s\n", optarg);
+          return 1;
+        }
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-p procedures] [-m pbr|sub|rtt]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (procedures == 0) {
+    fprintf(stderr, "invalid parameters\n");
+    return 1;
+  }
+
+  test_same_values();
+
+  /* Warm up, then both paths the same way */
+  (void)time_tlv(procedures / 10 + 1);
+  (void)time_typed(procedures / 10 + 1);
+  tlv_ns = time_tlv(procedures);
+  typed_ns = time_typed(procedures);
+
+  printf("# path,ns_per_procedure\n");
+  printf("tlv,%.1f\n", tlv_ns);
+  printf("typed,%.1f\n", typed_ns);
+  return 0;
+}
@@ -0,0 +1,294 @@
+/*
+ * dlog_bench.c
+ *
+ * Cost per log call on the host of the paths alg.c had and has:
+ *   printf         printf("d: %d, b: %d\n") as alg.c did before dlog
+ *   app_log        app_log_info() as the SDK implements it: level check,
+ *                  level prefix print, message print
+ *   dlog_write     dlog_write() of a site without rate limit
+ *   dlog_limited   dlog_write() of a site inside its rate limit
+ *   flush_text     dlog_flush() per record, formatted as text
+ *   flush_binary   dlog_encode() per record, the DLOG_BINARY flush
+ * printf and app_log print to /dev/null, so the times leave out the wait on
+ * the console. The console column gives it instead: the bytes each call
+ * sends and their time at the -b baud rate, spent in the caller for printf
+ * and app_log and in the main loop flush for dlog. Checks the binary frames
+ * first: every record survives dlog_encode() and dlog_decode(), a damaged
+ * frame is refused. Exits with 1 on the first failed check.
+ *
+ * Build (from the project root):
+ *   SDK=simplicity_sdk_2025.6.2
+ *   gcc -O2 -DALG_HOST_BUILD -Ihost/shim -Ihost -I. \
+ *     -I$SDK/platform/common/inc \
+ *     dlog.c host/alg_host_port.c host/dlog_bench.c -o dlog_bench
+ *
+ * Options:
+ *   -n <calls>   calls per variant (1000000)
+ *   -b <baud>    console baud rate (115200)
+ *
+ * Output:
+ *   # variant,ns_per_call,tsc_per_call,console_bytes,console_us
+ * tsc_per_call counts time stamp counter ticks on x86 hosts, 0 elsewhere.
+ * Times are those of the host build and only comparable between runs on
+ * the same host.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <getopt.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "alg_host_port.h"
+#include "dlog.h"
+
+#define LINE_MAX_SIZE 96
+
+/* APP_LOG_LEVEL_INFO and the filter level of the SDK app_log */
+#define LOG_LEVEL_INFO   2
+#define LOG_LEVEL_FILTER 0
+
+typedef enum
+{
+  VARIANT_PRINTF,
+  VARIANT_APP_LOG,
+  VARIANT_DLOG_WRITE,
+  VARIANT_DLOG_LIMITED,
+  VARIANT_FLUSH_TEXT,
+  VARIANT_FLUSH_BINARY,
+  VARIANT_COUNT
+} variant_t;
+
+static const char *variant_names[VARIANT_COUNT] =
+{
+  "printf", "app_log", "dlog_write", "dlog_limited", "flush_text", "flush_binary"
+};
+
+static FILE *sink;
+static volatile int log_level_filter = LOG_LEVEL_FILTER;
+static volatile uint8_t frame_sink;
+
+static void fail(const char *test, const char *what)
+{
+  printf("FAIL %s: %s\n", test, what);
+  exit(1);
+}
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t now_tsc(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+/* ---- The SDK app_log path ---- */
+
+static void app_log_printf(const char *format, ...)
+{
+  va_list args;
+
+  va_start(args, format);
+  vfprintf(sink, format, args);
+  va_end(args);
+}
+
+#define app_log_info(...)                        \
+  do {                                           \
+    if (LOG_LEVEL_INFO >= log_level_filter) {    \
+      app_log_printf("[I] ");                    \
+      app_log_printf(__VA_ARGS__);               \
+    }                                            \
+  } while (0)
+
+/* ---- Checks ---- */
+
+static void test_frames(void)
+{
+  dlog_record_t record;
+  dlog_record_t decoded;
+  uint8_t frame[DLOG_FRAME_SIZE];
+  char line[LINE_MAX_SIZE];
+  char decoded_line[LINE_MAX_SIZE];
+
+  for (unsigned int i = 0; i < 10000; i++)
+  {
+    memset(&record, 0, sizeof(record));
+    record.tick = (uint32_t)rand() * 7u;
+    record.id = (uint8_t)(rand() % DLOG_ID_COUNT);
+    record.suppressed = (uint8_t)rand();
+    record.arg[0] = rand() - RAND_MAX / 2;
+    record.arg[1] = -rand();
+    dlog_encode(&record, frame);
+    if (!dlog_decode(frame, &decoded) || memcmp(&record, &decoded, sizeof(record)) != 0)
+      fail("frames", "record changed");
+    dlog_format(&record, line, sizeof(line));
+    dlog_format(&decoded, decoded_line, sizeof(decoded_line));
+    if (strcmp(line, decoded_line) != 0)
+      fail("frames", "line changed");
+    frame[1 + rand() % (DLOG_FRAME_SIZE - 2)] ^= (uint8_t)(1u << (rand() % 8));
+    if (dlog_decode(frame, &decoded))
+      fail("frames", "damaged frame accepted");
+  }
+  printf("PASS frames\n");
+}
+
+/* ---- Timing ---- */
+
+typedef struct
+{
+  uint64_t ns;
+  uint64_t tsc;
+} cost_t;
+
+static cost_t time_calls(variant_t variant, unsigned long calls)
+{
+  static dlog_record_t records[DLOG_RING_SIZE];
+  uint8_t frame[DLOG_FRAME_SIZE];
+  char line[LINE_MAX_SIZE];
+  cost_t cost = { 0, 0 };
+  uint64_t start_ns;
+  uint64_t start_tsc;
+
+  for (unsigned int i = 0; i < DLOG_RING_SIZE; i++)
+  {
+    records[i].tick = i * 33u;
+    records[i].id = DLOG_DISTANCE;
+    records[i].arg[0] = (int32_t)(1000 + i);
+    records[i].arg[1] = 850;
+  }
+
+  for (unsigned long done = 0; done < calls; done += DLOG_RING_SIZE)
+  {
+    start_ns = now_ns();
+    start_tsc = now_tsc();
+    switch (variant)
+    {
+      case VARIANT_PRINTF:
+        for (int i = 0; i < DLOG_RING_SIZE; i++)
+          fprintf(sink, "d: %d, b: %d\n", (int)(done + i), 850);
+        break;
+      case VARIANT_APP_LOG:
+        for (int i = 0; i < DLOG_RING_SIZE; i++)
+          app_log_info("d: %d, b: %d\n", (int)(done + i), 850);
+        break;
+      case VARIANT_DLOG_WRITE:
+        for (int i = 0; i < DLOG_RING_SIZE; i++)
+          dlog_write(DLOG_RELAY_STATE, (int32_t)(done + i), 0);
+        break;
+      case VARIANT_DLOG_LIMITED:
+        for (int i = 0; i < DLOG_RING_SIZE; i++)
+          dlog_write(DLOG_DISTANCE, (int32_t)(done + i), 850);
+        break;
+      case VARIANT_FLUSH_TEXT:
+        for (int i = 0; i < DLOG_RING_SIZE; i++)
+          frame_sink += (uint8_t)dlog_format(&records[i], line, sizeof(line));
+        break;
+      default:
+        for (int i = 0; i < DLOG_RING_SIZE; i++)
+        {
+          dlog_encode(&records[i], frame);
+          frame_sink += frame[DLOG_FRAME_SIZE - 1];
+        }
+        break;
+    }
+    cost.tsc += now_tsc() - start_tsc;
+    cost.ns += now_ns() - start_ns;
+    // Empty the ring outside of the timing, DLOG_PRINT discards the lines
+    dlog_flush();
+  }
+  return cost;
+}
+
+/* Bytes on the console per call */
+static unsigned int console_bytes(variant_t variant)
+{
+  dlog_record_t record = { 1234u * 33u, DLOG_DISTANCE, 0, 0, { 1234, 850 } };
+  char line[LINE_MAX_SIZE];
+
+  switch (variant)
+  {
+    case VARIANT_PRINTF:
+      return (unsigned int)snprintf(line, sizeof(line), "d: %d, b: %d\n", 1234, 850);
+    case VARIANT_APP_LOG:
+      return (unsigned int)snprintf(line, sizeof(line), "[I] d: %d, b: %d\n", 1234, 850);
+    case VARIANT_DLOG_LIMITED:
+      return 0;
+    case VARIANT_FLUSH_BINARY:
+      return DLOG_FRAME_SIZE;
+    default:
+      return (unsigned int)dlog_format(&record, line, sizeof(line)) + 1;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  unsigned long calls = 1000000;
+  unsigned long baud = 115200;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:b:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n':
+        calls = strtoul(optarg, NULL, 0);
+        break;
+      case 'b':
+        baud = strtoul(optarg, NULL, 0);
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-n calls] [-b baud]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (calls < DLOG_RING_SIZE || baud == 0)
+  {
+    fprintf(stderr, "invalid parameters\n");
+    return 1;
+  }
+  calls -= calls % DLOG_RING_SIZE;
+  sink = fopen("/dev/null", "w");
+  if (sink == NULL)
+  {
+    fprintf(stderr, "cannot open /dev/null\n");
+    return 1;
+  }
+
+  test_frames();
+
+  dlog_init();
+  printf("# variant,ns_per_call,tsc_per_call,console_bytes,console_us\n");
+  for (variant_t v = VARIANT_PRINTF; v < VARIANT_COUNT; v++)
+  {
+    cost_t cost;
+    unsigned int bytes = console_bytes(v);
+
+    // The rate limited site has to be inside its interval after a first call
+    dlog_init();
+    if (v == VARIANT_DLOG_LIMITED)
+      dlog_write(DLOG_DISTANCE, 0, 0);
+    (void)time_calls(v, calls / 10 + DLOG_RING_SIZE);
+    cost = time_calls(v, calls);
+    printf("%s,%.1f,%.1f,%u,%.1f\n",
+           variant_names[v],
+           (double)cost.ns / (double)calls,
+           (double)cost.tsc / (double)calls,
+           bytes,
+           (double)bytes * 10.0 * 1e6 / (double)baud);
+  }
+  fclose(sink);
+  return 0;
+}
@@ -0,0 +1,105 @@
+/*
+ * dlog_decode.c
+ *
+ * Formats the binary dlog frames of a console capture from a target built
+ * with DLOG_BINARY=1. Text between the frames is copied as it is, a frame
+ * becomes the line dlog_flush() prints in text mode. A frame mark that does
+ * not start a valid frame is copied as text and counted as damaged.
+ *
+ * Build (from the project root):
+ *   SDK=simplicity_sdk_2025.6.2
+ *   gcc -O2 -DALG_HOST_BUILD -Ihost/shim -Ihost -I. \
+ *     -I$SDK/platform/common/inc \
+ *     dlog.c host/alg_host_port.c host/dlog_decode.c -o dlog_decode
+ *
+ * Usage:
+ *   dlog_decode [capture]   reads stdin without a capture file
+ *
+ * Output:
+ *   the capture with the frames formatted, and on stderr
+ *   <frames> frames, <damaged> damaged
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "dlog.h"
+
+#define LINE_MAX_SIZE 96
+
+static uint8_t *capture;
+static size_t capture_size;
+
+static int load(FILE *file)
+{
+  uint8_t buffer[4096];
+  size_t size;
+  size_t capacity = 0;
+
+  while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0)
+  {
+    if (capture_size + size > capacity)
+    {
+      capacity = capacity ? 2 * capacity : 65536;
+      while (capacity < capture_size + size)
+        capacity *= 2;
+      capture = realloc(capture, capacity);
+      if (capture == NULL)
+        return 0;
+    }
+    for (size_t i = 0; i < size; i++)
+      capture[capture_size + i] = buffer[i];
+    capture_size += size;
+  }
+  return 1;
+}
+
+int main(int argc, char **argv)
+{
+  FILE *file = stdin;
+  dlog_record_t record;
+  char line[LINE_MAX_SIZE];
+  unsigned long frames = 0;
+  unsigned long damaged = 0;
+  size_t pos = 0;
+
+  if (argc > 2)
+  {
+    fprintf(stderr, "usage: %s [capture]\n", argv[0]);
+    return 1;
+  }
+  if (argc == 2)
+  {
+    file = fopen(argv[1], "rb");
+    if (file == NULL)
+    {
+      fprintf(stderr, "cannot read capture %s\n", argv[1]);
+      return 1;
+    }
+  }
+  if (!load(file))
+  {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+
+  while (pos < capture_size)
+  {
+    if (capture[pos] == DLOG_FRAME_MARK)
+    {
+      if (pos + DLOG_FRAME_SIZE <= capture_size && dlog_decode(&capture[pos], &record))
+      {
+        dlog_format(&record, line, sizeof(line));
+        printf("%s\n", line);
+        pos += DLOG_FRAME_SIZE;
+        frames++;
+        continue;
+      }
+      damaged++;
+    }
+    putchar(capture[pos]);
+    pos++;
+  }
+  fprintf(stderr, "%lu frames, %lu damaged\n", frames, damaged);
+  return 0;
+}
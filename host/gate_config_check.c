@@ -0,0 +1,451 @@
+/*
+ * gate_config_check.c
+ *
+ * Drives gate_config.c on the NVM3 object store and the virtual clock of
+ * alg_host_port.c, with a main loop that runs gate_config_process() after
+ * every timer, and checks the boot paths (nothing stored, the 1-byte
+ * objects of the first layout, a damaged record, a record of an older or a
+ * newer layout) and the deferred writes: one flash write per burst of changes,
+ * written GATE_CONFIG_QUIET_MS after the last one, at most
+ * GATE_CONFIG_MAX_DELAY_MS after the first one. Prints the flash writes and
+ * commit latencies next to the one write per change of the first layout.
+ * Exits with 1 on the first failed check.
+ *
+ * Build (from the project root):
+ *   SDK=simplicity_sdk_2025.6.2
+ *   gcc -O2 -DALG_HOST_BUILD -Ihost/shim -Ihost -I. -Iconfig \
+ *     -I$SDK/platform/common/inc \
+ *     gate_config.c host/alg_host_port.c host/gate_config_check.c \
+ *     -o gate_config_check
+ *
+ * Options:
+ *   -n <changes>  changes per burst (50)
+ *   -i <ms>       interval between the changes of a burst (100)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <getopt.h>
+#include "alg_host_port.h"
+#include "gate_config.h"
+#include "config/token.h"
+
+/* Layout of the record, kept apart from gate_config.c on purpose */
+typedef struct
+{
+  uint8_t version;
+  uint8_t size;
+  uint16_t crc;
+  gate_config_t values;
+} record_t;
+
+static gate_config_t applied;
+static unsigned int apply_count;
+
+static void fail(const char *test, const char *what)
+{
+  printf("FAIL %s: %s\n", test, what);
+  exit(1);
+}
+
+static void on_apply(const gate_config_t *config)
+{
+  applied = *config;
+  apply_count++;
+}
+
+static uint32_t writes(void)
+{
+  return nvm3_defaultHandle->write_count;
+}
+
+/* CRC-16/CCITT-FALSE of the record with crc 0 */
+static uint16_t crc(const uint8_t *data, size_t len)
+{
+  uint16_t c = 0xffff;
+
+  for (size_t n = 0; n < len; n++)
+  {
+    uint8_t b = (n == offsetof(record_t, crc) || n == offsetof(record_t, crc) + 1) ? 0 : data[n];
+
+    c ^= (uint16_t)(b << 8);
+    for (int i = 0; i < 8; i++)
+      c = (c & 0x8000) ? (uint16_t)((c << 1) ^ 0x1021) : (uint16_t)(c << 1);
+  }
+  return c;
+}
+
+/* Run the main loop until no timer is left */
+static void drain(void)
+{
+  uint32_t next;
+
+  gate_config_process();
+  while (alg_host_next_timer(&next))
+  {
+    alg_host_advance_to(next);
+    gate_config_process();
+  }
+}
+
+/* Run the main loop up to time_ms, the time of the first write is kept */
+static void run_until(uint32_t time_ms, uint32_t *write_ms)
+{
+  uint32_t next;
+  uint32_t before = writes();
+
+  gate_config_process();
+  while (alg_host_next_timer(&next) && next <= time_ms)
+  {
+    alg_host_advance_to(next);
+    gate_config_process();
+    if (write_ms != NULL && writes() != before)
+    {
+      *write_ms = next;
+      write_ms = NULL;
+    }
+  }
+  alg_host_advance_to(time_ms);
+}
+
+static void erase(void)
+{
+  drain();
+  (void)nvm3_deleteObject(nvm3_defaultHandle, NVM3KEY_GATE_CONFIG);
+  (void)nvm3_deleteObject(nvm3_defaultHandle, NVM3KEY_DEVICE_MOVING_THRESHOLD);
+  (void)nvm3_deleteObject(nvm3_defaultHandle, NVM3KEY_DEVICE_BASELINE_WEIGHT);
+  (void)nvm3_deleteObject(nvm3_defaultHandle, NVM3KEY_DEVICE_OPEN_TIME);
+  (void)nvm3_deleteObject(nvm3_defaultHandle, NVM3KEY_DEVICE_CLOSE_TIME);
+}
+
+static void expect_origin(const char *test, gate_config_origin_t got, gate_config_origin_t wanted)
+{
+  if (got != wanted)
+  {
+    printf("FAIL %s: origin %d, expected %d\n", test, got, wanted);
+    exit(1);
+  }
+}
+
+static bool same(const gate_config_t *a, const gate_config_t *b)
+{
+  return memcmp(a, b, sizeof(*a)) == 0;
+}
+
+static void test_defaults(void)
+{
+  gate_config_t defaults;
+  uint32_t w;
+
+  erase();
+  w = writes();
+  expect_origin("defaults", gate_config_init(on_apply), GATE_CONFIG_DEFAULTS);
+  gate_config_defaults(&defaults);
+  if (!same(gate_config_get(), &defaults) || !same(&applied, &defaults))
+    fail("defaults", "values differ from the defaults");
+  if (defaults.moving_threshold_mm != 1000 || defaults.baseline_weight != 10
+      || defaults.open_block_ms != 8000 || defaults.close_block_ms != 10000)
+    fail("defaults", "defaults differ from the first layout");
+  if (writes() != w + 1)
+    fail("defaults", "one record write expected");
+
+  /* Next boot reads it back without writing */
+  w = writes();
+  expect_origin("defaults", gate_config_init(on_apply), GATE_CONFIG_LOADED);
+  if (writes() != w || !same(&applied, &defaults))
+    fail("defaults", "reload");
+  printf("PASS defaults\n");
+}
+
+static void test_legacy(void)
+{
+  uint8_t threshold = 15, weight = 30, open_s = 5, close_s = 12;
+  uint32_t type;
+  size_t len;
+  uint32_t w;
+
+  erase();
+  (void)nvm3_writeData(nvm3_defaultHandle, NVM3KEY_DEVICE_MOVING_THRESHOLD, &threshold, 1);
+  (void)nvm3_writeData(nvm3_defaultHandle, NVM3KEY_DEVICE_BASELINE_WEIGHT, &weight, 1);
+  (void)nvm3_writeData(nvm3_defaultHandle, NVM3KEY_DEVICE_OPEN_TIME, &open_s, 1);
+  (void)nvm3_writeData(nvm3_defaultHandle, NVM3KEY_DEVICE_CLOSE_TIME, &close_s, 1);
+
+  w = writes();
+  expect_origin("legacy", gate_config_init(on_apply), GATE_CONFIG_LEGACY);
+  if (applied.moving_threshold_mm != 1500 || applied.baseline_weight != 30
+      || applied.open_block_ms != 5000 || applied.close_block_ms != 12000)
+    fail("legacy", "values not converted");
+  /* The record, then the four old objects deleted */
+  if (writes() != w + 5)
+    fail("legacy", "one record write and four deletes expected");
+  if (nvm3_getObjectInfo(nvm3_defaultHandle, NVM3KEY_DEVICE_OPEN_TIME, &type, &len) != SL_STATUS_NOT_FOUND)
+    fail("legacy", "old object left");
+
+  w = writes();
+  expect_origin("legacy", gate_config_init(on_apply), GATE_CONFIG_LOADED);
+  if (writes() != w || applied.close_block_ms != 12000)
+    fail("legacy", "reload");
+
+  /* Out of range old values take their default */
+  erase();
+  weight = 0;
+  (void)nvm3_writeData(nvm3_defaultHandle, NVM3KEY_DEVICE_BASELINE_WEIGHT, &weight, 1);
+  expect_origin("legacy", gate_config_init(on_apply), GATE_CONFIG_LEGACY);
+  if (applied.baseline_weight != 10 || applied.moving_threshold_mm != 1000)
+    fail("legacy", "bad old value not defaulted");
+  printf("PASS legacy\n");
+}
+
+static void test_damaged(void)
+{
+  record_t r;
+  gate_config_t defaults;
+
+  erase();
+  gate_config_init(on_apply);
+  (void)nvm3_readData(nvm3_defaultHandle, NVM3KEY_GATE_CONFIG, &r, sizeof(r));
+  if (r.version != GATE_CONFIG_VERSION || r.size != sizeof(r) || r.crc != crc((uint8_t *)&r, sizeof(r)))
+    fail("damaged", "record layout");
+
+  /* A flipped bit */
+  r.values.open_block_ms ^= 0x40;
+  (void)nvm3_writeData(nvm3_defaultHandle, NVM3KEY_GATE_CONFIG, &r, sizeof(r));
+  expect_origin("damaged", gate_config_init(on_apply), GATE_CONFIG_DAMAGED);
+  gate_config_defaults(&defaults);
+  if (!same(&applied, &defaults))
+    fail("damaged", "defaults expected");
+  expect_origin("damaged", gate_config_init(on_apply), GATE_CONFIG_LOADED);
+
+  /* A truncated record */
+  (void)nvm3_writeData(nvm3_defaultHandle, NVM3KEY_GATE_CONFIG, &r, 3);
+  expect_origin("damaged", gate_config_init(on_apply), GATE_CONFIG_DAMAGED);
+
+  /* Valid CRC, impossible value */
+  gate_config_init(on_apply);
+  (void)nvm3_readData(nvm3_defaultHandle, NVM3KEY_GATE_CONFIG, &r, sizeof(r));
+  r.values.baseline_weight = 200;
+  r.crc = crc((uint8_t *)&r, sizeof(r));
+  (void)nvm3_writeData(nvm3_defaultHandle, NVM3KEY_GATE_CONFIG, &r, sizeof(r));
+  expect_origin("damaged", gate_config_init(on_apply), GATE_CONFIG_LOADED);
+  if (applied.baseline_weight != defaults.baseline_weight)
+    fail("damaged", "out of range value not defaulted");
+  printf("PASS damaged\n");
+}
+
+/* A version 1 record, before the zones and the relay pulse */
+static void test_migrated(void)
+{
+  uint8_t buf[offsetof(record_t, values) + offsetof(gate_config_t, red_zone_mm)];
+  record_t r;
+  gate_config_t defaults;
+  uint32_t w;
+
+  erase();
+  memset(&r, 0, sizeof(r));
+  r.version = 1;
+  r.size = sizeof(buf);
+  gate_config_defaults(&r.values);
+  r.values.moving_threshold_mm = 2500;
+  memcpy(buf, &r, sizeof(buf));
+  r.crc = crc(buf, sizeof(buf));
+  memcpy(buf, &r, sizeof(buf));
+  (void)nvm3_writeData(nvm3_defaultHandle, NVM3KEY_GATE_CONFIG, buf, sizeof(buf));
+
+  w = writes();
+  expect_origin("migrated", gate_config_init(on_apply), GATE_CONFIG_MIGRATED);
+  gate_config_defaults(&defaults);
+  if (applied.moving_threshold_mm != 2500 || applied.red_zone_mm != defaults.red_zone_mm
+      || applied.opening_zone_mm != defaults.opening_zone_mm
+      || applied.relay_pulse_ms != defaults.relay_pulse_ms)
+    fail("migrated", "old fields lost or new fields not defaulted");
+  if (writes() != w + 1)
+    fail("migrated", "record not rewritten");
+  expect_origin("migrated", gate_config_init(on_apply), GATE_CONFIG_LOADED);
+  printf("PASS migrated\n");
+}
+
+/* A record written by a firmware with more fields */
+static void test_newer(void)
+{
+  uint8_t buf[sizeof(record_t) + 8];
+  record_t r;
+  uint32_t w;
+
+  erase();
+  memset(&r, 0, sizeof(r));
+  r.version = GATE_CONFIG_VERSION + 1;
+  r.size = sizeof(buf);
+  gate_config_defaults(&r.values);
+  r.values.close_block_ms = 20000;
+  memset(buf, 0xa5, sizeof(buf));
+  memcpy(buf, &r, sizeof(r));
+  r.crc = crc(buf, sizeof(buf));
+  memcpy(buf, &r, sizeof(r));
+  (void)nvm3_writeData(nvm3_defaultHandle, NVM3KEY_GATE_CONFIG, buf, sizeof(buf));
+
+  w = writes();
+  expect_origin("newer", gate_config_init(on_apply), GATE_CONFIG_LOADED);
+  if (applied.close_block_ms != 20000 || writes() != w)
+    fail("newer", "known fields not taken as they are");
+  printf("PASS newer\n");
+}
+
+static void test_set(void)
+{
+  gate_config_t c;
+  uint32_t w;
+
+  erase();
+  gate_config_init(on_apply);
+
+  /* Atomic: one bad field rejects all */
+  c = *gate_config_get();
+  c.open_block_ms = 3000;
+  c.baseline_weight = 0;
+  apply_count = 0;
+  if (gate_config_set(&c) != SL_STATUS_INVALID_PARAMETER)
+    fail("set", "out of range value accepted");
+  if (gate_config_get()->open_block_ms != 8000 || apply_count != 0 || gate_config_pending())
+    fail("set", "rejected change partly applied");
+
+  /* Applied at once, written later */
+  c.baseline_weight = 20;
+  w = writes();
+  if (gate_config_set(&c) != SL_STATUS_OK || applied.open_block_ms != 3000 || !gate_config_pending())
+    fail("set", "change not applied");
+  if (writes() != w)
+    fail("set", "written right away");
+
+  /* Changed back before the write: nothing to write */
+  c.open_block_ms = 8000;
+  c.baseline_weight = 10;
+  (void)gate_config_set(&c);
+  if (gate_config_pending())
+    fail("set", "pending without a change");
+  drain();
+  if (writes() != w)
+    fail("set", "record written without a change");
+
+  /* Flush, as before a reset */
+  c.close_block_ms = 15000;
+  (void)gate_config_set(&c);
+  if (gate_config_flush() != SL_STATUS_OK || gate_config_pending() || writes() != w + 1)
+    fail("set", "flush");
+  drain();
+  if (writes() != w + 1)
+    fail("set", "written again after the flush");
+  gate_config_init(on_apply);
+  if (applied.close_block_ms != 15000)
+    fail("set", "flushed value lost");
+  printf("PASS set\n");
+}
+
+/* A commissioning burst, e.g. a sweep of the moving threshold */
+static void test_burst(unsigned int changes, uint32_t interval_ms)
+{
+  gate_config_t c;
+  uint32_t w;
+  uint32_t last_ms = 0;
+  uint32_t write_ms = 0;
+
+  erase();
+  gate_config_init(on_apply);
+  c = *gate_config_get();
+  w = writes();
+  for (unsigned int i = 0; i < changes; i++)
+  {
+    c.moving_threshold_mm = 1100 + 10 * (i % 4000);
+    last_ms = alg_host_now_ms();
+    (void)gate_config_set(&c);
+    run_until(alg_host_now_ms() + interval_ms, NULL);
+  }
+  run_until(last_ms + GATE_CONFIG_MAX_DELAY_MS, &write_ms);
+  if (interval_ms < GATE_CONFIG_QUIET_MS
+      && (uint64_t)changes * interval_ms < GATE_CONFIG_MAX_DELAY_MS)
+  {
+    if (writes() != w + 1)
+      fail("burst", "one write per burst expected");
+    if (write_ms != last_ms + GATE_CONFIG_QUIET_MS)
+      fail("burst", "not written a quiet period after the last change");
+  }
+  gate_config_init(on_apply);
+  if (applied.moving_threshold_mm != c.moving_threshold_mm)
+    fail("burst", "last value not saved");
+  printf("PASS burst: %u changes every %lu ms, %lu flash writes (%u with one per change), "
+         "written %lu ms after the last change\n",
+         changes, (unsigned long)interval_ms, (unsigned long)(writes() - w), changes,
+         (unsigned long)(write_ms - last_ms));
+}
+
+/* Changes that never stop still reach the flash */
+static void test_continuous(void)
+{
+  gate_config_t c;
+  uint32_t w;
+  uint32_t start;
+  uint32_t max_gap = 0;
+  uint32_t last_write;
+  const uint32_t period_ms = 500;
+  const uint32_t run_ms = 5 * GATE_CONFIG_MAX_DELAY_MS;
+
+  erase();
+  gate_config_init(on_apply);
+  c = *gate_config_get();
+  w = writes();
+  start = alg_host_now_ms();
+  last_write = start;
+  for (uint32_t t = 0; t < run_ms; t += period_ms)
+  {
+    uint32_t before = writes();
+
+    c.open_block_ms = 1000 + t / period_ms * 10;
+    (void)gate_config_set(&c);
+    run_until(start + t + period_ms, NULL);
+    if (writes() != before)
+    {
+      if (alg_host_now_ms() - last_write > max_gap)
+        max_gap = alg_host_now_ms() - last_write;
+      last_write = alg_host_now_ms();
+    }
+  }
+  drain();
+  if (writes() - w > run_ms / GATE_CONFIG_MAX_DELAY_MS + 1)
+    fail("continuous", "too many writes");
+  if (max_gap > GATE_CONFIG_MAX_DELAY_MS + period_ms)
+    fail("continuous", "change left unsaved too long");
+  printf("PASS continuous: %lu changes, %lu flash writes, longest unsaved %lu ms\n",
+         (unsigned long)(run_ms / period_ms), (unsigned long)(writes() - w), (unsigned long)max_gap);
+}
+
+int main(int argc, char *argv[])
+{
+  unsigned int changes = 50;
+  uint32_t interval_ms = 100;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:i:")) != -1) {
+    switch (opt) {
+      case 'n':
+        changes = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      case 'i':
+        interval_ms = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-n changes] [-i interval_ms]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  test_defaults();
+  test_legacy();
+  test_damaged();
+  test_migrated();
+  test_newer();
+  test_set();
+  test_burst(changes, interval_ms);
+  test_continuous();
+  return 0;
+}
@@ -0,0 +1,659 @@
+/*
+ * gatt_config_sim.c
+ *
+ * GATT client simulator for the gate configuration characteristics of
+ * ble_handler.c. Turns client reads and writes into the user_read_request
+ * and user_write_request events the stack delivers for type="user"
+ * characteristics, split at the ATT MTU: a write that does not fit one
+ * Write Request goes out as Prepare Writes and an Execute Write, a read
+ * continues with Read Blob offsets. The responses of ble_handler.c are
+ * captured in place of the stack. Checks the TLV round trip, the atomic
+ * validation of GATE_CONFIG writes, the long procedures, that the 1-byte
+ * characteristics still behave as before and that the Latency Histograms
+ * readout matches cs_initiator_latency.c and is not torn by results
+ * arriving during a long read, and prints the ATT round trips and flash
+ * writes of commissioning a gate and of a field sweep. Exits with 1 on the
+ * first failed check.
+ *
+ * Build (from the project root):
+ *   SDK=simplicity_sdk_2025.6.2
+ *   C=$SDK/app/bluetooth/common
+ *   gcc -O2 -DALG_HOST_BUILD -Ihost/shim -Ihost -I. -Iconfig \
+ *     -I$SDK/platform/common/inc -I$SDK/protocol/bluetooth/inc \
+ *     -I$SDK/platform/emlib/inc -I$SDK/util/silicon_labs/rtl/inc \
+ *     -I$C/cs_initiator/inc \
+ *     ble_handler.c gate_config.c $C/cs_initiator/src/cs_initiator_latency.c \
+ *     host/alg_host_port.c host/gatt_config_sim.c -o gatt_config_sim
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "alg_host_port.h"
+#include "sl_bt_api.h"
+#include "autogen/gatt_db.h"
+#include "gate_config.h"
+#include "cs_initiator_latency.h"
+#include "config/token.h"
+
+#define CONN        1
+#define ATT_HEADER  3   /* Opcode and handle */
+#define ATT_ERROR_OK 0
+
+void write_characteristic(sl_bt_evt_gatt_server_user_write_request_t * request);
+void read_characteristic(sl_bt_evt_gatt_server_user_read_request_t * request);
+
+/* Latency Histograms readout, the layout is in ble_handler.c */
+#define LATENCY_HEADER_SIZE   (8 + 4 * (CS_INITIATOR_LATENCY_BUCKET_COUNT - 1))
+#define LATENCY_STAGE_SIZE    (16 + 2 * CS_INITIATOR_LATENCY_BUCKET_COUNT)
+#define LATENCY_READOUT_SIZE  (LATENCY_HEADER_SIZE \
+                               + CS_INITIATOR_LATENCY_STAGE_COUNT * LATENCY_STAGE_SIZE)
+
+/* Last response of ble_handler.c */
+static struct
+{
+  bool sent;
+  uint8_t att_error;
+  uint16_t offset;
+  uint16_t len;
+  uint8_t data[256];
+} response;
+
+static uint16_t mtu = 23;
+static unsigned int round_trips;
+static unsigned int resets;
+
+static void fail(const char *test, const char *what)
+{
+  printf("FAIL %s: %s\n", test, what);
+  exit(1);
+}
+
+static void on_apply(const gate_config_t *config)
+{
+  (void)config;
+}
+
+static uint32_t flash_writes(void)
+{
+  return nvm3_defaultHandle->write_count;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Stack side */
+
+sl_status_t sl_bt_gatt_server_send_user_write_response(uint8_t connection,
+                                                       uint16_t characteristic,
+                                                       uint8_t att_errorcode)
+{
+  (void)connection;
+  (void)characteristic;
+  response.sent = true;
+  response.att_error = att_errorcode;
+  response.len = 0;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_gatt_server_send_user_prepare_write_response(uint8_t connection,
+                                                               uint16_t characteristic,
+                                                               uint8_t att_errorcode,
+                                                               uint16_t offset,
+                                                               size_t value_len,
+                                                               const uint8_t* value)
+{
+  (void)connection;
+  (void)characteristic;
+  response.sent = true;
+  response.att_error = att_errorcode;
+  response.offset = offset;
+  response.len = (uint16_t)value_len;
+  memcpy(response.data, value, value_len);
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_gatt_server_send_user_read_response(uint8_t connection,
+                                                      uint16_t characteristic,
+                                                      uint8_t att_errorcode,
+                                                      size_t value_len,
+                                                      const uint8_t* value,
+                                                      uint16_t *sent_len)
+{
+  (void)connection;
+  (void)characteristic;
+  /* The stack sends what fits one ATT_MTU */
+  if (value_len > (size_t)(mtu - 1))
+    value_len = mtu - 1;
+  response.sent = true;
+  response.att_error = att_errorcode;
+  response.len = (uint16_t)value_len;
+  if (value_len != 0)
+    memcpy(response.data, value, value_len);
+  *sent_len = (uint16_t)value_len;
+  return SL_STATUS_OK;
+}
+
+void NVIC_SystemReset(void)
+{
+  resets++;
+}
+
+/* One user_write_request event, returns the ATT error of the response */
+static uint8_t deliver_write(uint8_t opcode, uint16_t characteristic, uint16_t offset,
+                             const uint8_t *data, uint16_t len)
+{
+  union
+  {
+    sl_bt_evt_gatt_server_user_write_request_t request;
+    uint8_t bytes[sizeof(sl_bt_evt_gatt_server_user_write_request_t) + 256];
+  } evt;
+
+  memset(&evt, 0, sizeof(evt));
+  evt.request.connection = CONN;
+  evt.request.characteristic = characteristic;
+  evt.request.att_opcode = opcode;
+  evt.request.offset = offset;
+  evt.request.value.len = len;
+  if (len != 0)
+    memcpy(evt.request.value.data, data, len);
+
+  response.sent = false;
+  write_characteristic(&evt.request);
+  round_trips++;
+  if (!response.sent)
+    return 0xff;
+  return response.att_error;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Client side */
+
+/* Write Request, or Prepare Writes and an Execute Write if it does not fit */
+static uint8_t client_write(uint16_t characteristic, const uint8_t *data, uint16_t len)
+{
+  uint16_t part = mtu - ATT_HEADER - 2;     /* Prepare Write carries an offset */
+  uint16_t offset = 0;
+  uint8_t att_error;
+
+  if (len <= mtu - ATT_HEADER)
+    return deliver_write(sl_bt_gatt_write_request, characteristic, 0, data, len);
+
+  while (offset < len)
+  {
+    uint16_t n = (len - offset < part) ? len - offset : part;
+
+    att_error = deliver_write(sl_bt_gatt_prepare_write_request, characteristic, offset,
+                              &data[offset], n);
+    if (att_error != ATT_ERROR_OK)
+      return att_error;
+    /* Reliable write check of the echoed part */
+    if (response.offset != offset || response.len != n || memcmp(response.data, &data[offset], n) != 0)
+      return 0xfe;
+    offset += n;
+  }
+  /* The characteristic of the execute write is 0 */
+  return deliver_write(sl_bt_gatt_execute_write_request, 0, 0, NULL, 0);
+}
+
+/* Read Request, then Read Blob until a short part, returns the length */
+static uint16_t client_read(uint16_t characteristic, uint8_t *buf, uint16_t size, uint8_t *att_error)
+{
+  sl_bt_evt_gatt_server_user_read_request_t request;
+  uint16_t len = 0;
+
+  do
+  {
+    memset(&request, 0, sizeof(request));
+    request.connection = CONN;
+    request.characteristic = characteristic;
+    request.att_opcode = (len == 0) ? sl_bt_gatt_read_request : sl_bt_gatt_read_blob_request;
+    request.offset = len;
+    response.sent = false;
+    read_characteristic(&request);
+    round_trips++;
+    *att_error = response.sent ? response.att_error : 0xff;
+    if (*att_error != ATT_ERROR_OK || len + response.len > size)
+      return len;
+    memcpy(&buf[len], response.data, response.len);
+    len += response.len;
+  } while (response.len == mtu - 1);
+  return len;
+}
+
+/* Element of a TLV payload */
+static uint16_t put(uint8_t *buf, uint16_t pos, uint8_t tag, uint8_t size, uint32_t value)
+{
+  buf[pos++] = tag;
+  buf[pos++] = size;
+  for (uint8_t n = 0; n < size; n++)
+    buf[pos++] = (uint8_t)(value >> (8u * n));
+  return pos;
+}
+
+/* Every parameter, as a commissioning tool writes them */
+static uint16_t full_payload(uint8_t *buf, const gate_config_t *c)
+{
+  uint16_t len = 0;
+
+  len = put(buf, len, GATE_CONFIG_TAG_MOVING_THRESHOLD_MM, 4, c->moving_threshold_mm);
+  len = put(buf, len, GATE_CONFIG_TAG_OPEN_BLOCK_MS, 4, c->open_block_ms);
+  len = put(buf, len, GATE_CONFIG_TAG_CLOSE_BLOCK_MS, 4, c->close_block_ms);
+  len = put(buf, len, GATE_CONFIG_TAG_BASELINE_WEIGHT, 1, c->baseline_weight);
+  len = put(buf, len, GATE_CONFIG_TAG_RED_ZONE_MM, 4, c->red_zone_mm);
+  len = put(buf, len, GATE_CONFIG_TAG_OPENING_ZONE_MM, 4, c->opening_zone_mm);
+  len = put(buf, len, GATE_CONFIG_TAG_RELAY_PULSE_MS, 4, c->relay_pulse_ms);
+  return len;
+}
+
+static bool same(const gate_config_t *a, const gate_config_t *b)
+{
+  return memcmp(a, b, sizeof(*a)) == 0;
+}
+
+static void fresh(void)
+{
+  (void)nvm3_deleteObject(nvm3_defaultHandle, NVM3KEY_GATE_CONFIG);
+  (void)gate_config_init(on_apply);
+}
+
+static void expect_error(const char *test, uint8_t got, uint8_t wanted)
+{
+  if (got != wanted)
+  {
+    printf("FAIL %s: ATT error 0x%02x, expected 0x%02x\n", test, got, wanted);
+    exit(1);
+  }
+}
+
+/* ------------------------------------------------------------------------- */
+/* Checks */
+
+static void test_read(void)
+{
+  uint8_t buf[64];
+  uint8_t att_error;
+  uint16_t len;
+  gate_config_t c;
+  const uint16_t mtus[] = { 23, 24, 40, 247 };
+
+  fresh();
+  for (size_t i = 0; i < sizeof(mtus) / sizeof(mtus[0]); i++)
+  {
+    mtu = mtus[i];
+    len = client_read(gattdb_GATE_CONFIG, buf, sizeof(buf), &att_error);
+    expect_error("read", att_error, ATT_ERROR_OK);
+    if (len != GATE_CONFIG_TLV_SIZE)
+      fail("read", "length");
+    memset(&c, 0xff, sizeof(c));
+    memset(c.reserved, 0, sizeof(c.reserved));
+    if (gate_config_decode(buf, len, &c) != SL_STATUS_OK || !same(&c, gate_config_get()))
+      fail("read", "round trip");
+  }
+
+  /* Read Blob past the end */
+  {
+    sl_bt_evt_gatt_server_user_read_request_t request = {
+      .connection = CONN,
+      .characteristic = gattdb_GATE_CONFIG,
+      .att_opcode = sl_bt_gatt_read_blob_request,
+      .offset = GATE_CONFIG_TLV_SIZE + 1
+    };
+
+    read_characteristic(&request);
+    expect_error("read", response.att_error, (uint8_t)SL_STATUS_BT_ATT_INVALID_OFFSET);
+  }
+  printf("PASS read: %u bytes\n", (unsigned int)GATE_CONFIG_TLV_SIZE);
+}
+
+static void test_commission(uint16_t att_mtu)
+{
+  uint8_t buf[64];
+  uint16_t len;
+  uint8_t byte;
+  gate_config_t c;
+  unsigned int legacy_trips;
+  unsigned int bulk_trips;
+
+  fresh();
+  mtu = att_mtu;
+
+  /* The 1-byte characteristics: four writes, zones and pulse out of reach */
+  round_trips = 0;
+  byte = 12;
+  expect_error("commission", client_write(gattdb_MOVING_THRESHOLD, &byte, 1), ATT_ERROR_OK);
+  byte = 20;
+  expect_error("commission", client_write(gattdb_BASELINE, &byte, 1), ATT_ERROR_OK);
+  byte = 6;
+  expect_error("commission", client_write(gattdb_OPEN_TIME, &byte, 1), ATT_ERROR_OK);
+  byte = 9;
+  expect_error("commission", client_write(gattdb_CLOSE_TIME, &byte, 1), ATT_ERROR_OK);
+  legacy_trips = round_trips;
+
+  fresh();
+  c = *gate_config_get();
+  c.moving_threshold_mm = 1250;
+  c.baseline_weight = 20;
+  c.open_block_ms = 6500;
+  c.close_block_ms = 9000;
+  c.red_zone_mm = 1500;
+  c.opening_zone_mm = 60000;
+  c.relay_pulse_ms = 300;
+  len = full_payload(buf, &c);
+  round_trips = 0;
+  expect_error("commission", client_write(gattdb_GATE_CONFIG, buf, len), ATT_ERROR_OK);
+  bulk_trips = round_trips;
+  if (!same(gate_config_get(), &c))
+    fail("commission", "values not applied");
+
+  (void)gate_config_flush();
+  (void)gate_config_init(on_apply);
+  if (!same(gate_config_get(), &c))
+    fail("commission", "values not saved");
+  printf("PASS commission, MTU %u: %u bytes in %u ATT round trips, "
+         "%u round trips for the four 1-byte characteristics\n",
+         (unsigned int)att_mtu, (unsigned int)len, bulk_trips, legacy_trips);
+}
+
+static void test_atomic(void)
+{
+  uint8_t buf[64];
+  uint16_t len;
+  gate_config_t c;
+  gate_config_t before;
+
+  fresh();
+  mtu = 247;
+  before = *gate_config_get();
+
+  /* One field out of range rejects the others */
+  c = before;
+  c.moving_threshold_mm = 3000;
+  c.relay_pulse_ms = 10;
+  len = full_payload(buf, &c);
+  expect_error("atomic", client_write(gattdb_GATE_CONFIG, buf, len),
+               (uint8_t)SL_STATUS_BT_ATT_OUT_OF_RANGE);
+  if (!same(gate_config_get(), &before) || gate_config_pending())
+    fail("atomic", "range error partly applied");
+
+  /* Red zone beyond the opening zone */
+  len = put(buf, 0, GATE_CONFIG_TAG_RED_ZONE_MM, 4, 5000);
+  len = put(buf, len, GATE_CONFIG_TAG_OPENING_ZONE_MM, 4, 4000);
+  expect_error("atomic", client_write(gattdb_GATE_CONFIG, buf, len),
+               (uint8_t)SL_STATUS_BT_ATT_OUT_OF_RANGE);
+
+  /* Malformed payloads */
+  len = put(buf, 0, GATE_CONFIG_TAG_OPEN_BLOCK_MS, 4, 3000);
+  len = put(buf, len, 0x42, 4, 1);
+  expect_error("atomic", client_write(gattdb_GATE_CONFIG, buf, len),
+               (uint8_t)SL_STATUS_BT_ATT_VALUE_NOT_ALLOWED);
+  len = put(buf, 0, GATE_CONFIG_TAG_BASELINE_WEIGHT, 4, 30);
+  expect_error("atomic", client_write(gattdb_GATE_CONFIG, buf, len),
+               (uint8_t)SL_STATUS_BT_ATT_VALUE_NOT_ALLOWED);
+  len = put(buf, 0, GATE_CONFIG_TAG_OPEN_BLOCK_MS, 4, 3000);
+  len = put(buf, len, GATE_CONFIG_TAG_OPEN_BLOCK_MS, 4, 4000);
+  expect_error("atomic", client_write(gattdb_GATE_CONFIG, buf, len),
+               (uint8_t)SL_STATUS_BT_ATT_VALUE_NOT_ALLOWED);
+  len = put(buf, 0, GATE_CONFIG_TAG_OPEN_BLOCK_MS, 4, 3000);
+  expect_error("atomic", client_write(gattdb_GATE_CONFIG, buf, len - 1),
+               (uint8_t)SL_STATUS_BT_ATT_VALUE_NOT_ALLOWED);
+  if (!same(gate_config_get(), &before) || gate_config_pending())
+    fail("atomic", "malformed payload partly applied");
+
+  /* A subset leaves the other fields alone */
+  len = put(buf, 0, GATE_CONFIG_TAG_RELAY_PULSE_MS, 4, 700);
+  expect_error("atomic", client_write(gattdb_GATE_CONFIG, buf, len), ATT_ERROR_OK);
+  c = before;
+  c.relay_pulse_ms = 700;
+  if (!same(gate_config_get(), &c))
+    fail("atomic", "subset");
+  printf("PASS atomic\n");
+}
+
+static void test_long_write(void)
+{
+  uint8_t buf[64];
+  uint16_t len;
+  gate_config_t c;
+
+  fresh();
+  mtu = 23;
+  c = *gate_config_get();
+  c.opening_zone_mm = 80000;
+  len = full_payload(buf, &c);
+
+  /* Parts out of order */
+  expect_error("long write", deliver_write(sl_bt_gatt_prepare_write_request, gattdb_GATE_CONFIG, 0, buf, 18),
+               ATT_ERROR_OK);
+  expect_error("long write", deliver_write(sl_bt_gatt_prepare_write_request, gattdb_GATE_CONFIG, 20, &buf[20], 10),
+               (uint8_t)SL_STATUS_BT_ATT_INVALID_OFFSET);
+
+  /* Longer than any payload */
+  expect_error("long write", deliver_write(sl_bt_gatt_prepare_write_request, gattdb_GATE_CONFIG, 18, &buf[18], 30),
+               (uint8_t)SL_STATUS_BT_ATT_INVALID_ATT_LENGTH);
+
+  /* Started again from offset 0 */
+  expect_error("long write", client_write(gattdb_GATE_CONFIG, buf, len), ATT_ERROR_OK);
+  if (gate_config_get()->opening_zone_mm != 80000)
+    fail("long write", "not applied");
+
+  /* A bad value in the last part rejects the whole write */
+  c.opening_zone_mm = 90000;
+  c.relay_pulse_ms = 9000;
+  len = full_payload(buf, &c);
+  expect_error("long write", client_write(gattdb_GATE_CONFIG, buf, len),
+               (uint8_t)SL_STATUS_BT_ATT_OUT_OF_RANGE);
+  if (gate_config_get()->opening_zone_mm != 80000)
+    fail("long write", "rejected write partly applied");
+
+  /* The 1-byte characteristics are not long */
+  expect_error("long write", deliver_write(sl_bt_gatt_prepare_write_request, gattdb_BASELINE, 0, buf, 1),
+               (uint8_t)SL_STATUS_BT_ATT_ATT_NOT_LONG);
+  printf("PASS long write\n");
+}
+
+static void test_legacy(void)
+{
+  uint8_t data[2] = { 15, 0 };
+  uint8_t att_error;
+  uint8_t byte;
+
+  fresh();
+  mtu = 23;
+  expect_error("legacy", client_write(gattdb_MOVING_THRESHOLD, data, 1), ATT_ERROR_OK);
+  if (gate_config_get()->moving_threshold_mm != 1500)
+    fail("legacy", "threshold");
+  expect_error("legacy", client_write(gattdb_OPEN_TIME, data, 2),
+               (uint8_t)SL_STATUS_BT_ATT_INVALID_ATT_LENGTH);
+  data[0] = 0;
+  expect_error("legacy", client_write(gattdb_BASELINE, data, 1),
+               (uint8_t)SL_STATUS_BT_ATT_OUT_OF_RANGE);
+  if (client_read(gattdb_MOVING_THRESHOLD, &byte, 1, &att_error) != 1 || byte != 15)
+    fail("legacy", "read back");
+
+  /* Reset writes a pending change first */
+  resets = 0;
+  data[0] = 30;
+  expect_error("legacy", client_write(gattdb_BASELINE, data, 1), ATT_ERROR_OK);
+  if (!gate_config_pending())
+    fail("legacy", "written before the quiet period");
+  (void)deliver_write(sl_bt_gatt_write_request, gattdb_RESET, 0, data, 1);
+  if (resets != 1 || gate_config_pending())
+    fail("legacy", "reset without flush");
+  printf("PASS legacy\n");
+}
+
+/* A field sweep of the moving threshold, one value per second */
+static void test_sweep(void)
+{
+  uint8_t buf[8];
+  uint16_t len;
+  uint32_t writes;
+  uint32_t next;
+  const unsigned int steps = 20;
+
+  fresh();
+  mtu = 23;
+  round_trips = 0;
+  writes = flash_writes();
+  for (unsigned int i = 0; i < steps; i++)
+  {
+    len = put(buf, 0, GATE_CONFIG_TAG_MOVING_THRESHOLD_MM, 4, 600 + 50 * i);
+    expect_error("sweep", client_write(gattdb_GATE_CONFIG, buf, len), ATT_ERROR_OK);
+    if (gate_config_get()->moving_threshold_mm != 600 + 50 * i)
+      fail("sweep", "value not applied at once");
+    alg_host_advance_to(alg_host_now_ms() + 1000);
+    gate_config_process();
+  }
+  while (alg_host_next_timer(&next))
+  {
+    alg_host_advance_to(next);
+    gate_config_process();
+  }
+  if (flash_writes() - writes != 1)
+    fail("sweep", "one flash write expected");
+  printf("PASS sweep: %u values in %u ATT round trips, %lu flash write\n",
+         steps, round_trips, (unsigned long)(flash_writes() - writes));
+}
+
+static uint32_t get_u32(const uint8_t *buf, uint16_t pos)
+{
+  return (uint32_t)buf[pos] | ((uint32_t)buf[pos + 1] << 8)
+         | ((uint32_t)buf[pos + 2] << 16) | ((uint32_t)buf[pos + 3] << 24);
+}
+
+/* One procedure through every stage */
+static void latency_procedure(cs_initiator_latency_t *latency)
+{
+  for (int s = 0; s < CS_INITIATOR_LATENCY_STAGE_COUNT; s++)
+    cs_initiator_latency_record(latency, (cs_initiator_latency_stage_t)s);
+}
+
+/* Compare a readout with the histograms of cs_initiator_latency.c */
+static void check_latency(const uint8_t *buf, uint16_t len)
+{
+  cs_initiator_latency_histogram_t h;
+  uint16_t pos = LATENCY_HEADER_SIZE;
+
+  if (len != LATENCY_READOUT_SIZE)
+    fail("latency", "length");
+  if (buf[0] != 1 || buf[1] != CS_INITIATOR_LATENCY_STAGE_COUNT
+      || buf[2] != CS_INITIATOR_LATENCY_BUCKET_COUNT)
+    fail("latency", "header");
+  if (get_u32(buf, 4) != cs_initiator_latency_get_incomplete())
+    fail("latency", "incomplete count");
+  for (uint8_t b = 0; b < CS_INITIATOR_LATENCY_BUCKET_COUNT - 1; b++)
+    if (get_u32(buf, 8 + 4 * b) != cs_initiator_latency_bucket_limit_us(b))
+      fail("latency", "bucket limit");
+
+  for (int s = 0; s < CS_INITIATOR_LATENCY_STAGE_COUNT; s++)
+  {
+    (void)cs_initiator_latency_get((cs_initiator_latency_stage_t)s, &h);
+    if (get_u32(buf, pos) != h.count
+        || (h.count != 0 && (get_u32(buf, pos + 4) != h.min_us
+                             || get_u32(buf, pos + 8) != h.max_us
+                             || get_u32(buf, pos + 12) != (uint32_t)(h.sum_us / h.count)))
+        || (h.count == 0 && (get_u32(buf, pos + 4) != 0 || get_u32(buf, pos + 8) != 0)))
+      fail("latency", "stage");
+    for (uint8_t b = 0; b < CS_INITIATOR_LATENCY_BUCKET_COUNT; b++)
+    {
+      uint32_t n = (uint32_t)buf[pos + 16 + 2 * b] | ((uint32_t)buf[pos + 17 + 2 * b] << 8);
+
+      if (n != ((h.bucket[b] > 0xffffu) ? 0xffffu : h.bucket[b]))
+        fail("latency", "bucket");
+    }
+    pos += LATENCY_STAGE_SIZE;
+  }
+}
+
+static void test_latency(void)
+{
+  cs_initiator_latency_t latency;
+  cs_initiator_latency_histogram_t h;
+  uint8_t buf[512];
+  uint8_t first[256];
+  uint8_t att_error;
+  uint16_t len;
+  unsigned int trips[2];
+  const uint16_t mtus[] = { 23, 247 };
+
+  /* Empty histograms */
+  cs_initiator_latency_init();
+  cs_initiator_latency_reset(&latency);
+  mtu = 23;
+  len = client_read(gattdb_LATENCY_HISTOGRAM, buf, sizeof(buf), &att_error);
+  expect_error("latency", att_error, ATT_ERROR_OK);
+  check_latency(buf, len);
+
+  /* A busy bucket saturates, an abandoned procedure counts as incomplete */
+  for (unsigned int i = 0; i < 70000; i++)
+    latency_procedure(&latency);
+  cs_initiator_latency_record(&latency, CS_INITIATOR_LATENCY_PROCEDURE_ENABLE);
+  cs_initiator_latency_record(&latency, CS_INITIATOR_LATENCY_FIRST_CS_RESULT);
+  latency_procedure(&latency);
+  for (size_t i = 0; i < sizeof(mtus) / sizeof(mtus[0]); i++)
+  {
+    mtu = mtus[i];
+    round_trips = 0;
+    len = client_read(gattdb_LATENCY_HISTOGRAM, buf, sizeof(buf), &att_error);
+    expect_error("latency", att_error, ATT_ERROR_OK);
+    check_latency(buf, len);
+    trips[i] = round_trips;
+  }
+  if (cs_initiator_latency_get_incomplete() != 1)
+    fail("latency", "no incomplete procedure");
+
+  /* Procedures delivered between the Read Blobs do not change the readout */
+  mtu = 23;
+  {
+    sl_bt_evt_gatt_server_user_read_request_t request = {
+      .connection = CONN,
+      .characteristic = gattdb_LATENCY_HISTOGRAM,
+      .att_opcode = sl_bt_gatt_read_request,
+      .offset = 0
+    };
+
+    read_characteristic(&request);
+    expect_error("latency", response.att_error, ATT_ERROR_OK);
+    memcpy(first, response.data, response.len);
+    latency_procedure(&latency);
+    (void)cs_initiator_latency_get(CS_INITIATOR_LATENCY_RESULT_DELIVERY, &h);
+
+    /* Read Blobs of the same long read, the last one past the end */
+    len = response.len;
+    memcpy(buf, first, len);
+    request.att_opcode = sl_bt_gatt_read_blob_request;
+    while (len < LATENCY_READOUT_SIZE)
+    {
+      request.offset = len;
+      read_characteristic(&request);
+      expect_error("latency", response.att_error, ATT_ERROR_OK);
+      memcpy(&buf[len], response.data, response.len);
+      len += response.len;
+    }
+    if (get_u32(buf, LATENCY_HEADER_SIZE + CS_INITIATOR_LATENCY_RESULT_DELIVERY * LATENCY_STAGE_SIZE)
+        != h.count - 1)
+      fail("latency", "torn long read");
+    request.offset = LATENCY_READOUT_SIZE + 1;
+    read_characteristic(&request);
+    expect_error("latency", response.att_error, (uint8_t)SL_STATUS_BT_ATT_INVALID_OFFSET);
+  }
+
+  /* The next read sees them */
+  len = client_read(gattdb_LATENCY_HISTOGRAM, buf, sizeof(buf), &att_error);
+  expect_error("latency", att_error, ATT_ERROR_OK);
+  check_latency(buf, len);
+  printf("PASS latency: %u bytes in %u ATT round trips at MTU 23, %u at MTU 247\n",
+         (unsigned int)LATENCY_READOUT_SIZE, trips[0], trips[1]);
+}
+
+int main(void)
+{
+  test_read();
+  test_commission(23);
+  test_commission(247);
+  test_atomic();
+  test_long_write();
+  test_legacy();
+  test_sweep();
+  test_latency();
+  return 0;
+}
@@ -0,0 +1,223 @@
+/*
+ * power_policy_sim.c
+ *
+ * Simulates days of gate traffic with power_policy.c and reports the share
+ * of time in each power level, the average current of the current model
+ * and the battery life, with and without the power policy. Without it the
+ * tree behaves as before: connected reflectors keep the active intervals,
+ * only proc_sched.c slows the procedures, and the heartbeat stays at 10 s.
+ *
+ * Build (from the project root):
+ *   SDK=simplicity_sdk_2025.6.2
+ *   gcc -O2 -I. -Iconfig -Iautogen -I$SDK/platform/common/inc \
+ *     -I$SDK/protocol/bluetooth/inc -I$SDK/util/silicon_labs/rtl/inc \
+ *     power_policy.c host/power_policy_sim.c -o power_policy_sim
+ *
+ * Options:
+ *   -n <reflectors> reflectors bound to the gate, 1..CS_INITIATOR_MAX_CONNECTIONS (1)
+ *   -p <passes>     passes through the gate per reflector and day (8)
+ *   -w <s>          time a pass is measured at the fast rate (60)
+ *   -g <s>          time the gate is busy during a pass (20)
+ *   -a <hours>      time per day a reflector is away, not connected (10)
+ *   -c <units>      connection interval in 1.25 ms (8)
+ *   -i <events>     fast procedure interval in connection events (26)
+ *   -b <mAh>        battery capacity (2600)
+ *   -d <days>       simulated days (7)
+ *   -s <seed>       random seed (1)
+ *
+ * A reflector is away for one block a day and parked near the gate
+ * otherwise. Passes start at random times while it is parked; the
+ * departure and the return are passes too. The simulation runs in 1 s
+ * steps, the model has no sub-second dynamics.
+ *
+ * Output, one line per policy:
+ *   <policy>,<active_%>,<idle_%>,<dormant_%>,<mean_uA>,<battery_days>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <getopt.h>
+#include "ble_peer_manager_central_config.h"
+#include "proc_sched.h"
+#include "power_policy.h"
+
+#define DAY_S  86400u
+
+typedef struct
+{
+  uint32_t away_start_s;    /* Start of the daily away block */
+  uint32_t pass_end_s;      /* End of the current pass, 0 if none */
+  uint32_t still_since_s;   /* Last motion, for the slow rate */
+} reflector_t;
+
+static reflector_t reflectors[CS_INITIATOR_MAX_CONNECTIONS];
+static unsigned int count = 1;
+static double passes = 8.0;
+static uint32_t pass_s = 60;
+static uint32_t busy_s = 20;
+static uint32_t away_s = 10 * 3600;
+
+static double uniform(void)
+{
+  return (double)rand() / ((double)RAND_MAX + 1.0);
+}
+
+static bool is_away(const reflector_t *r, uint32_t time_s)
+{
+  uint32_t t = (time_s + DAY_S - r->away_start_s) % DAY_S;
+
+  return t < away_s;
+}
+
+/* Advance a reflector by one second, returns false while it is away */
+static bool step(reflector_t *r, uint32_t time_s, bool *fast, bool *busy)
+{
+  bool away = is_away(r, time_s);
+  bool edge = away != is_away(r, time_s - 1u);
+
+  *fast = false;
+  *busy = false;
+  if (r->pass_end_s == 0 && (edge || (!away && uniform() < passes / (DAY_S - away_s))))
+    r->pass_end_s = time_s + pass_s;
+  if (r->pass_end_s != 0)
+  {
+    if (time_s >= r->pass_end_s)
+    {
+      r->pass_end_s = 0;
+      r->still_since_s = time_s;
+    }
+    else
+    {
+      /* Connected for the whole pass, the gate moves in its middle */
+      *fast = true;
+      *busy = (r->pass_end_s - time_s) <= (pass_s + busy_s) / 2
+              && (r->pass_end_s - time_s) > (pass_s - busy_s) / 2;
+      return true;
+    }
+  }
+  if (away)
+    return false;
+  *fast = (time_s - r->still_since_s) < PROC_SCHED_STILL_TIMEOUT_MS / 1000u;
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  static const char *policy_names[] = { "fixed", "power_policy" };
+  uint16_t conn_interval = 8;
+  uint16_t fast_interval = 26;
+  double battery_mah = 2600.0;
+  unsigned int days = 7;
+  unsigned int seed = 1;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:p:w:g:a:c:i:b:d:s:")) != -1) {
+    switch (opt) {
+      case 'n':
+        count = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      case 'p':
+        passes = strtod(optarg, NULL);
+        break;
+      case 'w':
+        pass_s = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'g':
+        busy_s = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'a':
+        away_s = (uint32_t)(strtod(optarg, NULL) * 3600.0);
+        break;
+      case 'c':
+        conn_interval = (uint16_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'i':
+        fast_interval = (uint16_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'b':
+        battery_mah = strtod(optarg, NULL);
+        break;
+      case 'd':
+        days = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      case 's':
+        seed = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-n refl] [-p passes] [-w s] [-g s] [-a hours] "
+                        "[-c units] [-i events] [-b mAh] [-d days] [-s seed]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (count == 0 || count > CS_INITIATOR_MAX_CONNECTIONS || days == 0
+      || pass_s == 0 || busy_s > pass_s || away_s >= DAY_S
+      || conn_interval == 0 || fast_interval == 0 || battery_mah <= 0.0) {
+    fprintf(stderr, "invalid parameters\n");
+    return 1;
+  }
+
+  printf("# policy,active_%%,idle_%%,dormant_%%,mean_uA,battery_days\n");
+  for (int policy = 0; policy < 2; policy++) {
+    uint32_t level_s[POWER_LEVEL_COUNT] = { 0 };
+    double charge_uc = 0.0;
+    uint32_t end_s = days * DAY_S;
+
+    srand(seed);
+    for (unsigned int r = 0; r < count; r++) {
+      reflectors[r].away_start_s = (uint32_t)(uniform() * DAY_S);
+      reflectors[r].pass_end_s = 0;
+      reflectors[r].still_since_s = 0;
+    }
+    power_policy_init(0);
+
+    for (uint32_t t = 1; t <= end_s; t++) {
+      power_policy_input_t input = { .gate_idle = true };
+      power_plan_t plan;
+      power_level_t level;
+
+      for (unsigned int r = 0; r < count; r++) {
+        bool fast;
+        bool busy;
+
+        if (step(&reflectors[r], t, &fast, &busy)) {
+          input.reflectors++;
+          input.fast_reflectors += fast;
+        }
+        input.gate_idle &= !busy;
+      }
+      if (policy == 0)
+        level = (input.reflectors == 0) ? POWER_LEVEL_DORMANT : POWER_LEVEL_ACTIVE;
+      else
+        level = power_policy_update(&input, t * 1000u);
+      level_s[level]++;
+
+      plan.reflectors = input.reflectors;
+      plan.fast_reflectors = input.fast_reflectors;
+      plan.connection_interval = conn_interval
+                                 * (policy ? power_policy_connection_factor(level) : 1u);
+      plan.fast_procedure_interval = fast_interval;
+      plan.slow_procedure_interval = fast_interval * PROC_SCHED_SLOW_FACTOR
+                                     * (policy ? power_policy_procedure_factor(level) : 1u);
+      plan.heartbeat_ms = policy ? power_policy_heartbeat_ms(level) : POWER_ACTIVE_HEARTBEAT_MS;
+      /* As in app.c, the scanner runs until every connection slot is used */
+      plan.scan_duty = (input.reflectors < CS_INITIATOR_MAX_CONNECTIONS)
+                       ? ((float)BLE_PEER_MANAGER_CENTRAL_CONFIG_DEFAULT_SCAN_WINDOW
+                          / (float)BLE_PEER_MANAGER_CENTRAL_CONFIG_DEFAULT_SCAN_INTERVAL)
+                       : 0.f;
+      plan.cpu_fraction = -1.f;
+      charge_uc += power_policy_estimate_ua(&plan);
+    }
+
+    double mean_ua = charge_uc / end_s;
+    printf("%s,%.1f,%.1f,%.1f,%.0f,%.1f\n",
+           policy_names[policy],
+           100.0 * level_s[POWER_LEVEL_ACTIVE] / end_s,
+           100.0 * level_s[POWER_LEVEL_IDLE] / end_s,
+           100.0 * level_s[POWER_LEVEL_DORMANT] / end_s,
+           mean_ua,
+           battery_mah * 1000.0 / mean_ua / 24.0);
+  }
+  return 0;
+}
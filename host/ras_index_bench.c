@@ -0,0 +1,311 @@
+/*
+ * ras_index_bench.c
+ *
+ * Times the parsing of a RAS ranging data body on the host, with the
+ * functions of cs_ras_format_converter.c:
+ *   walk     the subevent walk ranging_data_is_complete() did before the
+ *            step index, cs_ras_format_get_next_subevent_header() per
+ *            subevent
+ *   index    cs_ras_format_build_step_index() over the whole body
+ *   segments cs_ras_format_advance_step_index() once per RAS segment as the
+ *            body arrives, what ranging_data_segment_arrived() does now
+ * The body fills CS_INITIATOR_MAX_RANGING_DATA_SIZE with mode 2 steps after
+ * three mode 0 steps per subevent. Checks that the walk and the index agree
+ * on the completeness and that the index counts every step, then prints the
+ * time per body. Exits with 1 on the first failed check.
+ *
+ * Build (from the project root):
+ *   SDK=simplicity_sdk_2025.6.2
+ *   C=$SDK/app/bluetooth/common
+ *   gcc -O2 -Ihost/shim -I. -Iconfig -Iautogen \
+ *     -I$SDK/platform/common/inc -I$SDK/protocol/bluetooth/inc \
+ *     -I$SDK/util/silicon_labs/rtl/inc -I$C/cs_ras/common/inc \
+ *     $C/cs_ras/common/src/cs_ras_format_converter.c \
+ *     host/ras_index_bench.c -o ras_index_bench
+ *
+ * Options:
+ *   -a <paths>       antenna paths, 1..4 (4)
+ *   -s <subevents>   subevents per body, 1..CS_RAS_STEP_INDEX_MAX_SUBEVENTS (1)
+ *   -i               initiator step sizes instead of reflector ones
+ *   -m <mtu>         ATT MTU of the segments (247)
+ *   -r <repeat>      bodies parsed per variant (200000)
+ *
+ * Output:
+ *   body <bytes> bytes, <subevents> subevents, <steps> steps
+ *   # variant,ns_per_body,ns_per_step
+ *   walk,<ns>,<ns>
+ *   index,<ns>,<ns>
+ *   segments,<ns>,<ns>
+ *   index size <bytes>
+ * Times are those of the host build and only comparable between runs on
+ * the same host.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+#include "sl_bt_api.h"
+#include "cs_initiator_config.h"
+#include "cs_ras_common.h"
+#include "cs_ras_format_converter.h"
+
+#define CALIBRATION_STEPS 3
+#define MODE_0_SIZE(i)    ((i) ? 5 : 3)
+#define MODE_2_SIZE(a)    (1 + ((a) + 1) * 4)
+
+static uint8_t body[CS_INITIATOR_MAX_RANGING_DATA_SIZE];
+static size_t body_size;
+static unsigned int body_steps;
+static uint8_t paths = 4;
+static bool is_initiator;
+static size_t segment_size;
+
+/* Defeats the optimizer across the timed loops */
+static volatile uint32_t sink;
+
+static void fail(const char *test, const char *what)
+{
+  printf("FAIL %s: %s\n", test, what);
+  exit(1);
+}
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Largest body of the given subevent count that fits the buffer */
+static bool build_body(unsigned int subevents)
+{
+  cs_ras_ranging_header_t *header = (cs_ras_ranging_header_t *)body;
+  size_t mode_0 = 1 + MODE_0_SIZE(is_initiator);
+  size_t mode_2 = 1 + MODE_2_SIZE(paths);
+  size_t per_subevent = (sizeof(body) - sizeof(*header)) / subevents;
+
+  if (per_subevent < sizeof(cs_ras_subevent_header_t) + CALIBRATION_STEPS * mode_0) {
+    return false;
+  }
+  memset(body, 0, sizeof(body));
+  header->antenna_paths_mask = (uint8_t)((1u << paths) - 1u);
+  body_size = sizeof(*header);
+  body_steps = 0;
+  for (unsigned int s = 0; s < subevents; s++) {
+    cs_ras_subevent_header_t *subevent = (cs_ras_subevent_header_t *)&body[body_size];
+    size_t pbr = (per_subevent - sizeof(*subevent) - CALIBRATION_STEPS * mode_0) / mode_2;
+    unsigned int steps;
+
+    if (pbr > UINT8_MAX - CALIBRATION_STEPS) {
+      pbr = UINT8_MAX - CALIBRATION_STEPS;
+    }
+    steps = CALIBRATION_STEPS + (unsigned int)pbr;
+    subevent->ranging_done_status = (s + 1 == subevents)
+                                    ? sl_bt_cs_done_status_complete
+                                    : sl_bt_cs_done_status_partial_results_continue;
+    subevent->subevent_done_status = sl_bt_cs_done_status_complete;
+    subevent->number_of_steps_reported = (uint8_t)steps;
+    body_size += sizeof(*subevent);
+    for (unsigned int i = 0; i < steps; i++) {
+      size_t size = (i < CALIBRATION_STEPS) ? mode_0 : mode_2;
+
+      body[body_size] = (i < CALIBRATION_STEPS) ? 0 : 2;
+      for (size_t b = 1; b < size; b++) {
+        body[body_size + b] = (uint8_t)rand();
+      }
+      body_size += size;
+    }
+    body_steps += steps;
+  }
+  return true;
+}
+
+/* ---- Variants ---- */
+
+/* ranging_data_is_complete() before the step index, true when complete */
+static bool walk(uint8_t *data, uint32_t size)
+{
+  uint8_t *data_end = data + size;
+  cs_ras_subevent_header_t *subevent_header = NULL;
+  bool aborted = false;
+  bool completed = false;
+  sl_status_t sc = SL_STATUS_OK;
+  sc = cs_ras_format_get_first_subevent_header(data, data_end, &subevent_header);
+
+  while (sc == SL_STATUS_OK) {
+    // Check for subevent and procedure aborts
+    aborted |= (subevent_header->ranging_done_status == sl_bt_cs_done_status_aborted);
+    aborted |= (subevent_header->subevent_done_status == sl_bt_cs_done_status_aborted);
+    // Check for completed state
+    completed |= (subevent_header->ranging_done_status == sl_bt_cs_done_status_complete);
+    if (aborted || completed) {
+      break;
+    }
+    sc = cs_ras_format_get_next_subevent_header(subevent_header,
+                                                data_end,
+                                                is_initiator,
+                                                paths,
+                                                &subevent_header);
+  }
+
+  return !aborted && completed;
+}
+
+/* Completeness from the subevent table, as ranging_data_is_complete() now */
+static bool index_state(const cs_ras_step_index_t *index)
+{
+  for (uint8_t i = 0; i < index->num_subevents; i++) {
+    const cs_ras_subevent_index_t *subevent = &index->subevent[i];
+
+    if ((subevent->ranging_done_status == sl_bt_cs_done_status_aborted)
+        || (subevent->subevent_done_status == sl_bt_cs_done_status_aborted)) {
+      return false;
+    }
+    if (subevent->ranging_done_status == sl_bt_cs_done_status_complete) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool build_index(cs_ras_step_index_t *index)
+{
+  (void)cs_ras_format_build_step_index(body, body + body_size, is_initiator, paths, index);
+  return index_state(index);
+}
+
+static bool segments(cs_ras_step_index_t *index)
+{
+  (void)cs_ras_format_init_step_index(index, is_initiator, paths);
+  for (size_t end = segment_size; ; end += segment_size) {
+    if (end >= body_size) {
+      (void)cs_ras_format_advance_step_index(body, body + body_size, index);
+      break;
+    }
+    (void)cs_ras_format_advance_step_index(body, body + end, index);
+  }
+  return index_state(index);
+}
+
+/* ---- Checks ---- */
+
+static void test_agree(void)
+{
+  static cs_ras_step_index_t index;
+  sl_status_t sc;
+
+  if (!walk(body, (uint32_t)body_size)) {
+    fail("agree", "walk not complete");
+  }
+  sc = cs_ras_format_build_step_index(body, body + body_size, is_initiator, paths, &index);
+  if (sc != SL_STATUS_OK || !index_state(&index)
+      || index.num_steps != body_steps || !index.complete) {
+    fail("agree", "index not complete");
+  }
+  if (!segments(&index) || index.num_steps != body_steps) {
+    fail("agree", "segment index not complete");
+  }
+  // The walk only reads the subevent headers, the index also the steps
+  sc = cs_ras_format_build_step_index(body, body + body_size - 1, is_initiator, paths, &index);
+  if (sc != SL_STATUS_WOULD_OVERFLOW || index.num_steps != body_steps - 1) {
+    fail("agree", "index of a cut body");
+  }
+  printf("PASS agree\n");
+}
+
+/* ---- Timing ---- */
+
+typedef enum {
+  VARIANT_WALK,
+  VARIANT_INDEX,
+  VARIANT_SEGMENTS,
+  VARIANT_COUNT
+} variant_t;
+
+static const char *variant_names[VARIANT_COUNT] = {
+  "walk", "index", "segments"
+};
+
+static double time_variant(variant_t variant, unsigned long repeat)
+{
+  static cs_ras_step_index_t index;
+  uint64_t start = now_ns();
+
+  for (unsigned long r = 0; r < repeat; r++) {
+    switch (variant) {
+      case VARIANT_WALK:
+        sink += walk(body, (uint32_t)body_size);
+        break;
+      case VARIANT_INDEX:
+        sink += build_index(&index);
+        break;
+      default:
+        sink += segments(&index);
+        break;
+    }
+  }
+  return (double)(now_ns() - start) / (double)repeat;
+}
+
+int main(int argc, char **argv)
+{
+  unsigned long subevents = 1;
+  unsigned long mtu = 247;
+  unsigned long repeat = 200000;
+  unsigned long value;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "a:s:im:r:")) != -1) {
+    switch (opt) {
+      case 'a':
+        value = strtoul(optarg, NULL, 0);
+        paths = (value >= 1 && value <= 4) ? (uint8_t)value : 0;
+        break;
+      case 's':
+        subevents = strtoul(optarg, NULL, 0);
+        break;
+      case 'i':
+        is_initiator = true;
+        break;
+      case 'm':
+        mtu = strtoul(optarg, NULL, 0);
+        break;
+      case 'r':
+        repeat = strtoul(optarg, NULL, 0);
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-a paths] [-s subevents] [-i] [-m mtu] [-r repeat]\n",
+                argv[0]);
+        return 1;
+    }
+  }
+  if (paths == 0 || subevents == 0 || subevents > CS_RAS_STEP_INDEX_MAX_SUBEVENTS
+      || mtu < ATT_MTU_MIN || mtu > ATT_MTU_MAX || repeat == 0) {
+    fprintf(stderr, "invalid parameters\n");
+    return 1;
+  }
+  segment_size = CS_RAS_SEGMENT_DATA_SIZE(mtu);
+  srand(1);
+  if (!build_body((unsigned int)subevents)) {
+    fprintf(stderr, "%lu subevents do not fit\n", subevents);
+    return 1;
+  }
+
+  test_agree();
+
+  printf("body %zu bytes, %lu subevents, %u steps\n", body_size, subevents, body_steps);
+  printf("# variant,ns_per_body,ns_per_step\n");
+  for (variant_t v = VARIANT_WALK; v < VARIANT_COUNT; v++) {
+    double ns;
+
+    // Warm up first
+    (void)time_variant(v, repeat / 10 + 1);
+    ns = time_variant(v, repeat);
+    printf("%s,%.1f,%.2f\n", variant_names[v], ns, ns / body_steps);
+  }
+  printf("index size %zu\n", sizeof(cs_ras_step_index_t));
+  return 0;
+}
@@ -0,0 +1,256 @@
+/*
+ * ras_mode_sim.c
+ *
+ * Simulates the ranging data transfers of a connection whose link quality
+ * changes over time, with the RAS mode fixed to real-time, fixed to
+ * on-demand and selected by cs_initiator_ras_policy.c, and reports the
+ * delivered procedures and the transfer latency of each.
+ *
+ * Build (from the project root):
+ *   SDK=simplicity_sdk_2025.6.2
+ *   gcc -O2 -DCS_INITIATOR_RAS_MODE_AUTO=1 -Ihost/shim -I. -Iconfig -Iautogen \
+ *     -I$SDK/platform/common/inc -I$SDK/protocol/bluetooth/inc \
+ *     -I$SDK/util/silicon_labs/rtl/inc \
+ *     -I$SDK/app/bluetooth/common/cs_initiator/inc \
+ *     $SDK/app/bluetooth/common/cs_initiator/src/cs_initiator_ras_policy.c \
+ *     $SDK/app/bluetooth/common/cs_initiator/src/cs_initiator_recovery.c \
+ *     host/ras_mode_sim.c -o ras_mode_sim
+ *
+ * Options:
+ *   -n <segments>   segments per procedure, 1..64 (16)
+ *   -k <segments>   segments sent per connection event (4)
+ *   -c <ms>         connection interval (7.5)
+ *   -g <prob>       loss burst start probability on a good link (0.002)
+ *   -w <prob>       loss burst start probability on a bad link (0.05)
+ *   -b <segments>   mean loss burst length (1.5)
+ *   -l <procedures> procedures per link phase, good and bad alternate (500)
+ *   -r <procedures> simulated procedures (100000)
+ *   -s <seed>       random seed (1)
+ *   -t <file>       recorded segment losses instead of the loss model
+ *
+ * Trace format: one character per transmitted segment, '1' lost and '0'
+ * received, other characters are skipped and '#' comments out the rest of
+ * the line. The trace is replayed from its start for each mode and wraps
+ * around when shorter than the simulation.
+ *
+ * Real-time data with a lost segment is dropped. On-demand data costs one
+ * connection event for the data ready notification, one for the GET and one
+ * for the completion, lost segments are retrieved in merged ranges. The
+ * automatic mode changes at the procedure boundary after the policy decided.
+ *
+ * Output, one line per mode:
+ *   <mode>,<delivered_%>,<mean_latency_ms>,<switches>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <getopt.h>
+#include "cs_initiator_ras_policy.h"
+#include "cs_initiator_recovery.h"
+
+typedef enum {
+  MODE_REAL_TIME,
+  MODE_ON_DEMAND,
+  MODE_AUTO
+} sim_mode_t;
+
+static const char *mode_names[] = { "real-time", "on-demand", "auto" };
+
+static unsigned int segments = 16;
+static unsigned int per_event = 4;
+static double interval_ms = 7.5;
+static double burst_start;
+static double burst_length = 1.5;
+static bool in_burst;
+static char *trace;
+static size_t trace_length;
+static size_t trace_pos;
+
+static double uniform(void)
+{
+  return (double)rand() / ((double)RAND_MAX + 1.0);
+}
+
+/* Two-state loss model, bursts have a geometric length */
+static bool segment_lost(void)
+{
+  if (trace_length != 0) {
+    bool lost = trace[trace_pos] == '1';
+    trace_pos = (trace_pos + 1) % trace_length;
+    return lost;
+  }
+  if (in_burst) {
+    in_burst = uniform() < (1.0 - 1.0 / burst_length);
+  } else {
+    in_burst = uniform() < burst_start;
+  }
+  return in_burst;
+}
+
+static uint64_t transfer(uint8_t start, uint8_t end)
+{
+  uint64_t lost = 0;
+
+  for (uint8_t i = start; i <= end; i++) {
+    if (segment_lost()) {
+      lost |= 1ULL << i;
+    }
+  }
+  return lost;
+}
+
+static bool load_trace(const char *path)
+{
+  FILE *file = fopen(path, "r");
+  size_t size = 0;
+  bool comment = false;
+  int c;
+
+  if (file == NULL) {
+    return false;
+  }
+  while ((c = fgetc(file)) != EOF) {
+    if (c == '#') {
+      comment = true;
+    } else if (c == '\n') {
+      comment = false;
+    } else if (!comment && (c == '0' || c == '1')) {
+      if (trace_length == size) {
+        size = size ? 2 * size : 4096;
+        trace = realloc(trace, size);
+        if (trace == NULL) {
+          fclose(file);
+          return false;
+        }
+      }
+      trace[trace_length++] = (char)c;
+    }
+  }
+  fclose(file);
+  return trace_length != 0;
+}
+
+static unsigned int events(unsigned int count)
+{
+  return (count + per_event - 1) / per_event;
+}
+
+/* One procedure, returns false if it was dropped */
+static bool procedure(bool real_time, cs_initiator_ras_sample_t *sample)
+{
+  cs_initiator_segment_range_t range;
+  unsigned int used = events(segments);
+  uint64_t pending = transfer(0, (uint8_t)(segments - 1));
+
+  sample->lost = (pending != 0);
+  sample->dropped = false;
+  if (real_time) {
+    sample->dropped = sample->lost;
+  } else {
+    used += 3;
+    while (!sample->dropped
+           && cs_initiator_recovery_next_range(pending,
+                                               CS_INITIATOR_RAS_LOST_SEGMENT_MERGE_GAP,
+                                               &range)) {
+      unsigned int length = range.end_segment - range.start_segment + 1u;
+
+      pending &= ~cs_initiator_recovery_range_mask(&range);
+      used += 2 + events(length);
+      sample->dropped = transfer(range.start_segment, range.end_segment) != 0;
+    }
+  }
+  sample->latency_ms = (uint32_t)(interval_ms * used);
+  return !sample->dropped;
+}
+
+int main(int argc, char **argv)
+{
+  double good_start = 0.002;
+  double bad_start = 0.05;
+  unsigned long phase = 500;
+  unsigned long runs = 100000;
+  unsigned int seed = 1;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:k:c:g:w:b:l:r:s:t:")) != -1) {
+    switch (opt) {
+      case 'n':
+        segments = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      case 'k':
+        per_event = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      case 'c':
+        interval_ms = strtod(optarg, NULL);
+        break;
+      case 'g':
+        good_start = strtod(optarg, NULL);
+        break;
+      case 'w':
+        bad_start = strtod(optarg, NULL);
+        break;
+      case 'b':
+        burst_length = strtod(optarg, NULL);
+        break;
+      case 'l':
+        phase = strtoul(optarg, NULL, 0);
+        break;
+      case 'r':
+        runs = strtoul(optarg, NULL, 0);
+        break;
+      case 's':
+        seed = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      case 't':
+        if (!load_trace(optarg)) {
+          fprintf(stderr, "cannot read trace %s\n", optarg);
+          return 1;
+        }
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-n segs] [-k segs] [-c ms] [-g prob] [-w prob] "
+                        "[-b len] [-l procs] [-r runs] [-s seed] [-t trace]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (segments == 0 || segments > 64 || per_event == 0 || burst_length < 1.0
+      || phase == 0 || runs == 0) {
+    fprintf(stderr, "invalid parameters\n");
+    return 1;
+  }
+
+  printf("# mode,delivered_%%,mean_latency_ms,switches\n");
+  for (sim_mode_t mode = MODE_REAL_TIME; mode <= MODE_AUTO; mode++) {
+    cs_initiator_ras_policy_t policy;
+    unsigned long delivered = 0;
+    unsigned long switches = 0;
+    double latency = 0.0;
+    bool real_time = (mode != MODE_ON_DEMAND);
+
+    srand(seed);
+    in_burst = false;
+    trace_pos = 0;
+    cs_initiator_ras_policy_init(&policy, real_time);
+    for (unsigned long run = 0; run < runs; run++) {
+      cs_initiator_ras_sample_t sample;
+
+      burst_start = ((run / phase) & 1) ? bad_start : good_start;
+      if (procedure(real_time, &sample)) {
+        delivered++;
+        latency += sample.latency_ms;
+      }
+      if (mode == MODE_AUTO && cs_initiator_ras_policy_update(&policy, &sample)) {
+        real_time = policy.real_time;
+        switches++;
+      }
+    }
+    printf("%s,%.1f,%.1f,%lu\n",
+           mode_names[mode],
+           100.0 * (double)delivered / (double)runs,
+           delivered ? latency / (double)delivered : 0.0,
+           switches);
+  }
+  return 0;
+}
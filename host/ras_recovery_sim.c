@@ -0,0 +1,170 @@
+/*
+ * ras_recovery_sim.c
+ *
+ * Simulates the on-demand transfer of one procedure's ranging data and the
+ * retrieval of its lost segments with cs_initiator_recovery.c, and reports
+ * the recovery time for a set of merge gaps. A gap of 63 is the single
+ * first-to-last range requested before the recovery planning.
+ *
+ * Build (from the project root):
+ *   SDK=simplicity_sdk_2025.6.2
+ *   gcc -O2 -I$SDK/app/bluetooth/common/cs_initiator/inc \
+ *     $SDK/app/bluetooth/common/cs_initiator/src/cs_initiator_recovery.c \
+ *     host/ras_recovery_sim.c -o ras_recovery_sim
+ *
+ * Options:
+ *   -n <segments>   segments per procedure, 1..64 (16)
+ *   -k <segments>   segments sent per connection event (4)
+ *   -c <ms>         connection interval (7.5)
+ *   -p <prob>       probability that a loss burst starts at a segment (0.05)
+ *   -b <segments>   mean loss burst length (1.5)
+ *   -m <hex mask>   fixed loss pattern of the first transfer, overrides -p/-b
+ *   -r <runs>       simulated procedures (100000)
+ *   -s <seed>       random seed (1)
+ *
+ * Losses hit retrieved segments too. A segment lost again makes the
+ * procedure unrecoverable, as on the target. A retrieval costs one
+ * connection event for the Control Point request, the events needed for
+ * its segments and one for the completion indication.
+ *
+ * Output, one line per merge gap, averaged over procedures with losses:
+ *   <gap>,<recovered_%>,<requests>,<resent_segments>,<recovery_ms>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <getopt.h>
+#include "cs_initiator_recovery.h"
+
+static const uint8_t gaps[] = { 0, 1, 2, 4, 8, 16, 63 };
+
+static double burst_start = 0.05;
+static double burst_length = 1.5;
+static bool in_burst;
+
+static double uniform(void)
+{
+  return (double)rand() / ((double)RAND_MAX + 1.0);
+}
+
+/* Two-state loss model, bursts have a geometric length */
+static bool segment_lost(void)
+{
+  if (in_burst) {
+    in_burst = uniform() < (1.0 - 1.0 / burst_length);
+  } else {
+    in_burst = uniform() < burst_start;
+  }
+  return in_burst;
+}
+
+static uint64_t transfer(uint8_t start, uint8_t end)
+{
+  uint64_t lost = 0;
+
+  for (uint8_t i = start; i <= end; i++) {
+    if (segment_lost()) {
+      lost |= 1ULL << i;
+    }
+  }
+  return lost;
+}
+
+int main(int argc, char **argv)
+{
+  unsigned int segments = 16;
+  unsigned int per_event = 4;
+  double interval_ms = 7.5;
+  unsigned long runs = 100000;
+  unsigned int seed = 1;
+  uint64_t fixed_mask = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:k:c:p:b:m:r:s:")) != -1) {
+    switch (opt) {
+      case 'n':
+        segments = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      case 'k':
+        per_event = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      case 'c':
+        interval_ms = strtod(optarg, NULL);
+        break;
+      case 'p':
+        burst_start = strtod(optarg, NULL);
+        break;
+      case 'b':
+        burst_length = strtod(optarg, NULL);
+        break;
+      case 'm':
+        fixed_mask = strtoull(optarg, NULL, 16);
+        break;
+      case 'r':
+        runs = strtoul(optarg, NULL, 0);
+        break;
+      case 's':
+        seed = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-n segs] [-k segs] [-c ms] [-p prob] "
+                        "[-b len] [-m mask] [-r runs] [-s seed]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (segments == 0 || segments > 64 || per_event == 0 || burst_length < 1.0) {
+    fprintf(stderr, "invalid parameters\n");
+    return 1;
+  }
+  if (segments < 64) {
+    fixed_mask &= (1ULL << segments) - 1;
+  }
+
+  printf("# gap,recovered_%%,requests,resent_segments,recovery_ms\n");
+  for (size_t g = 0; g < sizeof(gaps); g++) {
+    unsigned long lossy = 0;
+    unsigned long recovered = 0;
+    unsigned long requests = 0;
+    unsigned long resent = 0;
+    unsigned long events = 0;
+
+    srand(seed);
+    for (unsigned long run = 0; run < runs; run++) {
+      cs_initiator_segment_range_t range;
+      uint64_t pending;
+      bool failed = false;
+
+      in_burst = false;
+      pending = fixed_mask ? fixed_mask : transfer(0, (uint8_t)(segments - 1));
+      if (pending == 0) {
+        continue;
+      }
+      lossy++;
+      while (!failed && cs_initiator_recovery_next_range(pending, gaps[g], &range)) {
+        unsigned int length = range.end_segment - range.start_segment + 1u;
+
+        pending &= ~cs_initiator_recovery_range_mask(&range);
+        requests++;
+        resent += length;
+        events += 2 + (length + per_event - 1) / per_event;
+        failed = transfer(range.start_segment, range.end_segment) != 0;
+      }
+      if (!failed) {
+        recovered++;
+      }
+    }
+    if (lossy == 0) {
+      printf("%u,-,-,-,-\n", gaps[g]);
+      continue;
+    }
+    printf("%u,%.1f,%.2f,%.2f,%.1f\n",
+           gaps[g],
+           100.0 * (double)recovered / (double)lossy,
+           (double)requests / (double)lossy,
+           (double)resent / (double)lossy,
+           interval_ms * (double)events / (double)lossy);
+  }
+  return 0;
+}
@@ -0,0 +1,911 @@
+/*
+ * ras_segment_check.c
+ *
+ * Runs cs_initiator.c, its state machine and cs_initiator_extract.c on the
+ * host and streams the reflector ranging data of every procedure through
+ * cs_ras_client_on_ranging_data_segment() with lost, duplicated and
+ * reordered segments. The step index that ranging_data_segment_arrived()
+ * advances with cs_ras_format_advance_step_index() is checked against
+ * cs_ras_format_build_step_index() over the data stored so far:
+ *   after every segment  the index covers the data received without gaps
+ *                        and nothing past a missing segment, it matches
+ *                        the index built over that prefix
+ *   after the reception  the index matches the one built over the whole
+ *                        reassembled body, the procedure is estimated if
+ *                        and only if its last subevent is complete
+ * Lost segments are sent again after the others, in a random order. The
+ * bytes of the reflector buffer that no segment has written yet hold an
+ * invalid step mode, an index that reads them fails the check. The
+ * Bluetooth stack, the RAS client and the RTL library are stubbed. Exits
+ * with 1 on the first failed check.
+ *
+ * Build (from the project root):
+ *   SDK=simplicity_sdk_2025.6.2
+ *   C=$SDK/app/bluetooth/common
+ *   F="$C/cs_initiator/src/cs_initiator.c \
+ *     $C/cs_initiator/src/cs_initiator_state_machine.c \
+ *     $C/cs_initiator/src/cs_initiator_extract.c \
+ *     $C/cs_initiator/src/cs_initiator_buffer_pool.c \
+ *     $C/cs_initiator/src/cs_initiator_latency.c \
+ *     $C/cs_initiator/src/cs_initiator_error.c \
+ *     $C/cs_initiator/src/cs_initiator_client.c \
+ *     $C/cs_initiator/src/cs_initiator_ras_policy.c \
+ *     $C/cs_initiator/src/cs_initiator_recovery.c \
+ *     $C/cs_initiator/src/cs_initiator_capture.c \
+ *     $C/cs_ras/common/src/cs_ras_format_converter.c"
+ *   gcc -O2 -Ihost/shim -I. -Iconfig -Iautogen \
+ *     -I$SDK/platform/common/inc -I$SDK/protocol/bluetooth/inc \
+ *     -I$SDK/util/silicon_labs/rtl/inc \
+ *     -I$SDK/app/common/util/app_timer -I$SDK/app/common/util/app_timer/bm \
+ *     -I$C/cs_initiator/inc -I$C/cs_ras/common/inc -I$C/cs_ras/client/inc \
+ *     -I$C/cs_result/inc \
+ *     $F host/ras_segment_check.c -o ras_segment_check
+ * The component logs are compiled out, add -DHOST_APP_LOG to print them.
+ *
+ * Options:
+ *   -p <procedures>  procedures streamed (2000)
+ *   -s <seed>        random seed (1)
+ *   -l <percent>     segments lost and sent again at the end (5)
+ *   -u <percent>     segments sent twice (5)
+ *   -r <percent>     segments swapped with the next one (5)
+ *
+ * Output:
+ *   PASS step index
+ *   procedures <estimated> estimated, <aborted> aborted
+ *   segments <sent> sent, <lost> lost, <duplicated> duplicated,
+ *     <reordered> reordered
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "sl_bt_api.h"
+#include "sl_sleeptimer.h"
+#include "app_timer.h"
+#include "cs_initiator.h"
+#include "cs_initiator_client.h"
+#include "cs_initiator_common.h"
+#include "cs_initiator_estimate.h"
+#include "cs_ras_client.h"
+#include "cs_ras_common.h"
+#include "cs_ras_format_converter.h"
+
+/* Step data sizes, see cs_ras_format_converter.c */
+#define MODE_0_INITIATOR  5
+#define MODE_0_REFLECTOR  3
+#define MODE_1_SIZE       6
+#define MODE_2_SIZE(a)    (1 + ((a) + 1) * 4)
+#define CALIBRATION_STEPS 3
+#define PBR_STEPS         36
+#define PATHS             1
+
+#define RAS_HANDLE        0x30
+#define CONN_HANDLE       1
+#define INVALID_STEP_MODE 0x03
+
+#define MAX_SUBEVENTS     4
+#define MAX_SUBEVENT_STEPS 40
+#define MAX_SEGMENTS      (CS_INITIATOR_MAX_RANGING_DATA_SIZE / 19 + 1)
+#define MAX_SENDS         (3 * MAX_SEGMENTS)
+
+static const uint8_t conn_handle = CONN_HANDLE;
+static const uint16_t att_mtus[] = { 23, 65, 247 };
+
+static cs_initiator_t *instance;     /* From the procedure timer */
+static uint8_t *rx_buffer;           /* From the Real-Time receive */
+static uint16_t requested_interval;
+static uint16_t counter;
+static bool estimated_now;
+
+/* Reflector body of the procedure and its segments */
+static uint8_t body[CS_INITIATOR_MAX_RANGING_DATA_SIZE];
+static uint32_t body_size;
+static bool body_complete;
+static uint32_t segment_size;
+static unsigned int segment_count;
+static bool stored[MAX_SEGMENTS];
+static cs_ras_step_index_t last_index;  /* Index of the previous procedure */
+static uint8_t sends[MAX_SENDS];
+static unsigned int send_count;
+
+static unsigned int lost_percent = 5;
+static unsigned int duplicate_percent = 5;
+static unsigned int reorder_percent = 5;
+
+static unsigned long estimated;
+static unsigned long aborted;
+static unsigned long sent;
+static unsigned long lost;
+static unsigned long duplicated;
+static unsigned long reordered;
+static unsigned long procedure;
+
+static void fail(const char *test, const char *what)
+{
+  printf("FAIL %s: %s in procedure %lu\n", test, what, procedure);
+  exit(1);
+}
+
+static unsigned int percent(void)
+{
+  return (unsigned int)rand() % 100u;
+}
+
+/* ---- Stubs of the Bluetooth stack ---- */
+
+sl_status_t sl_bt_connection_get_security_status(uint8_t connection,
+                                                 uint8_t *security_mode,
+                                                 uint8_t *key_size,
+                                                 uint8_t *bonding_handle)
+{
+  (void)connection;
+  (void)key_size;
+  (void)bonding_handle;
+  *security_mode = sl_bt_connection_mode1_level2;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_connection_set_parameters(uint8_t connection,
+                                            uint16_t min_interval,
+                                            uint16_t max_interval,
+                                            uint16_t latency,
+                                            uint16_t timeout,
+                                            uint16_t min_ce_length,
+                                            uint16_t max_ce_length)
+{
+  (void)connection;
+  (void)min_interval;
+  (void)latency;
+  (void)timeout;
+  (void)min_ce_length;
+  (void)max_ce_length;
+  requested_interval = max_interval;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_connection_set_preferred_phy(uint8_t connection,
+                                               uint8_t preferred_phy,
+                                               uint8_t accepted_phy)
+{
+  (void)connection;
+  (void)preferred_phy;
+  (void)accepted_phy;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_sm_increase_security(uint8_t connection)
+{
+  (void)connection;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_gatt_discover_primary_services(uint8_t connection)
+{
+  (void)connection;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_gatt_discover_characteristics(uint8_t connection, uint32_t service)
+{
+  (void)connection;
+  (void)service;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_cs_set_default_settings(uint8_t connection,
+                                          uint8_t initiator_status,
+                                          uint8_t reflector_status,
+                                          uint8_t antenna_identifier,
+                                          int8_t max_tx_power)
+{
+  (void)connection;
+  (void)initiator_status;
+  (void)reflector_status;
+  (void)antenna_identifier;
+  (void)max_tx_power;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_cs_security_enable(uint8_t connection)
+{
+  (void)connection;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_cs_create_config(uint8_t connection,
+                                   uint8_t config_id,
+                                   uint8_t create_context,
+                                   uint8_t main_mode_type,
+                                   uint8_t sub_mode_type,
+                                   uint8_t min_main_mode_steps,
+                                   uint8_t max_main_mode_steps,
+                                   uint8_t main_mode_repetition,
+                                   uint8_t mode_calibration_steps,
+                                   uint8_t role,
+                                   uint8_t rtt_type,
+                                   uint8_t cs_sync_phy,
+                                   const sl_bt_cs_channel_map_t *channel_map,
+                                   uint8_t channel_map_repetition,
+                                   uint8_t channel_selection_type,
+                                   uint8_t ch3c_shape,
+                                   uint8_t ch3c_jump,
+                                   uint8_t reserved)
+{
+  (void)connection;
+  (void)config_id;
+  (void)create_context;
+  (void)main_mode_type;
+  (void)sub_mode_type;
+  (void)min_main_mode_steps;
+  (void)max_main_mode_steps;
+  (void)main_mode_repetition;
+  (void)mode_calibration_steps;
+  (void)role;
+  (void)rtt_type;
+  (void)cs_sync_phy;
+  (void)channel_map;
+  (void)channel_map_repetition;
+  (void)channel_selection_type;
+  (void)ch3c_shape;
+  (void)ch3c_jump;
+  (void)reserved;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_cs_remove_config(uint8_t connection, uint8_t config_id)
+{
+  (void)connection;
+  (void)config_id;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_cs_set_procedure_parameters(uint8_t connection,
+                                              uint8_t config_id,
+                                              uint16_t max_procedure_len,
+                                              uint16_t min_procedure_interval,
+                                              uint16_t max_procedure_interval,
+                                              uint16_t max_procedure_count,
+                                              uint32_t min_subevent_len,
+                                              uint32_t max_subevent_len,
+                                              uint8_t tone_antenna_config_selection,
+                                              uint8_t phy,
+                                              int8_t tx_pwr_delta,
+                                              uint8_t preferred_peer_antenna,
+                                              uint8_t snr_control_initiator,
+                                              uint8_t snr_control_reflector)
+{
+  (void)connection;
+  (void)config_id;
+  (void)max_procedure_len;
+  (void)min_procedure_interval;
+  (void)max_procedure_interval;
+  (void)max_procedure_count;
+  (void)min_subevent_len;
+  (void)max_subevent_len;
+  (void)tone_antenna_config_selection;
+  (void)phy;
+  (void)tx_pwr_delta;
+  (void)preferred_peer_antenna;
+  (void)snr_control_initiator;
+  (void)snr_control_reflector;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_cs_procedure_enable(uint8_t connection, uint8_t enable, uint8_t config_id)
+{
+  (void)connection;
+  (void)config_id;
+  (void)enable;
+  return SL_STATUS_OK;
+}
+
+
+/* ---- Stubs of the timers ---- */
+
+uint32_t sl_sleeptimer_get_tick_count(void)
+{
+  return 0;
+}
+
+uint32_t sl_sleeptimer_tick_to_ms(uint32_t tick)
+{
+  return tick;
+}
+
+sl_status_t app_timer_start(app_timer_t *timer,
+                            uint32_t timeout_ms,
+                            app_timer_callback_t callback,
+                            void *callback_data,
+                            bool is_periodic)
+{
+  cs_initiator_t *initiator = (cs_initiator_t *)callback_data;
+
+  // The procedure timer is the one place that shows the instance
+  if (timer == &initiator->timer_handle) {
+    instance = initiator;
+  }
+  (void)timeout_ms;
+  (void)callback;
+  (void)is_periodic;
+  return SL_STATUS_OK;
+}
+
+sl_status_t app_timer_stop(app_timer_t *timer)
+{
+  (void)timer;
+  return SL_STATUS_OK;
+}
+
+/* ---- Stubs of the RTL library and the estimation ---- */
+
+enum sl_rtl_error_code rtl_library_init(const uint8_t conn_handle,
+                                        sl_rtl_cs_libitem *handle,
+                                        rtl_config_t      *config,
+                                        uint8_t           *instance_id)
+{
+  (void)conn_handle;
+  (void)handle;
+  (void)config;
+  (void)instance_id;
+  return SL_RTL_ERROR_SUCCESS;
+}
+
+enum sl_rtl_error_code rtl_library_create_estimator(const uint8_t conn_handle,
+                                                    sl_rtl_cs_libitem *handle,
+                                                    rtl_config_t      *config,
+                                                    sl_rtl_cs_params  *cs_parameters,
+                                                    const uint8_t     cs_mode,
+                                                    const uint8_t     cs_sub_mode)
+{
+  (void)conn_handle;
+  (void)handle;
+  (void)config;
+  (void)cs_parameters;
+  (void)cs_mode;
+  (void)cs_sub_mode;
+  return SL_RTL_ERROR_SUCCESS;
+}
+
+uint32_t get_num_tones_from_channel_map(const uint8_t *ch_map, const uint32_t ch_map_len)
+{
+  (void)ch_map;
+  (void)ch_map_len;
+  return 72;
+}
+
+void calculate_distance(cs_initiator_t *initiator)
+{
+  cs_ras_ranging_header_t *header = (cs_ras_ranging_header_t *)initiator->data.reflector.ranging_data;
+
+  if (header == NULL || header->ranging_counter != initiator->ranging_counter) {
+    fail("step index", "estimation of mismatched halves");
+  }
+  estimated_now = true;
+}
+
+enum sl_rtl_error_code sl_rtl_cs_deinit(sl_rtl_cs_libitem *item)
+{
+  (void)item;
+  return SL_RTL_ERROR_SUCCESS;
+}
+
+enum sl_rtl_error_code sl_rtl_cs_set_cs_params(sl_rtl_cs_libitem *item,
+                                               const sl_rtl_cs_params *params)
+{
+  (void)item;
+  (void)params;
+  return SL_RTL_ERROR_SUCCESS;
+}
+
+enum sl_rtl_error_code sl_rtl_util_validate_bluetooth_cs_channel_map(const sl_rtl_cs_mode cs_mode,
+                                                                     const sl_rtl_cs_algo_mode algo_mode,
+                                                                     const uint8_t channel_map[10])
+{
+  (void)cs_mode;
+  (void)algo_mode;
+  (void)channel_map;
+  return SL_RTL_ERROR_SUCCESS;
+}
+
+
+/* ---- Stubs of the RAS client ---- */
+
+sl_status_t cs_ras_client_create(uint8_t connection,
+                                 cs_ras_gattdb_handles_t *handles,
+                                 uint16_t att_mtu)
+{
+  (void)connection;
+  (void)handles;
+  (void)att_mtu;
+  return SL_STATUS_OK;
+}
+
+sl_status_t cs_ras_client_create_initialized(uint8_t connection,
+                                             cs_ras_gattdb_handles_t *handles,
+                                             uint16_t att_mtu,
+                                             cs_ras_features_t features)
+{
+  (void)connection;
+  (void)handles;
+  (void)att_mtu;
+  (void)features;
+  return SL_STATUS_OK;
+}
+
+sl_status_t cs_ras_client_get_features(uint8_t connection, cs_ras_features_t *features)
+{
+  (void)connection;
+  *features = CS_RAS_FEATURE_RT_RANGING_DATA_MASK;
+  return SL_STATUS_OK;
+}
+
+sl_status_t cs_ras_client_configure(uint8_t connection, cs_ras_client_config_t config)
+{
+  (void)connection;
+  (void)config;
+  return SL_STATUS_OK;
+}
+
+sl_status_t cs_ras_client_select_mode(uint8_t connection, cs_ras_mode_t mode)
+{
+  (void)connection;
+  (void)mode;
+  return SL_STATUS_OK;
+}
+
+sl_status_t cs_ras_client_procedure_enabled(uint8_t connection, bool enabled)
+{
+  (void)connection;
+  (void)enabled;
+  return SL_STATUS_OK;
+}
+
+sl_status_t cs_ras_client_real_time_receive(uint8_t connection, uint32_t data_size, uint8_t *data)
+{
+  if (connection != conn_handle || data == NULL || data_size < CS_INITIATOR_MAX_RANGING_DATA_SIZE) {
+    fail("setup", "Real-Time receive without a buffer");
+  }
+  rx_buffer = data;
+  return SL_STATUS_OK;
+}
+
+sl_status_t cs_ras_client_get_ranging_data(uint8_t connection,
+                                           uint16_t ranging_counter,
+                                           uint32_t data_size,
+                                           uint8_t *data)
+{
+  (void)connection;
+  (void)ranging_counter;
+  (void)data_size;
+  (void)data;
+  fail("setup", "GET ranging data in Real-Time mode");
+  return SL_STATUS_FAIL;
+}
+
+sl_status_t cs_ras_client_ack(uint8_t connection, cs_ras_ranging_counter_t ranging_counter)
+{
+  (void)connection;
+  (void)ranging_counter;
+  return SL_STATUS_OK;
+}
+
+sl_status_t cs_ras_client_retreive_lost_segments(uint8_t connection,
+                                                 uint16_t ranging_counter,
+                                                 uint8_t start_segment,
+                                                 uint8_t end_segment,
+                                                 uint32_t data_size,
+                                                 uint8_t *data)
+{
+  (void)connection;
+  (void)ranging_counter;
+  (void)start_segment;
+  (void)end_segment;
+  (void)data_size;
+  (void)data;
+  return SL_STATUS_OK;
+}
+
+sl_status_t cs_ras_client_abort(uint8_t connection)
+{
+  (void)connection;
+  return SL_STATUS_OK;
+}
+
+/* ---- Initiator callbacks ---- */
+
+static void on_result(const uint8_t conn_handle,
+                      const uint16_t ranging_counter,
+                      const uint8_t *result,
+                      const cs_result_session_data_t *result_data,
+                      const cs_ranging_data_t *ranging_data,
+                      const void *user_data)
+{
+  (void)conn_handle;
+  (void)ranging_counter;
+  (void)result;
+  (void)result_data;
+  (void)ranging_data;
+  (void)user_data;
+}
+
+static void on_intermediate_result(const cs_intermediate_result_t *result, const void *user_data)
+{
+  (void)result;
+  (void)user_data;
+}
+
+static void on_error_event(uint8_t conn_handle, cs_error_event_t evt, sl_status_t sc)
+{
+  char what[64];
+
+  snprintf(what, sizeof(what), "connection %u error %u, sc 0x%lx",
+           conn_handle, (unsigned int)evt, (unsigned long)sc);
+  fail("step index", what);
+}
+
+/* ---- Events ---- */
+
+static union {
+  sl_bt_msg_t msg;
+  uint8_t raw[sizeof(sl_bt_msg_t) + 256];
+} event;
+
+static sl_bt_msg_t *new_event(uint32_t id)
+{
+  memset(&event, 0, sizeof(event));
+  event.msg.header = id;
+  return &event.msg;
+}
+
+static uint8_t put_steps(uint8_t *data, unsigned int first, unsigned int count)
+{
+  uint8_t len = 0;
+
+  for (unsigned int step = first; step < first + count; step++) {
+    uint8_t size = (step < CALIBRATION_STEPS) ? MODE_0_INITIATOR : MODE_2_SIZE(PATHS);
+
+    data[len++] = (step < CALIBRATION_STEPS) ? 0 : 2;
+    data[len++] = (uint8_t)(2 + step % 20);
+    data[len++] = size;
+    memset(&data[len], (int)step, size);
+    len += size;
+  }
+  return len;
+}
+
+/* The initiator half of the procedure, in two results */
+static void send_initiator_half(void)
+{
+  sl_bt_msg_t *evt = new_event(sl_bt_evt_cs_result_id);
+  sl_bt_evt_cs_result_t *result = &evt->data.evt_cs_result;
+  sl_bt_evt_cs_result_continue_t *cont;
+  unsigned int steps = (CALIBRATION_STEPS + PBR_STEPS) / 2;
+
+  result->connection = conn_handle;
+  result->procedure_counter = counter;
+  result->procedure_done_status = sl_bt_cs_done_status_partial_results_continue;
+  result->subevent_done_status = sl_bt_cs_done_status_partial_results_continue;
+  result->num_antenna_paths = PATHS;
+  result->num_steps = (uint8_t)steps;
+  result->data.len = put_steps(result->data.data, 0, steps);
+  (void)cs_initiator_on_event(evt);
+  if (instance->ranging_counter != (counter & CS_RAS_RANGING_COUNTER_MASK)) {
+    fail("setup", "procedure not started");
+  }
+
+  evt = new_event(sl_bt_evt_cs_result_continue_id);
+  cont = &evt->data.evt_cs_result_continue;
+  cont->connection = conn_handle;
+  cont->procedure_done_status = sl_bt_cs_done_status_complete;
+  cont->subevent_done_status = sl_bt_cs_done_status_complete;
+  cont->num_antenna_paths = PATHS;
+  cont->num_steps = (uint8_t)(CALIBRATION_STEPS + PBR_STEPS - steps);
+  cont->data.len = put_steps(cont->data.data, steps, CALIBRATION_STEPS + PBR_STEPS - steps);
+  (void)cs_initiator_on_event(evt);
+}
+
+static void open_connection(void)
+{
+  cs_initiator_config_t config = INITIATOR_CONFIG_DEFAULT;
+  rtl_config_t rtl_config = RTL_CONFIG_DEFAULT;
+  cs_ras_gattdb_handles_t handles;
+  sl_bt_msg_t *evt;
+  uint8_t instance_id;
+
+  // One antenna path, as the step data
+  config.num_antennas = 1;
+  config.cs_tone_antenna_config_idx_req = CS_ANTENNA_CONFIG_INDEX_SINGLE_ONLY;
+  cs_initiator_apply_channel_map_preset(config.channel_map_preset, config.channel_map.data);
+  config.max_procedure_count = 0;
+  if (cs_initiator_create(conn_handle, &config, &rtl_config, on_result,
+                          on_intermediate_result, on_error_event, &instance_id) != SL_STATUS_OK) {
+    fail("setup", "create failed");
+  }
+  memset(&handles, 0, sizeof(handles));
+  for (unsigned int i = 0; i < CS_RAS_CHARACTERISTIC_INDEX_COUNT; i++) {
+    handles.array[i] = (uint16_t)(RAS_HANDLE + 3 * i);
+  }
+  (void)cs_initiator_set_ras_attributes(conn_handle, &handles, CS_RAS_FEATURE_RT_RANGING_DATA_MASK);
+
+  evt = new_event(sl_bt_evt_connection_parameters_id);
+  evt->data.evt_connection_parameters.connection = conn_handle;
+  evt->data.evt_connection_parameters.interval = requested_interval;
+  evt->data.evt_connection_parameters.latency = config.latency;
+  evt->data.evt_connection_parameters.timeout = config.timeout;
+  evt->data.evt_connection_parameters.security_mode = sl_bt_connection_mode1_level2;
+  (void)cs_initiator_on_event(evt);
+
+  evt = new_event(sl_bt_evt_cs_security_enable_complete_id);
+  evt->data.evt_cs_security_enable_complete.connection = conn_handle;
+  (void)cs_initiator_on_event(evt);
+
+  evt = new_event(sl_bt_evt_cs_config_complete_id);
+  evt->data.evt_cs_config_complete.connection = conn_handle;
+  evt->data.evt_cs_config_complete.config_id = config.config_id;
+  (void)cs_initiator_on_event(evt);
+
+  cs_ras_client_on_mode_changed(conn_handle, CS_RAS_MODE_REAL_TIME_RANGING_DATA, SL_STATUS_OK);
+  if (instance == NULL || rx_buffer == NULL) {
+    fail("setup", "procedure not enabled");
+  }
+  evt = new_event(sl_bt_evt_cs_procedure_enable_complete_id);
+  evt->data.evt_cs_procedure_enable_complete.connection = conn_handle;
+  evt->data.evt_cs_procedure_enable_complete.state = sl_bt_cs_procedure_state_enabled;
+  evt->data.evt_cs_procedure_enable_complete.status = SL_STATUS_OK;
+  (void)cs_initiator_on_event(evt);
+}
+
+/* ---- Reflector data ---- */
+
+/* Subevents of random steps, the last one complete or aborted */
+static void build_body(void)
+{
+  cs_ras_ranging_header_t *header = (cs_ras_ranging_header_t *)body;
+  unsigned int subevents = 1u + (unsigned int)rand() % MAX_SUBEVENTS;
+
+  memset(header, 0, sizeof(*header));
+  header->ranging_counter = counter & CS_RAS_RANGING_COUNTER_MASK;
+  header->antenna_paths_mask = (uint8_t)((1u << PATHS) - 1u);
+  body_size = sizeof(*header);
+  body_complete = (percent() >= 15);
+  for (unsigned int s = 0; s < subevents; s++) {
+    cs_ras_subevent_header_t *subevent = (cs_ras_subevent_header_t *)&body[body_size];
+    unsigned int steps = 1u + (unsigned int)rand() % MAX_SUBEVENT_STEPS;
+    bool last = (s + 1 == subevents);
+
+    memset(subevent, 0, sizeof(*subevent));
+    subevent->ranging_done_status = !last ? sl_bt_cs_done_status_partial_results_continue
+                                    : body_complete ? sl_bt_cs_done_status_complete
+                                    : sl_bt_cs_done_status_aborted;
+    subevent->subevent_done_status = sl_bt_cs_done_status_complete;
+    subevent->number_of_steps_reported = (uint8_t)steps;
+    body_size += sizeof(*subevent);
+    for (unsigned int step = 0; step < steps; step++) {
+      unsigned int r = percent();
+      uint8_t mode = (r < 10) ? 0 : (r < 20) ? 1 : 2;
+      uint8_t size = (mode == 0) ? MODE_0_REFLECTOR : (mode == 1) ? MODE_1_SIZE : MODE_2_SIZE(PATHS);
+
+      if (r >= 90) {
+        // Aborted step, no data
+        body[body_size++] = (uint8_t)(0x80 | mode);
+        continue;
+      }
+      body[body_size++] = mode;
+      for (uint8_t i = 0; i < size; i++) {
+        body[body_size++] = (uint8_t)rand();
+      }
+    }
+  }
+}
+
+/* Segment order: swaps, duplicates, then the lost segments shuffled */
+static void build_sends(void)
+{
+  uint8_t lost_segments[MAX_SEGMENTS];
+  unsigned int lost_count = 0;
+
+  segment_size = CS_RAS_SEGMENT_DATA_SIZE(att_mtus[(unsigned int)rand() % 3]);
+  segment_count = (unsigned int)((body_size + segment_size - 1) / segment_size);
+  send_count = 0;
+  for (unsigned int k = 0; k < segment_count; k++) {
+    if (percent() < lost_percent) {
+      lost_segments[lost_count++] = (uint8_t)k;
+      lost++;
+      continue;
+    }
+    sends[send_count++] = (uint8_t)k;
+    if (percent() < duplicate_percent) {
+      // Sent again right away or after a later one
+      sends[send_count++] = (uint8_t)((unsigned int)rand() % (k + 1));
+      duplicated++;
+    }
+  }
+  for (unsigned int i = 0; i + 1 < send_count; i++) {
+    if (percent() < reorder_percent) {
+      uint8_t k = sends[i];
+
+      sends[i] = sends[i + 1];
+      sends[i + 1] = k;
+      reordered++;
+    }
+  }
+  while (lost_count > 0) {
+    unsigned int i = (unsigned int)rand() % lost_count;
+
+    sends[send_count++] = lost_segments[i];
+    lost_segments[i] = lost_segments[--lost_count];
+  }
+}
+
+/* ---- Checks ---- */
+
+static void compare_index(const cs_ras_step_index_t *index,
+                          const cs_ras_step_index_t *expected,
+                          const char *test)
+{
+  if (index->status != SL_STATUS_OK) {
+    fail(test, "index stopped on an error");
+  }
+  if (index->parsed != expected->parsed || index->steps_left != expected->steps_left) {
+    fail(test, "index does not end where the built one does");
+  }
+  if (index->num_subevents != expected->num_subevents || index->num_steps != expected->num_steps) {
+    fail(test, "subevent or step count differs");
+  }
+  if (index->complete != expected->complete) {
+    fail(test, "completeness differs");
+  }
+  for (uint8_t i = 0; i < index->num_subevents; i++) {
+    const cs_ras_subevent_index_t *a = &index->subevent[i];
+    const cs_ras_subevent_index_t *b = &expected->subevent[i];
+
+    if (a->offset != b->offset || a->num_steps != b->num_steps
+        || a->ranging_done_status != b->ranging_done_status
+        || a->subevent_done_status != b->subevent_done_status) {
+      fail(test, "subevent entry differs");
+    }
+  }
+}
+
+/* End of the data stored without a gap */
+static uint32_t stored_prefix(void)
+{
+  unsigned int k = 0;
+
+  while (k < segment_count && stored[k]) {
+    k++;
+  }
+  return (k == segment_count) ? body_size : k * segment_size;
+}
+
+static void check_segment(void)
+{
+  cs_ras_step_index_t expected;
+  uint32_t received = instance->data.reflector_received;
+
+  if (!stored[0]) {
+    // Nothing is indexed before the first segment of the procedure
+    if (memcmp(&instance->data.reflector_index, &last_index, sizeof(last_index)) != 0) {
+      fail("step index", "data indexed before the first segment");
+    }
+    return;
+  }
+  if (received > stored_prefix()) {
+    fail("step index", "data indexed past a missing segment");
+  }
+  (void)cs_ras_format_build_step_index(rx_buffer, rx_buffer + received, false, PATHS, &expected);
+  compare_index(&instance->data.reflector_index, &expected, "step index after a segment");
+}
+
+static void check_reception(void)
+{
+  cs_ras_step_index_t expected;
+
+  if (cs_ras_format_build_step_index(rx_buffer, rx_buffer + body_size, false, PATHS, &expected)
+      != SL_STATUS_OK) {
+    fail("step index", "reassembled body not indexed");
+  }
+  if (!expected.complete || expected.num_steps == 0) {
+    fail("step index", "reassembled body not whole");
+  }
+  compare_index(&instance->data.reflector_index, &expected, "step index after the reception");
+  if (estimated_now != body_complete) {
+    fail("step index", body_complete ? "complete procedure not estimated"
+         : "aborted procedure estimated");
+  }
+}
+
+/* ---- Procedures ---- */
+
+static void run_procedure(void)
+{
+  counter++;
+  estimated_now = false;
+  send_initiator_half();
+  build_body();
+  build_sends();
+
+  // Bytes not written by a segment cannot be indexed
+  memset(rx_buffer, INVALID_STEP_MODE, CS_INITIATOR_MAX_RANGING_DATA_SIZE);
+  memset(stored, 0, sizeof(stored));
+  for (unsigned int i = 0; i < send_count; i++) {
+    uint32_t offset = sends[i] * segment_size;
+    uint32_t size = (offset + segment_size > body_size) ? body_size - offset : segment_size;
+
+    memcpy(&rx_buffer[offset], &body[offset], size);
+    stored[sends[i]] = true;
+    cs_ras_client_on_ranging_data_segment(conn_handle, offset, size);
+    sent++;
+    check_segment();
+  }
+  cs_ras_client_on_ranging_data_reception_finished(conn_handle,
+                                                   true,
+                                                   false,
+                                                   SL_STATUS_OK,
+                                                   CS_RAS_CP_RESPONSE_CODE_SUCCESS,
+                                                   counter & CS_RAS_RANGING_COUNTER_MASK,
+                                                   0,
+                                                   0,
+                                                   true,
+                                                   body_size,
+                                                   true,
+                                                   0,
+                                                   0);
+  check_reception();
+  memcpy(&last_index, &instance->data.reflector_index, sizeof(last_index));
+  if (estimated_now) {
+    estimated++;
+  } else {
+    aborted++;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  unsigned long procedures = 2000;
+  unsigned int seed = 1;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "p:s:l:u:r:")) != -1) {
+    switch (opt) {
+      case 'p':
+        procedures = strtoul(optarg, NULL, 0);
+        break;
+      case 's':
+        seed = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      case 'l':
+        lost_percent = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      case 'u':
+        duplicate_percent = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      case 'r':
+        reorder_percent = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-p procedures] [-s seed] [-l percent] [-u percent] "
+                        "[-r percent]\n",
+                argv[0]);
+        return 1;
+    }
+  }
+  if (procedures == 0 || lost_percent > 100 || duplicate_percent > 100 || reorder_percent > 100) {
+    fprintf(stderr, "invalid parameters\n");
+    return 1;
+  }
+  srand(seed);
+  cs_initiator_init();
+  open_connection();
+  counter = (uint16_t)rand();
+
+  for (procedure = 0; procedure < procedures; procedure++) {
+    run_procedure();
+  }
+  printf("PASS step index\n");
+  printf("procedures %lu estimated, %lu aborted\n", estimated, aborted);
+  printf("segments %lu sent, %lu lost, %lu duplicated, %lu reordered\n",
+         sent, lost, duplicated, reordered);
+  return 0;
+}
@@ -0,0 +1,361 @@
+/*
+ * reflector_cache_check.c
+ *
+ * Drives reflector_cache.c on the NVM3 object store of alg_host_port.c and
+ * checks when a saved entry is used and when the connection falls back to
+ * the RAS discovery: unbonded or unresolved peers, entries of an older
+ * layout, another address or bonding, bad handles, a changed antenna count
+ * or a bad MTU, a failure before the first result, the slot replacement
+ * and that flash is only written when an attribute changed. Exits with 1
+ * on the first failed check.
+ *
+ * Build (from the project root):
+ *   SDK=simplicity_sdk_2025.6.2
+ *   gcc -O2 -DALG_HOST_BUILD -Ihost/shim -Ihost -I. -Iconfig -Iautogen \
+ *     -I$SDK/platform/common/inc -I$SDK/protocol/bluetooth/inc \
+ *     -I$SDK/util/silicon_labs/rtl/inc \
+ *     -I$SDK/app/bluetooth/common/cs_ras/common/inc \
+ *     reflector_cache.c host/alg_host_port.c host/reflector_cache_check.c \
+ *     -o reflector_cache_check
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "alg_host_port.h"
+#include "reflector_cache.h"
+#include "config/token.h"
+
+#define CONN        1
+#define BONDING     3
+#define ANTENNAS    2
+
+static void fail(const char *test, const char *what)
+{
+  printf("FAIL %s: %s\n", test, what);
+  exit(1);
+}
+
+static bd_addr address(uint8_t last)
+{
+  bd_addr a = { { 0x11, 0x22, 0x33, 0x44, 0x55, last } };
+
+  return a;
+}
+
+/* Attributes as discovered on a reflector with every RAS characteristic */
+static reflector_cache_entry_t discovered(void)
+{
+  reflector_cache_entry_t e;
+
+  memset(&e, 0, sizeof(e));
+  e.num_antennas = ANTENNAS;
+  e.mtu = 247;
+  e.connection_interval = 8;
+  e.procedure_interval = 26;
+  e.ras_features = CS_RAS_FEATURE_RT_RANGING_DATA_MASK;
+  for (int i = 0; i < CS_RAS_CHARACTERISTIC_INDEX_COUNT; i++)
+    e.handles.array[i] = (uint16_t)(0x20 + 3 * i);
+  return e;
+}
+
+/* Connect and look up the reflector, as app.c does */
+static reflector_cache_check_t reconnect(uint8_t conn, bd_addr a, uint8_t type, uint8_t bonding,
+                                         uint8_t antennas, reflector_cache_entry_t *out)
+{
+  reflector_cache_opened(conn, &a, type, bonding);
+  return reflector_cache_lookup(conn, antennas, out);
+}
+
+/* First connection of a reflector: discover and save */
+static void learn(const char *test, bd_addr a, uint8_t bonding, const reflector_cache_entry_t *e)
+{
+  reflector_cache_entry_t out;
+
+  if (reconnect(CONN, a, sl_bt_gap_public_address, bonding, e->num_antennas, &out)
+      == REFLECTOR_CACHE_OK)
+    fail(test, "unknown reflector found in the cache");
+  if (reflector_cache_confirm(CONN, e) != SL_STATUS_OK)
+    fail(test, "save failed");
+  reflector_cache_closed(CONN);
+}
+
+static void expect(const char *test, reflector_cache_check_t got, reflector_cache_check_t wanted)
+{
+  if (got != wanted)
+  {
+    printf("FAIL %s: %s, expected %s\n", test,
+           reflector_cache_check_name(got), reflector_cache_check_name(wanted));
+    exit(1);
+  }
+}
+
+static void reset(void)
+{
+  for (uint8_t i = 0; i < REFLECTOR_CACHE_SLOTS; i++)
+    (void)nvm3_deleteObject(nvm3_defaultHandle, NVM3KEY_REFLECTOR_CACHE(i));
+  reflector_cache_init();
+}
+
+static void test_hit(void)
+{
+  reflector_cache_entry_t e = discovered();
+  reflector_cache_entry_t out;
+  uint32_t writes;
+
+  reset();
+  learn("hit", address(1), BONDING, &e);
+
+  /* Survives a reboot */
+  reflector_cache_init();
+  expect("hit", reconnect(CONN, address(1), sl_bt_gap_public_address, BONDING, ANTENNAS, &out),
+         REFLECTOR_CACHE_OK);
+  if (memcmp(&out.handles, &e.handles, sizeof(e.handles)) != 0 || out.ras_features != e.ras_features
+      || out.mtu != e.mtu || out.procedure_interval != e.procedure_interval)
+    fail("hit", "attributes differ");
+  if (!reflector_cache_pending(CONN))
+    fail("hit", "not pending before the first result");
+
+  /* Same attributes, no write */
+  writes = nvm3_defaultHandle->write_count;
+  if (reflector_cache_confirm(CONN, &e) != SL_STATUS_OK || nvm3_defaultHandle->write_count != writes)
+    fail("hit", "unchanged attributes written again");
+  if (reflector_cache_pending(CONN))
+    fail("hit", "pending after the first result");
+  reflector_cache_closed(CONN);
+
+  /* A new MTU is saved */
+  (void)reconnect(CONN, address(1), sl_bt_gap_public_address, BONDING, ANTENNAS, &out);
+  e.mtu = 100;
+  if (reflector_cache_confirm(CONN, &e) != SL_STATUS_OK || nvm3_defaultHandle->write_count != writes + 1)
+    fail("hit", "changed attributes not written");
+  reflector_cache_closed(CONN);
+  reflector_cache_init();
+  (void)reconnect(CONN, address(1), sl_bt_gap_public_address, BONDING, ANTENNAS, &out);
+  if (out.mtu != 100)
+    fail("hit", "new MTU not loaded");
+  reflector_cache_closed(CONN);
+
+  /* Resolved private address of the same reflector */
+  expect("hit", reconnect(CONN, address(1), sl_bt_gap_public_address_resolved_from_rpa, BONDING,
+                          ANTENNAS, &out),
+         REFLECTOR_CACHE_OK);
+  reflector_cache_closed(CONN);
+  printf("PASS hit\n");
+}
+
+static void test_unusable(void)
+{
+  reflector_cache_entry_t e = discovered();
+  reflector_cache_entry_t out;
+
+  reset();
+  expect("unusable", reconnect(CONN, address(1), sl_bt_gap_public_address, BONDING, ANTENNAS, &out),
+         REFLECTOR_CACHE_NO_ENTRY);
+  reflector_cache_closed(CONN);
+
+  /* Nothing is saved without a bonding or an identity */
+  reflector_cache_opened(CONN, &(bd_addr){ { 1, 2, 3, 4, 5, 6 } }, sl_bt_gap_public_address, 0xff);
+  if (reflector_cache_confirm(CONN, &e) != SL_STATUS_NOT_SUPPORTED)
+    fail("unusable", "saved without bonding");
+  reflector_cache_closed(CONN);
+  reflector_cache_opened(CONN, &(bd_addr){ { 1, 2, 3, 4, 5, 6 } }, sl_bt_gap_random_resolvable_address, BONDING);
+  if (reflector_cache_confirm(CONN, &e) != SL_STATUS_NOT_SUPPORTED)
+    fail("unusable", "saved without identity");
+  reflector_cache_closed(CONN);
+
+  /* Bonded later on the first connection */
+  reflector_cache_opened(CONN, &(bd_addr){ { 1, 2, 3, 4, 5, 6 } }, sl_bt_gap_public_address, 0xff);
+  reflector_cache_bonded(CONN, BONDING);
+  if (reflector_cache_confirm(CONN, &e) != SL_STATUS_OK)
+    fail("unusable", "not saved after bonding");
+  reflector_cache_closed(CONN);
+
+  /* The entry is kept for a connection that cannot use it */
+  expect("unusable", reconnect(CONN, (bd_addr){ { 1, 2, 3, 4, 5, 6 } }, sl_bt_gap_public_address, 0xff,
+                               ANTENNAS, &out),
+         REFLECTOR_CACHE_NOT_BONDED);
+  reflector_cache_closed(CONN);
+  expect("unusable", reconnect(CONN, (bd_addr){ { 1, 2, 3, 4, 5, 6 } }, sl_bt_gap_public_address, BONDING,
+                               ANTENNAS, &out),
+         REFLECTOR_CACHE_OK);
+  reflector_cache_closed(CONN);
+  printf("PASS unusable\n");
+}
+
+/* Every stale entry is deleted and the connection discovers */
+static void stale(const char *test, uint8_t bonding, uint8_t antennas, reflector_cache_check_t wanted)
+{
+  reflector_cache_entry_t out;
+
+  expect(test, reconnect(CONN, address(1), sl_bt_gap_public_address, bonding, antennas, &out), wanted);
+  reflector_cache_closed(CONN);
+  expect(test, reconnect(CONN, address(1), sl_bt_gap_public_address, bonding, antennas, &out),
+         REFLECTOR_CACHE_NO_ENTRY);
+  reflector_cache_closed(CONN);
+  printf("PASS %s\n", test);
+}
+
+/* Save e as is, bypassing the checks of reflector_cache_confirm() */
+static void plant(reflector_cache_entry_t *e)
+{
+  e->address = address(1);
+  e->address_type = sl_bt_gap_public_address;
+  e->bonding = BONDING;
+  if (e->version == 0)
+    e->version = REFLECTOR_CACHE_VERSION;
+  e->stamp = 1;
+  reset();
+  (void)nvm3_writeData(nvm3_defaultHandle, NVM3KEY_REFLECTOR_CACHE(0), e, sizeof(*e));
+  reflector_cache_init();
+}
+
+static void test_stale(void)
+{
+  reflector_cache_entry_t e;
+
+  e = discovered();
+  e.version = REFLECTOR_CACHE_VERSION + 1;
+  plant(&e);
+  stale("version", BONDING, ANTENNAS, REFLECTOR_CACHE_BAD_VERSION);
+
+  e = discovered();
+  plant(&e);
+  stale("bonding", BONDING + 1, ANTENNAS, REFLECTOR_CACHE_OTHER_BONDING);
+
+  e = discovered();
+  plant(&e);
+  stale("antennas", BONDING, ANTENNAS + 1, REFLECTOR_CACHE_BAD_ANTENNAS);
+
+  e = discovered();
+  e.num_antennas = 5;
+  plant(&e);
+  stale("antenna range", BONDING, 5, REFLECTOR_CACHE_BAD_ANTENNAS);
+
+  e = discovered();
+  e.mtu = 22;
+  plant(&e);
+  stale("mtu", BONDING, ANTENNAS, REFLECTOR_CACHE_BAD_MTU);
+
+  e = discovered();
+  e.handles.array[CS_RAS_CHARACTERISTIC_INDEX_CONTROL_POINT] = 0;
+  plant(&e);
+  stale("missing handle", BONDING, ANTENNAS, REFLECTOR_CACHE_BAD_HANDLES);
+
+  e = discovered();
+  e.handles.array[CS_RAS_CHARACTERISTIC_INDEX_REAL_TIME_RANGING_DATA] = CS_RAS_INVALID_CHARACTERISTIC_HANDLE;
+  e.handles.array[CS_RAS_CHARACTERISTIC_INDEX_ON_DEMAND_RANGING_DATA] = 0;
+  plant(&e);
+  stale("no ranging data", BONDING, ANTENNAS, REFLECTOR_CACHE_BAD_HANDLES);
+
+  e = discovered();
+  e.handles.array[CS_RAS_CHARACTERISTIC_INDEX_RANGING_DATA_READY] =
+    e.handles.array[CS_RAS_CHARACTERISTIC_INDEX_RANGING_DATA_OVERWRITTEN];
+  plant(&e);
+  stale("duplicate handle", BONDING, ANTENNAS, REFLECTOR_CACHE_BAD_HANDLES);
+
+  /* One of the ranging data characteristics is enough */
+  e = discovered();
+  e.handles.array[CS_RAS_CHARACTERISTIC_INDEX_ON_DEMAND_RANGING_DATA] = 0;
+  plant(&e);
+  if (reflector_cache_check(&e, &e.address, sl_bt_gap_public_address, BONDING) != REFLECTOR_CACHE_OK)
+    fail("real time only", "rejected");
+  printf("PASS real time only\n");
+
+  /* An object of an older, shorter layout reads as empty */
+  reset();
+  (void)nvm3_writeData(nvm3_defaultHandle, NVM3KEY_REFLECTOR_CACHE(0), &e, sizeof(e) - 4);
+  reflector_cache_init();
+  e = discovered();
+  stale("short object", BONDING, ANTENNAS, REFLECTOR_CACHE_NO_ENTRY);
+}
+
+static void test_reject(void)
+{
+  reflector_cache_entry_t e = discovered();
+  reflector_cache_entry_t out;
+
+  /* A failure before the first result forgets the entry */
+  reset();
+  learn("reject", address(1), BONDING, &e);
+  expect("reject", reconnect(CONN, address(1), sl_bt_gap_public_address, BONDING, ANTENNAS, &out),
+         REFLECTOR_CACHE_OK);
+  reflector_cache_reject(CONN);
+  reflector_cache_closed(CONN);
+  expect("reject", reconnect(CONN, address(1), sl_bt_gap_public_address, BONDING, ANTENNAS, &out),
+         REFLECTOR_CACHE_NO_ENTRY);
+  reflector_cache_closed(CONN);
+
+  /* A failure after it does not */
+  learn("reject", address(1), BONDING, &e);
+  (void)reconnect(CONN, address(1), sl_bt_gap_public_address, BONDING, ANTENNAS, &out);
+  (void)reflector_cache_confirm(CONN, &e);
+  reflector_cache_reject(CONN);
+  reflector_cache_closed(CONN);
+  expect("reject", reconnect(CONN, address(1), sl_bt_gap_public_address, BONDING, ANTENNAS, &out),
+         REFLECTOR_CACHE_OK);
+  reflector_cache_closed(CONN);
+
+  /* Nor does a failure of a connection that discovered */
+  reset();
+  (void)reconnect(CONN, address(1), sl_bt_gap_public_address, BONDING, ANTENNAS, &out);
+  reflector_cache_reject(CONN);
+  reflector_cache_closed(CONN);
+  learn("reject", address(2), BONDING, &e);
+  (void)reconnect(CONN, address(1), sl_bt_gap_public_address, BONDING, ANTENNAS, &out);
+  reflector_cache_reject(CONN);
+  reflector_cache_closed(CONN);
+  expect("reject", reconnect(CONN, address(2), sl_bt_gap_public_address, BONDING, ANTENNAS, &out),
+         REFLECTOR_CACHE_OK);
+  reflector_cache_closed(CONN);
+  printf("PASS reject\n");
+}
+
+static void test_slots(void)
+{
+  reflector_cache_entry_t e = discovered();
+  reflector_cache_entry_t out;
+
+  reset();
+  for (uint8_t i = 0; i < REFLECTOR_CACHE_SLOTS; i++)
+    learn("slots", address(i), (uint8_t)(i % 4), &e);
+
+  /* Reflector 0 is seen again with a new MTU, reflector 1 is the oldest */
+  (void)reconnect(CONN, address(0), sl_bt_gap_public_address, 0, ANTENNAS, &out);
+  e.mtu = 185;
+  (void)reflector_cache_confirm(CONN, &e);
+  reflector_cache_closed(CONN);
+
+  learn("slots", address(100), BONDING, &e);
+  reflector_cache_init();
+  expect("slots", reconnect(CONN, address(1), sl_bt_gap_public_address, 1, ANTENNAS, &out),
+         REFLECTOR_CACHE_NO_ENTRY);
+  reflector_cache_closed(CONN);
+  expect("slots", reconnect(CONN, address(0), sl_bt_gap_public_address, 0, ANTENNAS, &out),
+         REFLECTOR_CACHE_OK);
+  reflector_cache_closed(CONN);
+  expect("slots", reconnect(CONN, address(100), sl_bt_gap_public_address, BONDING, ANTENNAS, &out),
+         REFLECTOR_CACHE_OK);
+  reflector_cache_closed(CONN);
+
+  /* Several connections at once */
+  for (uint8_t c = 0; c < CS_INITIATOR_MAX_CONNECTIONS; c++)
+    expect("slots", reconnect(c, address((uint8_t)(2 + c)), sl_bt_gap_public_address,
+                              (uint8_t)((2 + c) % 4), ANTENNAS, &out),
+           REFLECTOR_CACHE_OK);
+  for (uint8_t c = 0; c < CS_INITIATOR_MAX_CONNECTIONS; c++)
+    reflector_cache_closed(c);
+  printf("PASS slots\n");
+}
+
+int main(void)
+{
+  if (sizeof(reflector_cache_entry_t) != 36)
+    fail("layout", "entry size changed, bump REFLECTOR_CACHE_VERSION");
+  test_hit();
+  test_unusable();
+  test_stale();
+  test_reject();
+  test_slots();
+  return 0;
+}
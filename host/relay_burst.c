@@ -0,0 +1,320 @@
+/*
+ * relay_burst.c
+ *
+ * Drives relay.c on the virtual clock and GPIO of alg_host_port.c and
+ * checks the pulse timeline: the lead and pulse lengths, the block delay
+ * between two sequences, the coalescing rules and, for bursts of random
+ * decisions from several reflectors, that the last decision always ends
+ * up on the relays. Exits with 1 on the first failed check.
+ *
+ * Build (from the project root):
+ *   SDK=simplicity_sdk_2025.6.2
+ *   gcc -O2 -DALG_HOST_BUILD -Ihost/shim -Ihost -I. \
+ *     -I$SDK/platform/common/inc \
+ *     relay.c dlog.c host/alg_host_port.c host/relay_burst.c -o relay_burst
+ *
+ * Options:
+ *   -n <bursts>  random bursts (1000)
+ *   -s <seed>    random seed (1)
+ *   -v           print the pin changes
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <getopt.h>
+#include "em_gpio.h"
+#include "alg_host_port.h"
+#include "relay.h"
+
+#define OPEN_PORT   gpioPortC
+#define OPEN_PIN    2
+#define CLOSE_PORT  gpioPortC
+#define CLOSE_PIN   3
+#define LED_PORT    gpioPortD
+#define LED_PIN     4
+
+#define STEP_MS     500u
+#define OPEN_BLOCK_MS   8000u
+#define CLOSE_BLOCK_MS  10000u
+
+/* The host clock has 1 ms resolution, the driver 1 tick */
+#define TOLERANCE_MS    1u
+
+#define PULSE_MAX   4096
+
+typedef struct
+{
+  relay_command_t cmd;
+  uint32_t led_on_ms;
+  uint32_t rise_ms;
+  uint32_t fall_ms;
+  uint32_t led_off_ms;
+} pulse_t;
+
+static pulse_t pulses[PULSE_MAX];
+static unsigned int pulse_count;
+static bool led_on;
+static bool hold;
+static bool verbose;
+
+static void on_pin(uint32_t time_ms, unsigned int port, unsigned int pin, unsigned int value)
+{
+  pulse_t *p = &pulses[pulse_count % PULSE_MAX];
+
+  if (verbose)
+    printf("%lu,%u,%u,%u\n", (unsigned long)time_ms, port, pin, value);
+
+  if (port == LED_PORT && pin == LED_PIN)
+  {
+    led_on = value;
+    if (value)
+    {
+      p->cmd = RELAY_CMD_NONE;
+      p->led_on_ms = time_ms;
+    }
+    else
+    {
+      p->led_off_ms = time_ms;
+      pulse_count++;
+    }
+  }
+  else if (value)
+  {
+    p->cmd = (port == OPEN_PORT && pin == OPEN_PIN) ? RELAY_CMD_OPEN : RELAY_CMD_CLOSE;
+    p->rise_ms = time_ms;
+  }
+  else
+  {
+    p->fall_ms = time_ms;
+  }
+}
+
+static bool relay_hold(relay_command_t cmd)
+{
+  (void)cmd;
+  return hold;
+}
+
+static bool near(uint32_t value, uint32_t expected)
+{
+  return value + TOLERANCE_MS >= expected && value <= expected + TOLERANCE_MS;
+}
+
+static void fail(const char *test, const char *what)
+{
+  printf("FAIL %s: %s\n", test, what);
+  exit(1);
+}
+
+/* Run the virtual clock until the driver is idle */
+static void drain(void)
+{
+  uint32_t next;
+
+  while (alg_host_next_timer(&next))
+    alg_host_advance_to(next);
+}
+
+static void reset(void)
+{
+  const relay_config_t config = {
+    .open_port = OPEN_PORT,
+    .open_pin = OPEN_PIN,
+    .close_port = CLOSE_PORT,
+    .close_pin = CLOSE_PIN,
+    .led_port = LED_PORT,
+    .led_pin = LED_PIN,
+    .step_ms = STEP_MS,
+    .hold = relay_hold
+  };
+
+  drain();
+  relay_init(&config);
+  pulse_count = 0;
+  hold = false;
+}
+
+static uint32_t block_ms(relay_command_t cmd)
+{
+  return (cmd == RELAY_CMD_OPEN) ? OPEN_BLOCK_MS : CLOSE_BLOCK_MS;
+}
+
+static void submit(relay_command_t cmd)
+{
+  if (relay_submit(cmd, block_ms(cmd)) != SL_STATUS_OK)
+    fail("submit", "queue full");
+}
+
+/* Pulse shape, and sequences that follow each other without overlap */
+static void check_timeline(const char *test)
+{
+  for (unsigned int i = 0; i < pulse_count && i < PULSE_MAX; i++)
+  {
+    const pulse_t *p = &pulses[i];
+
+    if (p->cmd == RELAY_CMD_NONE)
+      fail(test, "LED sequence without a pulse");
+    if (!near(p->rise_ms, p->led_on_ms + STEP_MS))
+      fail(test, "lead time");
+    if (!near(p->fall_ms, p->rise_ms + STEP_MS))
+      fail(test, "pulse length");
+    if (!near(p->led_off_ms, p->fall_ms + block_ms(p->cmd)))
+      fail(test, "block delay");
+    if (i > 0 && p->led_on_ms < pulses[i - 1].led_off_ms)
+      fail(test, "overlapping sequences");
+    if (i > 0 && p->cmd == pulses[i - 1].cmd)
+      fail(test, "repeated command");
+  }
+}
+
+static void test_single(void)
+{
+  uint32_t start;
+
+  reset();
+  alg_host_advance_to(alg_host_now_ms() + 1234);
+  start = alg_host_now_ms();
+  submit(RELAY_CMD_OPEN);
+  if (!relay_busy() || !led_on)
+    fail("single", "sequence not started");
+  drain();
+  check_timeline("single");
+  if (pulse_count != 1 || pulses[0].cmd != RELAY_CMD_OPEN || pulses[0].led_on_ms != start)
+    fail("single", "one open pulse expected");
+  if (relay_busy() || relay_target() != RELAY_CMD_OPEN)
+    fail("single", "driver not idle on open");
+  printf("PASS single\n");
+}
+
+static void test_coalesce(void)
+{
+  reset();
+  submit(RELAY_CMD_OPEN);
+  /* Open while opening, in every phase */
+  for (uint32_t t = 100; t < STEP_MS * 2 + OPEN_BLOCK_MS; t += 250)
+  {
+    alg_host_advance_to(pulses[0].led_on_ms + t);
+    submit(RELAY_CMD_OPEN);
+    if (relay_pending() != 0)
+      fail("coalesce", "open queued behind open");
+  }
+  drain();
+  check_timeline("coalesce");
+  if (pulse_count != 1)
+    fail("coalesce", "one pulse expected");
+  printf("PASS coalesce\n");
+}
+
+static void test_supersede(void)
+{
+  reset();
+  submit(RELAY_CMD_CLOSE);
+  alg_host_advance_to(alg_host_now_ms() + 200);
+  submit(RELAY_CMD_OPEN);
+  submit(RELAY_CMD_CLOSE);
+  if (relay_pending() != 0)
+    fail("supersede", "close did not drop the pending open");
+  submit(RELAY_CMD_OPEN);
+  submit(RELAY_CMD_CLOSE);
+  submit(RELAY_CMD_OPEN);
+  if (relay_pending() != 1 || relay_target() != RELAY_CMD_OPEN)
+    fail("supersede", "last open not pending");
+  drain();
+  check_timeline("supersede");
+  if (pulse_count != 2 || pulses[0].cmd != RELAY_CMD_CLOSE || pulses[1].cmd != RELAY_CMD_OPEN)
+    fail("supersede", "close then open expected");
+  /* The queued open starts right at the end of the block delay */
+  if (pulses[1].led_on_ms != pulses[0].led_off_ms)
+    fail("supersede", "queued command started late");
+  printf("PASS supersede\n");
+}
+
+static void test_hold(void)
+{
+  uint32_t release;
+
+  reset();
+  hold = true;
+  submit(RELAY_CMD_OPEN);
+  if (!relay_busy() || led_on)
+    fail("hold", "held command must wait with the LED off");
+  alg_host_advance_to(alg_host_now_ms() + 5000);
+  if (pulse_count != 0 || led_on)
+    fail("hold", "pulse while held");
+  hold = false;
+  release = alg_host_now_ms();
+  drain();
+  check_timeline("hold");
+  if (pulse_count != 1 || pulses[0].led_on_ms > release + STEP_MS + TOLERANCE_MS)
+    fail("hold", "command not started after the hold");
+  printf("PASS hold\n");
+}
+
+/* Several reflectors take decisions at random times, some of them in the
+ * same main loop pass, some during a sequence */
+static void test_bursts(unsigned int bursts)
+{
+  unsigned int max_pending = 0;
+
+  reset();
+  for (unsigned int b = 0; b < bursts; b++)
+  {
+    relay_command_t wanted = RELAY_CMD_NONE;
+    unsigned int decisions = 1 + rand() % 8;
+
+    pulse_count = 0;
+    for (unsigned int d = 0; d < decisions; d++)
+    {
+      wanted = (rand() & 1) ? RELAY_CMD_OPEN : RELAY_CMD_CLOSE;
+      submit(wanted);
+      if (relay_pending() > max_pending)
+        max_pending = relay_pending();
+      if (relay_target() != wanted)
+        fail("bursts", "last decision is not the target");
+      if (rand() % 3)
+        alg_host_advance_to(alg_host_now_ms() + (uint32_t)(rand() % 12000));
+    }
+    drain();
+    check_timeline("bursts");
+    if (relay_busy() || relay_target() != wanted)
+      fail("bursts", "last decision lost");
+    if (pulse_count != 0 && pulses[(pulse_count - 1) % PULSE_MAX].cmd != wanted)
+      fail("bursts", "last pulse differs from the last decision");
+  }
+  printf("PASS bursts %u, max pending %u\n", bursts, max_pending);
+}
+
+int main(int argc, char *argv[])
+{
+  unsigned int bursts = 1000;
+  unsigned int seed = 1;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:s:v")) != -1) {
+    switch (opt) {
+      case 'n':
+        bursts = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      case 's':
+        seed = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      case 'v':
+        verbose = true;
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-n bursts] [-s seed] [-v]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  srand(seed);
+  alg_host_set_pin_callback(on_pin);
+  test_single();
+  test_coalesce();
+  test_supersede();
+  test_hold();
+  test_bursts(bursts);
+  return 0;
+}
@@ -0,0 +1,422 @@
+/*
+ * result_ring_stress.c
+ *
+ * Stresses the CS result ring of app.c on app_queue.c with results that
+ * arrive faster than app_process_action() drains them. Runs the main loop
+ * on a virtual microsecond clock: every pass sl_bt_step() handles up to -e
+ * stack events, a result event queues a measurement as queue_measurement()
+ * does, then app_process_action() drains the ring and spends -d per result
+ * in process_measure() and the outputs. Results that wait for the stack
+ * count as backlog, results refused by the full ring as dropped. A -r
+ * reconnect reuses the instance for a new connection, its queued results
+ * have to be skipped as stale. Checks that every result is accounted for
+ * and that each connection gets its results in order, then prints the
+ * drops and the latencies. Exits with 1 on the first failed check.
+ *
+ * Build (from the project root):
+ *   SDK=simplicity_sdk_2025.6.2
+ *   gcc -O2 -Ihost/shim -I. -Iconfig -Iautogen \
+ *     -I$SDK/platform/common/inc -I$SDK/protocol/bluetooth/inc \
+ *     -I$SDK/util/silicon_labs/rtl/inc \
+ *     -I$SDK/app/common/util/app_queue \
+ *     $SDK/app/common/util/app_queue/app_queue.c \
+ *     host/result_ring_stress.c -o result_ring_stress
+ *
+ * Options:
+ *   -c <connections> connections, 1..CS_INITIATOR_MAX_CONNECTIONS (2)
+ *   -n <results>     results per connection (10000)
+ *   -i <us>          result interval per connection (10000)
+ *   -j <us>          random jitter of the result times (2000)
+ *   -p <count>       intermediate results before each result (0)
+ *   -d <us>          app_process_action() time per result (6000)
+ *   -e <events>      stack events handled per main loop pass (1)
+ *   -r <results>     reconnect each connection after that many results (0, never)
+ *   -s <seed>        random seed (1)
+ *
+ * Output:
+ *   results <n> produced, <n> delivered, <n> dropped (<pct>%), <n> stale
+ *   progress <n> produced, <n> dropped
+ *   # stage,mean_us,p99_us,max_us
+ *   backlog,...      result time to queue_measurement()
+ *   ring,...         queue_measurement() to the end of process_measure()
+ *   total,...
+ *   ring peak <n>/<size>, backlog peak <n>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "cs_initiator_config.h"
+#include "app_queue.h"
+
+/* Same as app.c */
+#define MEASUREMENT_QUEUE_SIZE  (4u * CS_INITIATOR_MAX_CONNECTIONS)
+
+/* Same as cs_measurement_data_t and cs_measurement_event_t of app.h */
+typedef struct {
+  float distance_filtered;
+  float distance_raw;
+  float likeliness;
+  float distance_estimate_rssi;
+  float velocity;
+  float bit_error_rate;
+} measurement_t;
+
+typedef struct {
+  uint8_t instance;
+  uint8_t conn_handle;
+  bool progress;
+  uint16_t ranging_counter;
+  measurement_t mainmode;
+  measurement_t submode;
+} measurement_event_t;
+
+/* Stack event that ends with a result callback */
+typedef struct {
+  uint64_t time_us;
+  uint32_t seq;
+  uint8_t instance;
+  uint8_t conn_handle;
+  bool progress;
+  uint16_t ranging_counter;
+} stack_event_t;
+
+typedef struct {
+  uint8_t conn_handle;
+  uint16_t ranging_counter;
+  measurement_t mainmode;
+  bool delivered_any;
+  uint16_t last_delivered;
+} instance_t;
+
+typedef enum {
+  STAGE_BACKLOG,
+  STAGE_RING,
+  STAGE_TOTAL,
+  STAGE_COUNT
+} stage_t;
+
+static const char *stage_names[STAGE_COUNT] = {
+  "backlog", "ring", "total"
+};
+
+static APP_QUEUE(measurement_queue, measurement_event_t, MEASUREMENT_QUEUE_SIZE);
+
+/* Times of the queued events, in the order of the ring */
+static struct {
+  uint64_t born_us;
+  uint64_t queued_us;
+} queued_time[MEASUREMENT_QUEUE_SIZE];
+static unsigned int queued_head;
+static unsigned int queued_count;
+
+static instance_t instances[CS_INITIATOR_MAX_CONNECTIONS];
+static stack_event_t *events;
+static unsigned long event_count;
+static uint32_t *samples[STAGE_COUNT];
+
+static unsigned long results;
+static unsigned long delivered;
+static unsigned long dropped;
+static unsigned long stale;
+static unsigned long progress_count;
+static unsigned long progress_dropped;
+static unsigned int ring_peak;
+static unsigned long backlog_peak;
+
+static void fail(const char *test, const char *what)
+{
+  printf("FAIL %s: %s\n", test, what);
+  exit(1);
+}
+
+static int compare_event(const void *a, const void *b)
+{
+  const stack_event_t *x = a;
+  const stack_event_t *y = b;
+
+  if (x->time_us != y->time_us) {
+    return (x->time_us > y->time_us) - (x->time_us < y->time_us);
+  }
+  return (x->seq > y->seq) - (x->seq < y->seq);
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+  uint32_t x = *(const uint32_t *)a;
+  uint32_t y = *(const uint32_t *)b;
+
+  return (x > y) - (x < y);
+}
+
+/* Result and progress events of every connection, in time order */
+static void generate(unsigned long count, unsigned long per_connection,
+                     unsigned long interval_us, unsigned long jitter_us,
+                     unsigned long progress, unsigned long reconnect)
+{
+  uint32_t seq = 0;
+
+  event_count = count * per_connection * (1 + progress);
+  events = malloc(event_count * sizeof(*events));
+  if (events == NULL) {
+    fprintf(stderr, "out of memory\n");
+    exit(1);
+  }
+  for (unsigned long c = 0; c < count; c++) {
+    uint64_t time_us = c * interval_us / count + jitter_us;
+    uint8_t conn_handle = (uint8_t)(c + 1);
+
+    for (unsigned long r = 0; r < per_connection; r++) {
+      long jitter = jitter_us ? (long)(rand() % (2 * jitter_us + 1)) - (long)jitter_us : 0;
+
+      if (reconnect != 0 && r != 0 && r % reconnect == 0) {
+        conn_handle = (uint8_t)(conn_handle + count);
+      }
+      for (unsigned long p = 0; p < progress; p++) {
+        stack_event_t *evt = &events[seq];
+
+        evt->time_us = time_us + (p + 1) * interval_us / (progress + 1);
+        evt->seq = seq++;
+        evt->instance = (uint8_t)c;
+        evt->conn_handle = conn_handle;
+        evt->progress = true;
+        evt->ranging_counter = (uint16_t)r;
+      }
+      time_us += interval_us;
+      stack_event_t *evt = &events[seq];
+
+      evt->time_us = (uint64_t)((long long)time_us + jitter);
+      evt->seq = seq++;
+      evt->instance = (uint8_t)c;
+      evt->conn_handle = conn_handle;
+      evt->progress = false;
+      evt->ranging_counter = (uint16_t)r;
+    }
+  }
+  qsort(events, event_count, sizeof(*events), compare_event);
+}
+
+/* ---- app.c ---- */
+
+/* queue_measurement() */
+static void queue_measurement(const stack_event_t *stack_evt, uint64_t now_us)
+{
+  instance_t *instance = &instances[stack_evt->instance];
+  measurement_event_t evt;
+
+  // A new connection takes over the instance, as create_new_initiator_instance()
+  if (instance->conn_handle != stack_evt->conn_handle) {
+    instance->conn_handle = stack_evt->conn_handle;
+    instance->delivered_any = false;
+  }
+  instance->ranging_counter = stack_evt->ranging_counter;
+  instance->mainmode.distance_filtered = (float)stack_evt->ranging_counter;
+
+  memset(&evt, 0, sizeof(evt));
+  evt.instance = stack_evt->instance;
+  evt.conn_handle = instance->conn_handle;
+  evt.progress = stack_evt->progress;
+  evt.ranging_counter = instance->ranging_counter;
+  evt.mainmode = instance->mainmode;
+
+  if (app_queue_add(&measurement_queue, (uint8_t *)&evt) != SL_STATUS_OK) {
+    if (stack_evt->progress) {
+      progress_dropped++;
+    } else {
+      dropped++;
+    }
+    return;
+  }
+  queued_time[(queued_head + queued_count) % MEASUREMENT_QUEUE_SIZE].born_us = stack_evt->time_us;
+  queued_time[(queued_head + queued_count) % MEASUREMENT_QUEUE_SIZE].queued_us = now_us;
+  queued_count++;
+  if (queued_count > ring_peak) {
+    ring_peak = queued_count;
+  }
+}
+
+/* app_process_action(), returns the time after the drain */
+static uint64_t process_action(uint64_t now_us, unsigned long drain_us)
+{
+  measurement_event_t evt;
+
+  while (app_queue_remove(&measurement_queue, (uint8_t *)&evt) == SL_STATUS_OK) {
+    instance_t *instance = &instances[evt.instance];
+    uint64_t born_us;
+    uint64_t queued_us;
+
+    if (queued_count == 0) {
+      fail("accounting", "ring holds more than was queued");
+    }
+    born_us = queued_time[queued_head].born_us;
+    queued_us = queued_time[queued_head].queued_us;
+    queued_head = (queued_head + 1) % MEASUREMENT_QUEUE_SIZE;
+    queued_count--;
+    if (instance->conn_handle != evt.conn_handle) {
+      // Instance was deleted or reused since the result was queued
+      if (!evt.progress) {
+        stale++;
+      }
+      continue;
+    }
+    if (evt.progress) {
+      continue;
+    }
+    if (evt.mainmode.distance_filtered != (float)evt.ranging_counter) {
+      fail("order", "measurement of another result");
+    }
+    if (instance->delivered_any && evt.ranging_counter <= instance->last_delivered) {
+      fail("order", "result delivered out of order");
+    }
+    instance->delivered_any = true;
+    instance->last_delivered = evt.ranging_counter;
+
+    now_us += drain_us;
+    samples[STAGE_BACKLOG][delivered] = (uint32_t)(queued_us - born_us);
+    samples[STAGE_RING][delivered] = (uint32_t)(now_us - queued_us);
+    samples[STAGE_TOTAL][delivered] = (uint32_t)(now_us - born_us);
+    delivered++;
+  }
+  return now_us;
+}
+
+/* ---- Main loop ---- */
+
+static void run(unsigned long events_per_pass, unsigned long drain_us)
+{
+  uint64_t now_us = 0;
+  unsigned long handled = 0;
+
+  while (handled < event_count || !app_queue_is_empty(&measurement_queue)) {
+    unsigned long arrived = handled;
+    unsigned long step = 0;
+
+    // sl_bt_step(), one event each
+    while (step < events_per_pass && handled < event_count
+           && events[handled].time_us <= now_us) {
+      if (events[handled].progress) {
+        progress_count++;
+      } else {
+        results++;
+      }
+      queue_measurement(&events[handled], now_us);
+      handled++;
+      step++;
+    }
+    while (arrived < event_count && events[arrived].time_us <= now_us) {
+      arrived++;
+    }
+    if (arrived - handled > backlog_peak) {
+      backlog_peak = arrived - handled;
+    }
+    now_us = process_action(now_us, drain_us);
+    // Sleep until the next event when there is nothing to do
+    if (step == 0 && handled < event_count && events[handled].time_us > now_us) {
+      now_us = events[handled].time_us;
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+  unsigned long count = 2;
+  unsigned long per_connection = 10000;
+  unsigned long interval_us = 10000;
+  unsigned long jitter_us = 2000;
+  unsigned long progress = 0;
+  unsigned long drain_us = 6000;
+  unsigned long events_per_pass = 1;
+  unsigned long reconnect = 0;
+  unsigned int seed = 1;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "c:n:i:j:p:d:e:r:s:")) != -1) {
+    switch (opt) {
+      case 'c':
+        count = strtoul(optarg, NULL, 0);
+        break;
+      case 'n':
+        per_connection = strtoul(optarg, NULL, 0);
+        break;
+      case 'i':
+        interval_us = strtoul(optarg, NULL, 0);
+        break;
+      case 'j':
+        jitter_us = strtoul(optarg, NULL, 0);
+        break;
+      case 'p':
+        progress = strtoul(optarg, NULL, 0);
+        break;
+      case 'd':
+        drain_us = strtoul(optarg, NULL, 0);
+        break;
+      case 'e':
+        events_per_pass = strtoul(optarg, NULL, 0);
+        break;
+      case 'r':
+        reconnect = strtoul(optarg, NULL, 0);
+        break;
+      case 's':
+        seed = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-c conns] [-n results] [-i us] [-j us] [-p count] "
+                        "[-d us] [-e events] [-r results] [-s seed]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (count == 0 || count > CS_INITIATOR_MAX_CONNECTIONS || per_connection == 0
+      || per_connection > UINT16_MAX || interval_us == 0 || jitter_us >= interval_us
+      || events_per_pass == 0) {
+    fprintf(stderr, "invalid parameters\n");
+    return 1;
+  }
+  srand(seed);
+  generate(count, per_connection, interval_us, jitter_us, progress, reconnect);
+  for (stage_t s = STAGE_BACKLOG; s < STAGE_COUNT; s++) {
+    samples[s] = malloc((count * per_connection + 1) * sizeof(uint32_t));
+    if (samples[s] == NULL) {
+      fprintf(stderr, "out of memory\n");
+      return 1;
+    }
+  }
+  if (APP_QUEUE_INIT(&measurement_queue, measurement_event_t, MEASUREMENT_QUEUE_SIZE)
+      != SL_STATUS_OK) {
+    fail("init", "app_queue_init");
+  }
+
+  run(events_per_pass, drain_us);
+
+  if (results != count * per_connection || delivered + dropped + stale != results
+      || queued_count != 0) {
+    fail("accounting", "results lost");
+  }
+  printf("PASS order, accounting\n");
+  printf("results %lu produced, %lu delivered, %lu dropped (%.2f%%), %lu stale\n",
+         results,
+         delivered,
+         dropped,
+         100.0 * (double)dropped / (double)results,
+         stale);
+  printf("progress %lu produced, %lu dropped\n", progress_count, progress_dropped);
+  printf("# stage,mean_us,p99_us,max_us\n");
+  for (stage_t s = STAGE_BACKLOG; s < STAGE_COUNT && delivered > 0; s++) {
+    double sum = 0.0;
+
+    for (unsigned long i = 0; i < delivered; i++) {
+      sum += samples[s][i];
+    }
+    qsort(samples[s], delivered, sizeof(uint32_t), compare_u32);
+    printf("%s,%.0f,%u,%u\n",
+           stage_names[s],
+           sum / (double)delivered,
+           samples[s][(delivered * 99) / 100],
+           samples[s][delivered - 1]);
+  }
+  printf("ring peak %u/%u, backlog peak %lu\n",
+         ring_peak,
+         (unsigned int)MEASUREMENT_QUEUE_SIZE,
+         backlog_peak);
+  return 0;
+}
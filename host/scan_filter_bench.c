@@ -0,0 +1,542 @@
+/*
+ * scan_filter_bench.c
+ *
+ * Times ble_peer_manager_find_match() on dense scan traffic, a parking lot
+ * full of phones, earbuds and trackers with a few reflectors among them,
+ * and reports the scan reports matched per second. Build it once with the
+ * compiled matcher and once with BLE_PEER_MANAGER_FILTER_COMPILED=0 for the
+ * AD walk it replaces; both builds print the same matches and digest.
+ *
+ * Build (from the project root):
+ *   SDK=simplicity_sdk_2025.6.2
+ *   F=$SDK/app/bluetooth/common/ble_peer_manager/filter
+ *   gcc -O2 -Ihost/shim -I. -Iconfig -Iautogen \
+ *     -I$SDK/platform/common/inc -I$SDK/protocol/bluetooth/inc \
+ *     -I$SDK/util/silicon_labs/rtl/inc -I$F/inc \
+ *     $F/src/ble_peer_manager_filter.c host/scan_filter_bench.c \
+ *     -o scan_filter_bench
+ * Add -DBLE_PEER_MANAGER_FILTER_COMPILED=0 for the AD walk.
+ *
+ * Options:
+ *   -t <file>     replay a capture instead of generated traffic
+ *   -w <file>     write the generated traffic as a capture and exit
+ *   -f <filter>   app: name and RAS UUID as in app.c (default)
+ *                 allow: app and an allow-list of 10 addresses
+ *                 data: manufacturer data and RAS UUID
+ *   -d <devices>  generated devices other than reflectors (300)
+ *   -k <refl>     generated reflectors, 1..8 (2)
+ *   -n <reports>  generated scan reports (100000)
+ *   -r <repeat>   passes over the reports (20)
+ *   -s <seed>     random seed (1)
+ *
+ * Capture format: one scan report per line,
+ *   <address>,<address_type>,<rssi>,<advertising data>
+ * the address as 12 hex digits, most significant byte first, and the
+ * advertising data in hex. '#' comments out the rest of the line, a
+ * comment with "reflector" tags the report as one of a reflector. When
+ * reports are tagged, as the generated ones are, the matches are checked:
+ * only the reflectors pass each filter. The allow-list holds the tagged
+ * addresses.
+ *
+ * Output:
+ *   reports <n>, matches <m>, digest <hex>
+ *   <reports_per_s> reports per second, <ns> ns per report
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <getopt.h>
+#include <time.h>
+#include "sl_bt_api.h"
+#include "ble_peer_manager_filter.h"
+
+#define MAX_REFLECTORS  8
+#define LINE_MAX_LEN    1024
+
+/* As set by app.c */
+#define REFLECTOR_NAME  "CS RFLCT"
+#define RAS_UUID16      0x185B
+
+/* Silicon Labs company identifier, only the reflectors send it */
+#define REFLECTOR_COMPANY  0x02FF
+
+typedef struct
+{
+  bd_addr address;
+  uint8_t address_type;
+  int8_t rssi;
+  bool reflector;
+  uint8_t adv[1 + 255];   /* uint8array: length and data */
+} report_t;
+
+typedef struct
+{
+  bd_addr address;
+  uint8_t address_type;
+  uint8_t len;
+  uint8_t data[31];
+  bool reflector;
+} device_t;
+
+static report_t *reports;
+static unsigned int report_count;
+static device_t *devices;
+static unsigned int device_count;
+static bool tagged;
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint8_t random_byte(void)
+{
+  return (uint8_t)(rand() & 0xff);
+}
+
+/* Append an AD element, the data is random when value is NULL */
+static void ad(device_t *d, uint8_t type, const uint8_t *value, uint8_t len)
+{
+  if (d->len + 2u + len > sizeof(d->data))
+    return;
+  d->data[d->len++] = (uint8_t)(len + 1);
+  d->data[d->len++] = type;
+  for (uint8_t i = 0; i < len; i++)
+    d->data[d->len++] = value ? value[i] : random_byte();
+}
+
+static void ad_flags(device_t *d)
+{
+  const uint8_t flags = 0x1a;
+
+  ad(d, 0x01, &flags, 1);
+}
+
+static void ad_uuid16(device_t *d, uint16_t uuid)
+{
+  const uint8_t v[2] = { (uint8_t)uuid, (uint8_t)(uuid >> 8) };
+
+  ad(d, 0x03, v, 2);
+}
+
+static void ad_manufacturer(device_t *d, uint16_t company, uint8_t len)
+{
+  uint8_t v[29];
+
+  for (uint8_t i = 0; i < len; i++)
+    v[i] = random_byte();
+  v[0] = (uint8_t)company;
+  v[1] = (uint8_t)(company >> 8);
+  ad(d, 0xff, v, len);
+}
+
+static void ad_service_data(device_t *d, uint16_t uuid, uint8_t len)
+{
+  uint8_t v[29];
+
+  for (uint8_t i = 0; i < len; i++)
+    v[i] = random_byte();
+  v[0] = (uint8_t)uuid;
+  v[1] = (uint8_t)(uuid >> 8);
+  ad(d, 0x16, v, len);
+}
+
+static void ad_name(device_t *d, const char *name)
+{
+  ad(d, 0x09, (const uint8_t *)name, (uint8_t)strlen(name));
+}
+
+/* Advertising data of the usual devices in a parking lot */
+static void make_device(device_t *d)
+{
+  static const char *names[] = { "Galaxy Buds2", "JBL Flip 5", "[TV] Samsung", "CS", "Car Kit" };
+  uuid_128 uuid128;
+
+  memset(d, 0, sizeof(*d));
+  for (int i = 0; i < 6; i++)
+    d->address.addr[i] = random_byte();
+  /* Mostly resolvable private addresses */
+  d->address_type = (rand() % 8) ? sl_bt_gap_random_resolvable_address : sl_bt_gap_public_address;
+
+  switch (rand() % 8)
+  {
+    case 0:
+    case 1:
+    case 2:
+      /* Phone, Apple continuity */
+      ad_flags(d);
+      ad_manufacturer(d, 0x004c, (uint8_t)(8 + rand() % 20));
+      break;
+    case 3:
+      /* Google Fast Pair */
+      ad_uuid16(d, 0xfe2c);
+      ad_service_data(d, 0xfe2c, 5);
+      break;
+    case 4:
+      /* Exposure notification */
+      ad_flags(d);
+      ad_uuid16(d, 0xfd6f);
+      ad_service_data(d, 0xfd6f, 22);
+      break;
+    case 5:
+      /* Microsoft Swift Pair */
+      ad_manufacturer(d, 0x0006, 27);
+      break;
+    case 6:
+      /* Earbuds or car kit with a name */
+      ad_flags(d);
+      ad_name(d, names[rand() % (sizeof(names) / sizeof(names[0]))]);
+      ad_manufacturer(d, 0x0075, 6);
+      break;
+    default:
+      /* Tracker or wearable with a 128 bit service */
+      for (int i = 0; i < 16; i++)
+        uuid128.data[i] = random_byte();
+      ad_flags(d);
+      ad(d, 0x07, uuid128.data, sizeof(uuid128.data));
+      ad_uuid16(d, 0xfeed);
+      break;
+  }
+}
+
+static void make_reflector(device_t *d)
+{
+  memset(d, 0, sizeof(*d));
+  for (int i = 0; i < 6; i++)
+    d->address.addr[i] = random_byte();
+  d->address_type = sl_bt_gap_static_address;
+  d->reflector = true;
+  ad_flags(d);
+  ad_name(d, REFLECTOR_NAME);
+  ad_uuid16(d, RAS_UUID16);
+  ad_manufacturer(d, REFLECTOR_COMPANY, 4);
+}
+
+static void generate(unsigned int count, unsigned int reflectors, unsigned int reports_wanted)
+{
+  device_count = count + reflectors;
+  devices = calloc(device_count, sizeof(device_t));
+  reports = calloc(reports_wanted, sizeof(report_t));
+  if (devices == NULL || reports == NULL)
+  {
+    fprintf(stderr, "out of memory\n");
+    exit(1);
+  }
+  for (unsigned int i = 0; i < reflectors; i++)
+    make_reflector(&devices[i]);
+  tagged = true;
+  for (unsigned int i = reflectors; i < device_count; i++)
+    make_device(&devices[i]);
+
+  for (report_count = 0; report_count < reports_wanted; report_count++)
+  {
+    const device_t *d = &devices[(unsigned int)rand() % device_count];
+    report_t *r = &reports[report_count];
+
+    r->address = d->address;
+    r->address_type = d->address_type;
+    r->rssi = (int8_t)(-100 + rand() % 60);
+    r->reflector = d->reflector;
+    r->adv[0] = d->len;
+    memcpy(&r->adv[1], d->data, d->len);
+  }
+}
+
+static int hex_value(char c)
+{
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+/* Parse hex into out, returns the byte count or -1 */
+static int parse_hex(const char *s, uint8_t *out, int max)
+{
+  int n = 0;
+
+  while (hex_value(s[0]) >= 0 && hex_value(s[1]) >= 0)
+  {
+    if (n == max)
+      return -1;
+    out[n++] = (uint8_t)(hex_value(s[0]) << 4 | hex_value(s[1]));
+    s += 2;
+  }
+  return n;
+}
+
+static void load(const char *path)
+{
+  char line[LINE_MAX_LEN];
+  unsigned int size = 0;
+  FILE *f = fopen(path, "r");
+
+  if (f == NULL)
+  {
+    perror(path);
+    exit(1);
+  }
+  while (fgets(line, sizeof(line), f) != NULL)
+  {
+    uint8_t addr[6];
+    char *field[4];
+    char *p = line;
+    int type;
+    int rssi;
+    int len;
+    bool reflector = false;
+    report_t *r;
+
+    if ((p = strchr(line, '#')) != NULL)
+    {
+      reflector = strstr(p, "reflector") != NULL;
+      *p = '\0';
+    }
+    p = line;
+    for (int i = 0; i < 4; i++)
+    {
+      field[i] = p;
+      p = (p != NULL) ? strchr(p, ',') : NULL;
+      if (p != NULL)
+        *p++ = '\0';
+    }
+    if (field[3] == NULL)
+      continue;
+    if (report_count == size)
+    {
+      size = size ? 2 * size : 4096;
+      reports = realloc(reports, size * sizeof(report_t));
+      if (reports == NULL)
+      {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+      }
+    }
+    r = &reports[report_count];
+    type = atoi(field[1]);
+    rssi = atoi(field[2]);
+    len = parse_hex(field[3], &r->adv[1], 255);
+    if (parse_hex(field[0], addr, 6) != 6 || len < 0)
+    {
+      fprintf(stderr, "%s: bad line %u\n", path, report_count + 1);
+      exit(1);
+    }
+    for (int i = 0; i < 6; i++)
+      r->address.addr[i] = addr[5 - i];
+    r->address_type = (uint8_t)type;
+    r->rssi = (int8_t)rssi;
+    r->reflector = reflector;
+    tagged |= reflector;
+    r->adv[0] = (uint8_t)len;
+    report_count++;
+  }
+  fclose(f);
+}
+
+static void save(const char *path)
+{
+  FILE *f = fopen(path, "w");
+
+  if (f == NULL)
+  {
+    perror(path);
+    exit(1);
+  }
+  fprintf(f, "# address,address_type,rssi,advertising data\n");
+  for (unsigned int i = 0; i < report_count; i++)
+  {
+    const report_t *r = &reports[i];
+
+    for (int j = 5; j >= 0; j--)
+      fprintf(f, "%02x", r->address.addr[j]);
+    fprintf(f, ",%u,%d,", r->address_type, r->rssi);
+    for (int j = 0; j < r->adv[0]; j++)
+      fprintf(f, "%02x", r->adv[1 + j]);
+    fprintf(f, "%s\n", r->reflector ? " # reflector" : "");
+  }
+  fclose(f);
+}
+
+/* Allow-list of the tagged addresses, completed with other known devices */
+static void set_allow_list(void)
+{
+  bd_addr list[10];
+  unsigned int count = 0;
+  sl_status_t sc = SL_STATUS_OK;
+
+  for (unsigned int i = 0; i < report_count && count < 10; i++)
+  {
+    bool known = false;
+
+    if (!reports[i].reflector)
+      continue;
+    for (unsigned int j = 0; j < count; j++)
+      known |= memcmp(&list[j], &reports[i].address, sizeof(bd_addr)) == 0;
+    if (!known)
+      list[count++] = reports[i].address;
+  }
+  for (; count < 10; count++)
+  {
+    for (int j = 0; j < 6; j++)
+      list[count].addr[j] = random_byte();
+  }
+  for (unsigned int i = 0; i < count; i++)
+    sc |= ble_peer_manager_add_allowed_bt_address(&list[i]);
+  ble_peer_manager_set_filter_bt_address(true);
+  if (sc != SL_STATUS_OK)
+  {
+    fprintf(stderr, "allow-list setup failed\n");
+    exit(1);
+  }
+}
+
+static void set_filter(const char *name)
+{
+  uint16_t uuid = RAS_UUID16;
+  sl_status_t sc = SL_STATUS_OK;
+
+  ble_peer_manager_filter_init();
+  if (strcmp(name, "data") == 0)
+  {
+    uint8_t company[2] = { (uint8_t)REFLECTOR_COMPANY, (uint8_t)(REFLECTOR_COMPANY >> 8) };
+
+    sc |= ble_peer_manager_set_filter_manufacturer_data(company, 0, sizeof(company));
+  }
+  else
+  {
+    sc |= ble_peer_manager_set_filter_device_name(REFLECTOR_NAME, strlen(REFLECTOR_NAME), false);
+  }
+  sc |= ble_peer_manager_set_filter_service_uuid16((sl_bt_uuid_16_t *)&uuid);
+
+  if (strcmp(name, "allow") == 0)
+  {
+    set_allow_list();
+  }
+  else if (strcmp(name, "app") != 0 && strcmp(name, "data") != 0)
+  {
+    fprintf(stderr, "unknown filter %s\n", name);
+    exit(1);
+  }
+  if (sc != SL_STATUS_OK)
+  {
+    fprintf(stderr, "filter setup failed\n");
+    exit(1);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  const char *trace = NULL;
+  const char *write_path = NULL;
+  const char *filter = "app";
+  unsigned int count = 300;
+  unsigned int reflectors = 2;
+  unsigned int reports_wanted = 100000;
+  unsigned int repeat = 20;
+  unsigned int seed = 1;
+  unsigned int matches = 0;
+  unsigned int wrong = 0;
+  uint32_t digest = 2166136261u;
+  uint64_t start;
+  uint64_t elapsed;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "t:w:f:d:k:n:r:s:")) != -1) {
+    switch (opt) {
+      case 't':
+        trace = optarg;
+        break;
+      case 'w':
+        write_path = optarg;
+        break;
+      case 'f':
+        filter = optarg;
+        break;
+      case 'd':
+        count = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      case 'k':
+        reflectors = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      case 'n':
+        reports_wanted = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      case 'r':
+        repeat = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      case 's':
+        seed = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-t file] [-w file] [-f app|allow|data] [-d devices] "
+                        "[-k refl] [-n reports] [-r repeat] [-s seed]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (reflectors == 0 || reflectors > MAX_REFLECTORS || reports_wanted == 0 || repeat == 0) {
+    fprintf(stderr, "invalid parameters\n");
+    return 1;
+  }
+
+  srand(seed);
+  if (trace != NULL) {
+    load(trace);
+  } else {
+    generate(count, reflectors, reports_wanted);
+  }
+  if (write_path != NULL) {
+    save(write_path);
+    return 0;
+  }
+  if (report_count == 0) {
+    fprintf(stderr, "no scan reports\n");
+    return 1;
+  }
+  set_filter(filter);
+
+  /* Decisions of one pass, the others repeat them */
+  for (unsigned int i = 0; i < report_count; i++) {
+    report_t *r = &reports[i];
+    bool match = ble_peer_manager_find_match(&r->address,
+                                             (sl_bt_gap_address_type_t)r->address_type,
+                                             r->rssi,
+                                             (const uint8array *)r->adv);
+
+    matches += match;
+    digest = (digest ^ (uint32_t)match) * 16777619u;
+    if (tagged && match != r->reflector) {
+      wrong++;
+    }
+  }
+
+  start = now_ns();
+  for (unsigned int pass = 0; pass < repeat; pass++) {
+    for (unsigned int i = 0; i < report_count; i++) {
+      report_t *r = &reports[i];
+      (void)ble_peer_manager_find_match(&r->address,
+                                        (sl_bt_gap_address_type_t)r->address_type,
+                                        r->rssi,
+                                        (const uint8array *)r->adv);
+    }
+  }
+  elapsed = now_ns() - start;
+
+  printf("reports %u, matches %u, digest %08x\n", report_count, matches, digest);
+  printf("%.0f reports per second, %.1f ns per report\n",
+         (double)report_count * repeat * 1e9 / (double)elapsed,
+         (double)elapsed / ((double)report_count * repeat));
+  if (wrong != 0) {
+    printf("FAIL %u reports matched differently from the traffic\n", wrong);
+    return 1;
+  }
+  return 0;
+}
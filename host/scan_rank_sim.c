@@ -0,0 +1,525 @@
+/*
+ * scan_rank_sim.c
+ *
+ * Feeds synthetic scan streams of walking and parked reflectors to
+ * ble_peer_manager_scan_rank.c, with the scan aggregation window of
+ * ble_peer_manager_central.c around it, and compares the reflectors it
+ * connects with connecting to the first match. RSSI follows a log-distance
+ * path loss with Gaussian noise and lost reports. Exits with 1 on the
+ * first failed check.
+ *
+ * Build (from the project root):
+ *   SDK=simplicity_sdk_2025.6.2
+ *   C=$SDK/app/bluetooth/common/ble_peer_manager/central
+ *   gcc -O2 -Ihost/shim -I. -Iconfig -Iautogen \
+ *     -I$SDK/platform/common/inc -I$SDK/protocol/bluetooth/inc \
+ *     -I$C/inc \
+ *     $C/src/ble_peer_manager_scan_rank.c host/scan_rank_sim.c \
+ *     -lm -o scan_rank_sim
+ *
+ * Options:
+ *   -n <runs>   runs per scenario (1000)
+ *   -s <seed>   random seed (1)
+ *   -v          print the connections of every run
+ *
+ * Output, per scenario:
+ *   <scenario>: wanted <ranked %> ranked, <first match %> first match,
+ *     first connection after <ms> ms ranked, <ms> ms first match
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include <getopt.h>
+#include "sl_bt_api.h"
+#include "ble_peer_manager_central_config.h"
+#include "ble_peer_manager_scan_rank.h"
+
+#define MAX_REFLECTORS  16
+#define MAX_SLOTS       4
+
+#define WINDOW_MS       BLE_PEER_MANAGER_CENTRAL_CONFIG_SCAN_AGGREGATION_MS
+
+/* Advertising interval and the random advDelay added to it */
+#define ADV_INTERVAL_MS 100u
+#define ADV_DELAY_MS    10u
+/* Connection setup, and restart of the scanner by app.c after it */
+#define CONNECT_MS      150u
+#define RESTART_MS      400u
+#define RUN_MS          10000u
+
+/* Log-distance path loss */
+#define RSSI_1M         -45.0
+#define PATH_LOSS_EXP   2.2
+#define RSSI_NOISE      4.0
+#define RSSI_FLOOR      -95.0
+#define REPORT_LOSS     0.3
+
+typedef struct
+{
+  double x0;        /* Start position along the path, the gate at 0, m */
+  double lateral;   /* Distance of the path from the gate, m */
+  double speed;     /* Along the path toward and past the gate, m/s */
+  uint32_t next_ms; /* Next advertisement */
+} reflector_t;
+
+typedef enum
+{
+  SCANNING,
+  CONNECTING,
+  IDLE
+} state_t;
+
+typedef struct
+{
+  reflector_t refl[MAX_REFLECTORS];
+  unsigned int count;
+  unsigned int free_slots;
+  int wanted[MAX_SLOTS];      /* Expected connections in order, -1 ends */
+} scenario_t;
+
+typedef struct
+{
+  int order[MAX_SLOTS];       /* Connected reflectors in order */
+  unsigned int connected;
+  uint32_t first_ms;          /* Time of the first connection */
+} outcome_t;
+
+typedef void (*setup_t)(scenario_t *s);
+
+static bool verbose;
+
+static void fail(const char *test, const char *what)
+{
+  printf("FAIL %s: %s\n", test, what);
+  exit(1);
+}
+
+static double uniform(double lo, double hi)
+{
+  return lo + (hi - lo) * ((double)rand() / ((double)RAND_MAX + 1.0));
+}
+
+static double gauss(void)
+{
+  double u = uniform(1e-12, 1.0);
+  double v = uniform(0.0, 1.0);
+
+  return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+static double distance(const reflector_t *r, uint32_t time_ms)
+{
+  double x = r->x0 - r->speed * (double)time_ms / 1000.0;
+
+  return sqrt(x * x + r->lateral * r->lateral);
+}
+
+static void make_address(bd_addr *address, unsigned int index)
+{
+  memset(address, 0, sizeof(*address));
+  address->addr[0] = (uint8_t)index;
+  address->addr[5] = 0xc0;
+}
+
+/* Next report heard from any reflector, false when the run is over */
+static bool next_report(scenario_t *s, uint32_t *time_ms, unsigned int *index, int8_t *rssi)
+{
+  for (;;)
+  {
+    unsigned int i = 0;
+    double level;
+    reflector_t *r;
+
+    for (unsigned int k = 1; k < s->count; k++)
+    {
+      if (s->refl[k].next_ms < s->refl[i].next_ms)
+        i = k;
+    }
+    r = &s->refl[i];
+    if (r->next_ms >= RUN_MS)
+      return false;
+
+    *time_ms = r->next_ms;
+    *index = i;
+    r->next_ms += ADV_INTERVAL_MS + (uint32_t)(rand() % (ADV_DELAY_MS + 1));
+
+    level = RSSI_1M - 10.0 * PATH_LOSS_EXP * log10(distance(r, *time_ms)) + RSSI_NOISE * gauss();
+    if (level < RSSI_FLOOR || uniform(0.0, 1.0) < REPORT_LOSS)
+      continue;
+    *rssi = (int8_t)lround(level);
+    return true;
+  }
+}
+
+static bool is_connected(const outcome_t *o, unsigned int index)
+{
+  for (unsigned int i = 0; i < o->connected; i++)
+  {
+    if (o->order[i] == (int)index)
+      return true;
+  }
+  return false;
+}
+
+static void connect(scenario_t *s, outcome_t *o, unsigned int index, uint32_t time_ms,
+                    state_t *state, uint32_t *resume_ms)
+{
+  if (o->connected == 0)
+    o->first_ms = time_ms;
+  o->order[o->connected++] = (int)index;
+  s->free_slots--;
+  *state = CONNECTING;
+  *resume_ms = time_ms + CONNECT_MS + RESTART_MS;
+}
+
+/* Connect to the first match, as before the aggregation window */
+static void run_first_match(scenario_t *s, outcome_t *o)
+{
+  state_t state = SCANNING;
+  uint32_t resume_ms = 0;
+  uint32_t time_ms;
+  unsigned int index;
+  int8_t rssi;
+
+  while (s->free_slots > 0 && next_report(s, &time_ms, &index, &rssi))
+  {
+    if (state == CONNECTING && time_ms >= resume_ms)
+      state = SCANNING;
+    if (state != SCANNING || is_connected(o, index))
+      continue;
+    connect(s, o, index, time_ms, &state, &resume_ms);
+  }
+}
+
+/* The window of ble_peer_manager_central.c: the first match starts it, at
+ * its end the best candidate is connected and the others stay ranked */
+static void run_ranked(scenario_t *s, outcome_t *o)
+{
+  ble_peer_manager_scan_candidate_t candidate;
+  state_t state = SCANNING;
+  uint32_t resume_ms = 0;
+  uint32_t origin_ms = 0;
+  uint32_t window_end_ms = 0;
+  bool window_running = false;
+  uint32_t time_ms;
+  unsigned int index;
+  int8_t rssi;
+  bd_addr address;
+
+  ble_peer_manager_scan_rank_reset();
+  while (state != IDLE && next_report(s, &time_ms, &index, &rssi))
+  {
+    if (state == CONNECTING && time_ms >= resume_ms)
+      state = SCANNING;
+
+    if (window_running && time_ms >= window_end_ms)
+    {
+      uint32_t now_ms = window_end_ms - origin_ms;
+
+      window_running = false;
+      if (state == SCANNING)
+      {
+        if (now_ms > WINDOW_MS)
+          ble_peer_manager_scan_rank_expire(now_ms - WINDOW_MS);
+        if (s->free_slots == 0)
+        {
+          state = IDLE;
+          ble_peer_manager_scan_rank_reset();
+          continue;
+        }
+        while (ble_peer_manager_scan_rank_take_best(now_ms, &candidate) == SL_STATUS_OK)
+        {
+          unsigned int c = candidate.address.addr[0];
+
+          if (is_connected(o, c))
+            continue;
+          connect(s, o, c, window_end_ms, &state, &resume_ms);
+          break;
+        }
+      }
+    }
+
+    if (state != SCANNING || is_connected(o, index))
+      continue;
+    if (ble_peer_manager_scan_rank_count() == 0)
+      origin_ms = time_ms;
+    make_address(&address, index);
+    (void)ble_peer_manager_scan_rank_add(&address, 0, rssi, time_ms - origin_ms);
+    if (!window_running)
+    {
+      window_running = true;
+      window_end_ms = time_ms + WINDOW_MS;
+    }
+  }
+}
+
+static void start(scenario_t *s)
+{
+  for (unsigned int i = 0; i < s->count; i++)
+    s->refl[i].next_ms = (uint32_t)(rand() % ADV_INTERVAL_MS);
+}
+
+static void park(reflector_t *r, double d)
+{
+  r->x0 = d;
+  r->lateral = 0.0;
+  r->speed = 0.0;
+}
+
+/* A reflector walking to the gate and one parked at about the same distance */
+static void setup_approach(scenario_t *s)
+{
+  memset(s, 0, sizeof(*s));
+  s->count = 2;
+  s->free_slots = 1;
+  park(&s->refl[0], uniform(4.0, 5.0));
+  s->refl[1].x0 = uniform(5.0, 6.5);
+  s->refl[1].lateral = 1.0;
+  s->refl[1].speed = uniform(1.0, 1.5);
+  s->wanted[0] = 1;
+  s->wanted[1] = -1;
+}
+
+/* A reflector walking away from the gate, closer than a parked one */
+static void setup_leaving(scenario_t *s)
+{
+  memset(s, 0, sizeof(*s));
+  s->count = 2;
+  s->free_slots = 1;
+  park(&s->refl[0], uniform(4.0, 5.0));
+  s->refl[1].x0 = -uniform(1.5, 2.5);
+  s->refl[1].lateral = 1.0;
+  s->refl[1].speed = uniform(1.0, 1.5);
+  s->wanted[0] = 0;
+  s->wanted[1] = -1;
+}
+
+/* Parked reflectors only, the nearest first */
+static void setup_nearest(scenario_t *s)
+{
+  static const double d[3] = { 2.0, 4.0, 8.0 };
+  unsigned int first = (unsigned int)(rand() % 3);
+
+  memset(s, 0, sizeof(*s));
+  s->count = 3;
+  s->free_slots = 1;
+  for (unsigned int i = 0; i < 3; i++)
+    park(&s->refl[(first + i) % 3], d[i] * uniform(0.9, 1.1));
+  s->wanted[0] = (int)first;
+  s->wanted[1] = -1;
+}
+
+/* Two free slots for four parked reflectors: the two nearest, in order,
+ * and no more */
+static void setup_slots(scenario_t *s)
+{
+  static const double d[4] = { 1.5, 3.5, 7.0, 12.0 };
+  unsigned int first = (unsigned int)(rand() % 4);
+
+  memset(s, 0, sizeof(*s));
+  s->count = 4;
+  s->free_slots = 2;
+  for (unsigned int i = 0; i < 4; i++)
+    park(&s->refl[(first + i) % 4], d[i] * uniform(0.9, 1.1));
+  s->wanted[0] = (int)first;
+  s->wanted[1] = (int)((first + 1) % 4);
+  s->wanted[2] = -1;
+}
+
+/* More reflectors than candidate entries, one of them close */
+static void setup_crowd(scenario_t *s)
+{
+  unsigned int near_one = (unsigned int)(rand() % MAX_REFLECTORS);
+
+  memset(s, 0, sizeof(*s));
+  s->count = MAX_REFLECTORS;
+  s->free_slots = 1;
+  for (unsigned int i = 0; i < s->count; i++)
+    park(&s->refl[i], uniform(6.0, 20.0));
+  park(&s->refl[near_one], uniform(1.5, 2.5));
+  s->wanted[0] = (int)near_one;
+  s->wanted[1] = -1;
+}
+
+static bool as_wanted(const scenario_t *s, const outcome_t *o)
+{
+  unsigned int n = 0;
+
+  while (n < MAX_SLOTS && s->wanted[n] >= 0)
+    n++;
+  if (o->connected != n)
+    return false;
+  for (unsigned int i = 0; i < n; i++)
+  {
+    if (o->order[i] != s->wanted[i])
+      return false;
+  }
+  return true;
+}
+
+static void print_outcome(const char *name, const char *policy, const outcome_t *o)
+{
+  printf("%s %s:", name, policy);
+  for (unsigned int i = 0; i < o->connected; i++)
+    printf(" %d", o->order[i]);
+  printf(" at %lu ms\n", (unsigned long)o->first_ms);
+}
+
+/* Runs the scenario with both policies on the same streams */
+static void run_scenario(const char *name, setup_t setup, unsigned int runs,
+                         double min_ranked, double min_gain)
+{
+  unsigned int ok_ranked = 0;
+  unsigned int ok_first = 0;
+  double ms_ranked = 0.0;
+  double ms_first = 0.0;
+  double ranked;
+  double first;
+
+  for (unsigned int run = 0; run < runs; run++)
+  {
+    unsigned int seed = (unsigned int)rand();
+    unsigned int slots;
+    scenario_t s;
+    outcome_t o;
+
+    srand(seed);
+    setup(&s);
+    slots = s.free_slots;
+    start(&s);
+    memset(&o, 0, sizeof(o));
+    run_ranked(&s, &o);
+    if (o.connected > slots)
+      fail(name, "more connections than free slots");
+    ok_ranked += as_wanted(&s, &o);
+    ms_ranked += o.first_ms;
+    if (verbose)
+      print_outcome(name, "ranked", &o);
+
+    srand(seed);
+    setup(&s);
+    start(&s);
+    memset(&o, 0, sizeof(o));
+    run_first_match(&s, &o);
+    ok_first += as_wanted(&s, &o);
+    ms_first += o.first_ms;
+    if (verbose)
+      print_outcome(name, "first match", &o);
+
+    srand(seed + 1);
+  }
+
+  ranked = 100.0 * ok_ranked / runs;
+  first = 100.0 * ok_first / runs;
+  printf("%s: wanted %.1f%% ranked, %.1f%% first match, "
+         "first connection after %.0f ms ranked, %.0f ms first match\n",
+         name, ranked, first, ms_ranked / runs, ms_first / runs);
+  if (ranked < min_ranked)
+    fail(name, "ranked connections not as wanted");
+  if (ranked < first + min_gain)
+    fail(name, "no better than the first match");
+  printf("PASS %s\n", name);
+}
+
+/* Fit of exact streams */
+static void test_fit(void)
+{
+  ble_peer_manager_scan_candidate_t c;
+  bd_addr a;
+  bd_addr b;
+  float rssi;
+  float slope;
+
+  make_address(&a, 1);
+  make_address(&b, 2);
+  ble_peer_manager_scan_rank_reset();
+  if (ble_peer_manager_scan_rank_take_best(0, &c) != SL_STATUS_EMPTY)
+    fail("fit", "candidate from an empty table");
+
+  /* A steady and a rising RSSI, -70 dBm + 10 dB/s */
+  for (uint32_t t = 0; t <= 1000; t += 100)
+  {
+    ble_peer_manager_scan_rank_add(&a, 0, -60, t);
+    ble_peer_manager_scan_rank_add(&b, 0, (int8_t)(-70 + (int)(t / 100)), t);
+  }
+  if (ble_peer_manager_scan_rank_count() != 2)
+    fail("fit", "two candidates expected");
+
+  if (ble_peer_manager_scan_rank_take_best(1000, &c) != SL_STATUS_OK
+      || memcmp(&c.address, &b, sizeof(bd_addr)) != 0)
+    fail("fit", "rising RSSI not ranked first");
+  ble_peer_manager_scan_rank_estimate(&c, &rssi, &slope);
+  if (fabsf(rssi + 60.0f) > 0.01f || fabsf(slope - 10.0f) > 0.01f)
+    fail("fit", "rising line");
+
+  if (ble_peer_manager_scan_rank_take_best(1000, &c) != SL_STATUS_OK)
+    fail("fit", "steady candidate lost");
+  ble_peer_manager_scan_rank_estimate(&c, &rssi, &slope);
+  if (fabsf(rssi + 60.0f) > 0.01f || fabsf(slope) > 0.01f)
+    fail("fit", "steady line");
+
+  /* Too few reports for a slope, and the slope limit */
+  ble_peer_manager_scan_rank_reset();
+  ble_peer_manager_scan_rank_add(&a, 0, -80, 0);
+  ble_peer_manager_scan_rank_add(&a, 0, -40, 500);
+  ble_peer_manager_scan_rank_take_best(500, &c);
+  ble_peer_manager_scan_rank_estimate(&c, &rssi, &slope);
+  if (slope != 0.0f)
+    fail("fit", "slope from two reports");
+  ble_peer_manager_scan_rank_add(&a, 0, -80, 0);
+  ble_peer_manager_scan_rank_add(&a, 0, -60, 500);
+  ble_peer_manager_scan_rank_add(&a, 0, -40, 1000);
+  ble_peer_manager_scan_rank_take_best(1000, &c);
+  ble_peer_manager_scan_rank_estimate(&c, &rssi, &slope);
+  if (slope != (float)BLE_PEER_MANAGER_CENTRAL_CONFIG_MAX_RSSI_SLOPE)
+    fail("fit", "slope not limited");
+
+  /* Expiry */
+  ble_peer_manager_scan_rank_add(&a, 0, -60, 0);
+  ble_peer_manager_scan_rank_add(&b, 0, -60, 2000);
+  ble_peer_manager_scan_rank_expire(1000);
+  if (ble_peer_manager_scan_rank_count() != 1
+      || ble_peer_manager_scan_rank_take_best(2000, &c) != SL_STATUS_OK
+      || memcmp(&c.address, &b, sizeof(bd_addr)) != 0)
+    fail("fit", "expiry");
+  printf("PASS fit\n");
+}
+
+int main(int argc, char *argv[])
+{
+  unsigned int runs = 1000;
+  unsigned int seed = 1;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:s:v")) != -1) {
+    switch (opt) {
+      case 'n':
+        runs = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      case 's':
+        seed = (unsigned int)strtoul(optarg, NULL, 0);
+        break;
+      case 'v':
+        verbose = true;
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-n runs] [-s seed] [-v]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (runs == 0)
+    runs = 1;
+
+  srand(seed);
+  test_fit();
+  run_scenario("approach", setup_approach, runs, 70.0, 20.0);
+  run_scenario("leaving", setup_leaving, runs, 60.0, 10.0);
+  run_scenario("nearest", setup_nearest, runs, 85.0, 20.0);
+  run_scenario("slots", setup_slots, runs, 85.0, 20.0);
+  run_scenario("crowd", setup_crowd, runs, 90.0, 20.0);
+  return 0;
+}
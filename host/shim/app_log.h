@@ -0,0 +1,32 @@
+/*
+ * app_log.h
+ *
+ * Host shim: the component logs are compiled out, so a benchmark times the
+ * processing and not the console. Build with -DHOST_APP_LOG to print them.
+ */
+
+#ifndef HOST_SHIM_APP_LOG_H_
+#define HOST_SHIM_APP_LOG_H_
+
+#define APP_LOG_NL  "\n"
+
+#ifdef HOST_APP_LOG
+#include <stdio.h>
+#define app_log_debug(...)           printf(__VA_ARGS__)
+#define app_log_info(...)            printf(__VA_ARGS__)
+#define app_log_warning(...)         printf(__VA_ARGS__)
+#define app_log_error(...)           printf(__VA_ARGS__)
+#define app_log_critical(...)        printf(__VA_ARGS__)
+#define app_log_append_debug(...)    printf(__VA_ARGS__)
+#define app_log_hexdump_debug(p, n)  do { for (unsigned int i_ = 0; i_ < (unsigned int)(n); i_++) printf(" %02x", ((const unsigned char *)(p))[i_]); } while (0)
+#else
+#define app_log_debug(...)
+#define app_log_info(...)
+#define app_log_warning(...)
+#define app_log_error(...)
+#define app_log_critical(...)
+#define app_log_append_debug(...)
+#define app_log_hexdump_debug(p, n)
+#endif
+
+#endif /* HOST_SHIM_APP_LOG_H_ */
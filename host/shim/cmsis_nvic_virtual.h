@@ -0,0 +1,12 @@
+/*
+ * cmsis_nvic_virtual.h
+ *
+ * Host shim: NVIC_SystemReset() is provided by the host tool and returns.
+ */
+
+#ifndef HOST_SHIM_CMSIS_NVIC_VIRTUAL_H_
+#define HOST_SHIM_CMSIS_NVIC_VIRTUAL_H_
+
+void NVIC_SystemReset(void);
+
+#endif /* HOST_SHIM_CMSIS_NVIC_VIRTUAL_H_ */
@@ -0,0 +1,24 @@
+/*
+ * em_core.h
+ *
+ * Host shim: critical sections are no-ops, the replay is single threaded.
+ */
+
+#ifndef HOST_SHIM_EM_CORE_H_
+#define HOST_SHIM_EM_CORE_H_
+
+#include <stdint.h>
+
+typedef uint32_t CORE_irqState_t;
+
+static inline CORE_irqState_t CORE_EnterAtomic(void)
+{
+  return 0;
+}
+
+static inline void CORE_ExitAtomic(CORE_irqState_t irqState)
+{
+  (void)irqState;
+}
+
+#endif /* HOST_SHIM_EM_CORE_H_ */
@@ -0,0 +1,34 @@
+/*
+ * em_gpio.h
+ *
+ * Host shim: pin writes are recorded by alg_host_port.c and reported to the
+ * replay driver through alg_host_set_pin_callback().
+ */
+
+#ifndef HOST_SHIM_EM_GPIO_H_
+#define HOST_SHIM_EM_GPIO_H_
+
+#include <stdint.h>
+#include "em_core.h"
+
+typedef enum {
+  gpioPortA,
+  gpioPortB,
+  gpioPortC,
+  gpioPortD,
+} GPIO_Port_TypeDef;
+
+typedef enum {
+  gpioModeDisabled,
+  gpioModeInput,
+  gpioModePushPull,
+} GPIO_Mode_TypeDef;
+
+void GPIO_PinModeSet(GPIO_Port_TypeDef port,
+                     unsigned int pin,
+                     GPIO_Mode_TypeDef mode,
+                     unsigned int out);
+void GPIO_PinOutSet(GPIO_Port_TypeDef port, unsigned int pin);
+void GPIO_PinOutClear(GPIO_Port_TypeDef port, unsigned int pin);
+
+#endif /* HOST_SHIM_EM_GPIO_H_ */
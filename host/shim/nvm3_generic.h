@@ -0,0 +1,29 @@
+/*
+ * nvm3_generic.h
+ *
+ * Host shim: a small in-memory object store standing in for NVM3.
+ */
+
+#ifndef HOST_SHIM_NVM3_GENERIC_H_
+#define HOST_SHIM_NVM3_GENERIC_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sl_status.h"
+
+typedef uint32_t nvm3_ObjectKey_t;
+
+#define NVM3_OBJECTTYPE_DATA     0U
+#define NVM3_OBJECTTYPE_COUNTER  1U
+
+typedef struct {
+  uint32_t write_count;
+} nvm3_Handle_t;
+
+sl_status_t nvm3_writeData(nvm3_Handle_t *h, nvm3_ObjectKey_t key, const void *value, size_t len);
+sl_status_t nvm3_readData(nvm3_Handle_t *h, nvm3_ObjectKey_t key, void *value, size_t len);
+sl_status_t nvm3_deleteObject(nvm3_Handle_t *h, nvm3_ObjectKey_t key);
+sl_status_t nvm3_getObjectInfo(nvm3_Handle_t *h, nvm3_ObjectKey_t key,
+                               uint32_t *type, size_t *len);
+
+#endif /* HOST_SHIM_NVM3_GENERIC_H_ */
@@ -0,0 +1,19 @@
+/*
+ * sl_core.h
+ *
+ * Host shim: the atomic and critical section macros on top of the em_core.h
+ * shim.
+ */
+
+#ifndef HOST_SHIM_SL_CORE_H_
+#define HOST_SHIM_SL_CORE_H_
+
+#include "em_core.h"
+
+#define CORE_DECLARE_IRQ_STATE  CORE_irqState_t irqState
+#define CORE_ENTER_ATOMIC()     irqState = CORE_EnterAtomic()
+#define CORE_EXIT_ATOMIC()      CORE_ExitAtomic(irqState)
+#define CORE_ENTER_CRITICAL()   irqState = CORE_EnterAtomic()
+#define CORE_EXIT_CRITICAL()    CORE_ExitAtomic(irqState)
+
+#endif /* HOST_SHIM_SL_CORE_H_ */
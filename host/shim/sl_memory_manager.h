@@ -0,0 +1,15 @@
+/*
+ * sl_memory_manager.h
+ *
+ * Host shim: the memory manager allocations go to the C library.
+ */
+
+#ifndef HOST_SHIM_SL_MEMORY_MANAGER_H_
+#define HOST_SHIM_SL_MEMORY_MANAGER_H_
+
+#include <stdlib.h>
+
+#define sl_malloc(size)  malloc(size)
+#define sl_free(ptr)     free(ptr)
+
+#endif /* HOST_SHIM_SL_MEMORY_MANAGER_H_ */
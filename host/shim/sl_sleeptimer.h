@@ -0,0 +1,39 @@
+/*
+ * sl_sleeptimer.h
+ *
+ * Host shim: one-shot timers running on the virtual clock of alg_host_port.c.
+ * Timeouts are in 32768 Hz ticks, as on target.
+ */
+
+#ifndef HOST_SHIM_SL_SLEEPTIMER_H_
+#define HOST_SHIM_SL_SLEEPTIMER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sl_status.h"
+#include "em_core.h"
+
+typedef struct sl_sleeptimer_timer_handle sl_sleeptimer_timer_handle_t;
+
+typedef void (*sl_sleeptimer_timer_callback_t)(sl_sleeptimer_timer_handle_t *handle, void *data);
+
+struct sl_sleeptimer_timer_handle {
+  void *callback_data;
+  sl_sleeptimer_timer_callback_t callback;
+  uint32_t expire_ms;
+  bool running;
+};
+
+sl_status_t sl_sleeptimer_start_timer(sl_sleeptimer_timer_handle_t *handle,
+                                      uint32_t timeout,
+                                      sl_sleeptimer_timer_callback_t callback,
+                                      void *callback_data,
+                                      uint8_t priority,
+                                      uint16_t option_flags);
+sl_status_t sl_sleeptimer_stop_timer(sl_sleeptimer_timer_handle_t *handle);
+uint32_t sl_sleeptimer_get_tick_count(void);
+uint32_t sl_sleeptimer_ms_to_tick(uint16_t time_ms);
+uint32_t sl_sleeptimer_tick_to_ms(uint32_t tick);
+uint32_t sl_sleeptimer_get_timer_frequency(void);
+
+#endif /* HOST_SHIM_SL_SLEEPTIMER_H_ */
@@ -0,0 +1,935 @@
+/*
+ * state_machine_bench.c
+ *
+ * Replays a recorded run of buffer_pool_stress through cs_initiator.c, its
+ * state machine and cs_initiator_extract.c on the host and times every
+ * sl_bt_msg_t handed to cs_initiator_on_event(). The first binary routes
+ * the events through the connection handle map and dispatches them through
+ * the state x event table, the second one with CS_INITIATOR_TABLE_DISPATCH=0
+ * through the instance scan and the nested switch of earlier releases. The
+ * Bluetooth stack, the RAS client and the RTL library are stubbed as in
+ * buffer_pool_stress, the replay has to reach the same estimations as the
+ * recorded run. Exits with 1 on the first failed check.
+ *
+ * Recording, one record per line, '#' starts a comment:
+ *   C,<connection>               cs_initiator_create()
+ *   E,<header>,<data>            an sl_bt_msg_t in hex, trailing zero bytes
+ *                                of the event data left out
+ *   M,<connection>,<mode>        RAS mode changed
+ *   R,<connection>,<counter>     reflector data of the procedure counter
+ *   D,<connection>,<status>      cs_initiator_delete(), the procedure
+ *                                disable returns status
+ *   S,<estimated>                procedures estimated in the recorded run
+ * buffer_pool_stress -w <file> writes it. host/traces/cs_events_real_time.csv
+ * and cs_events_on_demand.csv are runs of 200 procedures over 2 connections,
+ * replay them with the build of the same RAS mode.
+ *
+ * Build (from the project root):
+ *   SDK=simplicity_sdk_2025.6.2
+ *   C=$SDK/app/bluetooth/common
+ *   F="$C/cs_initiator/src/cs_initiator.c \
+ *     $C/cs_initiator/src/cs_initiator_state_machine.c \
+ *     $C/cs_initiator/src/cs_initiator_extract.c \
+ *     $C/cs_initiator/src/cs_initiator_buffer_pool.c \
+ *     $C/cs_initiator/src/cs_initiator_latency.c \
+ *     $C/cs_initiator/src/cs_initiator_error.c \
+ *     $C/cs_initiator/src/cs_initiator_client.c \
+ *     $C/cs_initiator/src/cs_initiator_ras_policy.c \
+ *     $C/cs_initiator/src/cs_initiator_recovery.c \
+ *     $C/cs_initiator/src/cs_initiator_capture.c \
+ *     $C/cs_ras/common/src/cs_ras_format_converter.c"
+ *   gcc -O2 -Ihost/shim -I. -Iconfig -Iautogen \
+ *     -I$SDK/platform/common/inc -I$SDK/protocol/bluetooth/inc \
+ *     -I$SDK/util/silicon_labs/rtl/inc \
+ *     -I$SDK/app/common/util/app_timer -I$SDK/app/common/util/app_timer/bm \
+ *     -I$C/cs_initiator/inc -I$C/cs_ras/common/inc -I$C/cs_ras/client/inc \
+ *     -I$C/cs_result/inc \
+ *     $F host/state_machine_bench.c -o state_machine_bench
+ *   gcc -O2 -DCS_INITIATOR_TABLE_DISPATCH=0 \
+ *     -Ihost/shim -I. -Iconfig -Iautogen \
+ *     -I$SDK/platform/common/inc -I$SDK/protocol/bluetooth/inc \
+ *     -I$SDK/util/silicon_labs/rtl/inc \
+ *     -I$SDK/app/common/util/app_timer -I$SDK/app/common/util/app_timer/bm \
+ *     -I$C/cs_initiator/inc -I$C/cs_ras/common/inc -I$C/cs_ras/client/inc \
+ *     -I$C/cs_result/inc \
+ *     $F host/state_machine_bench.c -o state_machine_bench_switch
+ * Add -DCS_INITIATOR_RAS_MODE_USE_REAL_TIME_MODE=0 to both for the
+ * On-Demand recording. The recording of more connections needs the same
+ * -DCS_INITIATOR_MAX_CONNECTIONS=<n> in buffer_pool_stress and here.
+ *
+ * Usage:
+ *   state_machine_bench [-r <replays>] <recording>   (200 replays)
+ *
+ * Output:
+ *   PASS replay
+ *   dispatch <table|switch>, mode <real-time|on-demand>, <n> instances
+ *   recording <records> records, <events> events, <estimated> estimated
+ *   # event,count,ns_per_event,tsc_per_event
+ *   <event>,...
+ *   all,...
+ * count is per replay. tsc_per_event counts time stamp counter ticks on x86
+ * hosts, 0 elsewhere. Times are those of the host build and only comparable
+ * between runs on the same host.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <getopt.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "sl_bt_api.h"
+#include "sl_sleeptimer.h"
+#include "app_timer.h"
+#include "cs_initiator.h"
+#include "cs_initiator_client.h"
+#include "cs_initiator_common.h"
+#include "cs_initiator_buffer_pool.h"
+#include "cs_initiator_estimate.h"
+#include "cs_ras_client.h"
+
+/* Step data sizes, see buffer_pool_stress.c */
+#define MODE_0_REFLECTOR  3
+#define MODE_2_SIZE(a)    (1 + ((a) + 1) * 4)
+#define CALIBRATION_STEPS 3
+#define PBR_STEPS         36
+#define PATHS             1
+
+#define RAS_HANDLE        0x30
+#define LINE_MAX_SIZE     1024
+#define EVENT_TYPES_MAX   16
+
+#if defined(CS_INITIATOR_RAS_MODE_USE_REAL_TIME_MODE) && (CS_INITIATOR_RAS_MODE_USE_REAL_TIME_MODE == 0)
+#define REAL_TIME         false
+#define MODE_NAME         "on-demand"
+#else
+#define REAL_TIME         true
+#define MODE_NAME         "real-time"
+#endif
+
+#if CS_INITIATOR_TABLE_DISPATCH
+#define DISPATCH_NAME     "table"
+#else
+#define DISPATCH_NAME     "switch"
+#endif
+
+typedef struct {
+  char type;
+  uint8_t connection;
+  uint32_t value;                    /* Header, mode, counter or status */
+  size_t offset;                     /* Event data in payloads */
+  uint16_t size;
+} record_t;
+
+/* State of the stubbed RAS client per connection handle */
+typedef struct {
+  uint8_t *rx_buffer;
+  bool rx_armed;
+  bool get_requested;
+} ras_stub_t;
+
+typedef struct {
+  uint32_t header;
+  unsigned long count;
+  uint64_t ns;
+  uint64_t tsc;
+} event_cost_t;
+
+static const struct {
+  uint32_t header;
+  const char *name;
+} event_names[] = {
+  { sl_bt_evt_connection_parameters_id, "connection_parameters" },
+  { sl_bt_evt_cs_security_enable_complete_id, "cs_security_enable_complete" },
+  { sl_bt_evt_cs_config_complete_id, "cs_config_complete" },
+  { sl_bt_evt_cs_procedure_enable_complete_id, "cs_procedure_enable_complete" },
+  { sl_bt_evt_cs_result_id, "cs_result" },
+  { sl_bt_evt_cs_result_continue_id, "cs_result_continue" },
+};
+
+static record_t *records;
+static size_t record_count;
+static size_t event_count;
+static uint8_t *payloads;
+static size_t payload_size;
+static unsigned long recorded_estimated;
+
+static ras_stub_t ras_stubs[UINT8_MAX + 1];
+static sl_status_t disable_status = SL_STATUS_OK;
+static unsigned long estimated;
+static unsigned long errors;
+
+static event_cost_t costs[EVENT_TYPES_MAX];
+static unsigned int cost_count;
+
+static union {
+  sl_bt_msg_t msg;
+  uint8_t raw[sizeof(sl_bt_msg_t) + 256];
+} event;
+
+static void fail(const char *test, const char *what)
+{
+  printf("FAIL %s: %s\n", test, what);
+  exit(1);
+}
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t now_tsc(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+/* ---- Stubs of the Bluetooth stack ---- */
+
+sl_status_t sl_bt_connection_get_security_status(uint8_t connection,
+                                                 uint8_t *security_mode,
+                                                 uint8_t *key_size,
+                                                 uint8_t *bonding_handle)
+{
+  (void)connection;
+  (void)key_size;
+  (void)bonding_handle;
+  *security_mode = sl_bt_connection_mode1_level2;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_connection_set_parameters(uint8_t connection,
+                                            uint16_t min_interval,
+                                            uint16_t max_interval,
+                                            uint16_t latency,
+                                            uint16_t timeout,
+                                            uint16_t min_ce_length,
+                                            uint16_t max_ce_length)
+{
+  (void)connection;
+  (void)min_interval;
+  (void)max_interval;
+  (void)latency;
+  (void)timeout;
+  (void)min_ce_length;
+  (void)max_ce_length;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_connection_set_preferred_phy(uint8_t connection,
+                                               uint8_t preferred_phy,
+                                               uint8_t accepted_phy)
+{
+  (void)connection;
+  (void)preferred_phy;
+  (void)accepted_phy;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_sm_increase_security(uint8_t connection)
+{
+  (void)connection;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_gatt_discover_primary_services(uint8_t connection)
+{
+  (void)connection;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_gatt_discover_characteristics(uint8_t connection, uint32_t service)
+{
+  (void)connection;
+  (void)service;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_cs_set_default_settings(uint8_t connection,
+                                          uint8_t initiator_status,
+                                          uint8_t reflector_status,
+                                          uint8_t antenna_identifier,
+                                          int8_t max_tx_power)
+{
+  (void)connection;
+  (void)initiator_status;
+  (void)reflector_status;
+  (void)antenna_identifier;
+  (void)max_tx_power;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_cs_security_enable(uint8_t connection)
+{
+  (void)connection;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_cs_create_config(uint8_t connection,
+                                   uint8_t config_id,
+                                   uint8_t create_context,
+                                   uint8_t main_mode_type,
+                                   uint8_t sub_mode_type,
+                                   uint8_t min_main_mode_steps,
+                                   uint8_t max_main_mode_steps,
+                                   uint8_t main_mode_repetition,
+                                   uint8_t mode_calibration_steps,
+                                   uint8_t role,
+                                   uint8_t rtt_type,
+                                   uint8_t cs_sync_phy,
+                                   const sl_bt_cs_channel_map_t *channel_map,
+                                   uint8_t channel_map_repetition,
+                                   uint8_t channel_selection_type,
+                                   uint8_t ch3c_shape,
+                                   uint8_t ch3c_jump,
+                                   uint8_t reserved)
+{
+  (void)connection;
+  (void)config_id;
+  (void)create_context;
+  (void)main_mode_type;
+  (void)sub_mode_type;
+  (void)min_main_mode_steps;
+  (void)max_main_mode_steps;
+  (void)main_mode_repetition;
+  (void)mode_calibration_steps;
+  (void)role;
+  (void)rtt_type;
+  (void)cs_sync_phy;
+  (void)channel_map;
+  (void)channel_map_repetition;
+  (void)channel_selection_type;
+  (void)ch3c_shape;
+  (void)ch3c_jump;
+  (void)reserved;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_cs_remove_config(uint8_t connection, uint8_t config_id)
+{
+  (void)connection;
+  (void)config_id;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_cs_set_procedure_parameters(uint8_t connection,
+                                              uint8_t config_id,
+                                              uint16_t max_procedure_len,
+                                              uint16_t min_procedure_interval,
+                                              uint16_t max_procedure_interval,
+                                              uint16_t max_procedure_count,
+                                              uint32_t min_subevent_len,
+                                              uint32_t max_subevent_len,
+                                              uint8_t tone_antenna_config_selection,
+                                              uint8_t phy,
+                                              int8_t tx_pwr_delta,
+                                              uint8_t preferred_peer_antenna,
+                                              uint8_t snr_control_initiator,
+                                              uint8_t snr_control_reflector)
+{
+  (void)connection;
+  (void)config_id;
+  (void)max_procedure_len;
+  (void)min_procedure_interval;
+  (void)max_procedure_interval;
+  (void)max_procedure_count;
+  (void)min_subevent_len;
+  (void)max_subevent_len;
+  (void)tone_antenna_config_selection;
+  (void)phy;
+  (void)tx_pwr_delta;
+  (void)preferred_peer_antenna;
+  (void)snr_control_initiator;
+  (void)snr_control_reflector;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_cs_procedure_enable(uint8_t connection, uint8_t enable, uint8_t config_id)
+{
+  (void)connection;
+  (void)config_id;
+  return (enable == sl_bt_cs_procedure_state_disabled) ? disable_status : SL_STATUS_OK;
+}
+
+/* ---- Stubs of the timers ---- */
+
+uint32_t sl_sleeptimer_get_tick_count(void)
+{
+  return 0;
+}
+
+uint32_t sl_sleeptimer_tick_to_ms(uint32_t tick)
+{
+  return tick;
+}
+
+sl_status_t app_timer_start(app_timer_t *timer,
+                            uint32_t timeout_ms,
+                            app_timer_callback_t callback,
+                            void *callback_data,
+                            bool is_periodic)
+{
+  (void)timer;
+  (void)timeout_ms;
+  (void)callback;
+  (void)callback_data;
+  (void)is_periodic;
+  return SL_STATUS_OK;
+}
+
+sl_status_t app_timer_stop(app_timer_t *timer)
+{
+  (void)timer;
+  return SL_STATUS_OK;
+}
+
+/* ---- Stubs of the RTL library and the estimation ---- */
+
+enum sl_rtl_error_code rtl_library_init(const uint8_t conn_handle,
+                                        sl_rtl_cs_libitem *handle,
+                                        rtl_config_t      *config,
+                                        uint8_t           *instance_id)
+{
+  (void)conn_handle;
+  (void)handle;
+  (void)config;
+  (void)instance_id;
+  return SL_RTL_ERROR_SUCCESS;
+}
+
+enum sl_rtl_error_code rtl_library_create_estimator(const uint8_t conn_handle,
+                                                    sl_rtl_cs_libitem *handle,
+                                                    rtl_config_t      *config,
+                                                    sl_rtl_cs_params  *cs_parameters,
+                                                    const uint8_t     cs_mode,
+                                                    const uint8_t     cs_sub_mode)
+{
+  (void)conn_handle;
+  (void)handle;
+  (void)config;
+  (void)cs_parameters;
+  (void)cs_mode;
+  (void)cs_sub_mode;
+  return SL_RTL_ERROR_SUCCESS;
+}
+
+uint32_t get_num_tones_from_channel_map(const uint8_t *ch_map, const uint32_t ch_map_len)
+{
+  (void)ch_map;
+  (void)ch_map_len;
+  return 72;
+}
+
+void calculate_distance(cs_initiator_t *initiator)
+{
+  (void)initiator;
+  estimated++;
+}
+
+enum sl_rtl_error_code sl_rtl_cs_deinit(sl_rtl_cs_libitem *item)
+{
+  (void)item;
+  return SL_RTL_ERROR_SUCCESS;
+}
+
+enum sl_rtl_error_code sl_rtl_cs_set_cs_params(sl_rtl_cs_libitem *item,
+                                               const sl_rtl_cs_params *params)
+{
+  (void)item;
+  (void)params;
+  return SL_RTL_ERROR_SUCCESS;
+}
+
+enum sl_rtl_error_code sl_rtl_util_validate_bluetooth_cs_channel_map(const sl_rtl_cs_mode cs_mode,
+                                                                     const sl_rtl_cs_algo_mode algo_mode,
+                                                                     const uint8_t channel_map[10])
+{
+  (void)cs_mode;
+  (void)algo_mode;
+  (void)channel_map;
+  return SL_RTL_ERROR_SUCCESS;
+}
+
+/* ---- Stubs of the RAS client ---- */
+
+sl_status_t cs_ras_client_create(uint8_t connection,
+                                 cs_ras_gattdb_handles_t *handles,
+                                 uint16_t att_mtu)
+{
+  (void)connection;
+  (void)handles;
+  (void)att_mtu;
+  return SL_STATUS_OK;
+}
+
+sl_status_t cs_ras_client_create_initialized(uint8_t connection,
+                                             cs_ras_gattdb_handles_t *handles,
+                                             uint16_t att_mtu,
+                                             cs_ras_features_t features)
+{
+  (void)connection;
+  (void)handles;
+  (void)att_mtu;
+  (void)features;
+  return SL_STATUS_OK;
+}
+
+sl_status_t cs_ras_client_get_features(uint8_t connection, cs_ras_features_t *features)
+{
+  (void)connection;
+  *features = CS_RAS_FEATURE_RT_RANGING_DATA_MASK;
+  return SL_STATUS_OK;
+}
+
+sl_status_t cs_ras_client_configure(uint8_t connection, cs_ras_client_config_t config)
+{
+  (void)connection;
+  (void)config;
+  return SL_STATUS_OK;
+}
+
+sl_status_t cs_ras_client_select_mode(uint8_t connection, cs_ras_mode_t mode)
+{
+  (void)connection;
+  (void)mode;
+  return SL_STATUS_OK;
+}
+
+sl_status_t cs_ras_client_procedure_enabled(uint8_t connection, bool enabled)
+{
+  (void)connection;
+  (void)enabled;
+  return SL_STATUS_OK;
+}
+
+sl_status_t cs_ras_client_real_time_receive(uint8_t connection, uint32_t data_size, uint8_t *data)
+{
+  (void)data_size;
+  ras_stubs[connection].rx_buffer = data;
+  ras_stubs[connection].rx_armed = true;
+  return SL_STATUS_OK;
+}
+
+sl_status_t cs_ras_client_get_ranging_data(uint8_t connection,
+                                           uint16_t ranging_counter,
+                                           uint32_t data_size,
+                                           uint8_t *data)
+{
+  (void)ranging_counter;
+  (void)data_size;
+  ras_stubs[connection].rx_buffer = data;
+  ras_stubs[connection].get_requested = true;
+  return SL_STATUS_OK;
+}
+
+sl_status_t cs_ras_client_ack(uint8_t connection, cs_ras_ranging_counter_t ranging_counter)
+{
+  (void)connection;
+  (void)ranging_counter;
+  return SL_STATUS_OK;
+}
+
+sl_status_t cs_ras_client_retreive_lost_segments(uint8_t connection,
+                                                 uint16_t ranging_counter,
+                                                 uint8_t start_segment,
+                                                 uint8_t end_segment,
+                                                 uint32_t data_size,
+                                                 uint8_t *data)
+{
+  (void)connection;
+  (void)ranging_counter;
+  (void)start_segment;
+  (void)end_segment;
+  (void)data_size;
+  (void)data;
+  return SL_STATUS_OK;
+}
+
+sl_status_t cs_ras_client_abort(uint8_t connection)
+{
+  (void)connection;
+  return SL_STATUS_OK;
+}
+
+/* ---- Initiator callbacks ---- */
+
+static void on_result(const uint8_t conn_handle,
+                      const uint16_t ranging_counter,
+                      const uint8_t *result,
+                      const cs_result_session_data_t *result_data,
+                      const cs_ranging_data_t *ranging_data,
+                      const void *user_data)
+{
+  (void)conn_handle;
+  (void)ranging_counter;
+  (void)result;
+  (void)result_data;
+  (void)ranging_data;
+  (void)user_data;
+}
+
+static void on_intermediate_result(const cs_intermediate_result_t *result, const void *user_data)
+{
+  (void)result;
+  (void)user_data;
+}
+
+static void on_error_event(uint8_t conn_handle, cs_error_event_t evt, sl_status_t sc)
+{
+  (void)conn_handle;
+  // A Real-Time buffer refused by a full pool is part of the recorded run
+  if (evt != CS_ERROR_EVENT_RAS_CLIENT_REALTIME_RECEIVE_FAILED
+      || sc != SL_STATUS_NO_MORE_RESOURCE) {
+    errors++;
+  }
+}
+
+/* ---- Recording ---- */
+
+static int hex_value(char c)
+{
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+static bool parse_event(const char *hex, record_t *record)
+{
+  size_t length = strcspn(hex, "\r\n");
+
+  if (length % 2 != 0 || length / 2 > sizeof(event) - offsetof(sl_bt_msg_t, data)) {
+    return false;
+  }
+  record->offset = payload_size;
+  record->size = (uint16_t)(length / 2);
+  payloads = realloc(payloads, payload_size + record->size + 1);
+  if (payloads == NULL) {
+    return false;
+  }
+  for (size_t i = 0; i < length; i += 2) {
+    int high = hex_value(hex[i]);
+    int low = hex_value(hex[i + 1]);
+
+    if (high < 0 || low < 0) {
+      return false;
+    }
+    payloads[payload_size++] = (uint8_t)(high << 4 | low);
+  }
+  return true;
+}
+
+static bool load(FILE *file)
+{
+  char line[LINE_MAX_SIZE];
+  size_t capacity = 0;
+  unsigned long number = 0;
+
+  while (fgets(line, sizeof(line), file) != NULL) {
+    record_t record;
+    unsigned int connection = 0;
+    unsigned long value = 0;
+    int used = 0;
+    bool valid;
+
+    number++;
+    if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') {
+      continue;
+    }
+    memset(&record, 0, sizeof(record));
+    record.type = line[0];
+    switch (record.type) {
+      case 'E':
+        valid = sscanf(line, "E,%lx,%n", &value, &used) == 1 && used > 0
+                && parse_event(&line[used], &record);
+        break;
+      case 'C':
+        valid = sscanf(line, "C,%u", &connection) == 1;
+        break;
+      case 'M':
+      case 'R':
+      case 'D':
+        valid = sscanf(&line[1], ",%u,%lu", &connection, &value) == 2;
+        break;
+      case 'S':
+        valid = sscanf(line, "S,%lu", &recorded_estimated) == 1;
+        break;
+      default:
+        valid = false;
+        break;
+    }
+    if (!valid || connection > UINT8_MAX) {
+      fprintf(stderr, "invalid record in line %lu\n", number);
+      return false;
+    }
+    if (record.type == 'S') {
+      continue;
+    }
+    if (record.type == 'E') {
+      event_count++;
+    }
+    record.connection = (uint8_t)connection;
+    record.value = (uint32_t)value;
+    if (record_count == capacity) {
+      capacity = capacity ? 2 * capacity : 4096;
+      records = realloc(records, capacity * sizeof(*records));
+      if (records == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return false;
+      }
+    }
+    records[record_count++] = record;
+  }
+  return true;
+}
+
+/* ---- Replay ---- */
+
+static void create(uint8_t connection)
+{
+  cs_initiator_config_t config = INITIATOR_CONFIG_DEFAULT;
+  rtl_config_t rtl_config = RTL_CONFIG_DEFAULT;
+  cs_ras_gattdb_handles_t handles;
+  uint8_t instance_id;
+
+  // As buffer_pool_stress opens the connection
+  config.num_antennas = 1;
+  config.cs_tone_antenna_config_idx_req = CS_ANTENNA_CONFIG_INDEX_SINGLE_ONLY;
+  cs_initiator_apply_channel_map_preset(config.channel_map_preset, config.channel_map.data);
+  config.max_procedure_count = 0;
+  memset(&ras_stubs[connection], 0, sizeof(ras_stubs[connection]));
+  if (cs_initiator_create(connection, &config, &rtl_config, on_result,
+                          on_intermediate_result, on_error_event, &instance_id) != SL_STATUS_OK) {
+    fail("replay", "create failed");
+  }
+  memset(&handles, 0, sizeof(handles));
+  for (unsigned int i = 0; i < CS_RAS_CHARACTERISTIC_INDEX_COUNT; i++) {
+    handles.array[i] = (uint16_t)(RAS_HANDLE + 3 * i);
+  }
+  (void)cs_initiator_set_ras_attributes(connection, &handles, CS_RAS_FEATURE_RT_RANGING_DATA_MASK);
+}
+
+static uint32_t build_reflector(uint8_t *body, uint16_t counter)
+{
+  cs_ras_ranging_header_t *header = (cs_ras_ranging_header_t *)body;
+  cs_ras_subevent_header_t *subevent = (cs_ras_subevent_header_t *)&body[sizeof(*header)];
+  uint32_t size = sizeof(*header) + sizeof(*subevent);
+
+  memset(body, 0, size);
+  header->ranging_counter = counter & CS_RAS_RANGING_COUNTER_MASK;
+  header->antenna_paths_mask = (uint8_t)((1u << PATHS) - 1u);
+  subevent->ranging_done_status = sl_bt_cs_done_status_complete;
+  subevent->subevent_done_status = sl_bt_cs_done_status_complete;
+  subevent->number_of_steps_reported = CALIBRATION_STEPS + PBR_STEPS;
+  for (unsigned int step = 0; step < CALIBRATION_STEPS + PBR_STEPS; step++) {
+    uint8_t step_size = (step < CALIBRATION_STEPS) ? MODE_0_REFLECTOR : MODE_2_SIZE(PATHS);
+
+    body[size++] = (step < CALIBRATION_STEPS) ? 0 : 2;
+    memset(&body[size], (int)step, step_size);
+    size += step_size;
+  }
+  return size;
+}
+
+/* The reflector data as deliver_reflector() of buffer_pool_stress hands it */
+static void deliver_reflector(uint8_t connection, uint16_t counter)
+{
+  ras_stub_t *ras = &ras_stubs[connection];
+  uint32_t size;
+
+  if (REAL_TIME) {
+    if (!ras->rx_armed) {
+      fail("replay", "reflector data without Real-Time reception");
+    }
+    ras->rx_armed = false;
+  } else {
+    ras->get_requested = false;
+    cs_ras_client_on_ranging_data_ready(connection, counter & CS_RAS_RANGING_COUNTER_MASK);
+    if (!ras->get_requested) {
+      return;
+    }
+  }
+  size = build_reflector(ras->rx_buffer, counter);
+  cs_ras_client_on_ranging_data_segment(connection, 0, size);
+  cs_ras_client_on_ranging_data_reception_finished(connection,
+                                                   REAL_TIME,
+                                                   false,
+                                                   SL_STATUS_OK,
+                                                   CS_RAS_CP_RESPONSE_CODE_SUCCESS,
+                                                   counter & CS_RAS_RANGING_COUNTER_MASK,
+                                                   0,
+                                                   0,
+                                                   true,
+                                                   size,
+                                                   true,
+                                                   0,
+                                                   0);
+}
+
+static event_cost_t *event_cost(uint32_t header)
+{
+  for (unsigned int i = 0; i < cost_count; i++) {
+    if (costs[i].header == header) {
+      return &costs[i];
+    }
+  }
+  if (cost_count == EVENT_TYPES_MAX) {
+    fail("replay", "too many event types");
+  }
+  costs[cost_count].header = header;
+  return &costs[cost_count++];
+}
+
+static void replay(bool timed)
+{
+  cs_initiator_buffer_pool_stats_t stats;
+
+  cs_initiator_init();
+  estimated = 0;
+  errors = 0;
+  for (size_t i = 0; i < record_count; i++) {
+    const record_t *record = &records[i];
+
+    switch (record->type) {
+      case 'E': {
+        event_cost_t *cost = timed ? event_cost(record->value) : NULL;
+        uint64_t start_ns;
+        uint64_t start_tsc;
+
+        memset(&event, 0, sizeof(event));
+        event.msg.header = record->value;
+        memcpy(&event.raw[offsetof(sl_bt_msg_t, data)], &payloads[record->offset], record->size);
+        start_ns = now_ns();
+        start_tsc = now_tsc();
+        (void)cs_initiator_on_event(&event.msg);
+        if (cost != NULL) {
+          cost->tsc += now_tsc() - start_tsc;
+          cost->ns += now_ns() - start_ns;
+          cost->count++;
+        }
+        break;
+      }
+      case 'C':
+        create(record->connection);
+        break;
+      case 'M':
+        if ((record->value == CS_RAS_MODE_REAL_TIME_RANGING_DATA && !REAL_TIME)
+            || (record->value == CS_RAS_MODE_ON_DEMAND_RANGING_DATA && REAL_TIME)) {
+          fail("replay", "recording of the other RAS mode");
+        }
+        cs_ras_client_on_mode_changed(record->connection, (cs_ras_mode_t)record->value, SL_STATUS_OK);
+        break;
+      case 'R':
+        deliver_reflector(record->connection, (uint16_t)record->value);
+        break;
+      default:
+        disable_status = (sl_status_t)record->value;
+        if (cs_initiator_delete(record->connection) != SL_STATUS_OK) {
+          fail("replay", "delete refused");
+        }
+        disable_status = SL_STATUS_OK;
+        break;
+    }
+  }
+  if (estimated != recorded_estimated) {
+    fail("replay", "estimations differ from the recorded run");
+  }
+  if (errors != 0) {
+    fail("replay", "error events");
+  }
+  cs_initiator_buffer_pool_get_stats(&stats);
+  if (stats.in_use != 0) {
+    fail("replay", "buffers left lent");
+  }
+}
+
+static const char *event_name(uint32_t header)
+{
+  for (size_t i = 0; i < sizeof(event_names) / sizeof(event_names[0]); i++) {
+    if (event_names[i].header == header) {
+      return event_names[i].name;
+    }
+  }
+  return "other";
+}
+
+int main(int argc, char **argv)
+{
+  unsigned long replays = 200;
+  event_cost_t all = { 0, 0, 0, 0 };
+  FILE *file;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "r:")) != -1) {
+    switch (opt) {
+      case 'r':
+        replays = strtoul(optarg, NULL, 0);
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-r replays] recording\n", argv[0]);
+        return 1;
+    }
+  }
+  if (optind + 1 != argc || replays == 0) {
+    fprintf(stderr, "usage: %s [-r replays] recording\n", argv[0]);
+    return 1;
+  }
+  file = fopen(argv[optind], "r");
+  if (file == NULL) {
+    fprintf(stderr, "cannot read recording %s\n", argv[optind]);
+    return 1;
+  }
+  if (!load(file)) {
+    return 1;
+  }
+  fclose(file);
+
+  replay(false);
+  printf("PASS replay\n");
+
+  // Warm up first
+  for (unsigned long r = 0; r < replays / 10 + 1; r++) {
+    replay(false);
+  }
+  for (unsigned long r = 0; r < replays; r++) {
+    replay(true);
+  }
+
+  printf("dispatch %s, mode %s, %u instances\n",
+         DISPATCH_NAME, MODE_NAME, (unsigned int)CS_INITIATOR_MAX_CONNECTIONS);
+  printf("recording %zu records, %zu events, %lu estimated\n",
+         record_count, event_count, recorded_estimated);
+  printf("# event,count,ns_per_event,tsc_per_event\n");
+  for (unsigned int i = 0; i < cost_count; i++) {
+    const event_cost_t *cost = &costs[i];
+
+    printf("%s,%lu,%.1f,%.1f\n",
+           event_name(cost->header),
+           cost->count / replays,
+           (double)cost->ns / (double)cost->count,
+           (double)cost->tsc / (double)cost->count);
+    all.count += cost->count;
+    all.ns += cost->ns;
+    all.tsc += cost->tsc;
+  }
+  printf("all,%lu,%.1f,%.1f\n",
+         all.count / replays,
+         (double)all.ns / (double)all.count,
+         (double)all.tsc / (double)all.count);
+  return 0;
+}
@@ -36,6 +36,7 @@
 #include "sl_main_kernel.h"
 #else // SL_CATALOG_KERNEL_PRESENT
 #include "sl_main_process_action.h"
+#include "power_monitor.h"
 #endif // SL_CATALOG_KERNEL_PRESENT
 
 int main(void)
@@ -57,10 +58,13 @@ int main(void)
   while (1) {
     // Silicon Labs components process action routine
     // must be called from the super loop.
+    (void)power_monitor_enter(POWER_SUBSYSTEM_STACK);
     sl_main_process_action();
 
     // User provided code. Application process.
+    (void)power_monitor_enter(POWER_SUBSYSTEM_APP);
     app_process_action();
+    (void)power_monitor_enter(POWER_SUBSYSTEM_OTHER);
 
 #if defined(SL_CATALOG_POWER_MANAGER_PRESENT)
     // Let the CPU go to sleep if the system allows it.
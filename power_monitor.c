@@ -0,0 +1,120 @@
+/*
+ * power_monitor.c
+ *
+ * Energy mode residency, see power_monitor.h.
+ */
+
+#include <string.h>
+#include "em_device.h"
+#include "sl_core.h"
+#include "sl_power_manager.h"
+#include "sl_sleeptimer.h"
+#include "power_monitor.h"
+
+static void on_em_transition(sl_power_manager_em_t from, sl_power_manager_em_t to);
+
+static const sl_power_manager_em_transition_event_info_t em_event_info = {
+  .event_mask = SL_POWER_MANAGER_EVENT_TRANSITION_ENTERING_EM2
+                | SL_POWER_MANAGER_EVENT_TRANSITION_LEAVING_EM2,
+  .on_event = on_em_transition
+};
+static sl_power_manager_em_transition_event_handle_t em_event_handle;
+
+static const char *subsystem_names[POWER_SUBSYSTEM_COUNT] = { "other", "stack", "app" };
+
+static uint32_t cycles_per_us = 1;
+static uint32_t window_start_tick;
+static uint32_t em2_start_tick;
+static uint32_t em2_ticks;
+static uint32_t em2_entries;
+
+static power_subsystem_t current = POWER_SUBSYSTEM_OTHER;
+static uint32_t switch_cycles;
+static uint64_t active_cycles[POWER_SUBSYSTEM_COUNT];
+
+static void on_em_transition(sl_power_manager_em_t from, sl_power_manager_em_t to)
+{
+  uint32_t now = sl_sleeptimer_get_tick_count();
+
+  if (to == SL_POWER_MANAGER_EM2)
+  {
+    em2_start_tick = now;
+    em2_entries++;
+  }
+  else if (from == SL_POWER_MANAGER_EM2)
+  {
+    em2_ticks += now - em2_start_tick;
+  }
+}
+
+/* The cycle counter stops while the core sleeps, so only EM0 is counted */
+static void charge(void)
+{
+  uint32_t now = DWT->CYCCNT;
+
+  active_cycles[current] += now - switch_cycles;
+  switch_cycles = now;
+}
+
+void power_monitor_init(void)
+{
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  cycles_per_us = SystemCoreClockGet() / 1000000u;
+  if (cycles_per_us == 0)
+    cycles_per_us = 1;
+
+  window_start_tick = sl_sleeptimer_get_tick_count();
+  em2_ticks = 0;
+  em2_entries = 0;
+  switch_cycles = DWT->CYCCNT;
+  memset(active_cycles, 0, sizeof(active_cycles));
+  sl_power_manager_subscribe_em_transition_event(&em_event_handle, &em_event_info);
+}
+
+power_subsystem_t power_monitor_enter(power_subsystem_t subsystem)
+{
+  power_subsystem_t previous;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  charge();
+  previous = current;
+  current = subsystem;
+  CORE_EXIT_ATOMIC();
+  return previous;
+}
+
+void power_monitor_leave(power_subsystem_t previous)
+{
+  (void)power_monitor_enter(previous);
+}
+
+void power_monitor_collect(power_residency_t *residency)
+{
+  uint32_t now;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  charge();
+  now = sl_sleeptimer_get_tick_count();
+  residency->window_ms = sl_sleeptimer_tick_to_ms(now - window_start_tick);
+  residency->em2_ms = sl_sleeptimer_tick_to_ms(em2_ticks);
+  residency->em2_entries = em2_entries;
+  for (uint8_t i = 0; i < POWER_SUBSYSTEM_COUNT; i++)
+  {
+    residency->active_us[i] = (uint32_t)(active_cycles[i] / cycles_per_us);
+    active_cycles[i] = 0;
+  }
+  window_start_tick = now;
+  em2_ticks = 0;
+  em2_entries = 0;
+  CORE_EXIT_ATOMIC();
+}
+
+const char *power_monitor_subsystem_name(power_subsystem_t subsystem)
+{
+  if (subsystem >= POWER_SUBSYSTEM_COUNT)
+    return "?";
+  return subsystem_names[subsystem];
+}
@@ -0,0 +1,43 @@
+/*
+ * power_monitor.h
+ *
+ * Energy mode residency of the running system: time spent in EM2 from the
+ * power manager transitions, and the EM0 time of each subsystem of the
+ * super loop from the DWT cycle counter.
+ */
+
+#ifndef POWER_MONITOR_H_
+#define POWER_MONITOR_H_
+
+#include <stdint.h>
+
+typedef enum
+{
+  POWER_SUBSYSTEM_OTHER,  /* Interrupts and the sleep entry and exit */
+  POWER_SUBSYSTEM_STACK,  /* sl_main_process_action(): stack, CS initiator, RTL */
+  POWER_SUBSYSTEM_APP,    /* app_process_action(): gate algorithm, display, logs */
+  POWER_SUBSYSTEM_COUNT
+} power_subsystem_t;
+
+typedef struct
+{
+  uint32_t window_ms;
+  uint32_t em2_ms;        /* EM0 and EM1 make up the rest of the window */
+  uint32_t em2_entries;
+  uint32_t active_us[POWER_SUBSYSTEM_COUNT];
+} power_residency_t;
+
+void power_monitor_init(void);
+
+/* Charge the EM0 time from now on to subsystem, returns the one it replaces */
+power_subsystem_t power_monitor_enter(power_subsystem_t subsystem);
+
+/* Charge the EM0 time from now on to previous again */
+void power_monitor_leave(power_subsystem_t previous);
+
+/* Residency since the last call, then start a new window */
+void power_monitor_collect(power_residency_t *residency);
+
+const char *power_monitor_subsystem_name(power_subsystem_t subsystem);
+
+#endif /* POWER_MONITOR_H_ */
@@ -0,0 +1,141 @@
+/*
+ * power_policy.c
+ *
+ * Power level selection and current model, see power_policy.h.
+ */
+
+#include <stddef.h>
+#include "power_policy.h"
+
+static power_level_t level;
+static uint32_t last_active_ms;
+
+static const char *level_names[POWER_LEVEL_COUNT] = { "active", "idle", "dormant" };
+
+void power_policy_init(uint32_t now_ms)
+{
+  /* The boot heartbeat is the active one, the first update settles it */
+  level = POWER_LEVEL_ACTIVE;
+  last_active_ms = now_ms;
+}
+
+power_level_t power_policy_update(const power_policy_input_t *input, uint32_t now_ms)
+{
+#if POWER_POLICY_ENABLE
+  if (input->reflectors == 0)
+  {
+    /* The next reflector starts at the active level */
+    last_active_ms = now_ms;
+    level = POWER_LEVEL_DORMANT;
+  }
+  else if (input->fast_reflectors != 0 || input->red_zone || !input->gate_idle)
+  {
+    last_active_ms = now_ms;
+    level = POWER_LEVEL_ACTIVE;
+  }
+  else if ((now_ms - last_active_ms) >= POWER_IDLE_ENTER_MS)
+  {
+    level = POWER_LEVEL_IDLE;
+  }
+  else
+  {
+    level = POWER_LEVEL_ACTIVE;
+  }
+#else
+  (void)now_ms;
+  level = (input->reflectors == 0) ? POWER_LEVEL_DORMANT : POWER_LEVEL_ACTIVE;
+#endif
+  return level;
+}
+
+power_level_t power_policy_level(void)
+{
+  return level;
+}
+
+const char *power_policy_level_name(power_level_t l)
+{
+  if (l >= POWER_LEVEL_COUNT)
+    return "?";
+  return level_names[l];
+}
+
+uint8_t power_policy_connection_factor(power_level_t l)
+{
+  return (l == POWER_LEVEL_IDLE) ? POWER_IDLE_CONNECTION_FACTOR : 1;
+}
+
+uint8_t power_policy_procedure_factor(power_level_t l)
+{
+  return (l == POWER_LEVEL_IDLE) ? POWER_IDLE_PROCEDURE_FACTOR : 1;
+}
+
+uint32_t power_policy_heartbeat_ms(power_level_t l)
+{
+#if POWER_POLICY_ENABLE
+  switch (l)
+  {
+    case POWER_LEVEL_IDLE:
+      return POWER_IDLE_HEARTBEAT_MS;
+    case POWER_LEVEL_DORMANT:
+      return POWER_DORMANT_HEARTBEAT_MS;
+    default:
+      break;
+  }
+#else
+  (void)l;
+#endif
+  return POWER_ACTIVE_HEARTBEAT_MS;
+}
+
+/* Connection events and CS procedures per second */
+static void event_rates(const power_plan_t *plan, float *conn_rate, float *proc_rate)
+{
+  float period_s;
+  uint8_t slow;
+
+  *conn_rate = 0.f;
+  *proc_rate = 0.f;
+  if (plan->reflectors == 0 || plan->connection_interval == 0)
+    return;
+
+  period_s = plan->connection_interval * 1.25e-3f;
+  slow = plan->reflectors - plan->fast_reflectors;
+  *conn_rate = plan->reflectors / period_s;
+  if (plan->fast_procedure_interval != 0)
+    *proc_rate += plan->fast_reflectors / (period_s * plan->fast_procedure_interval);
+  if (plan->slow_procedure_interval != 0)
+    *proc_rate += slow / (period_s * plan->slow_procedure_interval);
+}
+
+float power_policy_cpu_fraction(const power_plan_t *plan)
+{
+  float conn_rate;
+  float proc_rate;
+  float fraction;
+
+  event_rates(plan, &conn_rate, &proc_rate);
+  fraction = (proc_rate * POWER_MODEL_PROCEDURE_CPU_US
+              + conn_rate * POWER_MODEL_CONN_EVENT_CPU_US) * 1e-6f;
+  return (fraction > 1.f) ? 1.f : fraction;
+}
+
+float power_policy_estimate_ua(const power_plan_t *plan)
+{
+  float conn_rate;
+  float proc_rate;
+  float cpu = plan->cpu_fraction;
+  float current;
+
+  event_rates(plan, &conn_rate, &proc_rate);
+  if (cpu < 0.f)
+    cpu = power_policy_cpu_fraction(plan);
+
+  current = POWER_MODEL_EM2_UA + (POWER_MODEL_EM0_UA - POWER_MODEL_EM2_UA) * cpu;
+  current += POWER_MODEL_CONN_EVENT_UC * conn_rate;
+  current += POWER_MODEL_PROCEDURE_UC * proc_rate;
+  current += POWER_MODEL_SCAN_UA * plan->scan_duty;
+  if (plan->heartbeat_ms != 0)
+    current += POWER_MODEL_LED_UA * POWER_MODEL_LED_FLASH_MS / (float)plan->heartbeat_ms;
+  return current;
+}
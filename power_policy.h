@@ -0,0 +1,97 @@
+/*
+ * power_policy.h
+ *
+ * System power level chosen from the reflector tracks and the gate state,
+ * the connection interval, procedure interval and heartbeat of each level,
+ * and a current model estimating the average draw of a level. Free of
+ * platform calls so the host model in host/power_policy_sim.c runs it.
+ */
+
+#ifndef POWER_POLICY_H_
+#define POWER_POLICY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* 0 keeps every level at the active intervals */
+#ifndef POWER_POLICY_ENABLE
+#define POWER_POLICY_ENABLE               1
+#endif
+
+/* All reflectors slow and the gate idle for this long enters the idle level */
+#define POWER_IDLE_ENTER_MS               30000
+
+/* Idle level: connection interval and procedure interval multiples */
+#define POWER_IDLE_CONNECTION_FACTOR      4
+#define POWER_IDLE_PROCEDURE_FACTOR       2
+
+/* Heartbeat LED period of each level, the flash stays 50 ms */
+#define POWER_ACTIVE_HEARTBEAT_MS         10000
+#define POWER_IDLE_HEARTBEAT_MS           30000
+#define POWER_DORMANT_HEARTBEAT_MS        60000
+
+/* Current model of the board, in uA and uC. The defaults are EFR32MG24
+ * datasheet figures at 0 dBm, replace them with bench measurements. */
+#define POWER_MODEL_EM0_UA                2600.f  /* CPU running, 78 MHz */
+#define POWER_MODEL_EM2_UA                3.f     /* Sleep, full RAM retention */
+#define POWER_MODEL_CONN_EVENT_UC         6.f     /* Empty connection event */
+#define POWER_MODEL_PROCEDURE_UC          120.f   /* CS procedure and RAS transfer radio */
+#define POWER_MODEL_PROCEDURE_CPU_US      25000u  /* Estimation, for the model only */
+#define POWER_MODEL_CONN_EVENT_CPU_US     300u    /* Stack, for the model only */
+#define POWER_MODEL_SCAN_UA               4400.f  /* Receiver on, full duty */
+#define POWER_MODEL_LED_UA                2000.f
+#define POWER_MODEL_LED_FLASH_MS          50u
+
+typedef enum
+{
+  POWER_LEVEL_ACTIVE,     /* A reflector is measured fast or the gate is busy */
+  POWER_LEVEL_IDLE,       /* Reflectors connected, all slow, gate closed */
+  POWER_LEVEL_DORMANT,    /* No reflector connected */
+  POWER_LEVEL_COUNT
+} power_level_t;
+
+typedef struct
+{
+  uint8_t reflectors;       /* Connected reflectors */
+  uint8_t fast_reflectors;  /* Reflectors measured at the fast procedure rate */
+  bool red_zone;            /* A reflector stands in the gate */
+  bool gate_idle;           /* Gate closed and relay sequence finished */
+} power_policy_input_t;
+
+/* Operating point of the system, input of the current model */
+typedef struct
+{
+  uint8_t reflectors;
+  uint8_t fast_reflectors;
+  uint16_t connection_interval;  /* 1.25 ms units */
+  uint16_t fast_procedure_interval;  /* Connection events */
+  uint16_t slow_procedure_interval;
+  uint32_t heartbeat_ms;
+  float scan_duty;               /* Scanner window / interval, 0 if not scanning */
+  float cpu_fraction;            /* Measured EM0 share, negative to model it */
+} power_plan_t;
+
+void power_policy_init(uint32_t now_ms);
+
+/* Level for the current state, changes are returned right away */
+power_level_t power_policy_update(const power_policy_input_t *input, uint32_t now_ms);
+
+power_level_t power_policy_level(void);
+
+const char *power_policy_level_name(power_level_t level);
+
+/* Connection interval multiple of a level */
+uint8_t power_policy_connection_factor(power_level_t level);
+
+/* Procedure interval multiple of a level, applied on top of proc_sched */
+uint8_t power_policy_procedure_factor(power_level_t level);
+
+uint32_t power_policy_heartbeat_ms(power_level_t level);
+
+/* EM0 share of the model for an operating point */
+float power_policy_cpu_fraction(const power_plan_t *plan);
+
+/* Average current of an operating point in uA */
+float power_policy_estimate_ua(const power_plan_t *plan);
+
+#endif /* POWER_POLICY_H_ */
@@ -0,0 +1,68 @@
+/*
+ * proc_sched.c
+ *
+ * Procedure rate selection, see proc_sched.h.
+ */
+
+#include <stddef.h>
+#include "alg.h"
+#include "proc_sched.h"
+
+static uint32_t last_motion_ms[CS_INITIATOR_MAX_CONNECTIONS];
+
+void proc_sched_reset(uint8_t index, uint32_t now_ms)
+{
+  if (index >= CS_INITIATOR_MAX_CONNECTIONS)
+    return;
+  last_motion_ms[index] = now_ms;
+}
+
+proc_rate_t proc_sched_update(uint8_t index, const gate_track_t *track, uint32_t now_ms)
+{
+#if PROC_SCHED_ADAPTIVE
+  bool moving;
+
+  if (index >= CS_INITIATOR_MAX_CONNECTIONS || track == NULL || !track->started)
+    return PROC_RATE_FAST;
+
+  /* An approach is never measured at the slow rate */
+  if (track->trend == TRACK_APPROACHING
+      || track->velocity_mm_s <= -PROC_SCHED_MOTION_MM_S)
+  {
+    last_motion_ms[index] = now_ms;
+    return PROC_RATE_FAST;
+  }
+
+  if (track->distance_mm > DISTANCE_OPENING_ZONE)
+    return PROC_RATE_SLOW;
+
+  /* Leaving the red zone must be seen quickly to release the gate */
+  moving = track->red_zone
+           || track->trend == TRACK_LEAVING
+           || track->velocity_mm_s >= PROC_SCHED_MOTION_MM_S;
+  if (moving)
+  {
+    last_motion_ms[index] = now_ms;
+    return PROC_RATE_FAST;
+  }
+
+  if ((now_ms - last_motion_ms[index]) >= PROC_SCHED_STILL_TIMEOUT_MS)
+    return PROC_RATE_SLOW;
+#else
+  (void)index;
+  (void)track;
+  (void)now_ms;
+#endif
+  return PROC_RATE_FAST;
+}
+
+uint16_t proc_sched_interval(proc_rate_t rate, uint16_t fast_interval)
+{
+  uint32_t interval = fast_interval;
+
+  if (rate == PROC_RATE_SLOW)
+    interval *= PROC_SCHED_SLOW_FACTOR;
+  if (interval > UINT16_MAX)
+    interval = UINT16_MAX;
+  return (uint16_t)interval;
+}
@@ -0,0 +1,45 @@
+/*
+ * proc_sched.h
+ *
+ * Chooses the CS procedure rate of each reflector from its gate track:
+ * full rate while it approaches or moves near the gate, a reduced rate
+ * while it stands still or is far beyond the opening zone.
+ */
+
+#ifndef PROC_SCHED_H_
+#define PROC_SCHED_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "gate_arbiter.h"
+
+/* 0 keeps the interval selected at connection time */
+#ifndef PROC_SCHED_ADAPTIVE
+#define PROC_SCHED_ADAPTIVE          1
+#endif
+
+/* The slow procedure interval is this multiple of the fast one */
+#define PROC_SCHED_SLOW_FACTOR       4
+
+/* Below this filter velocity a reflector near the gate counts as still */
+#define PROC_SCHED_MOTION_MM_S       300
+
+/* Without motion for this long a reflector goes to the slow rate */
+#define PROC_SCHED_STILL_TIMEOUT_MS  5000
+
+typedef enum
+{
+  PROC_RATE_FAST,
+  PROC_RATE_SLOW
+} proc_rate_t;
+
+/* Start at the fast rate on (re)connection */
+void proc_sched_reset(uint8_t index, uint32_t now_ms);
+
+/* Rate for the current state of the track */
+proc_rate_t proc_sched_update(uint8_t index, const gate_track_t *track, uint32_t now_ms);
+
+/* Procedure interval for a rate, fast_interval is the optimized one */
+uint16_t proc_sched_interval(proc_rate_t rate, uint16_t fast_interval);
+
+#endif /* PROC_SCHED_H_ */
@@ -0,0 +1,307 @@
+/*
+ * reflector_cache.c
+ *
+ * Reflector attribute cache, see reflector_cache.h.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "reflector_cache.h"
+#include "config/token.h"
+
+#define NO_SLOT     0xff
+#define NO_BONDING  0xff
+
+#define MAX_ANTENNAS  4
+
+typedef struct
+{
+  bool used;
+  uint8_t connection;
+  uint8_t address_type;
+  bd_addr address;
+  uint8_t bonding;
+  uint8_t slot;         /* Entry the connection was set up from */
+  bool pending;         /* No result yet */
+} track_t;
+
+static reflector_cache_entry_t entries[REFLECTOR_CACHE_SLOTS];
+static track_t tracks[CS_INITIATOR_MAX_CONNECTIONS];
+static uint32_t last_stamp;
+
+static const char *check_names[REFLECTOR_CACHE_CHECK_COUNT] = {
+  "ok", "no entry", "no identity", "not bonded", "bad version", "other address",
+  "other bonding", "bad handles", "bad antennas", "bad MTU"
+};
+
+/* Identity address type of an address seen on a connection, or 0xff when
+ * the address is a private one that was not resolved */
+static uint8_t identity_type(uint8_t address_type)
+{
+  switch (address_type)
+  {
+    case sl_bt_gap_public_address:
+    case sl_bt_gap_public_address_resolved_from_rpa:
+      return sl_bt_gap_public_address;
+    case sl_bt_gap_static_address:
+    case sl_bt_gap_static_address_resolved_from_rpa:
+      return sl_bt_gap_static_address;
+    default:
+      return 0xff;
+  }
+}
+
+static bool handle_valid(uint16_t handle)
+{
+  return handle != 0 && handle != CS_RAS_INVALID_CHARACTERISTIC_HANDLE;
+}
+
+/* Mandatory characteristics present, at least one ranging data
+ * characteristic and no handle used twice */
+static bool handles_valid(const cs_ras_gattdb_handles_t *handles)
+{
+  const uint16_t *h = handles->array;
+
+  if (!handle_valid(h[CS_RAS_CHARACTERISTIC_INDEX_RAS_FEATURES])
+      || !handle_valid(h[CS_RAS_CHARACTERISTIC_INDEX_CONTROL_POINT])
+      || !handle_valid(h[CS_RAS_CHARACTERISTIC_INDEX_RANGING_DATA_READY])
+      || !handle_valid(h[CS_RAS_CHARACTERISTIC_INDEX_RANGING_DATA_OVERWRITTEN]))
+    return false;
+  if (!handle_valid(h[CS_RAS_CHARACTERISTIC_INDEX_REAL_TIME_RANGING_DATA])
+      && !handle_valid(h[CS_RAS_CHARACTERISTIC_INDEX_ON_DEMAND_RANGING_DATA]))
+    return false;
+
+  for (int i = 0; i < CS_RAS_CHARACTERISTIC_INDEX_COUNT; i++)
+  {
+    if (!handle_valid(h[i]))
+      continue;
+    for (int j = i + 1; j < CS_RAS_CHARACTERISTIC_INDEX_COUNT; j++)
+    {
+      if (h[i] == h[j])
+        return false;
+    }
+  }
+  return true;
+}
+
+static track_t *find_track(uint8_t connection)
+{
+  for (int i = 0; i < CS_INITIATOR_MAX_CONNECTIONS; i++)
+  {
+    if (tracks[i].used && tracks[i].connection == connection)
+      return &tracks[i];
+  }
+  return NULL;
+}
+
+static uint8_t find_slot(const bd_addr *address, uint8_t address_type)
+{
+  for (uint8_t i = 0; i < REFLECTOR_CACHE_SLOTS; i++)
+  {
+    if (entries[i].version != 0
+        && entries[i].address_type == address_type
+        && memcmp(&entries[i].address, address, sizeof(bd_addr)) == 0)
+      return i;
+  }
+  return NO_SLOT;
+}
+
+/* Same address, else an empty slot, else the least recently saved one */
+static uint8_t free_slot(const bd_addr *address, uint8_t address_type)
+{
+  uint8_t slot = find_slot(address, address_type);
+
+  if (slot != NO_SLOT)
+    return slot;
+  slot = 0;
+  for (uint8_t i = 0; i < REFLECTOR_CACHE_SLOTS; i++)
+  {
+    if (entries[i].version == 0)
+      return i;
+    if ((int32_t)(entries[i].stamp - entries[slot].stamp) < 0)
+      slot = i;
+  }
+  return slot;
+}
+
+static void erase(uint8_t slot)
+{
+  memset(&entries[slot], 0, sizeof(entries[slot]));
+  (void)nvm3_deleteObject(nvm3_defaultHandle, NVM3KEY_REFLECTOR_CACHE(slot));
+}
+
+void reflector_cache_init(void)
+{
+  memset(tracks, 0, sizeof(tracks));
+  last_stamp = 0;
+  for (uint8_t i = 0; i < REFLECTOR_CACHE_SLOTS; i++)
+  {
+    /* A missing or shorter object, e.g. of an older layout, reads as empty */
+    if (nvm3_readData(nvm3_defaultHandle, NVM3KEY_REFLECTOR_CACHE(i),
+                      &entries[i], sizeof(entries[i])) != SL_STATUS_OK)
+      memset(&entries[i], 0, sizeof(entries[i]));
+    else if ((int32_t)(entries[i].stamp - last_stamp) > 0)
+      last_stamp = entries[i].stamp;
+  }
+}
+
+reflector_cache_check_t reflector_cache_check(const reflector_cache_entry_t *entry,
+                                              const bd_addr *address,
+                                              uint8_t address_type,
+                                              uint8_t bonding)
+{
+  uint8_t type = identity_type(address_type);
+
+  if (type == 0xff)
+    return REFLECTOR_CACHE_NO_IDENTITY;
+  if (bonding == NO_BONDING)
+    return REFLECTOR_CACHE_NOT_BONDED;
+  if (entry == NULL || entry->version == 0)
+    return REFLECTOR_CACHE_NO_ENTRY;
+  if (entry->version != REFLECTOR_CACHE_VERSION)
+    return REFLECTOR_CACHE_BAD_VERSION;
+  if (entry->address_type != type || memcmp(&entry->address, address, sizeof(bd_addr)) != 0)
+    return REFLECTOR_CACHE_OTHER_ADDRESS;
+  if (entry->bonding != bonding)
+    return REFLECTOR_CACHE_OTHER_BONDING;
+  if (!handles_valid(&entry->handles))
+    return REFLECTOR_CACHE_BAD_HANDLES;
+  if (entry->num_antennas == 0 || entry->num_antennas > MAX_ANTENNAS)
+    return REFLECTOR_CACHE_BAD_ANTENNAS;
+  if (entry->mtu < ATT_MTU_MIN || entry->mtu > ATT_MTU_MAX)
+    return REFLECTOR_CACHE_BAD_MTU;
+  return REFLECTOR_CACHE_OK;
+}
+
+const char *reflector_cache_check_name(reflector_cache_check_t check)
+{
+  if (check >= REFLECTOR_CACHE_CHECK_COUNT)
+    return "?";
+  return check_names[check];
+}
+
+void reflector_cache_opened(uint8_t connection,
+                            const bd_addr *address,
+                            uint8_t address_type,
+                            uint8_t bonding)
+{
+  track_t *t = find_track(connection);
+
+  for (int i = 0; t == NULL && i < CS_INITIATOR_MAX_CONNECTIONS; i++)
+  {
+    if (!tracks[i].used)
+      t = &tracks[i];
+  }
+  if (t == NULL)
+    return;
+
+  t->used = true;
+  t->connection = connection;
+  t->address_type = address_type;
+  t->address = *address;
+  t->bonding = bonding;
+  t->slot = NO_SLOT;
+  t->pending = true;
+}
+
+void reflector_cache_bonded(uint8_t connection, uint8_t bonding)
+{
+  track_t *t = find_track(connection);
+
+  if (t != NULL)
+    t->bonding = bonding;
+}
+
+void reflector_cache_closed(uint8_t connection)
+{
+  track_t *t = find_track(connection);
+
+  if (t != NULL)
+    t->used = false;
+}
+
+reflector_cache_check_t reflector_cache_lookup(uint8_t connection,
+                                               uint8_t num_antennas,
+                                               reflector_cache_entry_t *entry)
+{
+  track_t *t = find_track(connection);
+  reflector_cache_check_t check;
+  uint8_t slot;
+
+  if (t == NULL)
+    return REFLECTOR_CACHE_NO_ENTRY;
+  t->slot = NO_SLOT;
+
+  slot = find_slot(&t->address, identity_type(t->address_type));
+  check = reflector_cache_check((slot == NO_SLOT) ? NULL : &entries[slot],
+                                &t->address, t->address_type, t->bonding);
+  if (check == REFLECTOR_CACHE_OK && entries[slot].num_antennas != num_antennas)
+    check = REFLECTOR_CACHE_BAD_ANTENNAS;
+
+  /* Without a bonding the entry can still be right, it is only unusable */
+  if (check != REFLECTOR_CACHE_OK
+      && check != REFLECTOR_CACHE_NO_ENTRY
+      && check != REFLECTOR_CACHE_NO_IDENTITY
+      && check != REFLECTOR_CACHE_NOT_BONDED)
+    erase(slot);
+
+  if (check == REFLECTOR_CACHE_OK)
+  {
+    t->slot = slot;
+    *entry = entries[slot];
+  }
+  return check;
+}
+
+bool reflector_cache_pending(uint8_t connection)
+{
+  track_t *t = find_track(connection);
+
+  return t != NULL && t->pending;
+}
+
+sl_status_t reflector_cache_confirm(uint8_t connection, const reflector_cache_entry_t *entry)
+{
+  track_t *t = find_track(connection);
+  reflector_cache_entry_t e = *entry;
+  uint8_t slot;
+  sl_status_t sc;
+
+  if (t == NULL)
+    return SL_STATUS_NOT_FOUND;
+  t->pending = false;
+  e.address_type = identity_type(t->address_type);
+  if (e.address_type == 0xff || t->bonding == NO_BONDING)
+    return SL_STATUS_NOT_SUPPORTED;
+
+  e.version = REFLECTOR_CACHE_VERSION;
+  e.address = t->address;
+  e.bonding = t->bonding;
+  if (reflector_cache_check(&e, &t->address, t->address_type, t->bonding) != REFLECTOR_CACHE_OK)
+    return SL_STATUS_INVALID_PARAMETER;
+
+  slot = free_slot(&e.address, e.address_type);
+  e.stamp = entries[slot].stamp;
+  /* Flash is only written when an attribute changed */
+  if (memcmp(&entries[slot], &e, sizeof(e)) == 0)
+    return SL_STATUS_OK;
+
+  e.stamp = ++last_stamp;
+  sc = nvm3_writeData(nvm3_defaultHandle, NVM3KEY_REFLECTOR_CACHE(slot), &e, sizeof(e));
+  if (sc == SL_STATUS_OK)
+    entries[slot] = e;
+  return sc;
+}
+
+void reflector_cache_reject(uint8_t connection)
+{
+  track_t *t = find_track(connection);
+
+  if (t == NULL || !t->pending)
+    return;
+  t->pending = false;
+  /* The slot may have been given to another reflector meanwhile */
+  if (t->slot != NO_SLOT && t->slot == find_slot(&t->address, identity_type(t->address_type)))
+    erase(t->slot);
+  t->slot = NO_SLOT;
+}
@@ -0,0 +1,101 @@
+/*
+ * reflector_cache.h
+ *
+ * Attributes of bonded reflectors kept in NVM3 across connections: the RAS
+ * characteristic handles and features, the remote antenna count and the
+ * last MTU and intervals. A known reflector reconnects without the GATT
+ * discovery and the RAS features read. Entries are keyed by the identity
+ * address and bound to the bonding they were found under, since a client
+ * may only keep GATT handles of a bonded server. An entry that fails its
+ * checks, or a connection set up from it that fails before its first
+ * result, is dropped and the next connection discovers again.
+ */
+
+#ifndef REFLECTOR_CACHE_H_
+#define REFLECTOR_CACHE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sl_status.h"
+#include "sl_bt_api.h"
+#include "cs_ras_common.h"
+#include "cs_initiator_config.h"
+
+/* 0 keeps the discovery on every connection and does not bond */
+#ifndef REFLECTOR_CACHE_ENABLE
+#define REFLECTOR_CACHE_ENABLE      1
+#endif
+
+/* Reflectors remembered, the least recently saved one is replaced */
+#define REFLECTOR_CACHE_SLOTS       8
+
+/* Bumped on every change of reflector_cache_entry_t */
+#define REFLECTOR_CACHE_VERSION     1
+
+typedef enum
+{
+  REFLECTOR_CACHE_OK,
+  REFLECTOR_CACHE_NO_ENTRY,       /* Reflector not seen yet */
+  REFLECTOR_CACHE_NO_IDENTITY,    /* Unresolved private address */
+  REFLECTOR_CACHE_NOT_BONDED,     /* Connection without bonding */
+  REFLECTOR_CACHE_BAD_VERSION,
+  REFLECTOR_CACHE_OTHER_ADDRESS,
+  REFLECTOR_CACHE_OTHER_BONDING,  /* Bonded again since the entry was saved */
+  REFLECTOR_CACHE_BAD_HANDLES,
+  REFLECTOR_CACHE_BAD_ANTENNAS,   /* Out of range or changed */
+  REFLECTOR_CACHE_BAD_MTU,
+  REFLECTOR_CACHE_CHECK_COUNT
+} reflector_cache_check_t;
+
+typedef struct
+{
+  uint8_t version;
+  uint8_t address_type;             /* Identity address type, public or static */
+  bd_addr address;
+  uint8_t bonding;
+  uint8_t num_antennas;             /* Remote antennas */
+  uint16_t mtu;
+  uint16_t connection_interval;     /* 1.25 ms units */
+  uint16_t procedure_interval;      /* Connection events */
+  cs_ras_features_t ras_features;
+  cs_ras_gattdb_handles_t handles;
+  uint32_t stamp;                   /* Save order */
+} reflector_cache_entry_t;
+
+/* Load the saved entries */
+void reflector_cache_init(void);
+
+/* Validate entry for a connection from address over bonding */
+reflector_cache_check_t reflector_cache_check(const reflector_cache_entry_t *entry,
+                                              const bd_addr *address,
+                                              uint8_t address_type,
+                                              uint8_t bonding);
+
+const char *reflector_cache_check_name(reflector_cache_check_t check);
+
+/* Connection events of the central role */
+void reflector_cache_opened(uint8_t connection,
+                            const bd_addr *address,
+                            uint8_t address_type,
+                            uint8_t bonding);
+void reflector_cache_bonded(uint8_t connection, uint8_t bonding);
+void reflector_cache_closed(uint8_t connection);
+
+/* Entry of the reflector on connection, checked against the antenna count
+ * just read from it. An entry failing the checks is deleted. */
+reflector_cache_check_t reflector_cache_lookup(uint8_t connection,
+                                               uint8_t num_antennas,
+                                               reflector_cache_entry_t *entry);
+
+/* True until the connection is confirmed or rejected */
+bool reflector_cache_pending(uint8_t connection);
+
+/* The connection delivered a result with these attributes: save them if
+ * they changed. Address, bonding, version and stamp are filled in. */
+sl_status_t reflector_cache_confirm(uint8_t connection, const reflector_cache_entry_t *entry);
+
+/* The connection failed before its first result: if it was set up from the
+ * cache, the entry is deleted */
+void reflector_cache_reject(uint8_t connection);
+
+#endif /* REFLECTOR_CACHE_H_ */
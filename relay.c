@@ -0,0 +1,224 @@
+/*
+ * relay.c
+ *
+ * Gate relay driver, see relay.h.
+ */
+
+#include <stddef.h>
+#include "em_core.h"
+#include "sl_sleeptimer.h"
+#include "dlog.h"
+#include "relay.h"
+
+typedef struct
+{
+  relay_command_t cmd;
+  uint32_t block_ms;
+} relay_request_t;
+
+static relay_config_t cfg;
+static sl_sleeptimer_timer_handle_t timer;
+
+/* Ring of pending commands, shared with the timer callback */
+static relay_request_t queue[RELAY_QUEUE_SIZE];
+static uint8_t head;
+static uint8_t count;
+
+static relay_request_t running;
+static relay_command_t last = RELAY_CMD_NONE;
+static volatile relay_phase_t phase = RELAY_PHASE_IDLE;
+
+/* Absolute tick the current step ends at */
+static uint32_t deadline;
+
+static void on_timer(sl_sleeptimer_timer_handle_t *handle, void *data);
+
+static uint32_t ms_to_tick(uint32_t ms)
+{
+  return (uint32_t)(((uint64_t)ms * sl_sleeptimer_get_timer_frequency()) / 1000u);
+}
+
+/* Arm the timer for the step ending delay ticks after the previous one. The
+ * deadlines are absolute, so the latency of one step does not delay the
+ * next one */
+static void schedule(uint32_t delay)
+{
+  int32_t remaining;
+
+  deadline += delay;
+  remaining = (int32_t)(deadline - sl_sleeptimer_get_tick_count());
+  if (remaining < 1)
+    remaining = 1;
+  (void)sl_sleeptimer_start_timer(&timer, (uint32_t)remaining, on_timer, NULL, 0, 0);
+}
+
+static void set_phase(relay_phase_t p)
+{
+  phase = p;
+  dlog_write(DLOG_RELAY_STATE, p, running.cmd);
+}
+
+static void drive(relay_command_t cmd, bool level)
+{
+  GPIO_Port_TypeDef port = (cmd == RELAY_CMD_OPEN) ? cfg.open_port : cfg.close_port;
+  uint8_t pin = (cmd == RELAY_CMD_OPEN) ? cfg.open_pin : cfg.close_pin;
+
+  if (level)
+    GPIO_PinOutSet(port, pin);
+  else
+    GPIO_PinOutClear(port, pin);
+}
+
+/* Target once every running and queued command is done, queue locked */
+static relay_command_t target(void)
+{
+  if (count != 0)
+    return queue[(head + count - 1u) % RELAY_QUEUE_SIZE].cmd;
+  if (phase == RELAY_PHASE_LEAD || phase == RELAY_PHASE_PULSE || phase == RELAY_PHASE_BLOCK)
+    return running.cmd;
+  return last;
+}
+
+/* Start the next queued command, queue locked */
+static void start_next(void)
+{
+  if (count == 0)
+  {
+    phase = RELAY_PHASE_IDLE;
+    return;
+  }
+
+  if (cfg.hold != NULL && cfg.hold(queue[head].cmd))
+  {
+    /* The command stays queued, a newer decision can still replace it */
+    phase = RELAY_PHASE_HOLD;
+    schedule(ms_to_tick(cfg.step_ms));
+    return;
+  }
+
+  running = queue[head];
+  head = (head + 1u) % RELAY_QUEUE_SIZE;
+  count--;
+
+  GPIO_PinOutSet(cfg.led_port, cfg.led_pin);
+  set_phase(RELAY_PHASE_LEAD);
+  schedule(ms_to_tick(cfg.step_ms));
+}
+
+static void on_timer(sl_sleeptimer_timer_handle_t *handle, void *data)
+{
+  CORE_irqState_t irqState;
+
+  (void)handle;
+  (void)data;
+
+  irqState = CORE_EnterAtomic();
+  switch (phase)
+  {
+    case RELAY_PHASE_LEAD:
+      drive(running.cmd, true);
+      set_phase(RELAY_PHASE_PULSE);
+      schedule(ms_to_tick(cfg.step_ms));
+      break;
+    case RELAY_PHASE_PULSE:
+      drive(running.cmd, false);
+      /* After opening or closing the gate we wait before a new action */
+      set_phase(RELAY_PHASE_BLOCK);
+      schedule(ms_to_tick(running.block_ms));
+      break;
+    case RELAY_PHASE_BLOCK:
+      GPIO_PinOutClear(cfg.led_port, cfg.led_pin);
+      last = running.cmd;
+      set_phase(RELAY_PHASE_IDLE);
+      start_next();
+      break;
+    case RELAY_PHASE_HOLD:
+      start_next();
+      break;
+    default:
+      break;
+  }
+  CORE_ExitAtomic(irqState);
+}
+
+void relay_init(const relay_config_t *config)
+{
+  cfg = *config;
+  head = 0;
+  count = 0;
+  last = RELAY_CMD_NONE;
+  phase = RELAY_PHASE_IDLE;
+
+  GPIO_PinModeSet(cfg.open_port, cfg.open_pin, gpioModePushPull, 0);
+  GPIO_PinModeSet(cfg.close_port, cfg.close_pin, gpioModePushPull, 0);
+  GPIO_PinModeSet(cfg.led_port, cfg.led_pin, gpioModePushPull, 0);
+}
+
+void relay_set_step(uint32_t step_ms)
+{
+  CORE_irqState_t irqState;
+
+  irqState = CORE_EnterAtomic();
+  cfg.step_ms = step_ms;
+  CORE_ExitAtomic(irqState);
+}
+
+sl_status_t relay_submit(relay_command_t cmd, uint32_t block_ms)
+{
+  sl_status_t sc = SL_STATUS_OK;
+  CORE_irqState_t irqState;
+
+  irqState = CORE_EnterAtomic();
+  /* The newest decision replaces a pending one, e.g. a close drops an open
+   * that has not started yet */
+  if (count != 0 && target() != cmd)
+    count--;
+
+  /* Nothing to do when cmd is already the target, e.g. open while opening */
+  if (target() != cmd)
+  {
+    if (count == RELAY_QUEUE_SIZE)
+    {
+      sc = SL_STATUS_FULL;
+    }
+    else
+    {
+      queue[(head + count) % RELAY_QUEUE_SIZE].cmd = cmd;
+      queue[(head + count) % RELAY_QUEUE_SIZE].block_ms = block_ms;
+      count++;
+      if (phase == RELAY_PHASE_IDLE)
+      {
+        deadline = sl_sleeptimer_get_tick_count();
+        start_next();
+      }
+    }
+  }
+  CORE_ExitAtomic(irqState);
+  return sc;
+}
+
+relay_command_t relay_target(void)
+{
+  relay_command_t cmd;
+  CORE_irqState_t irqState;
+
+  irqState = CORE_EnterAtomic();
+  cmd = target();
+  CORE_ExitAtomic(irqState);
+  return cmd;
+}
+
+bool relay_busy(void)
+{
+  return phase != RELAY_PHASE_IDLE;
+}
+
+relay_phase_t relay_phase(void)
+{
+  return phase;
+}
+
+uint8_t relay_pending(void)
+{
+  return count;
+}
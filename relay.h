@@ -0,0 +1,77 @@
+/*
+ * relay.h
+ *
+ * Gate relay driver. Every command is one pulse on the open or the close
+ * relay followed by a block delay, with the status LED on for the whole
+ * sequence. Commands are queued and run one after the other from a single
+ * sleeptimer, the newest decision wins over a pending one and a command
+ * that repeats the current target is dropped, so no decision is lost
+ * while a sequence is running.
+ */
+
+#ifndef RELAY_H_
+#define RELAY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sl_status.h"
+#include "em_gpio.h"
+
+/* Pending commands, coalescing keeps at most one of them in practice */
+#define RELAY_QUEUE_SIZE  4
+
+typedef enum
+{
+  RELAY_CMD_CLOSE,
+  RELAY_CMD_OPEN,
+  RELAY_CMD_NONE
+} relay_command_t;
+
+typedef enum
+{
+  RELAY_PHASE_IDLE,
+  RELAY_PHASE_LEAD,     /* LED on, relay low */
+  RELAY_PHASE_PULSE,    /* Relay high */
+  RELAY_PHASE_BLOCK,    /* Relay low, gate moving */
+  RELAY_PHASE_HOLD      /* Next command postponed by the hold callback */
+} relay_phase_t;
+
+/* Returns true to postpone the start of cmd by one step */
+typedef bool (*relay_hold_t)(relay_command_t cmd);
+
+typedef struct
+{
+  GPIO_Port_TypeDef open_port;
+  uint8_t open_pin;
+  GPIO_Port_TypeDef close_port;
+  uint8_t close_pin;
+  GPIO_Port_TypeDef led_port;
+  uint8_t led_pin;
+  uint32_t step_ms;     /* Lead and pulse length */
+  relay_hold_t hold;    /* Optional */
+} relay_config_t;
+
+/* Configure the pins once, they are only driven afterwards */
+void relay_init(const relay_config_t *config);
+
+/* Lead and pulse length from the next step on */
+void relay_set_step(uint32_t step_ms);
+
+/* Queue cmd, block_ms is the wait after its pulse. Returns SL_STATUS_OK
+ * when the command is queued or already the target, SL_STATUS_FULL if the
+ * queue overflows */
+sl_status_t relay_submit(relay_command_t cmd, uint32_t block_ms);
+
+/* Gate position once the running and queued commands are done, or the
+ * last command when idle, RELAY_CMD_NONE before the first one */
+relay_command_t relay_target(void);
+
+/* A sequence is running or queued, safe from interrupt context */
+bool relay_busy(void);
+
+relay_phase_t relay_phase(void);
+
+/* Queued commands, not counting the running one */
+uint8_t relay_pending(void);
+
+#endif /* RELAY_H_ */
@@ -74,6 +74,8 @@ sl_status_t ble_peer_manager_central_set_scanner(sl_bt_gap_phy_coding_t scanning
  * event is received, and the connection handle is the same as
  * in the sl_bt_connection_open() function, the Peer Manager will stop the
  * scanner and save the connection.
+ * With BLE_PEER_MANAGER_CENTRAL_CONFIG_SCAN_AGGREGATION_MS set, matching
+ * peers are ranked for that time and the best one is connected.
  *
  * @retval SL_STATUS_OK if successful otherwise error code.
  *****************************************************************************/
@@ -100,5 +102,18 @@ sl_status_t ble_peer_manager_central_open_connection(bd_addr *address,
  * @retval SL_STATUS_NOT_FOUND if the connection handle is not found.
  *****************************************************************************/
 sl_status_t ble_peer_manager_central_close_connection(uint8_t conn_handle);
+
+/**************************************************************************//**
+ * Number of further central connections the application can take.
+ *
+ * At the end of a scan aggregation window the best ranked peer is only
+ * connected if this is not 0, otherwise scanning stops. The default allows
+ * up to BLE_PEER_MANAGER_COMMON_MAX_ALLOWED_CONN_COUNT connections.
+ * Weak function, override it in the application.
+ *
+ * @return Number of free connection slots.
+ *****************************************************************************/
+uint8_t ble_peer_manager_central_free_slots(void);
+
 /** @} (end addtogroup ble_peer_manager_central) */
 #endif // BLE_PEER_MANAGER_CENTRAL_H
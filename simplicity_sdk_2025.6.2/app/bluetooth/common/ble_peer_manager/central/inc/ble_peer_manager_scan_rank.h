@@ -0,0 +1,132 @@
+/***************************************************************************//**
+ * @file
+ * @brief Bluetooth Peer Manager - scan report ranking
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2025 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+#ifndef BLE_PEER_MANAGER_SCAN_RANK_H
+#define BLE_PEER_MANAGER_SCAN_RANK_H
+
+/***********************************************************************************************//**
+ * @addtogroup ble_peer_manager_central
+ * @{
+ **************************************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sl_status.h"
+#include "sl_bt_api.h"
+
+/// Candidate collected from the matching scan reports of one peer.
+/// The RSSI trend is an exponentially weighted least squares line; its sums
+/// are taken with the time in seconds relative to the last report.
+typedef struct {
+  bd_addr address;
+  uint8_t address_type;
+  uint8_t reports;     // Saturates at 255
+  uint32_t last_ms;    // Time of the last report
+  float sw;            // Sum of weights
+  float st;            // Weighted sum of time
+  float sr;            // Weighted sum of RSSI
+  float stt;           // Weighted sum of time squared
+  float str;           // Weighted sum of time x RSSI
+  float srr;           // Weighted sum of RSSI squared
+} ble_peer_manager_scan_candidate_t;
+
+/**************************************************************************//**
+ * Drop all candidates.
+ *****************************************************************************/
+void ble_peer_manager_scan_rank_reset(void);
+
+/**************************************************************************//**
+ * Add a matching scan report.
+ *
+ * A new peer takes a free entry. With the table full it replaces the
+ * candidate with the lowest score, if the report is stronger than that score.
+ *
+ * @param[in] address Address of the peer
+ * @param[in] address_type Address type of the peer
+ * @param[in] rssi RSSI of the report
+ * @param[in] time_ms Time of the report, not decreasing between calls
+ *
+ * @retval true if the report was kept
+ *****************************************************************************/
+bool ble_peer_manager_scan_rank_add(const bd_addr *address,
+                                    uint8_t address_type,
+                                    int8_t rssi,
+                                    uint32_t time_ms);
+
+/**************************************************************************//**
+ * Drop the candidates without a report since the given time.
+ *
+ * @param[in] since_ms Oldest report time kept
+ *****************************************************************************/
+void ble_peer_manager_scan_rank_expire(uint32_t since_ms);
+
+/**************************************************************************//**
+ * Number of candidates.
+ *****************************************************************************/
+uint8_t ble_peer_manager_scan_rank_count(void);
+
+/**************************************************************************//**
+ * Smoothed RSSI and RSSI slope of a candidate at its last report.
+ *
+ * The slope is 0 until the reports are enough and spread enough in time
+ * to fit a line, and it is limited to
+ * BLE_PEER_MANAGER_CENTRAL_CONFIG_MAX_RSSI_SLOPE.
+ *
+ * @param[in] candidate Candidate
+ * @param[out] rssi Smoothed RSSI in dBm
+ * @param[out] slope RSSI slope in dB/s, positive when approaching
+ *****************************************************************************/
+void ble_peer_manager_scan_rank_estimate(const ble_peer_manager_scan_candidate_t *candidate,
+                                         float *rssi,
+                                         float *slope);
+
+/**************************************************************************//**
+ * Ranking score of a candidate: the RSSI predicted
+ * BLE_PEER_MANAGER_CENTRAL_CONFIG_APPROACH_HORIZON_MS ahead of the given time.
+ *
+ * @param[in] candidate Candidate
+ * @param[in] time_ms Current time
+ *****************************************************************************/
+float ble_peer_manager_scan_rank_score(const ble_peer_manager_scan_candidate_t *candidate,
+                                       uint32_t time_ms);
+
+/**************************************************************************//**
+ * Remove the candidate with the highest score.
+ *
+ * @param[in] time_ms Current time
+ * @param[out] candidate Candidate removed
+ *
+ * @retval SL_STATUS_OK if a candidate was removed
+ * @retval SL_STATUS_EMPTY if there is no candidate
+ *****************************************************************************/
+sl_status_t ble_peer_manager_scan_rank_take_best(uint32_t time_ms,
+                                                 ble_peer_manager_scan_candidate_t *candidate);
+
+/** @} (end addtogroup ble_peer_manager_central) */
+#endif // BLE_PEER_MANAGER_SCAN_RANK_H
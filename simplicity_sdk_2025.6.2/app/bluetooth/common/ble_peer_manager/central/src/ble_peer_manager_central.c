@@ -29,6 +29,8 @@
  ******************************************************************************/
 #include "sl_bt_api.h"
 #include "app_timer.h"
+#include "sl_common.h"
+#include "sl_sleeptimer.h"
 #include "sl_component_catalog.h"
 #include "ble_peer_manager_central.h"
 #include "ble_peer_manager_central_internal.h"
@@ -38,6 +40,7 @@
 #include "ble_peer_manager_common_internal.h"
 #include "ble_peer_manager_filter.h"
 #include "ble_peer_manager_connections.h"
+#include "ble_peer_manager_scan_rank.h"
 
 // -----------------------------------------------------------------------------
 // Macros and Typedefs
@@ -54,6 +57,10 @@ typedef struct ble_peer_manager_scanner_s {
 static ble_peer_manager_state_id get_state(void);
 static void set_state(ble_peer_manager_state_id new_state);
 static void on_connection_timeout(app_timer_t *timer, void *data);
+#if BLE_PEER_MANAGER_CENTRAL_CONFIG_SCAN_AGGREGATION_MS > 0
+static void on_aggregation_timeout(app_timer_t *timer, void *data);
+static uint32_t get_aggregation_time_ms(void);
+#endif // BLE_PEER_MANAGER_CENTRAL_CONFIG_SCAN_AGGREGATION_MS > 0
 static sl_status_t process_scan_response(bd_addr *address,
                                          sl_bt_gap_address_type_t address_type,
                                          int8_t rssi,
@@ -65,6 +72,11 @@ static ble_peer_manager_scanner_t scanner;
 static uint8_t central_active_conn_handle;
 static app_timer_t timer;
 static ble_peer_manager_state_id state;
+static app_timer_t aggregation_timer;
+static bool aggregation_running;
+#if BLE_PEER_MANAGER_CENTRAL_CONFIG_SCAN_AGGREGATION_MS > 0
+static uint32_t aggregation_origin_tick;
+#endif // BLE_PEER_MANAGER_CENTRAL_CONFIG_SCAN_AGGREGATION_MS > 0
 
 // -----------------------------------------------------------------------------
 // Public functions
@@ -77,6 +89,9 @@ void ble_peer_manager_central_init()
   scanner.scan_interval = BLE_PEER_MANAGER_CENTRAL_CONFIG_DEFAULT_SCAN_INTERVAL;
   scanner.scan_window = BLE_PEER_MANAGER_CENTRAL_CONFIG_DEFAULT_SCAN_WINDOW;
   ble_peer_manager_reset_filter();
+  app_timer_stop(&aggregation_timer);
+  aggregation_running = false;
+  ble_peer_manager_scan_rank_reset();
   set_state(BLE_PEER_MANAGER_STATE_IDLE);
   ble_peer_manager_clear_all_connections();
 }
@@ -259,6 +274,16 @@ sl_status_t ble_peer_manager_central_close_connection(uint8_t conn_handle)
   return sc;
 }
 
+SL_WEAK uint8_t ble_peer_manager_central_free_slots(void)
+{
+  uint8_t active = ble_peer_manager_get_active_conn_number();
+
+  if (active >= BLE_PEER_MANAGER_COMMON_MAX_ALLOWED_CONN_COUNT) {
+    return 0;
+  }
+  return BLE_PEER_MANAGER_COMMON_MAX_ALLOWED_CONN_COUNT - active;
+}
+
 bool ble_peer_manager_is_filter_set_allowed()
 {
   if (get_state() == BLE_PEER_MANAGER_SCANNING) {
@@ -321,6 +346,26 @@ sl_status_t process_scan_response(bd_addr *address,
     return SL_STATUS_ALREADY_EXISTS;
   }
 
+#if BLE_PEER_MANAGER_CENTRAL_CONFIG_SCAN_AGGREGATION_MS > 0
+  // Rank the match, the best peer is connected at the end of the window
+  if (ble_peer_manager_scan_rank_count() == 0) {
+    aggregation_origin_tick = sl_sleeptimer_get_tick_count();
+  }
+  (void)ble_peer_manager_scan_rank_add(address, address_type, rssi, get_aggregation_time_ms());
+  if (!aggregation_running) {
+    sc = app_timer_start(&aggregation_timer,
+                         BLE_PEER_MANAGER_CENTRAL_CONFIG_SCAN_AGGREGATION_MS,
+                         on_aggregation_timeout,
+                         NULL,
+                         false);
+    if (sc != SL_STATUS_OK) {
+      return sc;
+    }
+    aggregation_running = true;
+  }
+  return SL_STATUS_OK;
+#else
+  (void)rssi;
   // If there was a match or there is no filtering active,
   // open connection as central
   ble_peer_manager_log_info("Opening connection as central to '%02x:%02x:%02x:%02x:%02x:%02x'" APP_LOG_NL,
@@ -332,4 +377,74 @@ sl_status_t process_scan_response(bd_addr *address,
                             address->addr[0]);
   sc = ble_peer_manager_central_open_connection(address, address_type);
   return sc;
+#endif // BLE_PEER_MANAGER_CENTRAL_CONFIG_SCAN_AGGREGATION_MS > 0
+}
+
+#if BLE_PEER_MANAGER_CENTRAL_CONFIG_SCAN_AGGREGATION_MS > 0
+// Time since the first report still in the ranking
+static uint32_t get_aggregation_time_ms(void)
+{
+  return sl_sleeptimer_tick_to_ms(sl_sleeptimer_get_tick_count() - aggregation_origin_tick);
+}
+
+// End of the scan aggregation window
+static void on_aggregation_timeout(app_timer_t *timer, void *data)
+{
+  (void)timer;
+  (void)data;
+  ble_peer_manager_scan_candidate_t candidate;
+  ble_peer_manager_evt_type_t peer_evt;
+  uint32_t now_ms;
+  float rssi;
+  float slope;
+  sl_status_t sc;
+
+  aggregation_running = false;
+  if (get_state() != BLE_PEER_MANAGER_SCANNING) {
+    return;
+  }
+
+  // Peers not heard during the whole window have left
+  now_ms = get_aggregation_time_ms();
+  if (now_ms > BLE_PEER_MANAGER_CENTRAL_CONFIG_SCAN_AGGREGATION_MS) {
+    ble_peer_manager_scan_rank_expire(now_ms - BLE_PEER_MANAGER_CENTRAL_CONFIG_SCAN_AGGREGATION_MS);
+  }
+
+  if (ble_peer_manager_central_free_slots() == 0) {
+    ble_peer_manager_log_info("No free connection slot, scanning stopped" APP_LOG_NL);
+    (void)sl_bt_scanner_stop();
+    ble_peer_manager_scan_rank_reset();
+    set_state(BLE_PEER_MANAGER_STATE_IDLE);
+    return;
+  }
+
+  // Best ranked peer first. The others stay ranked for the next window.
+  while (ble_peer_manager_scan_rank_take_best(now_ms, &candidate) == SL_STATUS_OK) {
+    if (ble_peer_manager_is_bt_address_already_connected(&candidate.address)) {
+      continue;
+    }
+    ble_peer_manager_scan_rank_estimate(&candidate, &rssi, &slope);
+    ble_peer_manager_log_info("Opening connection as central to '%02x:%02x:%02x:%02x:%02x:%02x', "
+                              "RSSI %d dBm, trend %d dB/s, %u reports, %u more candidates" APP_LOG_NL,
+                              candidate.address.addr[5],
+                              candidate.address.addr[4],
+                              candidate.address.addr[3],
+                              candidate.address.addr[2],
+                              candidate.address.addr[1],
+                              candidate.address.addr[0],
+                              (int)rssi,
+                              (int)slope,
+                              candidate.reports,
+                              ble_peer_manager_scan_rank_count());
+    sc = ble_peer_manager_central_open_connection(&candidate.address, candidate.address_type);
+    if (sc == SL_STATUS_OK) {
+      return;
+    }
+    ble_peer_manager_log_error("Failed to open connection, error: 0x%lx" APP_LOG_NL, (unsigned long)sc);
+    peer_evt.evt_id = BLE_PEER_MANAGER_ERROR;
+    peer_evt.connection_id = SL_BT_INVALID_CONNECTION_HANDLE;
+    ble_peer_manager_on_event(&peer_evt);
+    return;
+  }
 }
+#endif // BLE_PEER_MANAGER_CENTRAL_CONFIG_SCAN_AGGREGATION_MS > 0
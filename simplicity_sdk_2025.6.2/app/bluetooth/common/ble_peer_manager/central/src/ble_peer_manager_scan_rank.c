@@ -0,0 +1,242 @@
+/***************************************************************************//**
+ * @file
+ * @brief Bluetooth Peer Manager - scan report ranking
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2025 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+#include <string.h>
+#include <math.h>
+#include "ble_peer_manager_scan_rank.h"
+#include "ble_peer_manager_central_config.h"
+
+// -----------------------------------------------------------------------------
+// Definitions
+
+// Reports needed before the RSSI slope is used
+#define MIN_SLOPE_REPORTS   3
+// Least spread of the report times, as weighted variance in s^2, before
+// the RSSI slope is used. 0.15 s standard deviation.
+#define MIN_SLOPE_SPREAD    (0.15f * 0.15f)
+// Spread of the RSSI slopes of walking peers, dB/s. Slopes that the
+// noise of the reports could explain are scaled down toward 0 by
+// SLOPE_SPREAD^2 / (SLOPE_SPREAD^2 + slope variance).
+#define SLOPE_SPREAD        2.0f
+// Time constant of the weighting, at least 100 ms
+#if BLE_PEER_MANAGER_CENTRAL_CONFIG_SCAN_AGGREGATION_MS > 100
+#define WEIGHT_TIME_CONSTANT_S ((float)BLE_PEER_MANAGER_CENTRAL_CONFIG_SCAN_AGGREGATION_MS / 1000.0f)
+#else
+#define WEIGHT_TIME_CONSTANT_S 0.1f
+#endif
+
+// -----------------------------------------------------------------------------
+// Forward declaration of private functions
+static ble_peer_manager_scan_candidate_t *find_candidate(const bd_addr *address,
+                                                         uint8_t address_type);
+static uint8_t find_lowest(uint32_t time_ms);
+static void remove_candidate(uint8_t index);
+
+// -----------------------------------------------------------------------------
+// Static variables
+static ble_peer_manager_scan_candidate_t candidates[BLE_PEER_MANAGER_CENTRAL_CONFIG_MAX_CANDIDATES];
+static uint8_t candidate_count;
+
+// -----------------------------------------------------------------------------
+// Public functions
+void ble_peer_manager_scan_rank_reset(void)
+{
+  memset(candidates, 0, sizeof(candidates));
+  candidate_count = 0;
+}
+
+bool ble_peer_manager_scan_rank_add(const bd_addr *address,
+                                    uint8_t address_type,
+                                    int8_t rssi,
+                                    uint32_t time_ms)
+{
+  ble_peer_manager_scan_candidate_t *c = find_candidate(address, address_type);
+
+  if (c == NULL) {
+    if (candidate_count < BLE_PEER_MANAGER_CENTRAL_CONFIG_MAX_CANDIDATES) {
+      c = &candidates[candidate_count++];
+    } else {
+      uint8_t lowest = find_lowest(time_ms);
+      if ((float)rssi <= ble_peer_manager_scan_rank_score(&candidates[lowest], time_ms)) {
+        return false;
+      }
+      c = &candidates[lowest];
+    }
+    memset(c, 0, sizeof(*c));
+    memcpy(&c->address, address, sizeof(bd_addr));
+    c->address_type = address_type;
+  } else {
+    // Move the time origin to the new report, then age the old reports
+    float dt = (float)(time_ms - c->last_ms) / 1000.0f;
+    float w = expf(-dt / WEIGHT_TIME_CONSTANT_S);
+    c->stt = w * (c->stt - 2.0f * dt * c->st + c->sw * dt * dt);
+    c->str = w * (c->str - dt * c->sr);
+    c->srr = w * c->srr;
+    c->st = w * (c->st - c->sw * dt);
+    c->sr = w * c->sr;
+    c->sw = w * c->sw;
+  }
+
+  // The new report is at time 0
+  c->sw += 1.0f;
+  c->sr += (float)rssi;
+  c->srr += (float)rssi * (float)rssi;
+  if (c->reports < UINT8_MAX) {
+    c->reports++;
+  }
+  c->last_ms = time_ms;
+  return true;
+}
+
+void ble_peer_manager_scan_rank_expire(uint32_t since_ms)
+{
+  uint8_t i = 0;
+
+  while (i < candidate_count) {
+    if ((int32_t)(candidates[i].last_ms - since_ms) < 0) {
+      remove_candidate(i);
+    } else {
+      i++;
+    }
+  }
+}
+
+uint8_t ble_peer_manager_scan_rank_count(void)
+{
+  return candidate_count;
+}
+
+void ble_peer_manager_scan_rank_estimate(const ble_peer_manager_scan_candidate_t *candidate,
+                                         float *rssi,
+                                         float *slope)
+{
+  float mean_t = candidate->st / candidate->sw;
+  float mean_r = candidate->sr / candidate->sw;
+  float var_t = candidate->stt / candidate->sw - mean_t * mean_t;
+  float b = 0.0f;
+
+  if (candidate->reports >= MIN_SLOPE_REPORTS && var_t >= MIN_SLOPE_SPREAD) {
+    float a;
+    float residual;
+    float slope_var;
+
+    b = (candidate->str / candidate->sw - mean_t * mean_r) / var_t;
+    // Weighted mean square of the residuals, then the slope variance
+    a = mean_r - b * mean_t;
+    residual = (candidate->srr - 2.0f * a * candidate->sr - 2.0f * b * candidate->str
+                + a * a * candidate->sw + 2.0f * a * b * candidate->st
+                + b * b * candidate->stt) / candidate->sw;
+    if (residual < 0.0f) {
+      residual = 0.0f;
+    }
+    slope_var = residual / (candidate->sw * var_t);
+    b *= (SLOPE_SPREAD * SLOPE_SPREAD) / (SLOPE_SPREAD * SLOPE_SPREAD + slope_var);
+    if (b > (float)BLE_PEER_MANAGER_CENTRAL_CONFIG_MAX_RSSI_SLOPE) {
+      b = (float)BLE_PEER_MANAGER_CENTRAL_CONFIG_MAX_RSSI_SLOPE;
+    } else if (b < -(float)BLE_PEER_MANAGER_CENTRAL_CONFIG_MAX_RSSI_SLOPE) {
+      b = -(float)BLE_PEER_MANAGER_CENTRAL_CONFIG_MAX_RSSI_SLOPE;
+    }
+  }
+  // Value of the line at the last report
+  *rssi = mean_r - b * mean_t;
+  *slope = b;
+}
+
+float ble_peer_manager_scan_rank_score(const ble_peer_manager_scan_candidate_t *candidate,
+                                       uint32_t time_ms)
+{
+  float rssi;
+  float slope;
+  float ahead_s = (float)(time_ms - candidate->last_ms
+                          + BLE_PEER_MANAGER_CENTRAL_CONFIG_APPROACH_HORIZON_MS) / 1000.0f;
+
+  ble_peer_manager_scan_rank_estimate(candidate, &rssi, &slope);
+  return rssi + slope * ahead_s;
+}
+
+sl_status_t ble_peer_manager_scan_rank_take_best(uint32_t time_ms,
+                                                 ble_peer_manager_scan_candidate_t *candidate)
+{
+  uint8_t best = 0;
+  float best_score;
+
+  if (candidate_count == 0) {
+    return SL_STATUS_EMPTY;
+  }
+  best_score = ble_peer_manager_scan_rank_score(&candidates[0], time_ms);
+  for (uint8_t i = 1; i < candidate_count; i++) {
+    float score = ble_peer_manager_scan_rank_score(&candidates[i], time_ms);
+    if (score > best_score) {
+      best = i;
+      best_score = score;
+    }
+  }
+  *candidate = candidates[best];
+  remove_candidate(best);
+  return SL_STATUS_OK;
+}
+
+// -----------------------------------------------------------------------------
+// Private functions
+static ble_peer_manager_scan_candidate_t *find_candidate(const bd_addr *address,
+                                                         uint8_t address_type)
+{
+  for (uint8_t i = 0; i < candidate_count; i++) {
+    if (candidates[i].address_type == address_type
+        && memcmp(&candidates[i].address, address, sizeof(bd_addr)) == 0) {
+      return &candidates[i];
+    }
+  }
+  return NULL;
+}
+
+static uint8_t find_lowest(uint32_t time_ms)
+{
+  uint8_t lowest = 0;
+  float lowest_score = ble_peer_manager_scan_rank_score(&candidates[0], time_ms);
+
+  for (uint8_t i = 1; i < candidate_count; i++) {
+    float score = ble_peer_manager_scan_rank_score(&candidates[i], time_ms);
+    if (score < lowest_score) {
+      lowest = i;
+      lowest_score = score;
+    }
+  }
+  return lowest;
+}
+
+// Order does not matter, the last candidate takes the free entry
+static void remove_candidate(uint8_t index)
+{
+  candidate_count--;
+  if (index != candidate_count) {
+    candidates[index] = candidates[candidate_count];
+  }
+  memset(&candidates[candidate_count], 0, sizeof(candidates[candidate_count]));
+}
@@ -52,6 +52,7 @@
 #define FILTER_CLEARED                              0x00
 #define INVALID_ADDRESS_TYPE                        0xFE
 #define MAX_NUMBER_OF_ADDRESS_FILTERS               10
+#define AD_HEADER_SIZE                              2
 #if defined(SL_CATALOG_APP_LOG_PRESENT) && BLE_PEER_MANAGER_FILTER_LOG
 #define ble_peer_manager_filter_log_debug(...)           app_log_debug(__VA_ARGS__)
 #define ble_peer_manager_filter_log_info(...)            app_log_info(__VA_ARGS__)
@@ -98,9 +99,51 @@ typedef struct ble_peer_manager_filter_s {
   uint8_t manufacturer_data_len;
 } ble_peer_manager_filter_t;
 
+// Checks of the match program on the AD elements
+typedef enum {
+  CHECK_NAME,
+  CHECK_SERVICE_UUID16,
+  CHECK_SERVICE_UUID128,
+  CHECK_SERVICE_DATA,
+  CHECK_MANUFACTURER_DATA,
+  CHECK_COUNT
+} filter_check_t;
+
+// Match program compiled from the active filter: the AD types to look at,
+// the checks that decide the match and the allow-list with its hash bitmap.
+// The AD elements are walked once, elements of other types are skipped with
+// one bitmap lookup and the walk ends as soon as the outcome is known.
+typedef struct {
+  bool valid;
+  uint8_t ad_types[32];           // Bitmap of the AD types to check
+  uint8_t find_mask;              // Checks passing on one matching element
+  uint8_t all_mask;               // Checks failing on one mismatching element
+  uint16_t min_len;               // Shortest advertising data that can match
+  uint16_t service_uuid16;        // Little endian value of the UUID16 filter
+  uint8_t address_hash[32];       // Bitmap of the allowed address hashes
+  uint8_t address_count;
+  bd_addr address[MAX_NUMBER_OF_ADDRESS_FILTERS];
+} filter_program_t;
+
 // -----------------------------------------------------------------------------
 // Static variables
 static ble_peer_manager_filter_t active_filter;
+static filter_program_t program;
+
+#if BLE_PEER_MANAGER_FILTER_COMPILED
+// -----------------------------------------------------------------------------
+// Private function declarations
+static void compile_filter(void);
+static void enable_check(filter_check_t check, uint8_t ad_type, uint8_t min_len);
+static filter_check_t check_for_type(uint8_t ad_type);
+static uint8_t address_hash(const bd_addr *address);
+static bool address_allowed(const bd_addr *address);
+static bool run_check(filter_check_t check, const uint8_t *value, uint8_t len);
+static bool run_program(bd_addr *address,
+                        sl_bt_gap_address_type_t address_type,
+                        int8_t rssi,
+                        const uint8array *adv_data);
+#endif // BLE_PEER_MANAGER_FILTER_COMPILED
 
 // -----------------------------------------------------------------------------
 // Public functions
@@ -114,6 +157,7 @@ void ble_peer_manager_filter_init(void)
 
 void ble_peer_manager_set_filter_bt_address(bool enabled)
 {
+  program.valid = false;
   if (enabled) {
     active_filter.filter_set.flags.address = FILTER_SET;
     ble_peer_manager_filter_log_info("BT address filtering enabled" APP_LOG_NL);
@@ -138,6 +182,7 @@ sl_status_t ble_peer_manager_add_allowed_bt_address(bd_addr *filter_addr)
     if (memcmp(&(active_filter.address[i].addr), empty_addr.addr, sizeof(bd_addr)) == 0) {
       // If an empty slot is found, add the filter
       memcpy(&(active_filter.address[i]), filter_addr, sizeof(bd_addr));
+      program.valid = false;
       ble_peer_manager_filter_log_info("BT address accept filter added for '%02x:%02x:%02x:%02x:%02x:%02x'" APP_LOG_NL,
                                        active_filter.address[i].addr[5],
                                        active_filter.address[i].addr[4],
@@ -172,6 +217,7 @@ sl_status_t ble_peer_manager_remove_allowed_bt_address(bd_addr *filter_addr)
                                        active_filter.address[i].addr[1],
                                        active_filter.address[i].addr[0]);
       memset(&(active_filter.address[i].addr), 0xFF, sizeof(bd_addr));
+      program.valid = false;
       return SL_STATUS_OK;
     }
   }
@@ -185,6 +231,7 @@ sl_status_t ble_peer_manager_set_filter_address_type(sl_bt_gap_address_type_t ad
   }
   active_filter.address_type = addr_type;
   active_filter.filter_set.flags.address_type = FILTER_SET;
+  program.valid = false;
   ble_peer_manager_filter_log_info("Filtering by address type, only accepting '%02x'" APP_LOG_NL,
                                    active_filter.address_type);
   return SL_STATUS_OK;
@@ -207,6 +254,7 @@ sl_status_t ble_peer_manager_set_filter_device_name(const char *device_name,
   memcpy(active_filter.device_name, device_name, device_name_len);
   active_filter.device_name_len = device_name_len;
   active_filter.filter_set.flags.device_name = FILTER_SET;
+  program.valid = false;
   if (full_match) {
     active_filter.filter_set.flags.device_name_full_match = FILTER_SET;
   }
@@ -225,6 +273,7 @@ sl_status_t ble_peer_manager_set_filter_service_uuid16(sl_bt_uuid_16_t *service_
   }
   memcpy(&(active_filter.service_uuid16), service_uuid16, sizeof(sl_bt_uuid_16_t));
   active_filter.filter_set.flags.service_uuid16 = FILTER_SET;
+  program.valid = false;
   ble_peer_manager_filter_log_info("Filtering by 16 bit UUID" APP_LOG_NL);
   return SL_STATUS_OK;
 }
@@ -239,6 +288,7 @@ sl_status_t ble_peer_manager_set_filter_service_uuid128(uuid_128 *service_uuid12
   }
   memcpy(&(active_filter.service_uuid128), service_uuid128, sizeof(uuid_128));
   active_filter.filter_set.flags.service_uuid128 = FILTER_SET;
+  program.valid = false;
   ble_peer_manager_filter_log_info("Filtering by 128 bit UUID" APP_LOG_NL);
   return SL_STATUS_OK;
 }
@@ -261,6 +311,7 @@ sl_status_t ble_peer_manager_set_filter_service_data(uint8_t *service_data,
   active_filter.service_data_offset = service_data_offset;
   active_filter.service_data_len = service_data_len;
   active_filter.filter_set.flags.service_data = FILTER_SET;
+  program.valid = false;
   ble_peer_manager_filter_log_info("Filtering by service data" APP_LOG_NL);
   return SL_STATUS_OK;
 }
@@ -283,6 +334,7 @@ sl_status_t ble_peer_manager_set_filter_manufacturer_data(uint8_t *manufacturer_
   active_filter.manufacturer_data_offset = manufacturer_data_offset;
   active_filter.manufacturer_data_len = manufacturer_data_len;
   active_filter.filter_set.flags.manufacturer_data = FILTER_SET;
+  program.valid = false;
   ble_peer_manager_filter_log_info("Filtering by manufacturer data" APP_LOG_NL);
   return SL_STATUS_OK;
 }
@@ -297,6 +349,7 @@ sl_status_t ble_peer_manager_set_filter_rssi(int8_t rssi)
   }
   active_filter.rssi = rssi;
   active_filter.filter_set.flags.rssi = FILTER_SET;
+  program.valid = false;
   ble_peer_manager_filter_log_info("Filtering by RSSI, only accepting from %d dBm" APP_LOG_NL,
                                    active_filter.rssi);
   return SL_STATUS_OK;
@@ -332,6 +385,7 @@ void ble_peer_manager_reset_filter()
 
   // Set flags to 0
   active_filter.filter_set.total = FILTER_CLEARED;
+  program.valid = false;
 }
 
 // Find match for the filters
@@ -340,6 +394,12 @@ bool ble_peer_manager_find_match(bd_addr *address,
                                  int8_t rssi,
                                  const uint8array *adv_data)
 {
+#if BLE_PEER_MANAGER_FILTER_COMPILED
+  if (!program.valid) {
+    compile_filter();
+  }
+  return run_program(address, address_type, rssi, adv_data);
+#else
   uint8_t advertisement_length;
   uint8_t advertisement_type;
   uint8_t i = 0;
@@ -433,7 +493,7 @@ bool ble_peer_manager_find_match(bd_addr *address,
             < (active_filter.service_data_len + active_filter.service_data_offset)) {
           return false;
         }
-        if (memcmp(&(active_filter.service_data),
+        if (memcmp(active_filter.service_data,
                    &adv_data->data[i + 2 + active_filter.service_data_offset],
                    active_filter.service_data_len) == 0) {
           ble_peer_manager_filter_log_debug("Found matching service data" APP_LOG_NL);
@@ -449,7 +509,7 @@ bool ble_peer_manager_find_match(bd_addr *address,
             < (active_filter.manufacturer_data_len + active_filter.manufacturer_data_offset)) {
           return false;
         }
-        if (memcmp(&(active_filter.manufacturer_data),
+        if (memcmp(active_filter.manufacturer_data,
                    &adv_data->data[i + 2 + active_filter.manufacturer_data_offset],
                    active_filter.manufacturer_data_len) == 0) {
           ble_peer_manager_filter_log_debug("Found matching manufacturer data" APP_LOG_NL);
@@ -480,6 +540,7 @@ bool ble_peer_manager_find_match(bd_addr *address,
 
   ble_peer_manager_filter_log_info("Found matching device based on the configured filters" APP_LOG_NL);
   return true;
+#endif // BLE_PEER_MANAGER_FILTER_COMPILED
 }
 
 SL_WEAK bool ble_peer_manager_is_filter_set_allowed()
@@ -520,3 +581,259 @@ sl_status_t ble_peer_manager_str_to_address(const char *str, bd_addr *address)
   }
   return SL_STATUS_INVALID_PARAMETER;
 }
+
+#if BLE_PEER_MANAGER_FILTER_COMPILED
+// -----------------------------------------------------------------------------
+// Private functions
+
+/******************************************************************************
+ * Compile the active filter into the match program
+ *****************************************************************************/
+static void compile_filter(void)
+{
+  bd_addr empty_addr = { { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF } };
+
+  memset(&program, 0, sizeof(program));
+  if (active_filter.filter_set.flags.device_name == FILTER_SET) {
+    enable_check(CHECK_NAME, AD_TYPE_SHORTENED_LOCAL_NAME, active_filter.device_name_len);
+    enable_check(CHECK_NAME, AD_TYPE_COMPLETE_LOCAL_NAME, 0);
+  }
+  if (active_filter.filter_set.flags.service_uuid16 == FILTER_SET) {
+    enable_check(CHECK_SERVICE_UUID16,
+                 AD_TYPE_INCOMPLETE_LIST_16_BIT_SERVICE_IDS,
+                 sizeof(sl_bt_uuid_16_t));
+    enable_check(CHECK_SERVICE_UUID16, AD_TYPE_COMPLETE_LIST_16_BIT_SERVICE_IDS, 0);
+    program.service_uuid16 = (uint16_t)(active_filter.service_uuid16.data[0]
+                                        | (active_filter.service_uuid16.data[1] << 8));
+  }
+  if (active_filter.filter_set.flags.service_uuid128 == FILTER_SET) {
+    enable_check(CHECK_SERVICE_UUID128,
+                 AD_TYPE_INCOMPLETE_LIST_128_BIT_SERVICE_IDS,
+                 sizeof(uuid_128));
+    enable_check(CHECK_SERVICE_UUID128, AD_TYPE_COMPLETE_LIST_128_BIT_SERVICE_IDS, 0);
+  }
+  if (active_filter.filter_set.flags.service_data == FILTER_SET) {
+    enable_check(CHECK_SERVICE_DATA,
+                 AD_TYPE_SERVICE_DATA,
+                 active_filter.service_data_offset + active_filter.service_data_len);
+  }
+  if (active_filter.filter_set.flags.manufacturer_data == FILTER_SET) {
+    enable_check(CHECK_MANUFACTURER_DATA,
+                 AD_TYPE_MANUFACTURER_DATA,
+                 active_filter.manufacturer_data_offset + active_filter.manufacturer_data_len);
+  }
+
+  if (active_filter.filter_set.flags.address == FILTER_SET) {
+    for (uint8_t i = 0u; i < MAX_NUMBER_OF_ADDRESS_FILTERS; i++) {
+      uint8_t hash;
+      if (memcmp(&(active_filter.address[i]), &empty_addr, sizeof(bd_addr)) == 0) {
+        continue;
+      }
+      hash = address_hash(&(active_filter.address[i]));
+      program.address_hash[hash >> 3] |= (uint8_t)(1 << (hash & 0x07));
+      program.address[program.address_count++] = active_filter.address[i];
+    }
+  }
+  program.valid = true;
+  ble_peer_manager_filter_log_debug("Filter compiled: checks 0x%02x/0x%02x, %u addresses" APP_LOG_NL,
+                                    program.find_mask,
+                                    program.all_mask,
+                                    program.address_count);
+}
+
+/******************************************************************************
+ * Run check on the AD elements of a type. min_len is the shortest element
+ * value the check can pass on, counted once per check.
+ *****************************************************************************/
+static void enable_check(filter_check_t check, uint8_t ad_type, uint8_t min_len)
+{
+  program.ad_types[ad_type >> 3] |= (uint8_t)(1 << (ad_type & 0x07));
+  if (check == CHECK_SERVICE_DATA || check == CHECK_MANUFACTURER_DATA) {
+    program.all_mask |= (uint8_t)(1 << check);
+  } else {
+    program.find_mask |= (uint8_t)(1 << check);
+  }
+  if (min_len != 0) {
+    program.min_len = (uint16_t)(program.min_len + AD_HEADER_SIZE + min_len);
+  }
+}
+
+/******************************************************************************
+ * Check of an AD type, CHECK_COUNT if none
+ *****************************************************************************/
+static filter_check_t check_for_type(uint8_t ad_type)
+{
+  switch (ad_type) {
+    case AD_TYPE_SHORTENED_LOCAL_NAME:
+    case AD_TYPE_COMPLETE_LOCAL_NAME:
+      return CHECK_NAME;
+    case AD_TYPE_INCOMPLETE_LIST_16_BIT_SERVICE_IDS:
+    case AD_TYPE_COMPLETE_LIST_16_BIT_SERVICE_IDS:
+      return CHECK_SERVICE_UUID16;
+    case AD_TYPE_INCOMPLETE_LIST_128_BIT_SERVICE_IDS:
+    case AD_TYPE_COMPLETE_LIST_128_BIT_SERVICE_IDS:
+      return CHECK_SERVICE_UUID128;
+    case AD_TYPE_SERVICE_DATA:
+      return CHECK_SERVICE_DATA;
+    case AD_TYPE_MANUFACTURER_DATA:
+      return CHECK_MANUFACTURER_DATA;
+    default:
+      return CHECK_COUNT;
+  }
+}
+
+/******************************************************************************
+ * Hash of an address, a byte of the allow-list bitmap
+ *****************************************************************************/
+static uint8_t address_hash(const bd_addr *address)
+{
+  return (uint8_t)(address->addr[0] ^ address->addr[1] ^ address->addr[2]
+                   ^ address->addr[3] ^ address->addr[4] ^ address->addr[5]);
+}
+
+/******************************************************************************
+ * Look up the allow-list, most addresses are rejected by the hash bitmap
+ *****************************************************************************/
+static bool address_allowed(const bd_addr *address)
+{
+  uint8_t hash = address_hash(address);
+
+  if ((program.address_hash[hash >> 3] & (1 << (hash & 0x07))) == 0) {
+    return false;
+  }
+  for (uint8_t i = 0u; i < program.address_count; i++) {
+    if (memcmp(&(program.address[i]), address, sizeof(bd_addr)) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/******************************************************************************
+ * Run a check on the value of an AD element
+ *****************************************************************************/
+static bool run_check(filter_check_t check, const uint8_t *value, uint8_t len)
+{
+  switch (check) {
+    case CHECK_NAME:
+      if (len < active_filter.device_name_len
+          || (active_filter.filter_set.flags.device_name_full_match
+              && len != active_filter.device_name_len)) {
+        return false;
+      }
+      return memcmp(value, active_filter.device_name, active_filter.device_name_len) == 0;
+
+    case CHECK_SERVICE_UUID16:
+      for (uint8_t j = 0; j + sizeof(sl_bt_uuid_16_t) <= len; j += sizeof(sl_bt_uuid_16_t)) {
+        if ((uint16_t)(value[j] | (value[j + 1] << 8)) == program.service_uuid16) {
+          return true;
+        }
+      }
+      return false;
+
+    case CHECK_SERVICE_UUID128:
+      for (uint8_t j = 0; j + sizeof(uuid_128) <= len; j += sizeof(uuid_128)) {
+        if (memcmp(&value[j], &(active_filter.service_uuid128), sizeof(uuid_128)) == 0) {
+          return true;
+        }
+      }
+      return false;
+
+    case CHECK_SERVICE_DATA:
+      if (len < active_filter.service_data_offset + active_filter.service_data_len) {
+        return false;
+      }
+      // Most mismatches are decided by the first byte, e.g. the company ID
+      if (active_filter.service_data_len != 0
+          && value[active_filter.service_data_offset] != active_filter.service_data[0]) {
+        return false;
+      }
+      return memcmp(&value[active_filter.service_data_offset],
+                    active_filter.service_data,
+                    active_filter.service_data_len) == 0;
+
+    case CHECK_MANUFACTURER_DATA:
+      if (len < active_filter.manufacturer_data_offset + active_filter.manufacturer_data_len) {
+        return false;
+      }
+      // Most mismatches are decided by the first byte, e.g. the company ID
+      if (active_filter.manufacturer_data_len != 0
+          && value[active_filter.manufacturer_data_offset] != active_filter.manufacturer_data[0]) {
+        return false;
+      }
+      return memcmp(&value[active_filter.manufacturer_data_offset],
+                    active_filter.manufacturer_data,
+                    active_filter.manufacturer_data_len) == 0;
+
+    default:
+      return false;
+  }
+}
+
+/******************************************************************************
+ * Run the match program on a scan report
+ *****************************************************************************/
+static bool run_program(bd_addr *address,
+                        sl_bt_gap_address_type_t address_type,
+                        int8_t rssi,
+                        const uint8array *adv_data)
+{
+  const uint8_t *data = adv_data->data;
+  uint16_t len = adv_data->len;
+  uint16_t i = 0;
+  uint8_t found = 0;
+  uint8_t seen = 0;
+
+  // Cheapest checks first
+  if (len < program.min_len) {
+    return false;
+  }
+  if (active_filter.filter_set.flags.rssi == FILTER_SET
+      && active_filter.rssi >= rssi) {
+    return false;
+  }
+  if (active_filter.filter_set.flags.address_type == FILTER_SET
+      && active_filter.address_type != address_type) {
+    return false;
+  }
+  if (active_filter.filter_set.flags.address == FILTER_SET
+      && !address_allowed(address)) {
+    return false;
+  }
+  if ((program.find_mask | program.all_mask) == 0) {
+    ble_peer_manager_filter_log_info("Found matching device based on the configured filters" APP_LOG_NL);
+    return true;
+  }
+
+  // One pass over the AD elements. A zero length ends the data, an element
+  // running past the end of the report is ignored.
+  while (i + AD_HEADER_SIZE <= len && data[i] != 0 && i + 1 + data[i] <= len) {
+    uint8_t type = data[i + 1];
+
+    if (program.ad_types[type >> 3] & (1 << (type & 0x07))) {
+      filter_check_t check = check_for_type(type);
+      uint8_t mask = (uint8_t)(1 << check);
+      if ((found & mask) == 0) {
+        if (run_check(check, &data[i + AD_HEADER_SIZE], (uint8_t)(data[i] - 1))) {
+          found |= (uint8_t)(mask & program.find_mask);
+        } else if ((program.all_mask & mask) != 0) {
+          return false;
+        }
+        seen |= mask;
+        // Done when every check passed and no element can fail any more
+        if (program.all_mask == 0 && found == program.find_mask) {
+          break;
+        }
+      }
+    }
+    i = (uint16_t)(i + 1 + data[i]);
+  }
+
+  if (found != program.find_mask
+      || (seen & program.all_mask) != program.all_mask) {
+    return false;
+  }
+  ble_peer_manager_filter_log_info("Found matching device based on the configured filters" APP_LOG_NL);
+  return true;
+}
+#endif // BLE_PEER_MANAGER_FILTER_COMPILED
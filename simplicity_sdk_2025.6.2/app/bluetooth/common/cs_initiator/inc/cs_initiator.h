@@ -46,6 +46,7 @@
 #include "sl_rtl_clib_api.h"
 #include "cs_result.h"
 #include "cs_initiator_client.h"
+#include "cs_ras_common.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -109,6 +110,23 @@ typedef void (*cs_result_cb_t)(const uint8_t conn_handle,
                                const cs_ranging_data_t *ranging_data,
                                const void *user_data);
 
+/***************************************************************************//**
+ * Initiator typed result callback type
+ * Alternative to cs_result_cb_t. The estimator fills the typed result once per
+ * procedure, no TLV buffer is built and no field has to be extracted.
+ *
+ * @param[in] conn_handle connection handle
+ * @param[in] ranging_counter Ranging counter value.
+ * @param[in] result pointer to the typed result, valid during the call only.
+ * @param[in] ranging_data ranging data that the result was calculated from.
+ * @param[in] user_data pointer to additional user data.
+ ******************************************************************************/
+typedef void (*cs_result_fields_cb_t)(const uint8_t conn_handle,
+                                      const uint16_t ranging_counter,
+                                      const cs_result_fields_t *result,
+                                      const cs_ranging_data_t *ranging_data,
+                                      const void *user_data);
+
 /***************************************************************************//**
  * Initiator intermediate result callback type
  * Called only in case the static object tracking mode is active.
@@ -146,6 +164,89 @@ sl_status_t cs_initiator_create(const uint8_t               conn_handle,
                                 cs_error_cb_t               error_cb,
                                 uint8_t                     *instance_id);
 
+/***************************************************************************//**
+ * Deliver the results of an initiator instance as typed result instead of the
+ * TLV result buffer. Once set, the result callback given at creation is no
+ * longer called for this instance.
+ * @param[in] conn_handle connection handle
+ * @param[in] result_fields_cb callback for typed result, NULL to switch back
+ *                             to the result buffer
+ *
+ * @return status of the operation.
+ ******************************************************************************/
+sl_status_t cs_initiator_set_result_fields_cb(const uint8_t         conn_handle,
+                                              cs_result_fields_cb_t result_fields_cb);
+
+/***************************************************************************//**
+ * Change the procedure interval of a running initiator instance. The
+ * procedure in progress is completed first, then the procedure is disabled,
+ * its parameters are set again and it is re-enabled. The connection
+ * interval is not changed.
+ * @param[in] conn_handle connection handle
+ * @param[in] procedure_interval new procedure interval in connection events
+ *
+ * @return status of the operation.
+ ******************************************************************************/
+sl_status_t cs_initiator_set_procedure_interval(const uint8_t conn_handle,
+                                                uint16_t      procedure_interval);
+
+/***************************************************************************//**
+ * Stretch the connection interval of a running initiator instance to a
+ * multiple of the interval set up for its CS procedures. The procedure in
+ * progress is completed first, then the procedure is disabled, the
+ * connection is updated and the procedure is re-enabled once the new
+ * parameters are reported. The procedure interval is kept in connection
+ * events, so the procedure period is stretched by the same factor.
+ * The interval is limited so that the supervision timeout still holds.
+ * @param[in] conn_handle connection handle
+ * @param[in] factor multiple of the set up interval, 1 restores it
+ *
+ * @return status of the operation.
+ ******************************************************************************/
+sl_status_t cs_initiator_set_connection_interval_factor(const uint8_t conn_handle,
+                                                        uint8_t       factor);
+
+/***************************************************************************//**
+ * Hand over the RAS characteristic handles and features of a bonded
+ * reflector found on a previous connection. The service and characteristic
+ * discovery and the features read are skipped, the procedures are set up
+ * right after the connection parameters. Must be called after
+ * cs_initiator_create() and before the connection parameters are reported.
+ * @param[in] conn_handle connection handle
+ * @param[in] handles RAS characteristic handles
+ * @param[in] features RAS features
+ *
+ * @return status of the operation.
+ ******************************************************************************/
+sl_status_t cs_initiator_set_ras_attributes(const uint8_t                 conn_handle,
+                                            const cs_ras_gattdb_handles_t *handles,
+                                            cs_ras_features_t             features);
+
+/***************************************************************************//**
+ * Get the RAS characteristic handles and features in use, to be handed over
+ * with cs_initiator_set_ras_attributes() on the next connection.
+ * @param[in] conn_handle connection handle
+ * @param[out] handles RAS characteristic handles
+ * @param[out] features RAS features
+ *
+ * @return SL_STATUS_INVALID_STATE until the RAS client is initialized,
+ *         status of the operation otherwise.
+ ******************************************************************************/
+sl_status_t cs_initiator_get_ras_attributes(const uint8_t           conn_handle,
+                                            cs_ras_gattdb_handles_t *handles,
+                                            cs_ras_features_t       *features);
+
+/***************************************************************************//**
+ * Timestamp the gate decision taken with the last delivered result, which
+ * closes the pipeline latency measurement of the procedure. To be called
+ * after the decision, not when the result is consumed. Nothing is done
+ * if CS_INITIATOR_LATENCY_STATS is disabled.
+ * @param[in] conn_handle connection handle
+ *
+ * @return status of the operation.
+ ******************************************************************************/
+sl_status_t cs_initiator_mark_gate_decision(const uint8_t conn_handle);
+
 /***************************************************************************//**
  * Create and configure initiator instances.
  ******************************************************************************/
@@ -0,0 +1,97 @@
+/***************************************************************************//**
+ * @file
+ * @brief CS initiator - ranging buffer pool
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2025 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+#ifndef CS_INITIATOR_BUFFER_POOL_H
+#define CS_INITIATOR_BUFFER_POOL_H
+
+// -----------------------------------------------------------------------------
+// Includes
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cs_initiator_common.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// -----------------------------------------------------------------------------
+// Type definitions
+
+/// Ranging buffer pool usage
+typedef struct {
+  uint8_t size;       // Number of buffers in the pool
+  uint8_t in_use;     // Buffers lent at the moment
+  uint8_t peak;       // Highest in_use since init
+  uint32_t failed;    // Lend requests refused because the pool was empty
+} cs_initiator_buffer_pool_stats_t;
+
+// -----------------------------------------------------------------------------
+// Function declarations
+
+/******************************************************************************
+ * Initialize the ranging buffer pool. All buffers become free.
+ *****************************************************************************/
+void cs_initiator_buffer_pool_init(void);
+
+/******************************************************************************
+ * Lend a buffer of CS_INITIATOR_MAX_RANGING_DATA_SIZE bytes to a ranging data
+ * array. Nothing is done if the array holds a buffer already. A new buffer is
+ * filled with 0xFF and the data size is reset.
+ * Must be called from the Bluetooth event context only.
+ *
+ * @param[in,out] array ranging data array
+ *
+ * @return true if the array holds a buffer
+ * @return false if the pool is empty
+ *****************************************************************************/
+bool cs_initiator_buffer_pool_lend(ranging_data_array_t *array);
+
+/******************************************************************************
+ * Give the buffer of a ranging data array back to the pool. Nothing is done
+ * if the array holds no buffer.
+ * Must be called from the Bluetooth event context only.
+ *
+ * @param[in,out] array ranging data array
+ *****************************************************************************/
+void cs_initiator_buffer_pool_return(ranging_data_array_t *array);
+
+/******************************************************************************
+ * Get the pool usage.
+ *
+ * @param[out] stats pool usage
+ *****************************************************************************/
+void cs_initiator_buffer_pool_get_stats(cs_initiator_buffer_pool_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CS_INITIATOR_BUFFER_POOL_H
@@ -0,0 +1,176 @@
+/***************************************************************************//**
+ * @file
+ * @brief CS initiator - binary procedure capture
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2025 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef CS_INITIATOR_CAPTURE_H
+#define CS_INITIATOR_CAPTURE_H
+
+// -----------------------------------------------------------------------------
+// Includes
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sl_rtl_clib_api.h"
+#include "cs_initiator_config.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// -----------------------------------------------------------------------------
+// Macros
+
+/// First word of the start record, "CSCP" in the stream
+#define CS_INITIATOR_CAPTURE_MAGIC    0x50435343UL
+
+/// Version of the record layouts below
+#define CS_INITIATOR_CAPTURE_VERSION  1
+
+#if !defined(CS_INITIATOR_CAPTURE) || (CS_INITIATOR_CAPTURE == 0)
+#define cs_initiator_capture_init()
+#define cs_initiator_capture_procedure(conn_handle, ranging_counter, cs_params, procedure)
+#define cs_initiator_capture_field(type, value)
+#define cs_initiator_capture_result(conn_handle, ranging_counter, rtl_error)
+#endif
+
+// -----------------------------------------------------------------------------
+// Type definitions
+
+// The stream is a sequence of records, each a header followed by its
+// payload. All fields are little-endian and packed.
+
+/// Record types
+typedef enum {
+  CS_INITIATOR_CAPTURE_RECORD_START = 1,   // Capture started
+  CS_INITIATOR_CAPTURE_RECORD_PROCEDURE,   // Input of sl_rtl_ras_process()
+  CS_INITIATOR_CAPTURE_RECORD_RESULT,      // Output of the estimation
+  CS_INITIATOR_CAPTURE_RECORD_LOST         // Records dropped before this one
+} cs_initiator_capture_record_type_t;
+
+/// Record header
+typedef PACKSTRUCT (struct {
+  uint16_t length;        // Payload length, without this header
+  uint8_t  type;          // cs_initiator_capture_record_type_t
+  uint8_t  conn_handle;
+  uint32_t timestamp;     // Sleeptimer ticks
+}) cs_initiator_capture_header_t;
+
+/// Start record, the first one of the stream
+typedef PACKSTRUCT (struct {
+  uint32_t magic;                 // CS_INITIATOR_CAPTURE_MAGIC
+  uint8_t  version;               // CS_INITIATOR_CAPTURE_VERSION
+  uint8_t  cs_params_size;        // sizeof(sl_rtl_cs_params)
+  uint8_t  procedure_config_size; // sizeof(sl_rtl_cs_procedure_config)
+  uint8_t  reserved;
+  uint32_t timer_frequency;       // Timestamp ticks per second
+}) cs_initiator_capture_start_t;
+
+/// Procedure record, followed by the step channels [num_steps],
+/// the initiator ranging data [initiator_len] and the reflector ranging
+/// data [reflector_len]
+typedef PACKSTRUCT (struct {
+  uint16_t                   ranging_counter;
+  uint8_t                    num_antenna_paths;
+  uint8_t                    num_steps;
+  uint16_t                   initiator_len;
+  uint16_t                   reflector_len;
+  sl_rtl_cs_params           cs_params;
+  sl_rtl_cs_procedure_config procedure_config;
+}) cs_initiator_capture_procedure_t;
+
+/// Result record, followed by num_fields field type bytes, each followed
+/// by a float value as in the cs_result buffer
+typedef PACKSTRUCT (struct {
+  uint16_t ranging_counter;
+  uint8_t  rtl_error;             // enum sl_rtl_error_code
+  uint8_t  num_fields;
+}) cs_initiator_capture_result_t;
+
+/// Lost record, written when the stream has room again
+typedef PACKSTRUCT (struct {
+  uint32_t records;               // Records that did not fit
+}) cs_initiator_capture_lost_t;
+
+// -----------------------------------------------------------------------------
+// Function declarations
+
+#if defined(CS_INITIATOR_CAPTURE) && (CS_INITIATOR_CAPTURE == 1)
+/******************************************************************************
+ * Set up the RTT up buffer of the capture and write the start record.
+ *****************************************************************************/
+void cs_initiator_capture_init(void);
+
+/******************************************************************************
+ * Write the input of sl_rtl_ras_process() for one procedure and start
+ * collecting its result fields.
+ * Records that do not fit in the RTT buffer are dropped as a whole.
+ * Must be called from the Bluetooth event context only.
+ *
+ * @param[in] conn_handle connection handle
+ * @param[in] ranging_counter ranging counter of the procedure
+ * @param[in] cs_params CS parameters of the estimator
+ * @param[in] procedure procedure data passed to sl_rtl_ras_process()
+ *****************************************************************************/
+void cs_initiator_capture_procedure(uint8_t                     conn_handle,
+                                    uint16_t                    ranging_counter,
+                                    const sl_rtl_cs_params      *cs_params,
+                                    const sl_rtl_ras_procedure  *procedure);
+
+/******************************************************************************
+ * Add a result field of the procedure being estimated.
+ *
+ * @param[in] type cs_result_field_type_t of the field
+ * @param[in] value field value
+ *****************************************************************************/
+void cs_initiator_capture_field(uint8_t type, float value);
+
+/******************************************************************************
+ * Write the result record of the procedure being estimated.
+ * Must be called from the Bluetooth event context only.
+ *
+ * @param[in] conn_handle connection handle
+ * @param[in] ranging_counter ranging counter of the procedure
+ * @param[in] rtl_error return value of sl_rtl_ras_process()
+ *****************************************************************************/
+void cs_initiator_capture_result(uint8_t                 conn_handle,
+                                 uint16_t                ranging_counter,
+                                 enum sl_rtl_error_code  rtl_error);
+
+/******************************************************************************
+ * Get the number of records dropped because the RTT buffer was full.
+ *****************************************************************************/
+uint32_t cs_initiator_capture_get_lost(void);
+#endif // defined(CS_INITIATOR_CAPTURE) && (CS_INITIATOR_CAPTURE == 1)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CS_INITIATOR_CAPTURE_H
@@ -46,6 +46,9 @@
 #include "cs_initiator_client.h"
 #include "cs_initiator_config.h"
 #include "cs_ras_client.h"
+#include "cs_ras_format_converter.h"
+#include "cs_initiator_ras_policy.h"
+#include "cs_initiator_latency.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -58,6 +61,22 @@ extern "C"
 // Maximum number of subevents per procedure
 #define CS_INITIATOR_MAX_SUBEVENTS_PER_PROCEDURE 32
 
+// On-Demand Ranging Data is handled if it is the configured mode or if the
+// mode is selected automatically
+#if (defined(CS_INITIATOR_RAS_MODE_USE_REAL_TIME_MODE) && (CS_INITIATOR_RAS_MODE_USE_REAL_TIME_MODE == 0)) \
+  || (defined(CS_INITIATOR_RAS_MODE_AUTO) && (CS_INITIATOR_RAS_MODE_AUTO == 1))
+#define CS_INITIATOR_RAS_ON_DEMAND_USED 1
+#else
+#define CS_INITIATOR_RAS_ON_DEMAND_USED 0
+#endif
+
+// 1: events are routed through the connection handle map and dispatched
+// through the state x event table, 0: instance scan and switch dispatch of
+// earlier releases, kept to compare both on the host
+#ifndef CS_INITIATOR_TABLE_DISPATCH
+#define CS_INITIATOR_TABLE_DISPATCH 1
+#endif
+
 // CS initiator state machine
 
 /// CS initiator state machine event enumerator
@@ -170,24 +189,38 @@ typedef struct {
   bool real_time_mode;                    // Real-time or on-demand mode
   uint32_t service;                       // Ranging service handle
   cs_ras_gattdb_handles_t gattdb_handles; // Ranging characteristic handles
+  bool cached;                            // Handles and features known from
+                                          // a previous connection
+  cs_ras_features_t cached_features;      // RAS features of the server
   ras_state_t state;                      // State of the RAS client
   uint16_t mtu;                           // MTU setup of the connection
   bool overwritten;                       // true if the data of the given
                                           // ranging counter is overwritten
+  uint64_t lost_segments;                 // Lost segments not requested yet
+  bool segments_lost;                     // Segments of the current ranging
+                                          // data were lost
+  uint32_t first_segment_tick;            // Arrival of the first segment
+  cs_initiator_ras_policy_t policy;       // Automatic mode selection
 } ras_client_t;
 
 /// Ranging data array type
 typedef struct {
   uint32_t ranging_data_size;                               // Actual size
-  uint8_t ranging_data[CS_INITIATOR_MAX_RANGING_DATA_SIZE]; // Ranging data
+  uint8_t *ranging_data;                                    // Ranging data of
+                                                            // CS_INITIATOR_MAX_RANGING_DATA_SIZE
+                                                            // bytes, borrowed from
+                                                            // the buffer pool
 } ranging_data_array_t;
 
 /// Unified ranging data
 typedef struct {
   uint8_t num_steps;                        // Number of steps
   uint8_t step_channels[CS_MAX_STEP_COUNT]; // Step channel array
+  bool steps_valid;                         // Steps passed the subevent checks
   ranging_data_array_t initiator;           // Initiator ranging data
   ranging_data_array_t reflector;           // Reflector ranging data
+  cs_ras_step_index_t reflector_index;      // Reflector step index
+  uint32_t reflector_received;              // Reflector data received without gap
 } unified_ranging_data_t;
 
 /// CS Initiator main class
@@ -200,6 +233,7 @@ typedef struct {
   sl_rtl_cs_params cs_parameters;
   cs_result_session_data_t result_data;
   uint8_t result[CS_RESULT_MAX_BUFFER_SIZE];
+  cs_result_fields_t result_fields;
   cs_initiator_config_t config;
   ras_client_t ras_client;
   uint8_t conn_handle;
@@ -210,10 +244,12 @@ typedef struct {
   sl_rtl_cs_libitem rtl_handle;
   uint8_t instance_id;
   cs_result_cb_t result_cb;
+  cs_result_fields_cb_t result_fields_cb;
   cs_intermediate_result_cb_t intermediate_result_cb;
   cs_error_cb_t error_cb;
   uint32_t procedure_start_time_ms;
   uint32_t procedure_stop_time_ms;
+  cs_initiator_latency_t latency;       // Stage timestamps of the procedure
   uint32_t log_error_counter;
   uint8_t drop_counter;
   app_timer_t timer_handle;
@@ -221,6 +257,12 @@ typedef struct {
   bool error_timer_elapsed;
   uint8_t initiator_state;
   uint8_t procedure_enable_retry_counter;
+  uint16_t pending_procedure_interval;  // Applied at the next procedure
+                                        // boundary, 0 if none
+  uint16_t base_connection_interval;    // Interval set up for the CS procedures
+  uint16_t pending_connection_interval; // Applied at the next procedure
+                                        // boundary, 0 if none
+  bool wait_connection_parameters;      // Procedures restart on the update
   uint8_t num_antenna_path;
   uint8_t antenna_config;
   cs_ranging_data_t ranging_data_result;
@@ -63,21 +63,46 @@ void reset_subevent_data(cs_initiator_t *initiator, bool init);
 cs_procedure_state_t extract_cs_result_data(cs_initiator_t *initiator,
                                             cs_result_data_t *cs_result_content);
 
+/******************************************************************************
+ * Index a reflector ranging data segment that has just been stored.
+ *
+ * The reflector step index follows the segments while they arrive in order.
+ * After a lost segment it waits for the end of the reception. After the end
+ * of a reception it waits for the first segment of the next procedure.
+ *
+ * @param[in] initiator initiator instance reference
+ * @param[in] offset Offset of the segment data, 0 starts a new procedure
+ * @param[in] size Size of the segment data
+ *****************************************************************************/
+void ranging_data_segment_arrived(cs_initiator_t *initiator,
+                                  uint32_t offset,
+                                  uint32_t size);
+
+/******************************************************************************
+ * Close the reflector ranging data reception.
+ *
+ * Segments that arrive later, retrieved lost segments or those of the next
+ * procedure before its first one, do not continue the step index. The index
+ * itself is kept for the processing of the received data.
+ *
+ * @param[in] initiator initiator instance reference
+ *****************************************************************************/
+void ranging_data_reception_finished(cs_initiator_t *initiator);
+
 /******************************************************************************
  * Check if ranging data is complete
  *
  * @param[in] data Ranging data
  * @param[in] size Size of ranging data
- * @param[in] is_initiator True for initiator
- * @param[in] antenna_path_num Number of antenna paths
+ * @param[in,out] index Step index of the ranging data, indexing continues
+ *                      from the segments streamed so far
  *
  * @return CS_PROCEDURE_STATE_COMPLETED if procedure is completed
  * @return CS_PROCEDURE_STATE_ABORTED otherwise
  *****************************************************************************/
 cs_procedure_state_t ranging_data_is_complete(uint8_t *data,
                                               uint32_t size,
-                                              bool is_initiator,
-                                              uint8_t antenna_path_num);
+                                              cs_ras_step_index_t *index);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,162 @@
+/***************************************************************************//**
+ * @file
+ * @brief CS initiator - CS pipeline latency statistics
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2025 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+#ifndef CS_INITIATOR_LATENCY_H
+#define CS_INITIATOR_LATENCY_H
+
+// -----------------------------------------------------------------------------
+// Includes
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cs_initiator_config.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// -----------------------------------------------------------------------------
+// Macros
+
+/// Number of histogram buckets, the last one has no upper limit
+#define CS_INITIATOR_LATENCY_BUCKET_COUNT 13
+
+#if defined(CS_INITIATOR_LATENCY_STATS) && (CS_INITIATOR_LATENCY_STATS == 1)
+#define cs_initiator_latency_mark(initiator, stage) \
+  cs_initiator_latency_record(&(initiator)->latency, (stage))
+#else
+#define cs_initiator_latency_mark(initiator, stage)
+#endif
+
+// -----------------------------------------------------------------------------
+// Type definitions
+
+/// Stages of the pipeline from the procedure start to the gate decision
+typedef enum {
+  CS_INITIATOR_LATENCY_PROCEDURE_ENABLE = 0,  // Procedure enable completed
+  CS_INITIATOR_LATENCY_FIRST_CS_RESULT,       // First initiator CS result
+  CS_INITIATOR_LATENCY_LAST_CS_RESULT,        // Initiator procedure done
+  CS_INITIATOR_LATENCY_FIRST_RAS_SEGMENT,     // First reflector segment
+  CS_INITIATOR_LATENCY_LAST_RAS_SEGMENT,      // Reflector data complete
+  CS_INITIATOR_LATENCY_RTL_PROCESS_ENTRY,     // sl_rtl_ras_process() called
+  CS_INITIATOR_LATENCY_RTL_PROCESS_EXIT,      // sl_rtl_ras_process() returned
+  CS_INITIATOR_LATENCY_RESULT_DELIVERY,       // Result callback called
+  CS_INITIATOR_LATENCY_GATE_DECISION,         // Gate evaluated with the result
+  CS_INITIATOR_LATENCY_STAGE_COUNT
+} cs_initiator_latency_stage_t;
+
+/// Stage timestamps of the ongoing procedure of an instance
+typedef struct {
+  uint32_t time[CS_INITIATOR_LATENCY_STAGE_COUNT];  // Timestamp per stage
+  uint32_t origin;                                  // Procedure start
+  uint16_t reached;                                 // Bit per stage reached
+} cs_initiator_latency_t;
+
+/// Time from the procedure start to a stage, over all instances
+typedef struct {
+  uint32_t count;                                       // Procedures counted
+  uint32_t min_us;
+  uint32_t max_us;
+  uint64_t sum_us;
+  uint32_t bucket[CS_INITIATOR_LATENCY_BUCKET_COUNT];   // Procedures per bucket
+} cs_initiator_latency_histogram_t;
+
+// -----------------------------------------------------------------------------
+// Function declarations
+
+/******************************************************************************
+ * Start the timestamp counter and clear the histograms.
+ *****************************************************************************/
+void cs_initiator_latency_init(void);
+
+/******************************************************************************
+ * Clear the histograms and the incomplete procedure counter.
+ *****************************************************************************/
+void cs_initiator_latency_clear(void);
+
+/******************************************************************************
+ * Forget the ongoing procedure of an instance.
+ *
+ * @param[out] latency stage timestamps of the instance
+ *****************************************************************************/
+void cs_initiator_latency_reset(cs_initiator_latency_t *latency);
+
+/******************************************************************************
+ * Timestamp a stage of the ongoing procedure of an instance.
+ *
+ * The procedure starts with PROCEDURE_ENABLE, or with FIRST_CS_RESULT when
+ * the procedures are free running. Repeated FIRST_ stages keep the first
+ * timestamp, other stages keep the last one. The stages reached are added
+ * to the histograms at RESULT_DELIVERY, GATE_DECISION follows it. A
+ * procedure that starts before the previous one was delivered counts as
+ * incomplete.
+ *
+ * @param[in,out] latency stage timestamps of the instance
+ * @param[in] stage stage reached
+ *****************************************************************************/
+void cs_initiator_latency_record(cs_initiator_latency_t       *latency,
+                                 cs_initiator_latency_stage_t stage);
+
+/******************************************************************************
+ * Get the histogram of a stage.
+ *
+ * @param[in] stage pipeline stage
+ * @param[out] histogram copy of the histogram
+ *
+ * @return false if the stage is invalid
+ *****************************************************************************/
+bool cs_initiator_latency_get(cs_initiator_latency_stage_t     stage,
+                              cs_initiator_latency_histogram_t *histogram);
+
+/******************************************************************************
+ * Get the upper limit of a histogram bucket.
+ *
+ * @param[in] bucket bucket index
+ *
+ * @return upper limit in microseconds, UINT32_MAX for the last bucket
+ *****************************************************************************/
+uint32_t cs_initiator_latency_bucket_limit_us(uint8_t bucket);
+
+/******************************************************************************
+ * Get the number of procedures that started before the previous one of the
+ * same instance was delivered.
+ *****************************************************************************/
+uint32_t cs_initiator_latency_get_incomplete(void);
+
+/******************************************************************************
+ * Get the name of a stage.
+ *****************************************************************************/
+const char *cs_initiator_latency_stage_name(cs_initiator_latency_stage_t stage);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CS_INITIATOR_LATENCY_H
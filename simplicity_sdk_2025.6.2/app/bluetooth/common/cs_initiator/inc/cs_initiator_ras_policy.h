@@ -0,0 +1,96 @@
+/***************************************************************************//**
+ * @file
+ * @brief CS initiator - RAS mode selection policy
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2025 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+#ifndef CS_INITIATOR_RAS_POLICY_H
+#define CS_INITIATOR_RAS_POLICY_H
+
+// -----------------------------------------------------------------------------
+// Includes
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cs_initiator_config.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// -----------------------------------------------------------------------------
+// Type definitions
+
+/// Outcome of the ranging data transfer of one procedure
+typedef struct {
+  bool lost;            // Segments were lost, recovered or not
+  bool dropped;         // No reflector data for the procedure
+  uint32_t latency_ms;  // Until the data was complete
+} cs_initiator_ras_sample_t;
+
+/// RAS mode selection state of a connection
+typedef struct {
+  uint16_t bad_permille;  // Share of bad procedures, moving average
+  uint16_t dwell;         // Procedures since the last mode change
+  bool real_time;         // Mode selected by the policy
+} cs_initiator_ras_policy_t;
+
+// -----------------------------------------------------------------------------
+// Function declarations
+
+/******************************************************************************
+ * Start the policy of a connection in the given mode.
+ *
+ * @param[out] policy policy state
+ * @param[in] real_time true if the connection starts in Real-Time mode
+ *****************************************************************************/
+void cs_initiator_ras_policy_init(cs_initiator_ras_policy_t *policy,
+                                  bool real_time);
+
+/******************************************************************************
+ * Account the transfer of one procedure and select the mode.
+ *
+ * A procedure is bad if segments were lost, it was dropped or its data took
+ * longer than CS_INITIATOR_RAS_AUTO_MAX_LATENCY_MS. Real-Time mode is left
+ * when the share of bad procedures reaches
+ * CS_INITIATOR_RAS_AUTO_ON_DEMAND_THRESHOLD, and selected again when it
+ * falls to CS_INITIATOR_RAS_AUTO_REAL_TIME_THRESHOLD. A mode is kept for at
+ * least CS_INITIATOR_RAS_AUTO_MIN_PROCEDURES procedures.
+ *
+ * @param[in,out] policy policy state
+ * @param[in] sample transfer outcome
+ *
+ * @return true if the selected mode has changed
+ *****************************************************************************/
+bool cs_initiator_ras_policy_update(cs_initiator_ras_policy_t *policy,
+                                    const cs_initiator_ras_sample_t *sample);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CS_INITIATOR_RAS_POLICY_H
@@ -0,0 +1,89 @@
+/***************************************************************************//**
+ * @file
+ * @brief CS initiator - lost segment recovery planning
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2025 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+#ifndef CS_INITIATOR_RECOVERY_H
+#define CS_INITIATOR_RECOVERY_H
+
+// -----------------------------------------------------------------------------
+// Includes
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// -----------------------------------------------------------------------------
+// Type definitions
+
+/// Segments requested with one Retrieve Lost Ranging Data Segments command
+typedef struct {
+  uint8_t start_segment;  // First segment of the range
+  uint8_t end_segment;    // Last segment of the range
+} cs_initiator_segment_range_t;
+
+// -----------------------------------------------------------------------------
+// Function declarations
+
+/******************************************************************************
+ * Get the next range to retrieve from a lost segment bitmask.
+ *
+ * The range starts at the lowest lost segment. Following lost segments are
+ * added to it as long as at most merge_gap received segments lie between
+ * them: sending those again is cheaper than another Control Point round trip.
+ * A merge_gap of 0 gives one range per run of lost segments, 63 a single
+ * range from the first to the last lost segment.
+ *
+ * @param[in] lost_segments lost segment bitmask
+ * @param[in] merge_gap number of received segments allowed inside a range
+ * @param[out] range next range to retrieve
+ *
+ * @return true if a range was found
+ * @return false if no segment is lost
+ *****************************************************************************/
+bool cs_initiator_recovery_next_range(uint64_t lost_segments,
+                                      uint8_t merge_gap,
+                                      cs_initiator_segment_range_t *range);
+
+/******************************************************************************
+ * Get the bitmask of the segments in a range.
+ *
+ * @param[in] range segment range
+ *
+ * @return bitmask with the bits of start_segment to end_segment set
+ *****************************************************************************/
+uint64_t cs_initiator_recovery_range_mask(const cs_initiator_segment_range_t *range);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CS_INITIATOR_RECOVERY_H
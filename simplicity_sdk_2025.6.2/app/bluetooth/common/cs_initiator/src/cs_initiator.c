@@ -37,14 +37,20 @@
 #include "sl_component_catalog.h"
 #include "sl_rtl_clib_api.h"
 #include "sl_status.h"
+#include "sl_sleeptimer.h"
 
 #include "cs_initiator_config.h"
 #include "cs_initiator_common.h"
+#include "cs_initiator_buffer_pool.h"
 #include "cs_initiator_client.h"
 #include "cs_initiator_error.h"
 #include "cs_initiator_estimate.h"
 #include "cs_initiator_extract.h"
+#include "cs_initiator_latency.h"
+#include "cs_initiator_capture.h"
 #include "cs_initiator_log.h"
+#include "cs_initiator_ras_policy.h"
+#include "cs_initiator_recovery.h"
 #include "cs_initiator_state_machine.h"
 #include "cs_ras_client.h"
 #include "cs_ras_format_converter.h"
@@ -65,6 +71,9 @@
 // Length of UUID in bytes
 #define UUID_LEN                       16
 
+// Longest connection interval in 1.25 ms units
+#define CONNECTION_INTERVAL_MAX        3200u
+
 // -----------------------------------------------------------------------------
 // Enums, structs, typedefs
 
@@ -105,11 +114,17 @@ static void process_remote_ranging_data(cs_initiator_t *initiator,
                                         uint8_t *data,
                                         uint32_t data_size);
 static bool ras_client_handler(cs_initiator_t *initiator, sl_bt_msg_t *evt);
+static bool start_cached_ras_client(cs_initiator_t *initiator);
 static void reset_ras_config(cs_initiator_t* initiator);
-#if defined (CS_INITIATOR_RAS_MODE_USE_REAL_TIME_MODE) && (CS_INITIATOR_RAS_MODE_USE_REAL_TIME_MODE == 0)
-static void cs_initiator_get_lost_segments(uint64_t lost_segments,
-                                           uint8_t *start_segment,
-                                           uint8_t *end_segment);
+#if CS_INITIATOR_RAS_ON_DEMAND_USED
+static void request_lost_segments(cs_initiator_t *initiator,
+                                  uint16_t ranging_counter);
+#endif
+#if CS_INITIATOR_RAS_MODE_AUTO
+static void ras_mode_sample(cs_initiator_t *initiator,
+                            bool           lost,
+                            bool           dropped);
+static void ras_mode_switch(cs_initiator_t *initiator);
 #endif
 
 // -----------------------------------------------------------------------------
@@ -117,6 +132,13 @@ static void cs_initiator_get_lost_segments(uint64_t lost_segments,
 
 static cs_initiator_t cs_initiator_instances[CS_INITIATOR_MAX_CONNECTIONS];
 
+#if CS_INITIATOR_TABLE_DISPATCH
+// Connection handle to instance index, INSTANCE_MAP_NONE if not mapped.
+// Entries may be stale, the instance connection handle is authoritative.
+#define INSTANCE_MAP_NONE  0xFFu
+static uint8_t instance_map[UINT8_MAX + 1];
+#endif
+
 // RAS client
 uint16_t service_uuid = CS_RAS_SERVICE_UUID;
 uint16_t char_uuids[CS_RAS_CHARACTERISTIC_INDEX_COUNT] = {
@@ -136,6 +158,18 @@ uint16_t char_uuids[CS_RAS_CHARACTERISTIC_INDEX_COUNT] = {
  *****************************************************************************/
 static cs_initiator_t *cs_initiator_get_instance(const uint8_t conn_handle)
 {
+#if CS_INITIATOR_TABLE_DISPATCH
+  uint8_t index = instance_map[conn_handle];
+
+  // Events of other connections are expected here, the caller decides
+  // whether a miss is an error
+  if (index >= CS_INITIATOR_MAX_CONNECTIONS
+      || cs_initiator_instances[index].conn_handle != conn_handle
+      || conn_handle == SL_BT_INVALID_CONNECTION_HANDLE) {
+    return NULL;
+  }
+  return &cs_initiator_instances[index];
+#else
   for (uint8_t i = 0u; i < CS_INITIATOR_MAX_CONNECTIONS; i++) {
     if (cs_initiator_instances[i].conn_handle == conn_handle) {
       return &cs_initiator_instances[i];
@@ -144,6 +178,7 @@ static cs_initiator_t *cs_initiator_get_instance(const uint8_t conn_handle)
   initiator_log_error("No matching instance found for connection handle %u!" LOG_NL,
                       conn_handle);
   return NULL;
+#endif
 }
 
 /******************************************************************************
@@ -308,8 +343,7 @@ static void process_remote_ranging_data(cs_initiator_t *initiator,
   // Check done status of the procedure
   evt_data.evt_ranging_data.procedure_state = ranging_data_is_complete(initiator->data.reflector.ranging_data,
                                                                        initiator->data.reflector.ranging_data_size,
-                                                                       false,
-                                                                       initiator->num_antenna_path);
+                                                                       &initiator->data.reflector_index);
   sc = initiator_state_machine_event_handler(initiator,
                                              INITIATOR_EVT_RANGING_DATA,
                                              &evt_data);
@@ -415,6 +449,42 @@ static bool ras_client_handler(cs_initiator_t *initiator, sl_bt_msg_t *evt)
   return handled;
 }
 
+/******************************************************************************
+ * Create the RAS client from the handles and features of a previous
+ * connection, without discovery.
+ * @return false if the discovery has to run instead.
+ *****************************************************************************/
+static bool start_cached_ras_client(cs_initiator_t *initiator)
+{
+  sl_status_t sc;
+
+  if (initiator->ras_client.real_time_mode
+      && !initiator->ras_client.gattdb_handles.array[CS_RAS_CHARACTERISTIC_INDEX_REAL_TIME_RANGING_DATA]) {
+    initiator_log_warning(INSTANCE_PREFIX "RAS - cached handles lack real time ranging data, "
+                                          "discovering" LOG_NL,
+                          initiator->conn_handle);
+    return false;
+  }
+  sc = cs_ras_client_create_initialized(initiator->conn_handle,
+                                        &initiator->ras_client.gattdb_handles,
+                                        initiator->config.mtu,
+                                        initiator->ras_client.cached_features);
+  if (sc != SL_STATUS_OK) {
+    initiator_log_warning(INSTANCE_PREFIX "RAS - client create from cache failed, "
+                                          "discovering [sc: 0x%lx]" LOG_NL,
+                          initiator->conn_handle,
+                          (unsigned long)sc);
+    return false;
+  }
+  initiator_log_info(INSTANCE_PREFIX "RAS - client created from cache, discovery skipped" LOG_NL,
+                     initiator->conn_handle);
+  initiator->ras_client.state = RAS_STATE_CLIENT_INIT;
+  cs_ras_client_on_initialized(initiator->conn_handle,
+                               initiator->ras_client.cached_features,
+                               SL_STATUS_OK);
+  return true;
+}
+
 /******************************************************************************
  * Set the RAS config flags for indication and notification.
  *****************************************************************************/
@@ -422,6 +492,8 @@ static void reset_ras_config(cs_initiator_t* initiator)
 {
   initiator->ras_client.real_time_mode
     = CS_INITIATOR_RAS_MODE_USE_REAL_TIME_MODE;
+  cs_initiator_ras_policy_init(&initiator->ras_client.policy,
+                               initiator->ras_client.real_time_mode);
 
   initiator->ras_client.service = INVALID_SERVICE_HANDLE;
   initiator->ras_client.mtu = ATT_MTU_MIN;
@@ -435,10 +507,7 @@ static void reset_ras_config(cs_initiator_t* initiator)
   initiator->ras_client.config.ranging_data_overwritten_notification =
     CS_INITIATOR_RAS_DATA_OVERWRITTEN_NOTIFICATION;
 
-  initiator->data.reflector.ranging_data_size = 0;
-  memset(&initiator->data.reflector.ranging_data,
-         0,
-         sizeof(initiator->data.reflector.ranging_data));
+  cs_initiator_buffer_pool_return(&initiator->data.reflector);
   initiator->ras_client.overwritten = false;
 }
 
@@ -575,27 +644,105 @@ static void cs_initiator_select_antennas(uint8_t conn_handle, uint8_t cs_initiat
   }
 }
 
-#if defined (CS_INITIATOR_RAS_MODE_USE_REAL_TIME_MODE) && (CS_INITIATOR_RAS_MODE_USE_REAL_TIME_MODE == 0)
+#if CS_INITIATOR_RAS_ON_DEMAND_USED
 /******************************************************************************
- * Get start and end segments of the lost_segments bitfield.
+ * Request the next range of the lost segments not requested yet.
  *****************************************************************************/
-static void cs_initiator_get_lost_segments(uint64_t lost_segments,
-                                           uint8_t *start_segment,
-                                           uint8_t *end_segment)
+static void request_lost_segments(cs_initiator_t *initiator,
+                                  uint16_t ranging_counter)
 {
-  bool found_start_segment = false;
-  uint64_t bitmask;
-  for (uint64_t i = 0; i < sizeof(uint64_t) * 8; i++) {
-    bitmask = 1ULL << i;
-    if ((bitmask & lost_segments) > 0) {
-      if (!found_start_segment) {
-        *start_segment = i;
-        *end_segment = i;
-        found_start_segment = true;
-      } else {
-        *end_segment = i;
-      }
-    }
+  cs_initiator_segment_range_t range;
+  sl_status_t sc;
+
+  if (!cs_initiator_recovery_next_range(initiator->ras_client.lost_segments,
+                                        CS_INITIATOR_RAS_LOST_SEGMENT_MERGE_GAP,
+                                        &range)) {
+    return;
+  }
+  initiator->ras_client.lost_segments &= ~cs_initiator_recovery_range_mask(&range);
+  sc = cs_ras_client_retreive_lost_segments(initiator->conn_handle,
+                                            ranging_counter,
+                                            range.start_segment,
+                                            range.end_segment,
+                                            CS_INITIATOR_MAX_RANGING_DATA_SIZE,
+                                            initiator->data.reflector.ranging_data);
+  if (sc != SL_STATUS_OK) {
+    initiator_log_error(INSTANCE_PREFIX "RAS - failed to request lost segments! [sc: 0x%lx]" LOG_NL,
+                        initiator->conn_handle,
+                        (unsigned long)sc);
+    initiator->ras_client.lost_segments = 0;
+    on_error(initiator,
+             CS_ERROR_EVENT_RAS_CLIENT_REQUEST_LOST_SEGMENTS_FAILED,
+             sc);
+    return;
+  }
+  initiator_log_info(INSTANCE_PREFIX "RAS - requested lost segments %u -> %u, "
+                                     "left: 0x%16llx" LOG_NL,
+                     initiator->conn_handle,
+                     range.start_segment,
+                     range.end_segment,
+                     initiator->ras_client.lost_segments);
+}
+#endif
+
+#if CS_INITIATOR_RAS_MODE_AUTO
+/******************************************************************************
+ * Feed the outcome of a ranging data transfer to the mode selection policy.
+ *****************************************************************************/
+static void ras_mode_sample(cs_initiator_t *initiator,
+                            bool           lost,
+                            bool           dropped)
+{
+  cs_initiator_ras_sample_t sample;
+  uint32_t ticks = sl_sleeptimer_get_tick_count() - initiator->ras_client.first_segment_tick;
+
+  sample.lost = lost;
+  sample.dropped = dropped;
+  sample.latency_ms = sl_sleeptimer_tick_to_ms(ticks);
+  if (!cs_initiator_ras_policy_update(&initiator->ras_client.policy, &sample)) {
+    return;
+  }
+  initiator_log_info(INSTANCE_PREFIX "RAS - %u permille bad transfers, select %s mode" LOG_NL,
+                     initiator->conn_handle,
+                     initiator->ras_client.policy.bad_permille,
+                     (initiator->ras_client.policy.real_time ? "real-time" : "on-demand"));
+}
+
+/******************************************************************************
+ * Select the RAS mode chosen by the policy. Called at a procedure boundary,
+ * when no RAS operation is in progress.
+ *****************************************************************************/
+static void ras_mode_switch(cs_initiator_t *initiator)
+{
+  cs_ras_mode_t mode;
+  sl_status_t sc;
+
+  initiator->ras_client.real_time_mode = initiator->ras_client.policy.real_time;
+  if (initiator->ras_client.real_time_mode) {
+    // Buffer is lent and reception started once the mode is changed
+    initiator->ras_client.state = RAS_STATE_MODE_REAL_TIME_REENABLE;
+    mode = CS_RAS_MODE_REAL_TIME_RANGING_DATA;
+  } else {
+    initiator->ras_client.state = RAS_STATE_SET_MODE_ON_DEMAND;
+    mode = CS_RAS_MODE_ON_DEMAND_RANGING_DATA;
+  }
+  sc = cs_ras_client_select_mode(initiator->conn_handle, mode);
+  if ((sc == SL_STATUS_NOT_SUPPORTED) && initiator->ras_client.real_time_mode) {
+    // Reflector without Real-Time Ranging Data, stay in On-Demand mode
+    initiator_log_warning(INSTANCE_PREFIX "RAS - real-time mode not supported by the reflector" LOG_NL,
+                          initiator->conn_handle);
+    initiator->ras_client.real_time_mode = false;
+    initiator->ras_client.state = RAS_STATE_MODE_ON_DEMAND;
+    cs_initiator_ras_policy_init(&initiator->ras_client.policy, false);
+    return;
+  }
+  if (sc != SL_STATUS_OK) {
+    initiator_log_error(INSTANCE_PREFIX "RAS - failed to select mode! [sc: 0x%lx]" LOG_NL,
+                        initiator->conn_handle,
+                        (unsigned long)sc);
+    on_error(initiator,
+             CS_ERROR_EVENT_RAS_CLIENT_MODE_CHANGE_FAILED,
+             sc);
   }
 }
 #endif
@@ -622,6 +769,7 @@ sl_status_t cs_initiator_create(const uint8_t               conn_handle,
   cs_error_event_t initiator_err = CS_ERROR_EVENT_UNHANDLED;
   uint8_t cs_initiator_local_antenna_num;
   uint8_t cs_initiator_remote_antenna_num;
+  uint8_t security_mode;
 
   if (conn_handle == SL_BT_INVALID_CONNECTION_HANDLE) {
     return SL_STATUS_INVALID_HANDLE;
@@ -644,12 +792,17 @@ sl_status_t cs_initiator_create(const uint8_t               conn_handle,
 
   initiator_log_debug(INSTANCE_PREFIX "clean-up initiator and reflector data" LOG_NL,
                       initiator->conn_handle);
+  cs_initiator_buffer_pool_return(&initiator->data.initiator);
+  cs_initiator_buffer_pool_return(&initiator->data.reflector);
   memset(initiator, 0, sizeof(cs_initiator_t));
   reset_subevent_data(initiator, false);
   reset_ras_config(initiator);
 
   // Assign connection handle
   initiator->conn_handle = conn_handle;
+#if CS_INITIATOR_TABLE_DISPATCH
+  instance_map[conn_handle] = (uint8_t)(initiator - cs_initiator_instances);
+#endif
   initiator_log_debug(INSTANCE_PREFIX "load initiator configuration" LOG_NL,
                       initiator->conn_handle);
   memcpy(&initiator->config, initiator_config, sizeof(cs_initiator_config_t));
@@ -661,13 +814,14 @@ sl_status_t cs_initiator_create(const uint8_t               conn_handle,
                      cs_initiator_local_antenna_num,
                      cs_initiator_remote_antenna_num);
 
-  sc  = sl_bt_connection_get_security_status(initiator->conn_handle, &initiator->security_mode, NULL, NULL);
+  sc  = sl_bt_connection_get_security_status(initiator->conn_handle, &security_mode, NULL, NULL);
   if (sc != SL_STATUS_OK) {
     initiator_log_error(INSTANCE_PREFIX "failed to get security status" LOG_NL,
                         initiator->conn_handle);
     initiator_err = CS_ERROR_EVENT_INITIATOR_FAILED_TO_GET_SECURITY_STATUS;
     goto cleanup;
   }
+  initiator->security_mode = (sl_bt_connection_security_t)security_mode;
 
   if (initiator->security_mode != sl_bt_connection_mode1_level1) {
     initiator_log_info(INSTANCE_PREFIX "connection already encrypted [level: %u]" LOG_NL,
@@ -795,6 +949,8 @@ sl_status_t cs_initiator_create(const uint8_t               conn_handle,
     }
   }
 
+  initiator->base_connection_interval = initiator->config.max_connection_interval;
+
   // Request connection parameter update.
   sc = sl_bt_connection_set_parameters(initiator->conn_handle,
                                        initiator->config.min_connection_interval,
@@ -857,11 +1013,169 @@ sl_status_t cs_initiator_create(const uint8_t               conn_handle,
   return sc;
 }
 
+/******************************************************************************
+ * Select typed result delivery for an existing initiator instance.
+ *****************************************************************************/
+sl_status_t cs_initiator_set_result_fields_cb(const uint8_t         conn_handle,
+                                              cs_result_fields_cb_t result_fields_cb)
+{
+  cs_initiator_t *initiator = cs_initiator_get_instance(conn_handle);
+  if (initiator == NULL) {
+    return SL_STATUS_NOT_FOUND;
+  }
+  initiator->result_fields_cb = result_fields_cb;
+  initiator_log_debug(INSTANCE_PREFIX "result delivery: %s" LOG_NL,
+                      conn_handle,
+                      (result_fields_cb != NULL) ? "typed" : "buffer");
+  return SL_STATUS_OK;
+}
+
+/******************************************************************************
+ * Request a new procedure interval for an existing initiator instance.
+ *****************************************************************************/
+sl_status_t cs_initiator_set_procedure_interval(const uint8_t conn_handle,
+                                                uint16_t      procedure_interval)
+{
+  cs_initiator_t *initiator = cs_initiator_get_instance(conn_handle);
+  if (initiator == NULL) {
+    return SL_STATUS_NOT_FOUND;
+  }
+  if (procedure_interval == 0) {
+    return SL_STATUS_INVALID_PARAMETER;
+  }
+  if (procedure_interval == initiator->config.max_procedure_interval
+      && procedure_interval == initiator->config.min_procedure_interval) {
+    // Drop a pending change back to the current interval
+    initiator->pending_procedure_interval = 0;
+    return SL_STATUS_OK;
+  }
+  initiator->pending_procedure_interval = procedure_interval;
+  initiator_log_debug(INSTANCE_PREFIX "procedure interval %u requested" LOG_NL,
+                      conn_handle,
+                      procedure_interval);
+  return SL_STATUS_OK;
+}
+
+/******************************************************************************
+ * Stretch the connection interval of a running initiator instance.
+ *****************************************************************************/
+sl_status_t cs_initiator_set_connection_interval_factor(const uint8_t conn_handle,
+                                                        uint8_t       factor)
+{
+  uint32_t interval;
+  uint32_t max_interval;
+  cs_initiator_t *initiator = cs_initiator_get_instance(conn_handle);
+  if (initiator == NULL) {
+    return SL_STATUS_NOT_FOUND;
+  }
+  if (factor == 0) {
+    return SL_STATUS_INVALID_PARAMETER;
+  }
+  if (initiator->base_connection_interval == 0) {
+    // Connection not set up yet, it starts with the set up interval
+    return (factor == 1) ? SL_STATUS_OK : SL_STATUS_INVALID_STATE;
+  }
+  // Two connection event periods must fit in the supervision timeout:
+  // interval * 1.25 ms * (1 + latency) * 2 < timeout * 10 ms
+  max_interval = ((uint32_t)initiator->config.timeout * 4u - 1u)
+                 / (1u + initiator->config.latency);
+  if (max_interval > CONNECTION_INTERVAL_MAX) {
+    max_interval = CONNECTION_INTERVAL_MAX;
+  }
+  interval = (uint32_t)initiator->base_connection_interval * factor;
+  if (interval > max_interval) {
+    interval = max_interval;
+  }
+  if (interval < initiator->base_connection_interval) {
+    interval = initiator->base_connection_interval;
+  }
+  if (interval == initiator->config.max_connection_interval
+      && interval == initiator->config.min_connection_interval) {
+    // Drop a pending change back to the current interval
+    initiator->pending_connection_interval = 0;
+    return SL_STATUS_OK;
+  }
+  initiator->pending_connection_interval = (uint16_t)interval;
+  initiator_log_debug(INSTANCE_PREFIX "connection interval %lu requested" LOG_NL,
+                      conn_handle,
+                      (unsigned long)interval);
+  return SL_STATUS_OK;
+}
+
+/******************************************************************************
+ * Hand over the RAS attributes found on a previous connection.
+ *****************************************************************************/
+sl_status_t cs_initiator_set_ras_attributes(const uint8_t                 conn_handle,
+                                            const cs_ras_gattdb_handles_t *handles,
+                                            cs_ras_features_t             features)
+{
+  cs_initiator_t *initiator = cs_initiator_get_instance(conn_handle);
+  if (initiator == NULL) {
+    return SL_STATUS_NOT_FOUND;
+  }
+  if (handles == NULL) {
+    return SL_STATUS_NULL_POINTER;
+  }
+  if (initiator->ras_client.state != RAS_STATE_INIT) {
+    return SL_STATUS_INVALID_STATE;
+  }
+  memcpy(&initiator->ras_client.gattdb_handles,
+         handles,
+         sizeof(initiator->ras_client.gattdb_handles));
+  initiator->ras_client.cached_features = features;
+  initiator->ras_client.cached = true;
+  return SL_STATUS_OK;
+}
+
+/******************************************************************************
+ * Get the RAS attributes in use.
+ *****************************************************************************/
+sl_status_t cs_initiator_get_ras_attributes(const uint8_t           conn_handle,
+                                            cs_ras_gattdb_handles_t *handles,
+                                            cs_ras_features_t       *features)
+{
+  sl_status_t sc;
+  cs_initiator_t *initiator = cs_initiator_get_instance(conn_handle);
+  if (initiator == NULL) {
+    return SL_STATUS_NOT_FOUND;
+  }
+  if (handles == NULL || features == NULL) {
+    return SL_STATUS_NULL_POINTER;
+  }
+  sc = cs_ras_client_get_features(conn_handle, features);
+  if (sc != SL_STATUS_OK) {
+    return (sc == SL_STATUS_NOT_FOUND) ? SL_STATUS_INVALID_STATE : sc;
+  }
+  memcpy(handles,
+         &initiator->ras_client.gattdb_handles,
+         sizeof(initiator->ras_client.gattdb_handles));
+  return SL_STATUS_OK;
+}
+
+/******************************************************************************
+ * Timestamp the gate decision of the last delivered result.
+ *****************************************************************************/
+sl_status_t cs_initiator_mark_gate_decision(const uint8_t conn_handle)
+{
+  cs_initiator_t *initiator = cs_initiator_get_instance(conn_handle);
+  if (initiator == NULL) {
+    return SL_STATUS_NOT_FOUND;
+  }
+  cs_initiator_latency_mark(initiator, CS_INITIATOR_LATENCY_GATE_DECISION);
+  return SL_STATUS_OK;
+}
+
 /******************************************************************************
  * Initialize instance slots.
  *****************************************************************************/
 void cs_initiator_init(void)
 {
+  cs_initiator_buffer_pool_init();
+  cs_initiator_latency_init();
+  cs_initiator_capture_init();
+#if CS_INITIATOR_TABLE_DISPATCH
+  memset(instance_map, INSTANCE_MAP_NONE, sizeof(instance_map));
+#endif
   for (uint8_t i = 0u; i < CS_INITIATOR_MAX_CONNECTIONS; i++) {
     cs_initiator_t *initiator = &cs_initiator_instances[i];
     memset(initiator, 0, sizeof(cs_initiator_instances[0]));
@@ -1036,8 +1350,16 @@ void cs_ras_client_on_mode_changed(uint8_t       connection,
                                                     INITIATOR_EVT_INIT_COMPLETED,
                                                     &evt_data);
       } else {
+        if (!cs_initiator_buffer_pool_lend(&initiator->data.reflector)) {
+          initiator_log_error(INSTANCE_PREFIX "RAS - no free ranging buffer for real-time data!" LOG_NL,
+                              initiator->conn_handle);
+          on_error(initiator,
+                   CS_ERROR_EVENT_RAS_CLIENT_REALTIME_RECEIVE_FAILED,
+                   SL_STATUS_NO_MORE_RESOURCE);
+          break;
+        }
         sc = cs_ras_client_real_time_receive(initiator->conn_handle,
-                                             sizeof(initiator->data.reflector.ranging_data),
+                                             CS_INITIATOR_MAX_RANGING_DATA_SIZE,
                                              initiator->data.reflector.ranging_data);
         if (sc != SL_STATUS_OK) {
           initiator_log_error(INSTANCE_PREFIX "RAS - failed to receive real-time data! [sc: 0x%lx]" LOG_NL,
@@ -1051,8 +1373,13 @@ void cs_ras_client_on_mode_changed(uint8_t       connection,
       initiator->ras_client.state = RAS_STATE_MODE_REAL_TIME;
       break;
     case CS_RAS_MODE_ON_DEMAND_RANGING_DATA:
-      initiator->ras_client.state = RAS_STATE_MODE_ON_DEMAND;
       initiator->ras_client.overwritten = false;
+      if (initiator->ras_client.state == RAS_STATE_SET_MODE_ON_DEMAND) {
+        // Switched from Real-Time mode, the instance is initialized
+        initiator->ras_client.state = RAS_STATE_MODE_ON_DEMAND;
+        break;
+      }
+      initiator->ras_client.state = RAS_STATE_MODE_ON_DEMAND;
       evt_data.evt_init_completed = true;
       (void)initiator_state_machine_event_handler(initiator,
                                                   INITIATOR_EVT_INIT_COMPLETED,
@@ -1083,6 +1410,27 @@ void cs_ras_client_on_mode_changed(uint8_t       connection,
   }
 }
 
+/******************************************************************************
+ * RAS client callback that indicates a stored segment of ranging data.
+ *****************************************************************************/
+void cs_ras_client_on_ranging_data_segment(uint8_t  connection,
+                                           uint32_t offset,
+                                           uint32_t size)
+{
+  cs_initiator_t *initiator = cs_initiator_get_instance(connection);
+  if (initiator == NULL) {
+    return;
+  }
+  if (offset == 0) {
+    cs_initiator_latency_mark(initiator, CS_INITIATOR_LATENCY_FIRST_RAS_SEGMENT);
+  }
+  if ((offset == 0) && initiator->ras_client.real_time_mode) {
+    // On-Demand transfers are timed from the data ready notification
+    initiator->ras_client.first_segment_tick = sl_sleeptimer_get_tick_count();
+  }
+  ranging_data_segment_arrived(initiator, offset, size);
+}
+
 /******************************************************************************
  * RAS client callback that indicates the end of reception of ranging data.
  *****************************************************************************/
@@ -1110,11 +1458,21 @@ void cs_ras_client_on_ranging_data_reception_finished(uint8_t
              SL_STATUS_NULL_POINTER);
     return;
   }
+  ranging_data_reception_finished(initiator);
   cs_initiator_report(CS_INITIATOR_REPORT_LAST_CS_RESULT_BEGIN);
+  #if CS_INITIATOR_RAS_MODE_AUTO
+  if (real_time && (sc != SL_STATUS_ABORT)) {
+    ras_mode_sample(initiator, (lost_segments != 0), (sc != SL_STATUS_OK));
+    if (initiator->ras_client.real_time_mode && !initiator->ras_client.policy.real_time) {
+      // Switch instead of re-enabling, this data is still processed
+      ras_mode_switch(initiator);
+    }
+  }
+  #endif
   if (initiator->ras_client.real_time_mode) {
     // Re-enable reception for Real-Time mode
     status = cs_ras_client_real_time_receive(initiator->conn_handle,
-                                             sizeof(initiator->data.reflector.ranging_data),
+                                             CS_INITIATOR_MAX_RANGING_DATA_SIZE,
                                              initiator->data.reflector.ranging_data);
     if (status != SL_STATUS_OK) {
       initiator_log_error(INSTANCE_PREFIX "RAS - failed to receive real-time data! [sc: 0x%lx]" LOG_NL,
@@ -1129,7 +1487,18 @@ void cs_ras_client_on_ranging_data_reception_finished(uint8_t
     initiator_log_info(INSTANCE_PREFIX "RAS - real-time data reception restarted" LOG_NL,
                        initiator->conn_handle);
   }
-  if ((sc != SL_STATUS_OK) || (lost_segments > 0)) {
+  #if CS_INITIATOR_RAS_MODE_AUTO
+  if ((sc == SL_STATUS_OK) && real_time && (lost_segments > 0)) {
+    // Counted by the mode selection policy, only this procedure is dropped
+    initiator_log_warning(INSTANCE_PREFIX "RAS - real-time segments lost, "
+                                          "counter %u dropped" LOG_NL,
+                          initiator->conn_handle,
+                          ranging_counter);
+    return;
+  }
+  #endif
+  // Lost On-Demand segments can be retrieved again
+  if ((sc != SL_STATUS_OK) || (real_time && (lost_segments > 0))) {
     initiator_log_error(INSTANCE_PREFIX "RAS - reception finished - failure! [sc: 0x%lx]" LOG_NL,
                         initiator->conn_handle,
                         (unsigned long)sc);
@@ -1159,6 +1528,7 @@ void cs_ras_client_on_ranging_data_reception_finished(uint8_t
                      lost_segments);
   if (real_time) {
     initiator->data.reflector.ranging_data_size = size;
+    cs_initiator_latency_mark(initiator, CS_INITIATOR_LATENCY_LAST_RAS_SEGMENT);
     process_remote_ranging_data(initiator,
                                 initiator->data.reflector.ranging_data,
                                 initiator->data.reflector.ranging_data_size);
@@ -1174,9 +1544,28 @@ void cs_ras_client_on_ranging_data_reception_finished(uint8_t
   (void)recoverable;
   (void)last_arrived;
   (void)last_known_segment;
-  #if defined (CS_INITIATOR_RAS_MODE_USE_REAL_TIME_MODE) && (CS_INITIATOR_RAS_MODE_USE_REAL_TIME_MODE == 0)
+  #if CS_INITIATOR_RAS_ON_DEMAND_USED
   // Received Complete Ranging Data or Complete Lost Ranging Segment Response
   if (response == CS_RAS_CP_RESPONSE_CODE_SUCCESS) {
+    if (!retrieve_lost) {
+      initiator->data.reflector.ranging_data_size = size;
+      initiator->ras_client.segments_lost = (lost_segments != 0);
+      if ((lost_segments != 0) && recoverable && (initiator->config.max_procedure_count != 0)) {
+        // Retrieval requests follow each other from this callback
+        initiator->ras_client.lost_segments = lost_segments;
+        request_lost_segments(initiator, ranging_counter);
+        return;
+      }
+    } else if (lost_segments == 0) {
+      // Retrieved segments are merged in place, the data ends with the last one
+      if (size > initiator->data.reflector.ranging_data_size) {
+        initiator->data.reflector.ranging_data_size = size;
+      }
+      if (initiator->ras_client.lost_segments != 0) {
+        request_lost_segments(initiator, ranging_counter);
+        return;
+      }
+    }
     if (lost_segments == 0) {
       if (retrieve_lost) {
         initiator_log_info(INSTANCE_PREFIX "RAS - Received Complete Lost Ranging Segment Response" LOG_NL,
@@ -1199,39 +1588,25 @@ void cs_ras_client_on_ranging_data_reception_finished(uint8_t
       }
       initiator_log_info(INSTANCE_PREFIX "RAS - ACK was sent!" LOG_NL,
                          initiator->conn_handle);
-      initiator->data.reflector.ranging_data_size = size;
+      cs_initiator_latency_mark(initiator, CS_INITIATOR_LATENCY_LAST_RAS_SEGMENT);
+      #if CS_INITIATOR_RAS_MODE_AUTO
+      // Switched when the ACK is finished
+      ras_mode_sample(initiator, initiator->ras_client.segments_lost, false);
+      #endif
       process_remote_ranging_data(initiator,
                                   initiator->data.reflector.ranging_data,
                                   initiator->data.reflector.ranging_data_size);
       return;
     } else {
-      if (!retrieve_lost && recoverable && initiator->config.max_procedure_count != 0) {
-        // Get start and end segment
-        cs_initiator_get_lost_segments(lost_segments,
-                                       &start_segment,
-                                       &end_segment);
-        // Request lost segments
-        status = cs_ras_client_retreive_lost_segments(initiator->conn_handle,
-                                                      ranging_counter,
-                                                      start_segment,
-                                                      end_segment,
-                                                      sizeof(initiator->data.reflector.ranging_data),
-                                                      initiator->data.reflector.ranging_data);
-        if (status != SL_STATUS_OK) {
-          initiator_log_error(INSTANCE_PREFIX "RAS - failed to request lost segments! [sc: 0x%lx]" LOG_NL,
-                              initiator->conn_handle,
-                              (unsigned long)sc);
-          on_error(initiator,
-                   CS_ERROR_EVENT_RAS_CLIENT_REQUEST_LOST_SEGMENTS_FAILED,
-                   sc);
-          return;
-        }
-      }
+      initiator->ras_client.lost_segments = 0;
       // Complete Lost Ranging Segment Response returned with lost segments
       // Or not recoverable lost segments arrived
       // sending ACK, no calculation
       initiator_log_error(INSTANCE_PREFIX "RAS - unrecoverable lost segments, sending ACK!" LOG_NL,
                           initiator->conn_handle);
+      #if CS_INITIATOR_RAS_MODE_AUTO
+      ras_mode_sample(initiator, true, true);
+      #endif
       status = cs_ras_client_ack(initiator->conn_handle,
                                  ranging_counter);
       if (status != SL_STATUS_OK) {
@@ -1248,10 +1623,12 @@ void cs_ras_client_on_ranging_data_reception_finished(uint8_t
   #endif
 }
 
-#if defined (CS_INITIATOR_RAS_MODE_USE_REAL_TIME_MODE) && (CS_INITIATOR_RAS_MODE_USE_REAL_TIME_MODE == 0)
+#if CS_INITIATOR_RAS_ON_DEMAND_USED
 void cs_ras_client_on_ack_finished(uint8_t connection, sl_status_t sc, cs_ras_cp_response_code_value_t response)
 {
   cs_initiator_t *initiator = cs_initiator_get_instance(connection);
+  (void)sc;
+  (void)response;
   if (initiator == NULL) {
     initiator_log_error(INSTANCE_PREFIX "RAS - ranging data ready - unknown connection id!" LOG_NL,
                         connection);
@@ -1264,6 +1641,12 @@ void cs_ras_client_on_ack_finished(uint8_t connection, sl_status_t sc, cs_ras_cp
                      initiator->conn_handle,
                      (unsigned long)sc,
                      (unsigned long)response);
+  #if CS_INITIATOR_RAS_MODE_AUTO
+  // Procedure boundary, the Control Point is free again
+  if (initiator->ras_client.real_time_mode != initiator->ras_client.policy.real_time) {
+    ras_mode_switch(initiator);
+  }
+  #endif
 }
 
 void cs_ras_client_on_ranging_data_ready(uint8_t connection,
@@ -1281,12 +1664,20 @@ void cs_ras_client_on_ranging_data_ready(uint8_t connection,
   initiator_log_info(INSTANCE_PREFIX "RAS - ranging data ready, counter: %u" LOG_NL,
                      initiator->conn_handle,
                      ranging_counter);
+  initiator->ras_client.first_segment_tick = sl_sleeptimer_get_tick_count();
   // write GET to RAS CP
   if (((ranging_counter & CS_RAS_RANGING_COUNTER_MASK) == initiator->ranging_counter)
       && (initiator->ras_client.overwritten == false || initiator->ranging_counter != ranging_counter)) {
+    if (!cs_initiator_buffer_pool_lend(&initiator->data.reflector)) {
+      // Procedure is dropped, the drop counter resynchronizes the instance
+      initiator_log_warning(INSTANCE_PREFIX "RAS - no free ranging buffer, skip counter %u" LOG_NL,
+                            initiator->conn_handle,
+                            ranging_counter);
+      return;
+    }
     sl_status_t sc = cs_ras_client_get_ranging_data(initiator->conn_handle,
                                                     (uint16_t)ranging_counter,
-                                                    sizeof(initiator->data.reflector.ranging_data),
+                                                    CS_INITIATOR_MAX_RANGING_DATA_SIZE,
                                                     initiator->data.reflector.ranging_data);
     if (sc != SL_STATUS_OK) {
       initiator_log_error(INSTANCE_PREFIX "RAS - failed to get ranging data! [sc: 0x%lx]" LOG_NL,
@@ -1306,6 +1697,8 @@ void cs_ras_client_on_ranging_data_ready(uint8_t connection,
 void cs_ras_client_on_abort_finished(uint8_t connection, sl_status_t sc, cs_ras_cp_response_code_value_t response)
 {
   cs_initiator_t *initiator = cs_initiator_get_instance(connection);
+  (void)sc;
+  (void)response;
   if (initiator == NULL) {
     initiator_log_error(INSTANCE_PREFIX "RAS - abort finished - unknown connection id!" LOG_NL,
                         connection);
@@ -1340,13 +1733,15 @@ void cs_ras_client_on_ranging_data_overwritten(uint8_t connection, cs_ras_rangin
                      initiator->conn_handle,
                      ranging_counter);
 }
-#endif // CS_RAS_MODE_ON_DEMAND_RANGING_DATA
+#endif // CS_INITIATOR_RAS_ON_DEMAND_USED
 
 bool cs_ras_client_on_timeout(uint8_t connection,
                               cs_ras_client_timeout_t timeout,
                               cs_ras_client_timeout_action_t action)
 {
   cs_initiator_t *initiator = cs_initiator_get_instance(connection);
+  (void)timeout;
+  (void)action;
   initiator_log_debug(INSTANCE_PREFIX "RAS timeout: %u, action: %u" LOG_NL,
                       connection,
                       timeout,
@@ -1387,6 +1782,33 @@ bool cs_initiator_on_event(sl_bt_msg_t *evt)
       // initiation or the value set by local or the peer user.
       initiator->conn_interval = evt->data.evt_connection_parameters.interval;
 
+      if (initiator->wait_connection_parameters) {
+        // Interval stretched or restored at a procedure boundary, the
+        // estimator follows the new interval before the procedures restart
+        initiator->wait_connection_parameters = false;
+        app_timer_stop(&initiator->timer_handle);
+        initiator->cs_parameters.connection_interval = initiator->conn_interval;
+        rtl_err = sl_rtl_cs_set_cs_params(&initiator->rtl_handle,
+                                          &initiator->cs_parameters);
+        if (rtl_err != SL_RTL_ERROR_SUCCESS) {
+          initiator_log_warning(INSTANCE_PREFIX "RTL - failed to set connection interval %u! "
+                                                "[E: 0x%x]" LOG_NL,
+                                initiator->conn_handle,
+                                initiator->conn_interval,
+                                rtl_err);
+        }
+        initiator_log_info(INSTANCE_PREFIX "Connection interval: %u" LOG_NL,
+                           initiator->conn_handle,
+                           initiator->conn_interval);
+        if (initiator->initiator_state == (uint8_t)INITIATOR_STATE_START_PROCEDURE) {
+          (void)initiator_state_machine_event_handler(initiator,
+                                                      INITIATOR_EVT_START_PROCEDURE,
+                                                      NULL);
+        }
+        handled = true;
+        break;
+      }
+
       // Check if the connection parameters are set correctly the first time.
       if (!cs_initiator_check_connection_parameters(initiator, &evt->data.evt_connection_parameters)
           && !initiator->connection_parameters_set) {
@@ -1419,6 +1841,19 @@ bool cs_initiator_on_event(sl_bt_msg_t *evt)
         initiator_log_info(INSTANCE_PREFIX "CS - connection parameters set: "
                                            "encryption on. " LOG_NL,
                            initiator->conn_handle);
+        if (initiator->ras_client.state == RAS_STATE_INIT
+            && initiator->ras_client.cached) {
+          if (start_cached_ras_client(initiator)) {
+            init_cs_configuration(initiator->conn_handle);
+            handled = true;
+            break;
+          }
+          // Stale cache, forget it and discover
+          initiator->ras_client.cached = false;
+          memset(&initiator->ras_client.gattdb_handles,
+                 0,
+                 sizeof(initiator->ras_client.gattdb_handles));
+        }
         if (initiator->ras_client.state == RAS_STATE_INIT) {
           initiator_log_info(INSTANCE_PREFIX "Start discovering RAS service "
                                              "& characteristic ..." LOG_NL,
@@ -1472,10 +1907,11 @@ bool cs_initiator_on_event(sl_bt_msg_t *evt)
     case sl_bt_evt_gatt_procedure_completed_id:
       initiator = cs_initiator_get_instance(evt->data.evt_gatt_procedure_completed.connection);
       if (initiator == NULL) {
-        initiator_log_error("Unexpected event "
+        // Other connections may use GATT too
+        initiator_log_debug("Ignored event "
                             "[sl_bt_evt_gatt_procedure_completed_id]!"
                             "Unknown target connection id: %u" LOG_NL,
-                            evt->data.evt_connection_parameters.connection);
+                            evt->data.evt_gatt_procedure_completed.connection);
         break;
       }
       handled = ras_client_handler(initiator, evt);
@@ -1486,10 +1922,11 @@ bool cs_initiator_on_event(sl_bt_msg_t *evt)
     case sl_bt_evt_gatt_characteristic_id:
       initiator = cs_initiator_get_instance(evt->data.evt_gatt_characteristic.connection);
       if (initiator == NULL) {
-        initiator_log_error("Unexpected event "
+        // Other connections may use GATT too
+        initiator_log_debug("Ignored event "
                             "[sl_bt_evt_gatt_characteristic_id]!"
                             "Unknown target connection id: %u" LOG_NL,
-                            evt->data.evt_gatt_service.connection);
+                            evt->data.evt_gatt_characteristic.connection);
         break;
       }
 
@@ -1509,7 +1946,8 @@ bool cs_initiator_on_event(sl_bt_msg_t *evt)
     case sl_bt_evt_gatt_service_id:
       initiator = cs_initiator_get_instance(evt->data.evt_gatt_service.connection);
       if (initiator == NULL) {
-        initiator_log_error("Unexpected event [sl_bt_evt_gatt_service_id]!"
+        // Other connections may use GATT too
+        initiator_log_debug("Ignored event [sl_bt_evt_gatt_service_id]!"
                             "Unknown target connection id: %u" LOG_NL,
                             evt->data.evt_gatt_service.connection);
         break;
@@ -1672,6 +2110,10 @@ bool cs_initiator_on_event(sl_bt_msg_t *evt)
       if (initiator->initiator_state == INITIATOR_STATE_WAIT_REFLECTOR_PROCEDURE_COMPLETE
           || initiator->initiator_state == INITIATOR_STATE_WAIT_REFLECTOR_PROCEDURE_ABORTED) {
         initiator->drop_counter++;
+        #if CS_INITIATOR_RAS_MODE_AUTO
+        // Applied at the end of the ongoing transfer
+        ras_mode_sample(initiator, false, true);
+        #endif
         if (initiator->drop_counter > CS_INITIATOR_MAX_DROP) {
           initiator->drop_counter = 0;
           initiator->ranging_counter = CS_RAS_INVALID_RANGING_COUNTER;
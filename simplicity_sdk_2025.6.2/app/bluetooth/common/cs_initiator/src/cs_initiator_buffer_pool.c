@@ -0,0 +1,142 @@
+/***************************************************************************//**
+ * @file
+ * @brief CS initiator - ranging buffer pool implementation
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2025 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+// -----------------------------------------------------------------------------
+// Includes
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "cs_initiator_config.h"
+#include "cs_initiator_buffer_pool.h"
+
+// -----------------------------------------------------------------------------
+// Macros
+
+#if (CS_INITIATOR_RANGING_BUFFER_POOL_SIZE < 1) || (CS_INITIATOR_RANGING_BUFFER_POOL_SIZE > 255)
+#error "CS_INITIATOR_RANGING_BUFFER_POOL_SIZE must be in 1..255"
+#endif
+
+// Every real-time connection keeps its reflector buffer
+#if ((defined(CS_INITIATOR_RAS_MODE_USE_REAL_TIME_MODE) && (CS_INITIATOR_RAS_MODE_USE_REAL_TIME_MODE == 1)) \
+  || (defined(CS_INITIATOR_RAS_MODE_AUTO) && (CS_INITIATOR_RAS_MODE_AUTO == 1))) \
+  && (CS_INITIATOR_RANGING_BUFFER_POOL_SIZE <= CS_INITIATOR_MAX_CONNECTIONS)
+#error "CS_INITIATOR_RANGING_BUFFER_POOL_SIZE must exceed CS_INITIATOR_MAX_CONNECTIONS in real-time or automatic RAS mode"
+#endif
+
+// Keep every block 4 byte aligned for the RAS header casts
+#define POOL_BLOCK_SIZE  ((CS_INITIATOR_MAX_RANGING_DATA_SIZE + 3u) & ~3u)
+
+// -----------------------------------------------------------------------------
+// Static variables
+
+static uint32_t pool_arena[CS_INITIATOR_RANGING_BUFFER_POOL_SIZE][POOL_BLOCK_SIZE / sizeof(uint32_t)];
+
+// Stack of free block indexes, free_count entries are valid
+static uint8_t free_stack[CS_INITIATOR_RANGING_BUFFER_POOL_SIZE];
+static uint8_t free_count;
+static uint8_t peak_in_use;
+static uint32_t failed_count;
+
+// -----------------------------------------------------------------------------
+// Public functions
+
+/******************************************************************************
+ * Initialize the ranging buffer pool.
+ *****************************************************************************/
+void cs_initiator_buffer_pool_init(void)
+{
+  for (uint8_t i = 0u; i < CS_INITIATOR_RANGING_BUFFER_POOL_SIZE; i++) {
+    free_stack[i] = (uint8_t)(CS_INITIATOR_RANGING_BUFFER_POOL_SIZE - 1u - i);
+  }
+  free_count = CS_INITIATOR_RANGING_BUFFER_POOL_SIZE;
+  peak_in_use = 0u;
+  failed_count = 0u;
+}
+
+/******************************************************************************
+ * Lend a buffer to a ranging data array.
+ *****************************************************************************/
+bool cs_initiator_buffer_pool_lend(ranging_data_array_t *array)
+{
+  uint8_t in_use;
+
+  if (array->ranging_data != NULL) {
+    return true;
+  }
+  if (free_count == 0u) {
+    failed_count++;
+    return false;
+  }
+  free_count--;
+  array->ranging_data = (uint8_t *)pool_arena[free_stack[free_count]];
+  array->ranging_data_size = 0u;
+  memset(array->ranging_data, 0xFF, CS_INITIATOR_MAX_RANGING_DATA_SIZE);
+
+  in_use = (uint8_t)(CS_INITIATOR_RANGING_BUFFER_POOL_SIZE - free_count);
+  if (in_use > peak_in_use) {
+    peak_in_use = in_use;
+  }
+  return true;
+}
+
+/******************************************************************************
+ * Give the buffer of a ranging data array back to the pool.
+ *****************************************************************************/
+void cs_initiator_buffer_pool_return(ranging_data_array_t *array)
+{
+  uintptr_t offset;
+
+  if (array->ranging_data == NULL) {
+    return;
+  }
+  offset = (uintptr_t)array->ranging_data - (uintptr_t)pool_arena;
+  array->ranging_data = NULL;
+  array->ranging_data_size = 0u;
+  // Ignore anything that was not lent by this pool
+  if (offset >= sizeof(pool_arena)
+      || (offset % POOL_BLOCK_SIZE) != 0u
+      || free_count >= CS_INITIATOR_RANGING_BUFFER_POOL_SIZE) {
+    return;
+  }
+  free_stack[free_count] = (uint8_t)(offset / POOL_BLOCK_SIZE);
+  free_count++;
+}
+
+/******************************************************************************
+ * Get the pool usage.
+ *****************************************************************************/
+void cs_initiator_buffer_pool_get_stats(cs_initiator_buffer_pool_stats_t *stats)
+{
+  stats->size = CS_INITIATOR_RANGING_BUFFER_POOL_SIZE;
+  stats->in_use = (uint8_t)(CS_INITIATOR_RANGING_BUFFER_POOL_SIZE - free_count);
+  stats->peak = peak_in_use;
+  stats->failed = failed_count;
+}
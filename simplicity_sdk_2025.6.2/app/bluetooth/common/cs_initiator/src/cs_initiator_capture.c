@@ -0,0 +1,243 @@
+/***************************************************************************//**
+ * @file
+ * @brief CS initiator - binary procedure capture
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2025 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+// Includes
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "cs_initiator_capture.h"
+
+#if defined(CS_INITIATOR_CAPTURE) && (CS_INITIATOR_CAPTURE == 1)
+#include "sl_bt_api.h"
+#include "sl_sleeptimer.h"
+#include "SEGGER_RTT.h"
+#include "cs_result.h"
+
+// -----------------------------------------------------------------------------
+// Macros
+
+#define RTT_INDEX  CS_INITIATOR_CAPTURE_RTT_BUFFER_INDEX
+
+#if CS_INITIATOR_CAPTURE_RTT_BUFFER_INDEX >= SEGGER_RTT_MAX_NUM_UP_BUFFERS
+#error "CS_INITIATOR_CAPTURE_RTT_BUFFER_INDEX exceeds the RTT up buffers"
+#endif
+
+// Type byte and float value per field, as in the cs_result buffer
+#define FIELD_SIZE (sizeof(uint8_t) + sizeof(float))
+
+// -----------------------------------------------------------------------------
+// Static function declarations
+
+static bool record_begin(uint8_t  type,
+                         uint8_t  conn_handle,
+                         uint32_t length);
+static void put(const void *data, uint32_t size);
+
+// -----------------------------------------------------------------------------
+// Static variables
+
+static uint8_t rtt_buffer[CS_INITIATOR_CAPTURE_BUFFER_SIZE];
+static uint32_t lost_pending;
+static uint32_t lost_total;
+
+// Result fields of the procedure being estimated
+static uint8_t fields[CS_RESULT_FIELD_COUNT * FIELD_SIZE];
+static uint8_t num_fields;
+
+// -----------------------------------------------------------------------------
+// Public function definitions
+
+/******************************************************************************
+ * Set up the RTT up buffer of the capture and write the start record.
+ *****************************************************************************/
+void cs_initiator_capture_init(void)
+{
+  cs_initiator_capture_start_t start = {
+    .magic = CS_INITIATOR_CAPTURE_MAGIC,
+    .version = CS_INITIATOR_CAPTURE_VERSION,
+    .cs_params_size = sizeof(sl_rtl_cs_params),
+    .procedure_config_size = sizeof(sl_rtl_cs_procedure_config),
+    .reserved = 0u,
+    .timer_frequency = sl_sleeptimer_get_timer_frequency()
+  };
+
+  // Skip mode never waits for the debugger, a full buffer drops records
+  (void)SEGGER_RTT_ConfigUpBuffer(RTT_INDEX,
+                                  "cs_capture",
+                                  rtt_buffer,
+                                  sizeof(rtt_buffer),
+                                  SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+  lost_pending = 0u;
+  lost_total = 0u;
+  num_fields = 0u;
+  if (record_begin(CS_INITIATOR_CAPTURE_RECORD_START,
+                   SL_BT_INVALID_CONNECTION_HANDLE,
+                   sizeof(start))) {
+    put(&start, sizeof(start));
+  }
+}
+
+/******************************************************************************
+ * Write the input of sl_rtl_ras_process() for one procedure.
+ *****************************************************************************/
+void cs_initiator_capture_procedure(uint8_t                     conn_handle,
+                                    uint16_t                    ranging_counter,
+                                    const sl_rtl_cs_params      *cs_params,
+                                    const sl_rtl_ras_procedure  *procedure)
+{
+  const sl_rtl_ras_measurement *initiator = procedure->initiator_ras_measurement;
+  const sl_rtl_ras_measurement *reflector = procedure->reflector_ras_measurement;
+  cs_initiator_capture_procedure_t record = {
+    .ranging_counter = ranging_counter,
+    .num_antenna_paths = procedure->ras_info.num_antenna_paths,
+    .num_steps = procedure->ras_info.num_steps_reported,
+    .initiator_len = initiator->ranging_data_body_len,
+    .reflector_len = reflector->ranging_data_body_len,
+    .cs_params = *cs_params,
+    .procedure_config = procedure->cs_procedure_config
+  };
+
+  num_fields = 0u;
+  if (!record_begin(CS_INITIATOR_CAPTURE_RECORD_PROCEDURE,
+                    conn_handle,
+                    sizeof(record)
+                    + record.num_steps
+                    + record.initiator_len
+                    + record.reflector_len)) {
+    return;
+  }
+  put(&record, sizeof(record));
+  put(procedure->ras_info.step_channels, record.num_steps);
+  put(initiator->ranging_data_body, record.initiator_len);
+  put(reflector->ranging_data_body, record.reflector_len);
+}
+
+/******************************************************************************
+ * Add a result field of the procedure being estimated.
+ *****************************************************************************/
+void cs_initiator_capture_field(uint8_t type, float value)
+{
+  if (num_fields >= CS_RESULT_FIELD_COUNT) {
+    return;
+  }
+  fields[num_fields * FIELD_SIZE] = type;
+  memcpy(&fields[num_fields * FIELD_SIZE + sizeof(uint8_t)], &value, sizeof(value));
+  num_fields++;
+}
+
+/******************************************************************************
+ * Write the result record of the procedure being estimated.
+ *****************************************************************************/
+void cs_initiator_capture_result(uint8_t                 conn_handle,
+                                 uint16_t                ranging_counter,
+                                 enum sl_rtl_error_code  rtl_error)
+{
+  cs_initiator_capture_result_t record = {
+    .ranging_counter = ranging_counter,
+    .rtl_error = (uint8_t)rtl_error,
+    .num_fields = num_fields
+  };
+
+  num_fields = 0u;
+  if (!record_begin(CS_INITIATOR_CAPTURE_RECORD_RESULT,
+                    conn_handle,
+                    sizeof(record) + record.num_fields * FIELD_SIZE)) {
+    return;
+  }
+  put(&record, sizeof(record));
+  put(fields, record.num_fields * FIELD_SIZE);
+}
+
+/******************************************************************************
+ * Get the number of records dropped because the RTT buffer was full.
+ *****************************************************************************/
+uint32_t cs_initiator_capture_get_lost(void)
+{
+  return lost_total;
+}
+
+// -----------------------------------------------------------------------------
+// Static function definitions
+
+/******************************************************************************
+ * Write a record header if the whole record fits into the RTT buffer.
+ * A pending lost record is written first.
+ *
+ * @param[in] type record type
+ * @param[in] conn_handle connection handle
+ * @param[in] length payload length
+ *
+ * @return true if the payload has to be written
+ *****************************************************************************/
+static bool record_begin(uint8_t  type,
+                         uint8_t  conn_handle,
+                         uint32_t length)
+{
+  cs_initiator_capture_header_t header;
+  cs_initiator_capture_lost_t lost;
+  uint32_t needed = sizeof(header) + length;
+
+  if (lost_pending > 0u) {
+    needed += sizeof(header) + sizeof(lost);
+  }
+  if ((length > UINT16_MAX) || (SEGGER_RTT_GetAvailWriteSpace(RTT_INDEX) < needed)) {
+    lost_pending++;
+    lost_total++;
+    return false;
+  }
+  header.timestamp = sl_sleeptimer_get_tick_count();
+  header.conn_handle = conn_handle;
+  if (lost_pending > 0u) {
+    header.length = sizeof(lost);
+    header.type = CS_INITIATOR_CAPTURE_RECORD_LOST;
+    lost.records = lost_pending;
+    put(&header, sizeof(header));
+    put(&lost, sizeof(lost));
+    lost_pending = 0u;
+  }
+  header.length = (uint16_t)length;
+  header.type = type;
+  put(&header, sizeof(header));
+  return true;
+}
+
+/******************************************************************************
+ * Copy part of a record into the RTT buffer, the space has been checked.
+ *****************************************************************************/
+static void put(const void *data, uint32_t size)
+{
+  if (size > 0u) {
+    (void)SEGGER_RTT_WriteNoLock(RTT_INDEX, data, size);
+  }
+}
+
+#endif // defined(CS_INITIATOR_CAPTURE) && (CS_INITIATOR_CAPTURE == 1)
@@ -45,6 +45,7 @@
 #include "cs_initiator_extract.h"
 #include "cs_initiator_error.h"
 #include "cs_ras_format_converter.h"
+#include "cs_initiator_capture.h"
 
 #ifdef SL_CATALOG_CS_INITIATOR_REPORT_PRESENT
 #include "cs_initiator_report.h"
@@ -58,6 +59,9 @@
 // Static function declarations
 static void show_rtl_api_call_result(cs_initiator_t *initiator,
                                      enum sl_rtl_error_code err_code);
+static sl_status_t append_result(cs_initiator_t *initiator,
+                                 cs_result_field_type_t type,
+                                 float *value);
 static void report_result(cs_initiator_t *initiator);
 static void report_intermediate_result(cs_initiator_t *initiator);
 
@@ -180,6 +184,27 @@ static void show_rtl_api_call_result(cs_initiator_t *initiator,
   (void)initiator;
 }
 
+/******************************************************************************
+ * Store one result field, either in the typed result or in the result buffer.
+ *
+ * @param[in] initiator initiator instance.
+ * @param[in] type field type.
+ * @param[in] value pointer to the field value.
+ *****************************************************************************/
+static sl_status_t append_result(cs_initiator_t *initiator,
+                                 cs_result_field_type_t type,
+                                 float *value)
+{
+  cs_initiator_capture_field((uint8_t)type, *value);
+  if (initiator->result_fields_cb != NULL) {
+    return cs_result_set_field(&initiator->result_fields, type, *value);
+  }
+  return cs_result_append_field(&initiator->result_data,
+                                type,
+                                (uint8_t *)value,
+                                initiator->result);
+}
+
 /******************************************************************************
  * Handle successful RTL process, and get distance.
  *
@@ -197,7 +222,11 @@ static void report_result(cs_initiator_t *initiator)
   float last_known_distance = 0.0f;
 
   // initialize result data
-  cs_result_initialize_results_data(&initiator->result_data);
+  if (initiator->result_fields_cb != NULL) {
+    cs_result_clear_fields(&initiator->result_fields);
+  } else {
+    cs_result_initialize_results_data(&initiator->result_data);
+  }
 
   if (initiator->config.cs_sub_mode == sl_bt_cs_submode_disabled) {
     mode = SL_RTL_CS_BEST_ESTIMATE;
@@ -216,10 +245,9 @@ static void report_result(cs_initiator_t *initiator)
 
   show_rtl_api_call_result(initiator, rtl_err);
   if (rtl_err == SL_RTL_ERROR_SUCCESS) {
-    sc = cs_result_append_field(&initiator->result_data,
-                                CS_RESULT_FIELD_DISTANCE_MAINMODE,
-                                (uint8_t *)&last_known_distance,
-                                initiator->result);
+    sc = append_result(initiator,
+                       CS_RESULT_FIELD_DISTANCE_MAINMODE,
+                       &last_known_distance);
     if (sc != SL_STATUS_OK) {
       initiator_log_error(INSTANCE_PREFIX "RTL - failed to append distance! [sc: 0x%lx]" LOG_NL,
                           initiator->conn_handle,
@@ -241,10 +269,9 @@ static void report_result(cs_initiator_t *initiator)
                                               &last_known_distance);
     show_rtl_api_call_result(initiator, rtl_err);
     if (rtl_err == SL_RTL_ERROR_SUCCESS) {
-      sc = cs_result_append_field(&initiator->result_data,
-                                  CS_RESULT_FIELD_DISTANCE_SUBMODE,
-                                  (uint8_t *)&last_known_distance,
-                                  initiator->result);
+      sc = append_result(initiator,
+                         CS_RESULT_FIELD_DISTANCE_SUBMODE,
+                         &last_known_distance);
       if (sc != SL_STATUS_OK) {
         initiator_log_error(INSTANCE_PREFIX "RTL - failed to append sub mode distance! [sc: 0x%lx]" LOG_NL,
                             initiator->conn_handle,
@@ -267,10 +294,9 @@ static void report_result(cs_initiator_t *initiator)
                                             &rtl_value);
   show_rtl_api_call_result(initiator, rtl_err);
   if (rtl_err == SL_RTL_ERROR_SUCCESS) {
-    sc = cs_result_append_field(&initiator->result_data,
-                                CS_RESULT_FIELD_DISTANCE_RAW_MAINMODE,
-                                (uint8_t *)&rtl_value,
-                                initiator->result);
+    sc = append_result(initiator,
+                       CS_RESULT_FIELD_DISTANCE_RAW_MAINMODE,
+                       &rtl_value);
     if (sc != SL_STATUS_OK) {
       initiator_log_error(INSTANCE_PREFIX "RTL - failed to append RAW distance! [sc: 0x%lx]" LOG_NL,
                           initiator->conn_handle,
@@ -291,10 +317,9 @@ static void report_result(cs_initiator_t *initiator)
                                               &rtl_value);
     show_rtl_api_call_result(initiator, rtl_err);
     if (rtl_err == SL_RTL_ERROR_SUCCESS) {
-      sc = cs_result_append_field(&initiator->result_data,
-                                  CS_RESULT_FIELD_DISTANCE_RAW_SUBMODE,
-                                  (uint8_t *)&rtl_value,
-                                  initiator->result);
+      sc = append_result(initiator,
+                         CS_RESULT_FIELD_DISTANCE_RAW_SUBMODE,
+                         &rtl_value);
       if (sc != SL_STATUS_OK) {
         initiator_log_error(INSTANCE_PREFIX "RTL - failed to append RAW sub mode distance! [sc: 0x%lx]" LOG_NL,
                             initiator->conn_handle,
@@ -317,10 +342,9 @@ static void report_result(cs_initiator_t *initiator)
                                                        &rtl_value);
   show_rtl_api_call_result(initiator, rtl_err);
   if (rtl_err == SL_RTL_ERROR_SUCCESS) {
-    sc = cs_result_append_field(&initiator->result_data,
-                                CS_RESULT_FIELD_LIKELINESS_MAINMODE,
-                                (uint8_t *)&rtl_value,
-                                initiator->result);
+    sc = append_result(initiator,
+                       CS_RESULT_FIELD_LIKELINESS_MAINMODE,
+                       &rtl_value);
     if (sc != SL_STATUS_OK) {
       initiator_log_error(INSTANCE_PREFIX "RTL - failed to append distance likeliness! [sc: 0x%lx]" LOG_NL,
                           initiator->conn_handle,
@@ -341,10 +365,9 @@ static void report_result(cs_initiator_t *initiator)
                                                          &rtl_value);
     show_rtl_api_call_result(initiator, rtl_err);
     if (rtl_err == SL_RTL_ERROR_SUCCESS) {
-      sc = cs_result_append_field(&initiator->result_data,
-                                  CS_RESULT_FIELD_LIKELINESS_SUBMODE,
-                                  (uint8_t *)&rtl_value,
-                                  initiator->result);
+      sc = append_result(initiator,
+                         CS_RESULT_FIELD_LIKELINESS_SUBMODE,
+                         &rtl_value);
       if (sc != SL_STATUS_OK) {
         initiator_log_error(INSTANCE_PREFIX "RTL - failed to append sub mode distance likeliness! [sc: 0x%lx]" LOG_NL,
                             initiator->conn_handle,
@@ -378,10 +401,9 @@ static void report_result(cs_initiator_t *initiator)
                                             &rtl_value);
   show_rtl_api_call_result(initiator, rtl_err);
   if (rtl_err == SL_RTL_ERROR_SUCCESS) {
-    sc = cs_result_append_field(&initiator->result_data,
-                                CS_RESULT_FIELD_DISTANCE_RSSI,
-                                (uint8_t *)&rtl_value,
-                                initiator->result);
+    sc = append_result(initiator,
+                       CS_RESULT_FIELD_DISTANCE_RSSI,
+                       &rtl_value);
     if (sc != SL_STATUS_OK) {
       initiator_log_error(INSTANCE_PREFIX "RTL - failed to append RSSI distance! [sc: 0x%lx]" LOG_NL,
                           initiator->conn_handle,
@@ -416,10 +438,9 @@ static void report_result(cs_initiator_t *initiator)
                                               &rtl_value);
     show_rtl_api_call_result(initiator, rtl_err);
     if (rtl_err == SL_RTL_ERROR_SUCCESS) {
-      sc = cs_result_append_field(&initiator->result_data,
-                                  CS_RESULT_FIELD_VELOCITY_MAINMODE,
-                                  (uint8_t *)&rtl_value,
-                                  initiator->result);
+      sc = append_result(initiator,
+                         CS_RESULT_FIELD_VELOCITY_MAINMODE,
+                         &rtl_value);
       if (sc != SL_STATUS_OK) {
         initiator_log_error(INSTANCE_PREFIX "RTL - failed to append velocity! [sc: 0x%lx]" LOG_NL,
                             initiator->conn_handle,
@@ -443,10 +464,9 @@ static void report_result(cs_initiator_t *initiator)
                                                          &rtl_value);
     show_rtl_api_call_result(initiator, rtl_err);
     if (rtl_err == SL_RTL_ERROR_SUCCESS) {
-      sc = cs_result_append_field(&initiator->result_data,
-                                  CS_RESULT_FIELD_BIT_ERROR_RATE,
-                                  (uint8_t *)&rtl_value,
-                                  initiator->result);
+      sc = append_result(initiator,
+                         CS_RESULT_FIELD_BIT_ERROR_RATE,
+                         &rtl_value);
       if (sc != SL_STATUS_OK) {
         initiator_log_error(INSTANCE_PREFIX "RTL - failed to append BER! [sc: 0x%lx]" LOG_NL,
                             initiator->conn_handle,
@@ -461,7 +481,8 @@ static void report_result(cs_initiator_t *initiator)
     }
   }
 
-  if (estimation_valid && initiator->result_cb != NULL) {
+  if (estimation_valid
+      && (initiator->result_cb != NULL || initiator->result_fields_cb != NULL)) {
     cs_initiator_report(CS_INITIATOR_REPORT_ESTIMATION_END);
     // Copy results
     initiator->ranging_data_result.num_steps = initiator->data.num_steps;
@@ -477,12 +498,21 @@ static void report_result(cs_initiator_t *initiator)
       = &initiator->data.reflector.ranging_data[0];
 
     // Call result callback in case of successful process call
-    initiator->result_cb(initiator->conn_handle,
-                         initiator->ranging_counter,
-                         initiator->result,
-                         &initiator->result_data,
-                         &initiator->ranging_data_result,
-                         NULL);
+    cs_initiator_latency_mark(initiator, CS_INITIATOR_LATENCY_RESULT_DELIVERY);
+    if (initiator->result_fields_cb != NULL) {
+      initiator->result_fields_cb(initiator->conn_handle,
+                                  initiator->ranging_counter,
+                                  &initiator->result_fields,
+                                  &initiator->ranging_data_result,
+                                  NULL);
+    } else {
+      initiator->result_cb(initiator->conn_handle,
+                           initiator->ranging_counter,
+                           initiator->result,
+                           &initiator->result_data,
+                           &initiator->ranging_data_result,
+                           NULL);
+    }
   }
 }
 
@@ -747,9 +777,15 @@ void calculate_distance(cs_initiator_t *initiator)
 
   // Start estimation
   // Note: procedure count is always 1.
+  cs_initiator_capture_procedure(initiator->conn_handle,
+                                 initiator->ranging_counter,
+                                 &initiator->cs_parameters,
+                                 &procedure_data);
+  cs_initiator_latency_mark(initiator, CS_INITIATOR_LATENCY_RTL_PROCESS_ENTRY);
   rtl_err = sl_rtl_ras_process(&initiator->rtl_handle,
                                1,
                                &procedure_data);
+  cs_initiator_latency_mark(initiator, CS_INITIATOR_LATENCY_RTL_PROCESS_EXIT);
 
   show_rtl_api_call_result(initiator, rtl_err);
   switch (rtl_err) {
@@ -769,4 +805,7 @@ void calculate_distance(cs_initiator_t *initiator)
                SL_STATUS_FAIL);
       break;
   }
+  cs_initiator_capture_result(initiator->conn_handle,
+                              initiator->ranging_counter,
+                              rtl_err);
 }
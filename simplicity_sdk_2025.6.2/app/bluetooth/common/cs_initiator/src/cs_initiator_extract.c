@@ -38,7 +38,9 @@
 #include "sl_sleeptimer.h"
 #include "sl_component_catalog.h"
 
+#include "cs_initiator_config.h"
 #include "cs_initiator_common.h"
+#include "cs_initiator_buffer_pool.h"
 #include "cs_initiator_log.h"
 #include "cs_initiator_state_machine.h"
 #include "cs_ras_format_converter.h"
@@ -51,6 +53,32 @@
 
 #include "cs_initiator_extract.h"
 
+// -----------------------------------------------------------------------------
+// Macros
+
+// Initiator step data sizes per mode (see RAS specification)
+#define STEP_MODE_0_SIZE                  5
+#define STEP_MODE_1_SIZE                  6
+#define STEP_MODE_2_SIZE(a)               (1 + ((a) + 1) * 4)
+#define STEP_MAX_ANTENNA_PATH_NUM         4
+
+// CS channel index range, channels 23, 24 and 25 are never used
+#define STEP_CHANNEL_MIN                  2
+#define STEP_CHANNEL_MAX                  76
+#define STEP_CHANNEL_EXCLUDED_FIRST       23
+#define STEP_CHANNEL_EXCLUDED_LAST        25
+
+// No offset matches, only the first segment of a procedure is indexed
+#define REFLECTOR_RECEPTION_FINISHED      UINT32_MAX
+
+// -----------------------------------------------------------------------------
+// Static function declarations
+
+#if defined(CS_INITIATOR_CONFIG_PIPELINED_EXTRACT) && (CS_INITIATOR_CONFIG_PIPELINED_EXTRACT == 1)
+static bool step_is_valid(const cs_ras_step_header_t *step_header,
+                          uint8_t num_antenna_path);
+#endif // defined(CS_INITIATOR_CONFIG_PIPELINED_EXTRACT) && (CS_INITIATOR_CONFIG_PIPELINED_EXTRACT == 1)
+
 // -----------------------------------------------------------------------------
 // Public functions
 
@@ -61,16 +89,15 @@ void reset_subevent_data(cs_initiator_t *initiator, bool init)
 {
   initiator->data.num_steps = 0;
   initiator->last_subevent_header = NULL;
-  initiator->data.initiator.ranging_data_size = 0;
+  // The initiator buffer is only held while a procedure is processed
+  cs_initiator_buffer_pool_return(&initiator->data.initiator);
   initiator->num_antenna_path = 0;
+  initiator->data.steps_valid = true;
   initiator->ranging_counter = CS_RAS_INVALID_RANGING_COUNTER;
   if (!init) {
     initiator_log_info(INSTANCE_PREFIX "subevent data reset executed." LOG_NL,
                        initiator->conn_handle);
   }
-  memset(initiator->data.initiator.ranging_data,
-         0xFF,
-         sizeof(initiator->data.initiator.ranging_data));
 }
 
 /******************************************************************************
@@ -97,6 +124,7 @@ cs_procedure_state_t extract_cs_result_data(cs_initiator_t *initiator,
     initiator->ranging_counter =
       cs_result_content->cs_event->data.evt_cs_result.procedure_counter
       & CS_RAS_RANGING_COUNTER_MASK;
+    initiator->data.steps_valid = true;
     initiator->num_antenna_path
       = cs_result_content->cs_event->data.evt_cs_result.num_antenna_paths;
     procedure_done_status
@@ -131,6 +159,14 @@ cs_procedure_state_t extract_cs_result_data(cs_initiator_t *initiator,
                      subevent_done_status);
 
   cs_initiator_report(CS_INITIATOR_REPORT_FIRST_CS_RESULT);
+  cs_initiator_latency_mark(initiator, CS_INITIATOR_LATENCY_FIRST_CS_RESULT);
+
+  if (!cs_initiator_buffer_pool_lend(&initiator->data.initiator)) {
+    initiator_log_error(INSTANCE_PREFIX "No free ranging buffer, dropping procedure %u" LOG_NL,
+                        initiator->conn_handle,
+                        initiator->ranging_counter);
+    return CS_PROCEDURE_STATE_ABORTED;
+  }
 
   // Ranging header
   cs_ras_ranging_header_t *ranging_header
@@ -157,11 +193,42 @@ cs_procedure_state_t extract_cs_result_data(cs_initiator_t *initiator,
 
   uint8_t *data_dst
     = &initiator->data.initiator.ranging_data[initiator->data.initiator.ranging_data_size];
+  uint8_t *data_dst_end
+    = &initiator->data.initiator.ranging_data[CS_INITIATOR_MAX_RANGING_DATA_SIZE];
   uint8_t *data_src = step_data;
+  uint8_t *data_src_end = step_data + step_data_len;
   uint8_t step_mode;
   // Iterate over steps
   for (uint8_t i = 0; i < num_steps; i++) {
     cs_ras_step_header_t * step_header = (cs_ras_step_header_t *)data_src;
+    if ((data_src + sizeof(cs_ras_step_header_t) > data_src_end)
+        || (data_src + sizeof(cs_ras_step_header_t) + step_header->step_data_length
+            > data_src_end)) {
+      initiator_log_error(INSTANCE_PREFIX "Step data is partial" LOG_NL,
+                          initiator->conn_handle);
+      return CS_PROCEDURE_STATE_ABORTED;
+    }
+    if ((data_dst + sizeof(step_mode) + step_header->step_data_length > data_dst_end)
+        || (initiator->data.num_steps == UINT8_MAX)) {
+      initiator_log_error(INSTANCE_PREFIX "Ranging data buffer full" LOG_NL,
+                          initiator->conn_handle);
+      return CS_PROCEDURE_STATE_ABORTED;
+    }
+    #if defined(CS_INITIATOR_CONFIG_PIPELINED_EXTRACT) && (CS_INITIATOR_CONFIG_PIPELINED_EXTRACT == 1)
+    // Validate while the rest of the procedure is still on air, so the end of
+    // the procedure only has to run the estimation.
+    if (initiator->data.steps_valid
+        && subevent_done_status != sl_bt_cs_done_status_aborted
+        && !step_is_valid(step_header, initiator->num_antenna_path)) {
+      initiator_log_error(INSTANCE_PREFIX "Invalid step %u [mode:%u, ch:%u, len:%u]" LOG_NL,
+                          initiator->conn_handle,
+                          initiator->data.num_steps,
+                          step_header->step_mode,
+                          step_header->step_channel,
+                          step_header->step_data_length);
+      initiator->data.steps_valid = false;
+    }
+    #endif // defined(CS_INITIATOR_CONFIG_PIPELINED_EXTRACT) && (CS_INITIATOR_CONFIG_PIPELINED_EXTRACT == 1)
     // Check mode and abort
     step_mode = step_header->step_mode & CS_RAS_STEP_MODE_MASK;
     if (subevent_done_status == sl_bt_cs_done_status_aborted) {
@@ -182,11 +249,6 @@ cs_procedure_state_t extract_cs_result_data(cs_initiator_t *initiator,
     initiator->data.step_channels[initiator->data.num_steps]
       = step_header->step_channel;
     initiator->data.num_steps++;
-    if (data_src > data_src + step_data_len) {
-      initiator_log_error(INSTANCE_PREFIX "Step data is partial" LOG_NL,
-                          initiator->conn_handle);
-      return CS_PROCEDURE_STATE_ABORTED;
-    }
   }
   initiator->data.initiator.ranging_data_size
     = data_dst - initiator->data.initiator.ranging_data;
@@ -219,6 +281,15 @@ cs_procedure_state_t extract_cs_result_data(cs_initiator_t *initiator,
   switch (procedure_done_status) {
     case sl_bt_cs_done_status_complete:
       procedure_state = CS_PROCEDURE_STATE_COMPLETED;
+      cs_initiator_latency_mark(initiator, CS_INITIATOR_LATENCY_LAST_CS_RESULT);
+      if (!initiator->data.steps_valid) {
+        // Drop now instead of fetching the reflector data for it
+        initiator_log_error(INSTANCE_PREFIX "Procedure %u dropped, invalid step data" LOG_NL,
+                            initiator->conn_handle,
+                            initiator->ranging_counter);
+        procedure_state = CS_PROCEDURE_STATE_ABORTED;
+        break;
+      }
       #if defined(CS_INITIATOR_CONFIG_LOG_DATA) && (CS_INITIATOR_CONFIG_LOG_DATA == 1)
       initiator_log_debug(INSTANCE_PREFIX "Initiator Ranging Data %u ready" LOG_NL,
                           initiator->conn_handle,
@@ -256,45 +327,125 @@ cs_procedure_state_t extract_cs_result_data(cs_initiator_t *initiator,
   return procedure_state;
 }
 
+void ranging_data_segment_arrived(cs_initiator_t *initiator,
+                                  uint32_t offset,
+                                  uint32_t size)
+{
+  cs_ras_step_index_t *index = &initiator->data.reflector_index;
+  uint8_t *data = initiator->data.reflector.ranging_data;
+  bool complete;
+
+  if (data == NULL) {
+    return;
+  }
+  if (offset == 0) {
+    (void)cs_ras_format_init_step_index(index,
+                                        false,
+                                        initiator->num_antenna_path);
+    initiator->data.reflector_received = 0;
+  }
+  // After a gap the rest is indexed when the reception has finished
+  if (offset != initiator->data.reflector_received) {
+    return;
+  }
+  initiator->data.reflector_received = offset + size;
+  complete = index->complete;
+  (void)cs_ras_format_advance_step_index(data,
+                                         data + initiator->data.reflector_received,
+                                         index);
+  if (!complete && index->complete) {
+    initiator_log_debug(INSTANCE_PREFIX "Reflector data complete, %u subevents, %u steps" LOG_NL,
+                        initiator->conn_handle,
+                        index->num_subevents,
+                        index->num_steps);
+  }
+}
+
+void ranging_data_reception_finished(cs_initiator_t *initiator)
+{
+  initiator->data.reflector_received = REFLECTOR_RECEPTION_FINISHED;
+}
+
 cs_procedure_state_t ranging_data_is_complete(uint8_t *data,
                                               uint32_t size,
-                                              bool is_initiator,
-                                              uint8_t antenna_path_num)
+                                              cs_ras_step_index_t *index)
 {
-  uint8_t *data_end = data + size;
-  cs_ras_subevent_header_t *subevent_header = NULL;
-  bool aborted = false;
-  bool completed = false;
-  sl_status_t sc = SL_STATUS_OK;
-  cs_procedure_state_t state = CS_PROCEDURE_STATE_ABORTED;
-  sc = cs_ras_format_get_first_subevent_header(data, data_end, &subevent_header);
-  uint8_t subevent = 0;
-
-  while (sc == SL_STATUS_OK) {
+  sl_status_t sc;
+  cs_ras_subevent_index_t *subevent;
+
+  // Partial index is still usable, subevents up to the error are checked
+  sc = cs_ras_format_advance_step_index(data,
+                                        data + size,
+                                        index);
+  if (sc != SL_STATUS_OK) {
+    initiator_log_debug("Step index stopped at subevent %u, step %u [sc: 0x%lx]" LOG_NL,
+                        index->num_subevents,
+                        index->num_steps,
+                        (unsigned long)sc);
+  }
+
+  for (uint8_t i = 0; i < index->num_subevents; i++) {
+    subevent = &index->subevent[i];
+    initiator_log_debug("Parse subevent %u, steps: %u, ranging done: %u, subevent done: %u" LOG_NL,
+                        i,
+                        subevent->num_steps,
+                        subevent->ranging_done_status,
+                        subevent->subevent_done_status);
     // Check for subevent and procedure aborts
-    aborted |= (subevent_header->ranging_done_status == sl_bt_cs_done_status_aborted);
-    aborted |= (subevent_header->subevent_done_status == sl_bt_cs_done_status_aborted);
+    if ((subevent->ranging_done_status == sl_bt_cs_done_status_aborted)
+        || (subevent->subevent_done_status == sl_bt_cs_done_status_aborted)) {
+      return CS_PROCEDURE_STATE_ABORTED;
+    }
     // Check for completed state
-    completed |= (subevent_header->ranging_done_status == sl_bt_cs_done_status_complete);
-    initiator_log_debug("Parse subevent %u, completed: %u, aborted: %u" LOG_NL,
-                        subevent++,
-                        completed,
-                        aborted);
-    if (aborted || completed) {
-      break;
+    if (subevent->ranging_done_status == sl_bt_cs_done_status_complete) {
+      return CS_PROCEDURE_STATE_COMPLETED;
     }
-    sc = cs_ras_format_get_next_subevent_header(subevent_header,
-                                                data_end,
-                                                is_initiator,
-                                                antenna_path_num,
-                                                &subevent_header);
   }
+  return CS_PROCEDURE_STATE_ABORTED;
+}
 
-  if (aborted) {
-    return CS_PROCEDURE_STATE_ABORTED;
+// -----------------------------------------------------------------------------
+// Static functions
+
+#if defined(CS_INITIATOR_CONFIG_PIPELINED_EXTRACT) && (CS_INITIATOR_CONFIG_PIPELINED_EXTRACT == 1)
+/******************************************************************************
+ * Check mode, channel and data length of an initiator step.
+ *
+ * @param[in] step_header Step header followed by the step data.
+ * @param[in] num_antenna_path Number of antenna paths of the procedure.
+ * @return true if the step can be handed over to the RTL library.
+ *****************************************************************************/
+static bool step_is_valid(const cs_ras_step_header_t *step_header,
+                          uint8_t num_antenna_path)
+{
+  uint8_t channel = step_header->step_channel;
+  uint8_t expected_length;
+
+  if ((channel < STEP_CHANNEL_MIN)
+      || (channel > STEP_CHANNEL_MAX)
+      || ((channel >= STEP_CHANNEL_EXCLUDED_FIRST)
+          && (channel <= STEP_CHANNEL_EXCLUDED_LAST))) {
+    return false;
   }
-  if (completed) {
-    return CS_PROCEDURE_STATE_COMPLETED;
+
+  switch (step_header->step_mode & CS_RAS_STEP_MODE_MASK) {
+    case 0:
+      expected_length = STEP_MODE_0_SIZE;
+      break;
+    case 1:
+      expected_length = STEP_MODE_1_SIZE;
+      break;
+    case 2:
+      if ((num_antenna_path == 0)
+          || (num_antenna_path > STEP_MAX_ANTENNA_PATH_NUM)) {
+        return false;
+      }
+      expected_length = STEP_MODE_2_SIZE(num_antenna_path);
+      break;
+    default:
+      // Mode 3 is not supported by the RAS format
+      return false;
   }
-  return state;
+  return step_header->step_data_length == expected_length;
 }
+#endif // defined(CS_INITIATOR_CONFIG_PIPELINED_EXTRACT) && (CS_INITIATOR_CONFIG_PIPELINED_EXTRACT == 1)
@@ -0,0 +1,309 @@
+/***************************************************************************//**
+ * @file
+ * @brief CS initiator - CS pipeline latency statistics
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2025 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+// -----------------------------------------------------------------------------
+// Includes
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__arm__)
+#include "em_device.h"
+#else
+#include <time.h>
+#endif
+
+#include "cs_initiator_latency.h"
+
+// -----------------------------------------------------------------------------
+// Macros
+
+#define REACHED(stage)  ((uint16_t)(1u << (stage)))
+
+#if CS_INITIATOR_LATENCY_STAGE_COUNT > 16
+#error "cs_initiator_latency_t.reached holds one bit per stage"
+#endif
+
+// -----------------------------------------------------------------------------
+// Static function declarations
+
+static uint32_t timestamp(void);
+static uint32_t elapsed_us(uint32_t from, uint32_t to);
+static void start_procedure(cs_initiator_latency_t       *latency,
+                            cs_initiator_latency_stage_t stage,
+                            uint32_t                     now);
+static void add_sample(cs_initiator_latency_stage_t stage, uint32_t us);
+
+// -----------------------------------------------------------------------------
+// Static variables
+
+// Upper limits of the buckets, the last bucket collects the rest
+static const uint32_t bucket_limit_us[CS_INITIATOR_LATENCY_BUCKET_COUNT - 1] = {
+  1000u, 2000u, 5000u, 10000u, 20000u, 50000u,
+  100000u, 150000u, 200000u, 300000u, 500000u, 1000000u
+};
+
+static const char *stage_names[CS_INITIATOR_LATENCY_STAGE_COUNT] = {
+  "procedure enable",
+  "first CS result",
+  "last CS result",
+  "first RAS segment",
+  "last RAS segment",
+  "RTL process entry",
+  "RTL process exit",
+  "result delivery",
+  "gate decision"
+};
+
+static cs_initiator_latency_histogram_t histograms[CS_INITIATOR_LATENCY_STAGE_COUNT];
+static uint32_t incomplete_count;
+
+#if defined(__arm__)
+static uint32_t cycles_per_us = 1u;
+#endif
+
+// -----------------------------------------------------------------------------
+// Public function definitions
+
+/******************************************************************************
+ * Start the timestamp counter and clear the histograms.
+ *****************************************************************************/
+void cs_initiator_latency_init(void)
+{
+#if defined(__arm__)
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  cycles_per_us = SystemCoreClockGet() / 1000000u;
+  if (cycles_per_us == 0u) {
+    cycles_per_us = 1u;
+  }
+#endif
+  cs_initiator_latency_clear();
+}
+
+/******************************************************************************
+ * Clear the histograms and the incomplete procedure counter.
+ *****************************************************************************/
+void cs_initiator_latency_clear(void)
+{
+  memset(histograms, 0, sizeof(histograms));
+  for (uint8_t i = 0u; i < CS_INITIATOR_LATENCY_STAGE_COUNT; i++) {
+    histograms[i].min_us = UINT32_MAX;
+  }
+  incomplete_count = 0u;
+}
+
+/******************************************************************************
+ * Forget the ongoing procedure of an instance.
+ *****************************************************************************/
+void cs_initiator_latency_reset(cs_initiator_latency_t *latency)
+{
+  latency->reached = 0u;
+}
+
+/******************************************************************************
+ * Timestamp a stage of the ongoing procedure of an instance.
+ *****************************************************************************/
+void cs_initiator_latency_record(cs_initiator_latency_t       *latency,
+                                 cs_initiator_latency_stage_t stage)
+{
+  uint32_t now = timestamp();
+
+  if ((latency == NULL) || (stage >= CS_INITIATOR_LATENCY_STAGE_COUNT)) {
+    return;
+  }
+  switch (stage) {
+    case CS_INITIATOR_LATENCY_PROCEDURE_ENABLE:
+      start_procedure(latency, stage, now);
+      return;
+    case CS_INITIATOR_LATENCY_FIRST_CS_RESULT:
+      if ((latency->reached & REACHED(stage)) != 0u) {
+        if ((latency->reached & REACHED(CS_INITIATOR_LATENCY_LAST_CS_RESULT)) == 0u) {
+          // Next subevent of the same procedure
+          return;
+        }
+        start_procedure(latency, stage, now);
+        return;
+      }
+      if ((latency->reached & REACHED(CS_INITIATOR_LATENCY_PROCEDURE_ENABLE)) == 0u) {
+        // Free running procedures start with their first result
+        start_procedure(latency, stage, now);
+        return;
+      }
+      break;
+    case CS_INITIATOR_LATENCY_GATE_DECISION:
+      if ((latency->reached & REACHED(CS_INITIATOR_LATENCY_RESULT_DELIVERY)) != 0u) {
+        add_sample(stage, elapsed_us(latency->origin, now));
+        latency->reached = 0u;
+      }
+      return;
+    default:
+      if ((latency->reached & REACHED(CS_INITIATOR_LATENCY_FIRST_CS_RESULT)) == 0u) {
+        // No procedure in progress
+        return;
+      }
+      if ((stage == CS_INITIATOR_LATENCY_FIRST_RAS_SEGMENT)
+          && ((latency->reached & REACHED(stage)) != 0u)) {
+        return;
+      }
+      break;
+  }
+  latency->time[stage] = now;
+  latency->reached |= REACHED(stage);
+
+  if (stage == CS_INITIATOR_LATENCY_RESULT_DELIVERY) {
+    // The first stage reached is the origin
+    uint16_t measured = latency->reached & ~REACHED(CS_INITIATOR_LATENCY_PROCEDURE_ENABLE);
+    if ((latency->reached & REACHED(CS_INITIATOR_LATENCY_PROCEDURE_ENABLE)) == 0u) {
+      measured &= ~REACHED(CS_INITIATOR_LATENCY_FIRST_CS_RESULT);
+    }
+    for (uint8_t i = 0u; i < CS_INITIATOR_LATENCY_GATE_DECISION; i++) {
+      if ((measured & REACHED(i)) != 0u) {
+        add_sample((cs_initiator_latency_stage_t)i, elapsed_us(latency->origin, latency->time[i]));
+      }
+    }
+    // Only the gate decision of this procedure is expected now
+    latency->reached = REACHED(CS_INITIATOR_LATENCY_RESULT_DELIVERY);
+  }
+}
+
+/******************************************************************************
+ * Get the histogram of a stage.
+ *****************************************************************************/
+bool cs_initiator_latency_get(cs_initiator_latency_stage_t     stage,
+                              cs_initiator_latency_histogram_t *histogram)
+{
+  if ((stage >= CS_INITIATOR_LATENCY_STAGE_COUNT) || (histogram == NULL)) {
+    return false;
+  }
+  *histogram = histograms[stage];
+  return true;
+}
+
+/******************************************************************************
+ * Get the upper limit of a histogram bucket.
+ *****************************************************************************/
+uint32_t cs_initiator_latency_bucket_limit_us(uint8_t bucket)
+{
+  if (bucket >= (CS_INITIATOR_LATENCY_BUCKET_COUNT - 1)) {
+    return UINT32_MAX;
+  }
+  return bucket_limit_us[bucket];
+}
+
+/******************************************************************************
+ * Get the number of incomplete procedures.
+ *****************************************************************************/
+uint32_t cs_initiator_latency_get_incomplete(void)
+{
+  return incomplete_count;
+}
+
+/******************************************************************************
+ * Get the name of a stage.
+ *****************************************************************************/
+const char *cs_initiator_latency_stage_name(cs_initiator_latency_stage_t stage)
+{
+  if (stage >= CS_INITIATOR_LATENCY_STAGE_COUNT) {
+    return "unknown";
+  }
+  return stage_names[stage];
+}
+
+// -----------------------------------------------------------------------------
+// Static function definitions
+
+/******************************************************************************
+ * Free running counter: DWT cycles on target, microseconds on the host.
+ *****************************************************************************/
+static uint32_t timestamp(void)
+{
+#if defined(__arm__)
+  return DWT->CYCCNT;
+#else
+  struct timespec now;
+  (void)clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint32_t)((uint64_t)now.tv_sec * 1000000u + (uint64_t)now.tv_nsec / 1000u);
+#endif
+}
+
+/******************************************************************************
+ * Convert a timestamp difference to microseconds. The cycle counter wraps
+ * after 55 s at 78 MHz, longer stages are not measured correctly.
+ *****************************************************************************/
+static uint32_t elapsed_us(uint32_t from, uint32_t to)
+{
+#if defined(__arm__)
+  return (to - from) / cycles_per_us;
+#else
+  return to - from;
+#endif
+}
+
+/******************************************************************************
+ * Start a new procedure, the unfinished one is counted as incomplete.
+ *****************************************************************************/
+static void start_procedure(cs_initiator_latency_t       *latency,
+                            cs_initiator_latency_stage_t stage,
+                            uint32_t                     now)
+{
+  if ((latency->reached
+       & ~REACHED(CS_INITIATOR_LATENCY_PROCEDURE_ENABLE)
+       & ~REACHED(CS_INITIATOR_LATENCY_RESULT_DELIVERY)) != 0u) {
+    incomplete_count++;
+  }
+  latency->origin = now;
+  latency->time[stage] = now;
+  latency->reached = REACHED(stage);
+}
+
+/******************************************************************************
+ * Add a sample to the histogram of a stage.
+ *****************************************************************************/
+static void add_sample(cs_initiator_latency_stage_t stage, uint32_t us)
+{
+  cs_initiator_latency_histogram_t *histogram = &histograms[stage];
+  uint8_t bucket = 0u;
+
+  while ((bucket < (CS_INITIATOR_LATENCY_BUCKET_COUNT - 1))
+         && (us >= bucket_limit_us[bucket])) {
+    bucket++;
+  }
+  histogram->bucket[bucket]++;
+  histogram->count++;
+  histogram->sum_us += us;
+  if (us < histogram->min_us) {
+    histogram->min_us = us;
+  }
+  if (us > histogram->max_us) {
+    histogram->max_us = us;
+  }
+}
@@ -0,0 +1,93 @@
+/***************************************************************************//**
+ * @file
+ * @brief CS initiator - RAS mode selection policy
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2025 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+// -----------------------------------------------------------------------------
+// Includes
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "cs_initiator_ras_policy.h"
+
+// -----------------------------------------------------------------------------
+// Macros
+
+// Weight of a new procedure in the moving average: 1 / 2^BAD_AVERAGE_SHIFT
+#define BAD_AVERAGE_SHIFT 5
+
+#if CS_INITIATOR_RAS_AUTO_REAL_TIME_THRESHOLD >= CS_INITIATOR_RAS_AUTO_ON_DEMAND_THRESHOLD
+#error "CS_INITIATOR_RAS_AUTO_REAL_TIME_THRESHOLD must be below CS_INITIATOR_RAS_AUTO_ON_DEMAND_THRESHOLD"
+#endif
+
+// -----------------------------------------------------------------------------
+// Public function definitions
+
+void cs_initiator_ras_policy_init(cs_initiator_ras_policy_t *policy,
+                                  bool real_time)
+{
+  policy->bad_permille = 0;
+  policy->dwell = 0;
+  policy->real_time = real_time;
+}
+
+bool cs_initiator_ras_policy_update(cs_initiator_ras_policy_t *policy,
+                                    const cs_initiator_ras_sample_t *sample)
+{
+  int32_t target;
+  bool bad;
+
+  if ((policy == NULL) || (sample == NULL)) {
+    return false;
+  }
+  bad = sample->lost
+        || sample->dropped
+        || (sample->latency_ms > CS_INITIATOR_RAS_AUTO_MAX_LATENCY_MS);
+  target = bad ? 1000 : 0;
+  policy->bad_permille = (uint16_t)((int32_t)policy->bad_permille
+                                    + ((target - (int32_t)policy->bad_permille)
+                                       / (1 << BAD_AVERAGE_SHIFT)));
+  if (policy->dwell < UINT16_MAX) {
+    policy->dwell++;
+  }
+  if (policy->dwell < CS_INITIATOR_RAS_AUTO_MIN_PROCEDURES) {
+    return false;
+  }
+  if (policy->real_time
+      && (policy->bad_permille >= CS_INITIATOR_RAS_AUTO_ON_DEMAND_THRESHOLD * 10)) {
+    policy->real_time = false;
+  } else if (!policy->real_time
+             && (policy->bad_permille <= CS_INITIATOR_RAS_AUTO_REAL_TIME_THRESHOLD * 10)) {
+    policy->real_time = true;
+  } else {
+    return false;
+  }
+  policy->dwell = 0;
+  return true;
+}
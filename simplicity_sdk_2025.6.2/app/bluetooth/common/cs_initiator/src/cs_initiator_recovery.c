@@ -0,0 +1,81 @@
+/***************************************************************************//**
+ * @file
+ * @brief CS initiator - lost segment recovery planning
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2025 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+// -----------------------------------------------------------------------------
+// Includes
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "cs_initiator_recovery.h"
+
+// -----------------------------------------------------------------------------
+// Macros
+
+#define SEGMENT_MASK_BITS 64
+
+// -----------------------------------------------------------------------------
+// Public function definitions
+
+bool cs_initiator_recovery_next_range(uint64_t lost_segments,
+                                      uint8_t merge_gap,
+                                      cs_initiator_segment_range_t *range)
+{
+  uint8_t segment = 0;
+  uint8_t received = 0;
+
+  if ((lost_segments == 0) || (range == NULL)) {
+    return false;
+  }
+  while ((lost_segments & (1ULL << segment)) == 0) {
+    segment++;
+  }
+  range->start_segment = segment;
+  range->end_segment = segment;
+  for (segment++; segment < SEGMENT_MASK_BITS; segment++) {
+    if ((lost_segments & (1ULL << segment)) != 0) {
+      range->end_segment = segment;
+      received = 0;
+    } else if (++received > merge_gap) {
+      break;
+    }
+  }
+  return true;
+}
+
+uint64_t cs_initiator_recovery_range_mask(const cs_initiator_segment_range_t *range)
+{
+  uint8_t length = range->end_segment - range->start_segment + 1;
+
+  if (length >= SEGMENT_MASK_BITS) {
+    return UINT64_MAX;
+  }
+  return ((1ULL << length) - 1) << range->start_segment;
+}
@@ -39,6 +39,7 @@
 #include "app_timer.h"
 
 #include "cs_initiator_common.h"
+#include "cs_initiator_buffer_pool.h"
 #include "cs_initiator_config.h"
 #include "cs_initiator_extract.h"
 #include "cs_initiator_error.h"
@@ -60,6 +61,18 @@
 // Procedure enable maximum retry count
 #define CS_MAX_PROCEDURE_ENABLE_RETRY  3
 
+#if CS_INITIATOR_TABLE_DISPATCH
+// Dimensions of the transition table
+#define INITIATOR_STATE_COUNT          ((uint8_t)INITIATOR_STATE_ERROR + 1u)
+#define INITIATOR_EVT_COUNT            ((uint8_t)INITIATOR_EVT_ERROR + 1u)
+
+// -----------------------------------------------------------------------------
+// Type definitions
+
+typedef sl_status_t (*state_handler_t)(cs_initiator_t             *initiator,
+                                       state_machine_event_data_t *data);
+#endif
+
 // -----------------------------------------------------------------------------
 // Static function declarations
 
@@ -80,6 +93,12 @@ static sl_status_t state_in_procedure_on_cs_result(cs_initiator_t             *i
 static sl_status_t state_wait_reflector_on_ranging_data(cs_initiator_t             *initiator,
                                                         state_machine_event_data_t *data,
                                                         bool                       complete);
+#if CS_INITIATOR_TABLE_DISPATCH
+static sl_status_t state_wait_reflector_complete_on_ranging_data(cs_initiator_t             *initiator,
+                                                                 state_machine_event_data_t *data);
+static sl_status_t state_wait_reflector_aborted_on_ranging_data(cs_initiator_t             *initiator,
+                                                                state_machine_event_data_t *data);
+#endif
 static sl_status_t state_in_procedure_on_ranging_data(cs_initiator_t             *initiator,
                                                       state_machine_event_data_t *data);
 static sl_status_t state_wait_procedure_disable_on_procedure_enable_completed(cs_initiator_t             *initiator,
@@ -88,9 +107,50 @@ static sl_status_t state_delete_on_procedure_enable_completed(cs_initiator_t
                                                               state_machine_event_data_t *data);
 static void handle_procedure_enable_completed_event_disable(cs_initiator_t *initiator);
 static initiator_state_t initiator_stop_procedure_on_invalid_state(cs_initiator_t *initiator);
+static sl_status_t apply_pending_procedure_interval(cs_initiator_t *initiator);
+static bool apply_pending_connection_interval(cs_initiator_t *initiator);
 static sl_status_t initiator_finalize_cleanup(cs_initiator_t *initiator);
 static void procedure_timer_cb(app_timer_t *handle, void *data);
 
+#if CS_INITIATOR_TABLE_DISPATCH
+// -----------------------------------------------------------------------------
+// Static variables
+
+// State x event transitions, NULL entries ignore the event.
+// ERROR and DELETE_INSTANCE are handled in every state before the lookup.
+static const state_handler_t transition_table[INITIATOR_STATE_COUNT][INITIATOR_EVT_COUNT] = {
+  [INITIATOR_STATE_UNINITIALIZED] = {
+    [INITIATOR_EVT_INIT_STARTED] = state_uninitialized_on_init_started,
+  },
+  [INITIATOR_STATE_INIT] = {
+    [INITIATOR_EVT_INIT_COMPLETED] = state_init_on_start_init_completed,
+  },
+  [INITIATOR_STATE_START_PROCEDURE] = {
+    [INITIATOR_EVT_START_PROCEDURE] = state_start_procedure_on_start_procedure,
+  },
+  [INITIATOR_STATE_WAIT_PROCEDURE_ENABLE_COMPLETE] = {
+    [INITIATOR_EVT_PROCEDURE_ENABLE_COMPLETED] = state_wait_procedure_enable_complete_on_enable_completed,
+  },
+  [INITIATOR_STATE_IN_PROCEDURE] = {
+    [INITIATOR_EVT_RANGING_DATA] = state_in_procedure_on_ranging_data,
+    [INITIATOR_EVT_CS_RESULT] = state_in_procedure_on_cs_result,
+    [INITIATOR_EVT_CS_RESULT_CONTINUE] = state_in_procedure_on_cs_result,
+  },
+  [INITIATOR_STATE_WAIT_REFLECTOR_PROCEDURE_COMPLETE] = {
+    [INITIATOR_EVT_RANGING_DATA] = state_wait_reflector_complete_on_ranging_data,
+  },
+  [INITIATOR_STATE_WAIT_REFLECTOR_PROCEDURE_ABORTED] = {
+    [INITIATOR_EVT_RANGING_DATA] = state_wait_reflector_aborted_on_ranging_data,
+  },
+  [INITIATOR_STATE_WAIT_PROCEDURE_DISABLE_COMPLETE] = {
+    [INITIATOR_EVT_PROCEDURE_ENABLE_COMPLETED] = state_wait_procedure_disable_on_procedure_enable_completed,
+  },
+  [INITIATOR_STATE_DELETE] = {
+    [INITIATOR_EVT_PROCEDURE_ENABLE_COMPLETED] = state_delete_on_procedure_enable_completed,
+  },
+};
+#endif
+
 // -----------------------------------------------------------------------------
 // Static function definitions
 
@@ -181,8 +241,17 @@ static sl_status_t state_init_on_start_init_completed(cs_initiator_t
     initiator->initiator_state = (uint8_t)INITIATOR_STATE_START_PROCEDURE;
     initiator->procedure_enable_retry_counter = 0;
     if (initiator->ras_client.real_time_mode) {
+      // The RAS client may write real-time data at any time
+      if (!cs_initiator_buffer_pool_lend(&initiator->data.reflector)) {
+        initiator_log_error(INSTANCE_PREFIX "RAS - no free ranging buffer for real-time data!" LOG_NL,
+                            initiator->conn_handle);
+        on_error(initiator,
+                 CS_ERROR_EVENT_RAS_CLIENT_REALTIME_RECEIVE_FAILED,
+                 SL_STATUS_NO_MORE_RESOURCE);
+        return SL_STATUS_NO_MORE_RESOURCE;
+      }
       sc = cs_ras_client_real_time_receive(initiator->conn_handle,
-                                           sizeof(initiator->data.reflector.ranging_data),
+                                           CS_INITIATOR_MAX_RANGING_DATA_SIZE,
                                            initiator->data.reflector.ranging_data);
       if (sc != SL_STATUS_OK) {
         initiator_log_error(INSTANCE_PREFIX "RAS - failed to receive real-time data! [sc: 0x%lx]" LOG_NL,
@@ -231,6 +300,10 @@ static sl_status_t state_start_procedure_on_start_procedure(cs_initiator_t
                                                &data_out);
     return sc;
   }
+  if (apply_pending_connection_interval(initiator)) {
+    // Enabled again when the new connection parameters are reported
+    return SL_STATUS_OK;
+  }
   cs_initiator_report(CS_INITIATOR_REPORT_CS_PROCEDURE_BEGIN);
   sc = sl_bt_cs_procedure_enable(initiator->conn_handle,
                                  sl_bt_cs_procedure_state_enabled,
@@ -280,6 +353,7 @@ static sl_status_t state_wait_procedure_enable_complete_on_enable_completed(cs_i
 
   if (data->evt_procedure_enable_completed->status == SL_STATUS_OK) {
     cs_initiator_report(CS_INITIATOR_REPORT_CS_PROCEDURE_STARTED);
+    cs_initiator_latency_mark(initiator, CS_INITIATOR_LATENCY_PROCEDURE_ENABLE);
     uint32_t time_tick = sl_sleeptimer_get_tick_count();
     initiator->procedure_start_time_ms =
       sl_sleeptimer_tick_to_ms(time_tick);
@@ -488,6 +562,10 @@ static sl_status_t state_wait_reflector_on_ranging_data(cs_initiator_t
   initiator_log_hexdump_debug((initiator->data.reflector.ranging_data),
                               (initiator->data.reflector.ranging_data_size));
   initiator_log_append_debug(LOG_NL);
+  initiator_log_debug(INSTANCE_PREFIX "Reflector Ranging Data: %u subevents, %u steps" LOG_NL,
+                      initiator->conn_handle,
+                      initiator->data.reflector_index.num_subevents,
+                      initiator->data.reflector_index.num_steps);
   #endif // defined(CS_INITIATOR_CONFIG_LOG_DATA) && (CS_INITIATOR_CONFIG_LOG_DATA == 1)
   if (data->evt_ranging_data.ranging_counter != initiator->ranging_counter) {
     if (initiator->config.max_procedure_count != 0) {
@@ -521,6 +599,11 @@ static sl_status_t state_wait_reflector_on_ranging_data(cs_initiator_t
                                                &data_out);
   }
   if (initiator->config.max_procedure_count != 0) {
+    // The procedures are already disabled between two runs
+    sc = apply_pending_procedure_interval(initiator);
+    if (sc != SL_STATUS_OK) {
+      return sc;
+    }
     initiator_log_info(INSTANCE_PREFIX "Instance new state: START_PROCEDURE" LOG_NL,
                        initiator->conn_handle);
     initiator->initiator_state = (uint8_t)INITIATOR_STATE_START_PROCEDURE;
@@ -556,11 +639,51 @@ static sl_status_t state_wait_reflector_on_ranging_data(cs_initiator_t
   }
   // Procedure data processed in free running mode, clear the subevent data
   reset_subevent_data(initiator, false);
+  if (!initiator->ras_client.real_time_mode) {
+    // On-demand data was received completely, borrowed again on the next GET
+    cs_initiator_buffer_pool_return(&initiator->data.reflector);
+  }
+
+  if (initiator->pending_procedure_interval != 0
+      || initiator->pending_connection_interval != 0) {
+    // Procedure boundary: disable, the new intervals are set on completion
+    initiator->initiator_state = (uint8_t)initiator_stop_procedure_on_invalid_state(initiator);
+    if (initiator->initiator_state == ((uint8_t)INITIATOR_STATE_ERROR)) {
+      data_out.evt_error.error_type = CS_ERROR_EVENT_CS_PROCEDURE_STOP_FAILED;
+      data_out.evt_error.sc = SL_STATUS_FAIL;
+      return initiator_state_machine_event_handler(initiator,
+                                                   INITIATOR_EVT_ERROR,
+                                                   &data_out);
+    }
+    if (initiator->initiator_state == ((uint8_t)INITIATOR_STATE_START_PROCEDURE)) {
+      sc = apply_pending_procedure_interval(initiator);
+      if (sc != SL_STATUS_OK) {
+        return sc;
+      }
+      return initiator_state_machine_event_handler(initiator,
+                                                   INITIATOR_EVT_START_PROCEDURE,
+                                                   NULL);
+    }
+  }
 
   sc = SL_STATUS_OK;
   return sc;
 }
 
+#if CS_INITIATOR_TABLE_DISPATCH
+static sl_status_t state_wait_reflector_complete_on_ranging_data(cs_initiator_t             *initiator,
+                                                                 state_machine_event_data_t *data)
+{
+  return state_wait_reflector_on_ranging_data(initiator, data, true);
+}
+
+static sl_status_t state_wait_reflector_aborted_on_ranging_data(cs_initiator_t             *initiator,
+                                                                state_machine_event_data_t *data)
+{
+  return state_wait_reflector_on_ranging_data(initiator, data, false);
+}
+#endif
+
 static sl_status_t state_wait_procedure_disable_on_procedure_enable_completed(cs_initiator_t             *initiator,
                                                                               state_machine_event_data_t *data)
 {
@@ -572,6 +695,10 @@ static sl_status_t state_wait_procedure_disable_on_procedure_enable_completed(cs
   handle_procedure_enable_completed_event_disable(initiator);
   if (data->evt_procedure_enable_completed->status == SL_STATUS_OK) {
     app_timer_stop(&initiator->timer_handle);
+    sc = apply_pending_procedure_interval(initiator);
+    if (sc != SL_STATUS_OK) {
+      return sc;
+    }
     initiator_log_info(INSTANCE_PREFIX "Instance new state: START_PROCEDURE" LOG_NL,
                        initiator->conn_handle);
     initiator->initiator_state = (uint8_t)INITIATOR_STATE_START_PROCEDURE;
@@ -671,6 +798,114 @@ static initiator_state_t initiator_stop_procedure_on_invalid_state(cs_initiator_
   }
 }
 
+/******************************************************************************
+ * Request the pending connection interval. Only valid while the procedures
+ * are disabled. The procedure timer guards the wait for the update, if it
+ * elapses the procedures restart on the current interval.
+ * @param[in] initiator pointer to the initiator instance.
+ * @return true if the update was requested and the procedures have to wait
+ *         for the connection parameters event.
+ *****************************************************************************/
+static bool apply_pending_connection_interval(cs_initiator_t *initiator)
+{
+  sl_status_t sc;
+  uint16_t interval = initiator->pending_connection_interval;
+
+  if (interval == 0) {
+    return false;
+  }
+  initiator->pending_connection_interval = 0;
+  if (interval == initiator->conn_interval) {
+    // Already in use, no connection parameters event would follow
+    initiator->config.min_connection_interval = interval;
+    initiator->config.max_connection_interval = interval;
+    return false;
+  }
+  sc = sl_bt_connection_set_parameters(initiator->conn_handle,
+                                       interval,
+                                       interval,
+                                       initiator->config.latency,
+                                       initiator->config.timeout,
+                                       initiator->config.min_ce_length,
+                                       initiator->config.max_ce_length);
+  if (sc != SL_STATUS_OK) {
+    // Keep the current interval, the procedures go on
+    initiator_log_warning(INSTANCE_PREFIX "CS - failed to set connection interval %u! "
+                                          "[sc: 0x%lx]" LOG_NL,
+                          initiator->conn_handle,
+                          interval,
+                          (unsigned long)sc);
+    return false;
+  }
+  sc = app_timer_start(&initiator->timer_handle,
+                       CS_INITIATOR_PROCEDURE_TIMEOUT_MS,
+                       procedure_timer_cb,
+                       (void *)initiator,
+                       false);
+  if (sc != SL_STATUS_OK) {
+    initiator_log_warning(INSTANCE_PREFIX "CS - connection update not guarded by timer! "
+                                          "[sc: 0x%lx]" LOG_NL,
+                          initiator->conn_handle,
+                          (unsigned long)sc);
+  }
+  initiator->config.min_connection_interval = interval;
+  initiator->config.max_connection_interval = interval;
+  initiator->wait_connection_parameters = true;
+  initiator_log_info(INSTANCE_PREFIX "CS - connection interval %u requested" LOG_NL,
+                     initiator->conn_handle,
+                     interval);
+  return true;
+}
+
+/******************************************************************************
+ * Set the procedure parameters again with the pending procedure interval.
+ * Only valid while the procedures are disabled.
+ * @param[in] initiator pointer to the initiator instance.
+ * @return SL_STATUS_OK if there was nothing to do or the parameters were set.
+ *****************************************************************************/
+static sl_status_t apply_pending_procedure_interval(cs_initiator_t *initiator)
+{
+  sl_status_t sc;
+
+  if (initiator->pending_procedure_interval == 0) {
+    return SL_STATUS_OK;
+  }
+  initiator->config.min_procedure_interval = initiator->pending_procedure_interval;
+  initiator->config.max_procedure_interval = initiator->pending_procedure_interval;
+  initiator->pending_procedure_interval = 0;
+
+  sc = sl_bt_cs_set_procedure_parameters(initiator->conn_handle,
+                                         initiator->config.config_id,
+                                         initiator->config.max_procedure_duration,
+                                         initiator->config.min_procedure_interval,
+                                         initiator->config.max_procedure_interval,
+                                         initiator->config.max_procedure_count,
+                                         initiator->config.min_subevent_len,
+                                         initiator->config.max_subevent_len,
+                                         initiator->config.cs_tone_antenna_config_idx,
+                                         initiator->config.conn_phy,
+                                         initiator->config.tx_pwr_delta,
+                                         initiator->config.preferred_peer_antenna,
+                                         initiator->config.snr_control_initiator,
+                                         initiator->config.snr_control_reflector);
+  if (sc != SL_STATUS_OK) {
+    initiator_log_error(INSTANCE_PREFIX "CS procedure - failed to set procedure interval %u! "
+                                        "[sc: 0x%lx]" LOG_NL,
+                        initiator->conn_handle,
+                        initiator->config.max_procedure_interval,
+                        (unsigned long)sc);
+    initiator->initiator_state = (uint8_t)INITIATOR_STATE_ERROR;
+    on_error(initiator,
+             CS_ERROR_EVENT_CS_SET_PROCEDURE_PARAMETERS_FAILED,
+             sc);
+    return sc;
+  }
+  initiator_log_info(INSTANCE_PREFIX "CS procedure - procedure interval: %u" LOG_NL,
+                     initiator->conn_handle,
+                     initiator->config.max_procedure_interval);
+  return SL_STATUS_OK;
+}
+
 /******************************************************************************
  * Initiator finalize cleanup. Remove the configuration and deinit RTL lib.
  * This function is called after the procedure was stopped.
@@ -697,6 +932,8 @@ static sl_status_t initiator_finalize_cleanup(cs_initiator_t *initiator)
   initiator_log_debug(INSTANCE_PREFIX "deleting instance" LOG_NL,
                       initiator->conn_handle);
 
+  cs_initiator_buffer_pool_return(&initiator->data.initiator);
+  cs_initiator_buffer_pool_return(&initiator->data.reflector);
   memset(initiator, 0, sizeof(cs_initiator_t));
   initiator_log_info(INSTANCE_PREFIX "instance deleted" LOG_NL, initiator->conn_handle);
   initiator->conn_handle = SL_BT_INVALID_CONNECTION_HANDLE;
@@ -715,10 +952,6 @@ static sl_status_t initiator_finalize_cleanup(cs_initiator_t *initiator)
   initiator->ras_client.config.ranging_data_overwritten_notification =
     CS_INITIATOR_RAS_DATA_OVERWRITTEN_NOTIFICATION;
 
-  initiator->data.reflector.ranging_data_size = 0;
-  memset(&initiator->data.reflector.ranging_data,
-         0,
-         sizeof(initiator->data.reflector.ranging_data));
   return sc;
 }
 
@@ -744,7 +977,12 @@ sl_status_t initiator_state_machine_event_handler(cs_initiator_t *initiator,
   }
 
   if (event == INITIATOR_EVT_ERROR) {
+#if CS_INITIATOR_TABLE_DISPATCH
+    // The handler moves to the ERROR state, which has no transitions
+    return state_any_on_error(initiator, data);
+#else
     sc = state_any_on_error(initiator, data);
+#endif
   }
 
   if (event == INITIATOR_EVT_DELETE_INSTANCE) {
@@ -752,6 +990,15 @@ sl_status_t initiator_state_machine_event_handler(cs_initiator_t *initiator,
     return sc;
   }
 
+#if CS_INITIATOR_TABLE_DISPATCH
+  if (initiator->initiator_state < INITIATOR_STATE_COUNT
+      && (uint8_t)event < INITIATOR_EVT_COUNT) {
+    state_handler_t handler = transition_table[initiator->initiator_state][event];
+    if (handler != NULL) {
+      sc = handler(initiator, data);
+    }
+  }
+#else
   switch (initiator->initiator_state) {
     case INITIATOR_STATE_UNINITIALIZED:
       if (event == INITIATOR_EVT_INIT_STARTED) {
@@ -819,6 +1066,7 @@ sl_status_t initiator_state_machine_event_handler(cs_initiator_t *initiator,
     default:
       break;
   }
+#endif
   return sc;
 }
 
@@ -828,6 +1076,23 @@ sl_status_t initiator_state_machine_event_handler(cs_initiator_t *initiator,
 static void procedure_timer_cb(app_timer_t *handle, void *data)
 {
   cs_initiator_t *initiator = (cs_initiator_t *)data;
+  if (handle == &initiator->timer_handle && initiator->wait_connection_parameters) {
+    // The peer did not take the new interval, keep the old one and restart
+    // the procedures instead of closing the connection
+    initiator->wait_connection_parameters = false;
+    initiator->config.min_connection_interval = initiator->conn_interval;
+    initiator->config.max_connection_interval = initiator->conn_interval;
+    initiator_log_warning(INSTANCE_PREFIX "CS - connection interval update timed out, "
+                                          "keeping %u" LOG_NL,
+                          initiator->conn_handle,
+                          initiator->conn_interval);
+    if (initiator->initiator_state == (uint8_t)INITIATOR_STATE_START_PROCEDURE) {
+      (void)initiator_state_machine_event_handler(initiator,
+                                                  INITIATOR_EVT_START_PROCEDURE,
+                                                  NULL);
+    }
+    return;
+  }
   if (handle == &initiator->timer_handle) {
     initiator->error_timer_started = false;
     initiator->error_timer_elapsed = true;
@@ -64,6 +64,22 @@ sl_status_t cs_ras_client_create(uint8_t                 connection,
                                  cs_ras_gattdb_handles_t *handles,
                                  uint16_t                att_mtu);
 
+/**************************************************************************//**
+ * Create RAS Client for a server whose features are already known, e.g. from
+ * a previous connection of a bonded peer. The features are not read again,
+ * the client is initialized on return and no initialized callback follows.
+ *
+ * @param[in] connection Connection handle.
+ * @param[in] handles    GATT database handles.
+ * @param[in] att_mtu    Initial MTU size.
+ * @param[in] features   RAS features of the server.
+ * @return Status of the operation.
+ *****************************************************************************/
+sl_status_t cs_ras_client_create_initialized(uint8_t                 connection,
+                                             cs_ras_gattdb_handles_t *handles,
+                                             uint16_t                att_mtu,
+                                             cs_ras_features_t       features);
+
 /**************************************************************************//**
  * Get features supported by the RAS Server.
  *
@@ -227,6 +243,20 @@ void cs_ras_client_on_ranging_data_ready(uint8_t                  connection,
 void cs_ras_client_on_ranging_data_overwritten(uint8_t                  connection,
                                                cs_ras_ranging_counter_t ranging_counter);
 
+/**************************************************************************//**
+ * Callback indicates that a segment of Ranging Data has been stored in the
+ * reception buffer. Called for every segment of a reception, before
+ * @ref cs_ras_client_on_ranging_data_reception_finished.
+ *
+ * @param[in] connection         Connection handle.
+ * @param[in] offset             Offset of the segment data in the buffer.
+ *                               A new procedure starts at offset 0.
+ * @param[in] size               Size of the segment data.
+ *****************************************************************************/
+void cs_ras_client_on_ranging_data_segment(uint8_t  connection,
+                                           uint32_t offset,
+                                           uint32_t size);
+
 /**************************************************************************//**
  * Callback indicates the end of a data reception in Real-Time or On-Demand
  * mode.
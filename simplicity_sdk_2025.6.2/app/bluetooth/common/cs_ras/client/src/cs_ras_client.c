@@ -128,6 +128,50 @@ sl_status_t cs_ras_client_create(uint8_t                 connection,
   return sc;
 }
 
+sl_status_t cs_ras_client_create_initialized(uint8_t                 connection,
+                                             cs_ras_gattdb_handles_t *handles,
+                                             uint16_t                att_mtu,
+                                             cs_ras_features_t       features)
+{
+  if (connection == SL_BT_INVALID_CONNECTION_HANDLE) {
+    return SL_STATUS_INVALID_HANDLE;
+  }
+  if (handles == NULL) {
+    return SL_STATUS_NULL_POINTER;
+  }
+  if ((att_mtu > ATT_MTU_MAX) || (att_mtu < ATT_MTU_MIN)) {
+    return SL_STATUS_INVALID_PARAMETER;
+  }
+  // Check for mandatory GATT database handles
+  if ((handles->array[CS_RAS_CHARACTERISTIC_INDEX_RAS_FEATURES] == CS_RAS_INVALID_CHARACTERISTIC_HANDLE)
+      || (handles->array[CS_RAS_CHARACTERISTIC_INDEX_CONTROL_POINT] == CS_RAS_INVALID_CHARACTERISTIC_HANDLE)
+      || (handles->array[CS_RAS_CHARACTERISTIC_INDEX_RANGING_DATA_READY] == CS_RAS_INVALID_CHARACTERISTIC_HANDLE)
+      || (handles->array[CS_RAS_CHARACTERISTIC_INDEX_RANGING_DATA_OVERWRITTEN] == CS_RAS_INVALID_CHARACTERISTIC_HANDLE)) {
+    return SL_STATUS_INVALID_PARAMETER;
+  }
+  // Find empty slot
+  cs_ras_client_t *client = cs_ras_client_find(SL_BT_INVALID_CONNECTION_HANDLE);
+  if (client == NULL) {
+    return SL_STATUS_ALLOCATION_FAILED;
+  }
+  // Same as a completed features read, the caller continues with
+  // cs_ras_client_configure() right away
+  memset(client, 0, sizeof(cs_ras_client_t));
+  memcpy(&client->subscription.cccd.config,
+         &default_config,
+         sizeof(client->subscription.cccd.config));
+  client->connection = connection;
+  client->handles = handles;
+  client->att_mtu = att_mtu;
+  client->features = features;
+  client->features_read = true;
+  set_state(client, CLIENT_STATE_INITIALIZED);
+  cs_ras_client_log_info(CONN_PREFIX "RAS features taken over: 0x%08lx" LOG_NL,
+                         client->connection,
+                         (unsigned long)client->features);
+  return SL_STATUS_OK;
+}
+
 sl_status_t cs_ras_client_get_features(uint8_t           connection,
                                        cs_ras_features_t *features)
 {
@@ -1213,11 +1257,17 @@ static void control_point_timer_rised(app_timer_t *timer, void *data)
 void cs_ras_client_messaging_segment_received(cs_ras_client_messaging_reception_t *rx,
                                               cs_ras_ranging_counter_t            counter)
 {
-  (void)counter;
   cs_ras_client_t *client = cs_ras_client_find(rx->config.conn_handle);
   if (client == NULL) {
     return;
   }
+  // Size is only moved past the offset if the segment has been stored
+  uint32_t offset = (uint32_t)counter * CS_RAS_SEGMENT_DATA_SIZE(rx->config.att_mtu);
+  if (rx->size > offset) {
+    cs_ras_client_on_ranging_data_segment(client->connection,
+                                          offset,
+                                          rx->size - offset);
+  }
   (void)app_timer_stop(&client->timer.data_arrived);
   (void)app_timer_start(&client->timer.data_arrived,
                         CS_RAS_CLIENT_INTER_EVENT_TIMEOUT_MS,
@@ -1261,6 +1311,15 @@ SL_WEAK void cs_ras_client_on_ranging_data_overwritten(uint8_t
   (void)ranging_counter;
 }
 
+SL_WEAK void cs_ras_client_on_ranging_data_segment(uint8_t  connection,
+                                                   uint32_t offset,
+                                                   uint32_t size)
+{
+  (void)connection;
+  (void)offset;
+  (void)size;
+}
+
 SL_WEAK bool cs_ras_client_on_timeout(uint8_t                        connection,
                                       cs_ras_client_timeout_t        timeout,
                                       cs_ras_client_timeout_action_t action)
@@ -44,6 +44,33 @@ extern "C" {
 
 #define INVALID_ANTENNA_CONF           0xff
 
+#ifndef CS_RAS_STEP_INDEX_MAX_SUBEVENTS
+#define CS_RAS_STEP_INDEX_MAX_SUBEVENTS 32
+#endif
+
+/// Subevent entry of a step index
+typedef struct {
+  uint16_t offset;               // Subevent header offset from the data start
+  uint8_t  num_steps;            // Number of steps indexed in the subevent
+  uint8_t  ranging_done_status;  // Ranging done status of the subevent header
+  uint8_t  subevent_done_status; // Subevent done status of the subevent header
+} cs_ras_subevent_index_t;
+
+/// Step index of a RAS ranging data body, built in a single pass
+/// @note Steps are counted, not stored. With the default of 32 subevents the
+///       index takes 208 bytes, one per initiator instance.
+typedef struct {
+  uint8_t  num_subevents;                                       // Indexed subevents
+  uint16_t num_steps;                                           // Indexed steps
+  cs_ras_subevent_index_t subevent[CS_RAS_STEP_INDEX_MAX_SUBEVENTS];
+  // Parser state, kept between calls while the data is still arriving
+  uint16_t parsed;                                              // Offset of the first byte not indexed
+  uint8_t  steps_left;                                          // Steps of the last subevent not indexed
+  uint8_t  step_size[3];                                        // Data size of step modes 0-2
+  bool     complete;                                            // Last subevent of the procedure indexed
+  sl_status_t status;                                           // First parsing error
+} cs_ras_step_index_t;
+
 /**************************************************************************//**
  * Convert from event data to RAS format as
  * specified by the SIG standard.
@@ -97,6 +124,72 @@ sl_status_t cs_ras_format_get_next_subevent_header(cs_ras_subevent_header_t *sub
                                                    uint8_t antenna_path_num,
                                                    cs_ras_subevent_header_t **subevent_header_out);
 
+/**************************************************************************//**
+ * Start a step index for data that arrives in parts
+ *
+ * @param[out] index            Step index to reset.
+ * @param[in]  is_initiator     True for initiator.
+ * @param[in]  antenna_path_num Number of antenna paths.
+ * @return status of the operation.
+ * @retval SL_STATUS_OK The index is ready for @ref cs_ras_format_advance_step_index.
+ * @retval SL_STATUS_NULL_POINTER Index is NULL.
+ * @retval SL_STATUS_INVALID_PARAMETER Invalid antenna path number specified.
+ *****************************************************************************/
+sl_status_t cs_ras_format_init_step_index(cs_ras_step_index_t *index,
+                                          bool is_initiator,
+                                          uint8_t antenna_path_num);
+
+/**************************************************************************//**
+ * Continue the step index of RAS data
+ *
+ * Indexes the subevents and steps that arrived since the previous call and
+ * are complete in data. A subevent header or step that does not fit yet is
+ * left for the next call, so the data can grow a segment at a time. Bytes
+ * already indexed are not read again.
+ *
+ * @param[in]     data     Data pointer, the same for every call.
+ * @param[in]     data_end End of the data received without gaps.
+ * @param[in,out] index    Step index started by @ref cs_ras_format_init_step_index.
+ * @return status of the operation.
+ * @retval SL_STATUS_OK All data was indexed, it ends on a subevent boundary.
+ * @retval SL_STATUS_IN_PROGRESS More data is needed to finish the last
+ *                               subevent or step.
+ * @retval SL_STATUS_NO_MORE_RESOURCE The index is full.
+ * @retval SL_STATUS_NULL_POINTER At least one input pointer is NULL.
+ * @retval SL_STATUS_INVALID_PARAMETER Data is shorter than already indexed.
+ * @retval SL_STATUS_INVALID_MODE Invalid step mode found in the data.
+ * Errors are kept, later calls return them without indexing.
+ *****************************************************************************/
+sl_status_t cs_ras_format_advance_step_index(uint8_t *data,
+                                             uint8_t *data_end,
+                                             cs_ras_step_index_t *index);
+
+/**************************************************************************//**
+ * Build the step index of RAS data
+ *
+ * Walks the ranging data once, records the offset, status and step count of
+ * every subevent and counts the steps. Indexing stops at the first error;
+ * the entries recorded up to that point stay valid.
+ *
+ * @param[in]  data             Data pointer.
+ * @param[in]  data_end         End of the data.
+ * @param[in]  is_initiator     True for initiator.
+ * @param[in]  antenna_path_num Number of antenna paths.
+ * @param[out] index            Step index output.
+ * @return status of the operation.
+ * @retval SL_STATUS_OK All data was indexed.
+ * @retval SL_STATUS_WOULD_OVERFLOW A subevent or step does not fit in data.
+ * @retval SL_STATUS_NO_MORE_RESOURCE The index is full.
+ * @retval SL_STATUS_NULL_POINTER At least one input pointer is NULL.
+ * @retval SL_STATUS_INVALID_PARAMETER Invalid antenna path number specified.
+ * @retval SL_STATUS_INVALID_MODE Invalid step mode found in the data.
+ *****************************************************************************/
+sl_status_t cs_ras_format_build_step_index(uint8_t *data,
+                                           uint8_t *data_end,
+                                           bool is_initiator,
+                                           uint8_t antenna_path_num,
+                                           cs_ras_step_index_t *index);
+
 #ifdef __cplusplus
 };
 #endif
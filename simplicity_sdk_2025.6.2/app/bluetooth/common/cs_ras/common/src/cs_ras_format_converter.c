@@ -199,3 +199,164 @@ sl_status_t cs_ras_format_get_next_subevent_header(cs_ras_subevent_header_t *sub
   *subevent_header_out = (cs_ras_subevent_header_t *)position;
   return SL_STATUS_OK;
 }
+
+sl_status_t cs_ras_format_init_step_index(cs_ras_step_index_t *index,
+                                          bool is_initiator,
+                                          uint8_t antenna_path_num)
+{
+  if (index == NULL) {
+    return SL_STATUS_NULL_POINTER;
+  }
+  index->num_subevents = 0;
+  index->num_steps = 0;
+  index->parsed = 0;
+  index->steps_left = 0;
+  index->complete = false;
+  index->status = SL_STATUS_OK;
+  if ((antenna_path_num == 0) || (antenna_path_num > MAX_ANTENNA_PATH_NUM)) {
+    index->status = SL_STATUS_INVALID_PARAMETER;
+    return index->status;
+  }
+  // Step sizes are fixed for a procedure, resolve them once
+  index->step_size[CS_RAS_STEP_MODE_CALIBRATION] = MODE_0_SIZE(is_initiator);
+  index->step_size[CS_RAS_STEP_MODE_RTT] = MODE_1_SIZE;
+  index->step_size[CS_RAS_STEP_MODE_PBR] = MODE_2_SIZE(antenna_path_num);
+  return SL_STATUS_OK;
+}
+
+sl_status_t cs_ras_format_advance_step_index(uint8_t *data,
+                                             uint8_t *data_end,
+                                             cs_ras_step_index_t *index)
+{
+  if ((data == NULL)
+      || (data_end == NULL)
+      || (index == NULL)) {
+    return SL_STATUS_NULL_POINTER;
+  }
+  if (index->status != SL_STATUS_OK) {
+    return index->status;
+  }
+  if (data_end < data + index->parsed) {
+    return SL_STATUS_INVALID_PARAMETER;
+  }
+
+  uint8_t *position = data + index->parsed;
+  cs_ras_subevent_header_t *subevent_header;
+  cs_ras_subevent_index_t *subevent = NULL;
+  // Parser state is kept in locals, the data bytes could alias the index
+  uint8_t steps_left = index->steps_left;
+  uint16_t num_steps = index->num_steps;
+  uint8_t subevent_steps = 0;
+  uint8_t step_size[3];
+  uint8_t step_mode;
+  uint8_t size;
+  sl_status_t sc = SL_STATUS_OK;
+
+  memcpy(step_size, index->step_size, sizeof(step_size));
+  if (index->num_subevents > 0) {
+    subevent = &index->subevent[index->num_subevents - 1];
+    subevent_steps = subevent->num_steps;
+  }
+
+  if (index->parsed == 0) {
+    if (position + sizeof(cs_ras_ranging_header_t) > data_end) {
+      return SL_STATUS_IN_PROGRESS;
+    }
+    position += sizeof(cs_ras_ranging_header_t);
+  }
+
+  while (position < data_end) {
+    if (steps_left == 0) {
+      if (position + sizeof(cs_ras_subevent_header_t) > data_end) {
+        sc = SL_STATUS_IN_PROGRESS;
+        break;
+      }
+      if (index->num_subevents == CS_RAS_STEP_INDEX_MAX_SUBEVENTS) {
+        sc = SL_STATUS_NO_MORE_RESOURCE;
+        break;
+      }
+      subevent_header = (cs_ras_subevent_header_t *)position;
+      subevent = &index->subevent[index->num_subevents++];
+      subevent->offset = (uint16_t)(position - data);
+      subevent->ranging_done_status = subevent_header->ranging_done_status;
+      subevent->subevent_done_status = subevent_header->subevent_done_status;
+      subevent_steps = 0;
+      position += sizeof(cs_ras_subevent_header_t);
+      steps_left = subevent_header->number_of_steps_reported;
+    }
+    // Steps of the current subevent
+    while ((steps_left > 0) && (position < data_end)) {
+      step_mode = *position;
+      // Branches instead of a size table: the modes repeat, so the next
+      // step's position does not wait on this mode byte.
+      if ((step_mode & CS_RAS_STEP_ABORTED_MASK) != 0) {
+        // If the Step is aborted, the length of Step_Data [i] is 0.
+        size = sizeof(step_mode);
+      } else if ((step_mode & CS_RAS_STEP_MODE_MASK) == CS_RAS_STEP_MODE_PBR) {
+        size = sizeof(step_mode) + step_size[CS_RAS_STEP_MODE_PBR];
+      } else if ((step_mode & CS_RAS_STEP_MODE_MASK) == CS_RAS_STEP_MODE_CALIBRATION) {
+        size = sizeof(step_mode) + step_size[CS_RAS_STEP_MODE_CALIBRATION];
+      } else if ((step_mode & CS_RAS_STEP_MODE_MASK) == CS_RAS_STEP_MODE_RTT) {
+        size = sizeof(step_mode) + step_size[CS_RAS_STEP_MODE_RTT];
+      } else {
+        sc = SL_STATUS_INVALID_MODE;
+        break;
+      }
+      if (position + size > data_end) {
+        sc = SL_STATUS_IN_PROGRESS;
+        break;
+      }
+      num_steps++;
+      subevent_steps++;
+      steps_left--;
+      position += size;
+    }
+    if (subevent != NULL) {
+      subevent->num_steps = subevent_steps;
+    }
+    if (sc != SL_STATUS_OK) {
+      break;
+    }
+    if (steps_left == 0) {
+      // Any other status than partial results ends the procedure
+      if (subevent->ranging_done_status != sl_bt_cs_done_status_partial_results_continue) {
+        index->complete = true;
+      }
+    }
+  }
+  index->steps_left = steps_left;
+  index->num_steps = num_steps;
+  index->parsed = (uint16_t)(position - data);
+
+  if ((sc == SL_STATUS_OK) && (index->steps_left > 0)) {
+    sc = SL_STATUS_IN_PROGRESS;
+  } else if ((sc != SL_STATUS_OK) && (sc != SL_STATUS_IN_PROGRESS)) {
+    index->status = sc;
+  }
+  return sc;
+}
+
+sl_status_t cs_ras_format_build_step_index(uint8_t *data,
+                                           uint8_t *data_end,
+                                           bool is_initiator,
+                                           uint8_t antenna_path_num,
+                                           cs_ras_step_index_t *index)
+{
+  sl_status_t sc;
+
+  if ((data == NULL)
+      || (data_end == NULL)
+      || (index == NULL)) {
+    return SL_STATUS_NULL_POINTER;
+  }
+  sc = cs_ras_format_init_step_index(index, is_initiator, antenna_path_num);
+  if (sc != SL_STATUS_OK) {
+    return sc;
+  }
+  sc = cs_ras_format_advance_step_index(data, data_end, index);
+  // All data is present, a missing part is an overflow
+  if (sc == SL_STATUS_IN_PROGRESS) {
+    sc = SL_STATUS_WOULD_OVERFLOW;
+  }
+  return sc;
+}
@@ -59,6 +59,27 @@ SL_ENUM(cs_result_field_type_t) {
   CS_RESULT_FIELD_BIT_ERROR_RATE            ///< bit error rate for RTT only
 };
 
+/// Number of field types
+#define CS_RESULT_FIELD_COUNT     (CS_RESULT_FIELD_BIT_ERROR_RATE + 1)
+
+/// Validity bit of a field type in cs_result_fields_t::valid_mask
+#define CS_RESULT_FIELD_BIT(type) (1ul << (type))
+
+/// Typed result, filled once per procedure as an alternative to the TLV buffer
+typedef struct {
+  float distance_mainmode;     ///< filtered distance value (mainmode)
+  float distance_submode;      ///< filtered distance value (submode)
+  float distance_raw_mainmode; ///< raw distance value (mainmode)
+  float distance_raw_submode;  ///< raw distance value (submode)
+  float likeliness_mainmode;   ///< likeliness (mainmode)
+  float likeliness_submode;    ///< likeliness (submode)
+  float distance_rssi;         ///< distance value based on RSSI
+  float velocity_mainmode;     ///< velocity (mainmode)
+  float velocity_submode;      ///< velocity (submode)
+  float bit_error_rate;        ///< bit error rate for RTT only
+  uint32_t valid_mask;         ///< CS_RESULT_FIELD_BIT() of each valid field
+} cs_result_fields_t;
+
 /// Result sesion data
 typedef struct {
   uint8_t type_count;          ///< number of field types in the result buffer
@@ -124,6 +145,37 @@ sl_status_t cs_result_create_session_data(uint8_t *buffer,
                                           uint8_t buffer_length,
                                           cs_result_session_data_t *result_data);
 
+/***************************************************************************//**
+ * Clear all fields of a typed result.
+ * @param[in] fields pointer to the typed result.
+ ******************************************************************************/
+void cs_result_clear_fields(cs_result_fields_t *fields);
+
+/***************************************************************************//**
+ * Set a field of a typed result and mark it valid.
+ * @param[in] fields pointer to the typed result.
+ * @param[in] target field type to be set.
+ * @param[in] value value of the field.
+ *
+ * @return Status of the operation.
+ ******************************************************************************/
+sl_status_t cs_result_set_field(cs_result_fields_t *fields,
+                                cs_result_field_type_t target,
+                                float value);
+
+/***************************************************************************//**
+ * Check if a field of a typed result is valid.
+ * @param[in] fields pointer to the typed result.
+ * @param[in] target field type to be checked.
+ *
+ * @return true if the field has been set.
+ ******************************************************************************/
+static inline bool cs_result_field_is_valid(const cs_result_fields_t *fields,
+                                            cs_result_field_type_t target)
+{
+  return (fields->valid_mask & CS_RESULT_FIELD_BIT(target)) != 0;
+}
+
 #ifdef __cplusplus
 }
 #endif
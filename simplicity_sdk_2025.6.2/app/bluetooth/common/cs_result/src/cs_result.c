@@ -267,3 +267,57 @@ sl_status_t cs_result_create_session_data(uint8_t *buffer,
                    result_data->size);
   return sc;
 }
+
+/******************************************************************************
+ * Clear all fields of a typed result.
+ *****************************************************************************/
+void cs_result_clear_fields(cs_result_fields_t *fields)
+{
+  memset(fields, 0, sizeof(*fields));
+}
+
+/******************************************************************************
+ * Set a field of a typed result.
+ *****************************************************************************/
+sl_status_t cs_result_set_field(cs_result_fields_t *fields,
+                                cs_result_field_type_t target,
+                                float value)
+{
+  switch (target) {
+    case CS_RESULT_FIELD_DISTANCE_MAINMODE:
+      fields->distance_mainmode = value;
+      break;
+    case CS_RESULT_FIELD_DISTANCE_SUBMODE:
+      fields->distance_submode = value;
+      break;
+    case CS_RESULT_FIELD_DISTANCE_RAW_MAINMODE:
+      fields->distance_raw_mainmode = value;
+      break;
+    case CS_RESULT_FIELD_DISTANCE_RAW_SUBMODE:
+      fields->distance_raw_submode = value;
+      break;
+    case CS_RESULT_FIELD_LIKELINESS_MAINMODE:
+      fields->likeliness_mainmode = value;
+      break;
+    case CS_RESULT_FIELD_LIKELINESS_SUBMODE:
+      fields->likeliness_submode = value;
+      break;
+    case CS_RESULT_FIELD_DISTANCE_RSSI:
+      fields->distance_rssi = value;
+      break;
+    case CS_RESULT_FIELD_VELOCITY_MAINMODE:
+      fields->velocity_mainmode = value;
+      break;
+    case CS_RESULT_FIELD_VELOCITY_SUBMODE:
+      fields->velocity_submode = value;
+      break;
+    case CS_RESULT_FIELD_BIT_ERROR_RATE:
+      fields->bit_error_rate = value;
+      break;
+    default:
+      result_log_error("failed to set unknown type 0x%x!" NL, target);
+      return SL_STATUS_INVALID_TYPE;
+  }
+  fields->valid_mask |= CS_RESULT_FIELD_BIT(target);
+  return SL_STATUS_OK;
+}